@@ -0,0 +1,134 @@
+#include "AdapterSelection.h"
+
+#include <fstream>
+
+namespace
+{
+	/* 11_0, 11_1, 12_0, 12_1 and 12_2; what a feature level is worth is how many of these it reaches. */
+	constexpr uint32_t FeatureLevels[] = { 0xb000, 0xb100, 0xc000, 0xc100, 0xc200 };
+
+	int64_t FeatureLevelSteps(uint32_t level)
+	{
+		int64_t steps = 0;
+		for (uint32_t known : FeatureLevels)
+		{
+			if (level >= known)
+				steps++;
+		}
+		return steps;
+	}
+}
+
+int64_t AdapterScoring::Score(const AdapterInfo& adapter, const AdapterRequirements& requirements)
+{
+	const AdapterCaps& caps = adapter.Caps;
+	if (!adapter.Probed || caps.MaxFeatureLevel == 0 || caps.MaxFeatureLevel < requirements.MinFeatureLevel
+		|| caps.ResourceBindingTier < requirements.MinResourceBindingTier)
+		return -1;
+	if (adapter.Software)
+		return requirements.RejectSoftware ? -1 : 0;
+
+	// 64-bit throughout; memory sizes past 4 GB are the common case.
+	int64_t score = 1 + (int64_t)(adapter.DedicatedVideoMemory / (1024 * 1024));
+	score += FeatureLevelBonus * (FeatureLevelSteps(caps.MaxFeatureLevel) - FeatureLevelSteps(requirements.MinFeatureLevel));
+	score += BindingTierBonus * ((int64_t)caps.ResourceBindingTier - (int64_t)requirements.MinResourceBindingTier);
+	score += caps.RaytracingTier != 0 ? RaytracingBonus : 0;
+	score += caps.MeshShaderTier != 0 ? MeshShaderBonus : 0;
+	score += caps.VariableShadingRateTier != 0 ? ShadingRateBonus : 0;
+	score += caps.WaveOps != 0 ? WaveOpsBonus : 0;
+	return score;
+}
+
+uint32_t AdapterScoring::Select(const std::vector<AdapterInfo>& adapters, const AdapterRequirements& requirements)
+{
+	uint32_t best = InvalidAdapter;
+	int64_t bestScore = -1;
+	for (uint32_t i = 0; i < (uint32_t)adapters.size(); i++)
+	{
+		int64_t score = Score(adapters[i], requirements);
+		if (score > bestScore)
+		{
+			best = i;
+			bestScore = score;
+		}
+	}
+	return best;
+}
+
+void AdapterCapsCache::Load(const char* path)
+{
+	mEntries.clear();
+	mDirty = false;
+
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return;
+	uint64_t fileSize = (uint64_t)file.tellg();
+	file.seekg(0);
+
+	FileHeader header = {};
+	file.read((char*)&header, sizeof(header));
+	if (!file || header.Magic != FileHeader::MagicValue || header.Version != FileHeader::CurrentVersion || header.EntrySize != sizeof(Entry))
+		return;
+	// Count comes from disk; a truncated or corrupt file must not size the allocation.
+	if ((uint64_t)header.Count * sizeof(Entry) != fileSize - sizeof(header))
+		return;
+
+	std::vector<Entry> entries(header.Count);
+	file.read((char*)entries.data(), (std::streamsize)(entries.size() * sizeof(Entry)));
+	if (file)
+		mEntries = std::move(entries);
+}
+
+bool AdapterCapsCache::Save(const char* path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	FileHeader header = { FileHeader::MagicValue, FileHeader::CurrentVersion, (uint32_t)mEntries.size(), (uint32_t)sizeof(Entry) };
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)mEntries.data(), (std::streamsize)(mEntries.size() * sizeof(Entry)));
+	return (bool)file;
+}
+
+const AdapterCaps* AdapterCapsCache::Find(const AdapterInfo& adapter, uint32_t format)
+{
+	for (const Entry& entry : mEntries)
+	{
+		if (entry.Luid != adapter.Luid || entry.Format != format)
+			continue;
+
+		if (entry.DriverVersion == adapter.DriverVersion && entry.VendorId == adapter.VendorId && entry.DeviceId == adapter.DeviceId)
+		{
+			mStats.Hits++;
+			return &entry.Caps;
+		}
+
+		// Same slot, different driver or card: probe again, Store() replaces the entry.
+		mStats.Stale++;
+		break;
+	}
+
+	mStats.Misses++;
+	return nullptr;
+}
+
+void AdapterCapsCache::Store(const AdapterInfo& adapter, uint32_t format, const AdapterCaps& caps)
+{
+	Entry entry = {};
+	entry.Luid = adapter.Luid;
+	entry.DriverVersion = adapter.DriverVersion;
+	entry.Format = format;
+	entry.VendorId = adapter.VendorId;
+	entry.DeviceId = adapter.DeviceId;
+	entry.Caps = caps;
+
+	mDirty = true;
+	for (Entry& existing : mEntries)
+	{
+		if (existing.Luid == adapter.Luid && existing.Format == format)
+		{
+			existing = entry;
+			return;
+		}
+	}
+	mEntries.push_back(entry);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/* What probing one adapter found, in the API's values; 0 where a query failed or the tier is not supported. */
+struct AdapterCaps
+{
+	/* D3D_FEATURE_LEVEL, e.g. 0xc100 for 12_1; 0 if no device could be created. */
+	uint32_t MaxFeatureLevel = 0;
+	/* D3D_SHADER_MODEL, e.g. 0x65 for 6_5. */
+	uint32_t HighestShaderModel = 0;
+	uint32_t ResourceBindingTier = 0;
+	uint32_t ResourceHeapTier = 0;
+	uint32_t TiledResourcesTier = 0;
+	uint32_t ConservativeRasterizationTier = 0;
+	uint32_t RaytracingTier = 0;
+	uint32_t VariableShadingRateTier = 0;
+	uint32_t MeshShaderTier = 0;
+	uint32_t WaveOps = 0;
+	/* Bit n set when 2^n samples are supported for the probed format, 1 to 16 samples. */
+	uint32_t MsaaSampleCounts = 0;
+	uint32_t Msaa4xQualityLevels = 0;
+};
+
+/* One enumerated adapter; Caps is valid once Probed. */
+struct AdapterInfo
+{
+	uint64_t Luid = 0;
+	/* The user mode driver version, which changes whenever the driver does. */
+	uint64_t DriverVersion = 0;
+	uint32_t VendorId = 0;
+	uint32_t DeviceId = 0;
+	uint64_t DedicatedVideoMemory = 0;
+	uint64_t SharedSystemMemory = 0;
+	bool Software = false;
+	char Name[128] = {};
+
+	bool Probed = false;
+	AdapterCaps Caps;
+};
+
+struct AdapterRequirements
+{
+	uint32_t MinFeatureLevel = 0xb000;
+	uint32_t MinResourceBindingTier = 1;
+	/* 0 allows software adapters, which only win when nothing else qualifies. */
+	bool RejectSoftware = false;
+};
+
+/*
+	Scores probed adapters. Dedicated memory in MB is the base, since it tells
+	discrete from integrated parts and bigger from smaller ones; each feature
+	level step and tier above the requirements adds a fixed bonus, so a newer
+	part wins between cards of similar memory. Adapters below the requirements
+	score -1, software adapters 0.
+*/
+class AdapterScoring
+{
+public:
+	static constexpr uint32_t InvalidAdapter = ~0u;
+
+	static constexpr int64_t FeatureLevelBonus = 256;
+	static constexpr int64_t BindingTierBonus = 128;
+	static constexpr int64_t RaytracingBonus = 512;
+	static constexpr int64_t MeshShaderBonus = 512;
+	static constexpr int64_t ShadingRateBonus = 256;
+	static constexpr int64_t WaveOpsBonus = 128;
+
+	static int64_t Score(const AdapterInfo& adapter, const AdapterRequirements& requirements);
+	/* Highest score, the earlier adapter on a tie since DXGI lists the preferred one first; InvalidAdapter if none qualifies. */
+	static uint32_t Select(const std::vector<AdapterInfo>& adapters, const AdapterRequirements& requirements);
+};
+
+struct AdapterCacheStats
+{
+	uint32_t Hits = 0;
+	uint32_t Misses = 0;
+	/* Lookups that found the adapter under another driver version or card; Store() replaces those entries. */
+	uint32_t Stale = 0;
+};
+
+/*
+	Probe results on disk, keyed by adapter LUID, driver version and the probed
+	format, so startup only probes adapters it has not seen with this driver.
+	LUIDs change across reboots, which then costs one probe per adapter.
+*/
+class AdapterCapsCache
+{
+public:
+	/* Missing or unreadable files leave the cache empty. */
+	void Load(const char* path);
+	bool Save(const char* path) const;
+
+	/* Caps for this adapter and format, or nullptr if they need probing. */
+	const AdapterCaps* Find(const AdapterInfo& adapter, uint32_t format);
+	void Store(const AdapterInfo& adapter, uint32_t format, const AdapterCaps& caps);
+
+	bool IsDirty() const { return mDirty; }
+	AdapterCacheStats Stats() const { return mStats; }
+
+private:
+	/* Layout of the file Save() writes: FileHeader, then Count entries. */
+	struct FileHeader
+	{
+		static constexpr uint32_t MagicValue = 0x43415844; // "DXAC"
+		/* Bump whenever AdapterCaps changes. */
+		static constexpr uint32_t CurrentVersion = 1;
+
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t Count;
+		uint32_t EntrySize;
+	};
+
+	struct Entry
+	{
+		uint64_t Luid;
+		uint64_t DriverVersion;
+		uint32_t Format;
+		uint32_t VendorId;
+		uint32_t DeviceId;
+		uint32_t Padding;
+		AdapterCaps Caps;
+	};
+	static_assert(std::is_trivially_copyable_v<Entry>, "Cache entries are written as raw bytes");
+
+	std::vector<Entry> mEntries;
+	AdapterCacheStats mStats;
+	bool mDirty = false;
+};
@@ -0,0 +1,235 @@
+#include "AssetStreamer.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+AssetStreamer::~AssetStreamer()
+{
+	Stop();
+}
+
+void AssetStreamer::Start(FrameSync* sync, uint64_t readAhead)
+{
+	Stop();
+
+	mSync = sync;
+	mReadAhead = readAhead;
+	mQuit = false;
+	mThread = std::thread(&AssetStreamer::IoMain, this);
+}
+
+void AssetStreamer::Stop()
+{
+	if (!mThread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWake.notify_all();
+	mThread.join();
+}
+
+uint64_t AssetStreamer::Request(const PackFile& pack, uint32_t entry, int32_t priority, Callback onResident, void* user)
+{
+	// The I/O thread indexes the pack with it unchecked.
+	if (entry >= pack.EntryCount())
+		return 0;
+
+	PendingRequest request = {};
+	request.Priority = priority;
+	request.Pack = &pack;
+	request.Entry = entry;
+	request.OnResident = std::move(onResident);
+	request.User = user;
+
+	uint64_t id;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		id = request.Id = mNextId++;
+		mQueued.push_back(std::move(request));
+		std::push_heap(mQueued.begin(), mQueued.end(), LowerPriority);
+		mStats.Requested++;
+	}
+	mWake.notify_all();
+	return id;
+}
+
+void AssetStreamer::Pump(uint64_t byteBudget, const Sink& sink, const Submit& submit)
+{
+	// Report everything whose last upload has completed on the GPU.
+	uint64_t completed = mSync->CompletedValue();
+	for (size_t i = 0; i < mInFlight.size();)
+	{
+		if (mInFlight[i].FenceValue > completed)
+		{
+			i++;
+			continue;
+		}
+
+		PendingRequest request = std::move(mInFlight[i]);
+		mInFlight[i] = std::move(mInFlight.back());
+		mInFlight.pop_back();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStats.Completed++;
+			mStats.BytesCompleted += request.Pack->Entry(request.Entry).Size;
+		}
+		if (request.OnResident)
+			request.OnResident(request.Id, request.User);
+	}
+
+	// Take prefetched requests until the budget is covered; partial uploads from last time go first.
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		uint64_t pending = 0;
+		for (const PendingRequest& request : mUploading)
+			pending += request.Pack->Entry(request.Entry).Size - request.Uploaded;
+
+		bool took = false;
+		while (pending < byteBudget && !mReady.empty())
+		{
+			std::pop_heap(mReady.begin(), mReady.end(), LowerPriority);
+			PendingRequest& request = mReady.back();
+			uint64_t size = request.Pack->Entry(request.Entry).Size;
+			pending += size;
+			mReadyBytes -= size;
+			mUploading.push_back(std::move(request));
+			mReady.pop_back();
+			took = true;
+		}
+		if (took)
+			mWake.notify_all();
+	}
+
+	bool submitted = false;
+	size_t finished = 0;
+	for (; finished < mUploading.size(); finished++)
+	{
+		PendingRequest& request = mUploading[finished];
+		const PackEntry& entry = request.Pack->Entry(request.Entry);
+
+		bool stalled = false;
+		while (request.Uploaded < entry.Size)
+		{
+			if (byteBudget == 0)
+			{
+				stalled = true;
+				break;
+			}
+
+			StreamChunk chunk;
+			chunk.Request = request.Id;
+			chunk.Entry = request.Entry;
+			chunk.Data = request.Pack->Data(request.Entry) + request.Uploaded;
+			chunk.Offset = request.Uploaded;
+			chunk.Size = std::min(entry.Size - request.Uploaded, byteBudget);
+			chunk.TotalSize = entry.Size;
+			chunk.User = request.User;
+
+			if (!sink(chunk))
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mStats.SinkStalls++;
+				stalled = true;
+				break;
+			}
+
+			request.Uploaded += chunk.Size;
+			byteBudget -= chunk.Size;
+			submitted = true;
+		}
+		if (stalled)
+			break;
+	}
+
+	// Empty payloads still go through a fence so their callback is ordered after earlier uploads.
+	if (finished == 0 && !submitted)
+		return;
+
+	uint64_t fenceValue = submitted ? submit() : mSync->LastSignaledValue();
+	for (size_t i = 0; i < finished; i++)
+	{
+		mUploading[i].FenceValue = fenceValue;
+		mInFlight.push_back(std::move(mUploading[i]));
+	}
+	mUploading.erase(mUploading.begin(), mUploading.begin() + finished);
+}
+
+bool AssetStreamer::IsIdle()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mQueued.empty() && mReady.empty() && mUploading.empty() && mInFlight.empty();
+}
+
+StreamStats AssetStreamer::Stats()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	StreamStats stats = mStats;
+	stats.Queued = (uint32_t)mQueued.size();
+	stats.Ready = (uint32_t)mReady.size();
+	stats.ReadyBytes = mReadyBytes;
+	return stats;
+}
+
+bool AssetStreamer::LowerPriority(const PendingRequest& a, const PendingRequest& b)
+{
+	if (a.Priority != b.Priority)
+		return a.Priority < b.Priority;
+	return a.Id > b.Id;
+}
+
+void AssetStreamer::Prefetch(const uint8_t* data, uint64_t size)
+{
+	if (size == 0)
+		return;
+
+	const uint64_t pageSize = 4096;
+	uintptr_t begin = (uintptr_t)data & ~(uintptr_t)(pageSize - 1);
+	uintptr_t end = (uintptr_t)data + size;
+
+	// Ask the OS to read the whole range ahead, then fault in any page it skipped.
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range = { (void*)begin, (SIZE_T)(end - begin) };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	madvise((void*)begin, end - begin, MADV_WILLNEED);
+#endif
+
+	uint8_t touched = 0;
+	for (uintptr_t page = begin; page < end; page += pageSize)
+		touched ^= *(const volatile uint8_t*)std::max(page, (uintptr_t)data);
+	(void)touched;
+}
+
+void AssetStreamer::IoMain()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		mWake.wait(lock, [&] { return mQuit || (!mQueued.empty() && mReadyBytes < mReadAhead); });
+		if (mQuit)
+			return;
+
+		std::pop_heap(mQueued.begin(), mQueued.end(), LowerPriority);
+		PendingRequest request = std::move(mQueued.back());
+		mQueued.pop_back();
+
+		// Page faults happen here, without the lock and off the render thread.
+		uint64_t size = request.Pack->Entry(request.Entry).Size;
+		mReadyBytes += size;
+		lock.unlock();
+		Prefetch(request.Pack->Data(request.Entry), size);
+		lock.lock();
+
+		mReady.push_back(std::move(request));
+		std::push_heap(mReady.begin(), mReady.end(), LowerPriority);
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "FrameRing.h"
+#include "PackFile.h"
+
+/* A piece of a payload handed to the upload sink; large payloads arrive in several. */
+struct StreamChunk
+{
+	uint64_t Request = 0;
+	uint32_t Entry = 0;
+	/* Points into the mapped pack file; the pages are already resident. */
+	const uint8_t* Data = nullptr;
+	uint64_t Offset = 0;
+	uint64_t Size = 0;
+	uint64_t TotalSize = 0;
+	void* User = nullptr;
+};
+
+struct StreamStats
+{
+	uint64_t Requested = 0;
+	uint64_t Completed = 0;
+	uint64_t BytesCompleted = 0;
+	/* Requests waiting for the I/O thread, and prefetched ones waiting for Pump(). */
+	uint32_t Queued = 0;
+	uint32_t Ready = 0;
+	uint64_t ReadyBytes = 0;
+	/* Pump() calls that stopped early because the sink was out of upload memory. */
+	uint64_t SinkStalls = 0;
+};
+
+/*
+	Streams pack file entries without blocking the render thread.
+	A background I/O thread takes requests in priority order and faults the
+	payload pages in; Pump(), called once per frame on the render thread, hands
+	the resident bytes straight from the mapping to the sink (no staging copy)
+	and reports a request resident once the fence value of its last upload has
+	completed on the completion FrameSync.
+*/
+class AssetStreamer
+{
+public:
+	/* Copies chunk into upload memory and records the GPU copy. Returns false when out of upload memory. */
+	using Sink = std::function<bool(const StreamChunk& chunk)>;
+	/* Submits the work recorded by the sink during this Pump() and returns its fence value. */
+	using Submit = std::function<uint64_t()>;
+	/* Called on the Pump() thread once the data is resident. */
+	using Callback = std::function<void(uint64_t request, void* user)>;
+
+	/* Prefetched-but-unconsumed bytes the I/O thread may run ahead by. */
+	static constexpr uint64_t DefaultReadAhead = 64ull * 1024 * 1024;
+
+	AssetStreamer() = default;
+	~AssetStreamer();
+
+	AssetStreamer(const AssetStreamer&) = delete;
+	AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+	/* sync is the timeline the Submit fence values belong to. */
+	void Start(FrameSync* sync, uint64_t readAhead = DefaultReadAhead);
+	void Stop();
+
+	/*
+		Thread-safe. Higher priorities are served first, equal ones in request order.
+		Returns 0 without queuing anything if entry is not in pack, e.g. PackFile::InvalidEntry.
+	*/
+	uint64_t Request(const PackFile& pack, uint32_t entry, int32_t priority, Callback onResident, void* user = nullptr);
+
+	/* Render thread: uploads up to byteBudget bytes and fires callbacks of resident requests. */
+	void Pump(uint64_t byteBudget, const Sink& sink, const Submit& submit);
+
+	/* True once every request has been reported resident. */
+	bool IsIdle();
+
+	StreamStats Stats();
+
+private:
+	struct PendingRequest
+	{
+		uint64_t Id;
+		int32_t Priority;
+		const PackFile* Pack;
+		uint32_t Entry;
+		Callback OnResident;
+		void* User;
+		/* Bytes already handed to the sink. */
+		uint64_t Uploaded;
+		/* Fence value of the submission carrying the last chunk. */
+		uint64_t FenceValue;
+	};
+
+	/* Heap comparator: true if b should be served before a. */
+	static bool LowerPriority(const PendingRequest& a, const PendingRequest& b);
+	static void Prefetch(const uint8_t* data, uint64_t size);
+
+	void IoMain();
+
+	FrameSync* mSync = nullptr;
+	uint64_t mReadAhead = DefaultReadAhead;
+
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	bool mQuit = false;
+	std::thread mThread;
+
+	uint64_t mNextId = 1;
+	/* Heaps ordered by LowerPriority(). */
+	std::vector<PendingRequest> mQueued;
+	std::vector<PendingRequest> mReady;
+	uint64_t mReadyBytes = 0;
+
+	// Render thread only.
+	std::vector<PendingRequest> mUploading;
+	std::vector<PendingRequest> mInFlight;
+
+	StreamStats mStats;
+};
@@ -0,0 +1,91 @@
+#include "ChromeTrace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+ChromeTrace::ChromeTrace(int64_t ticksPerSecond)
+	:
+	mTicksPerSecond(ticksPerSecond)
+{
+}
+
+void ChromeTrace::SetTrackName(uint32_t track, const char* name)
+{
+	for (auto& named : mTracks)
+	{
+		if (named.first == track)
+		{
+			named.second = name;
+			return;
+		}
+	}
+	mTracks.emplace_back(track, name);
+}
+
+void ChromeTrace::Add(const char* name, uint32_t track, int64_t beginTicks, int64_t endTicks)
+{
+	mEvents.push_back({ name, track, beginTicks, std::max(endTicks, beginTicks) });
+}
+
+void ChromeTrace::Write(std::ostream& out) const
+{
+	int64_t origin = 0;
+	if (!mEvents.empty())
+	{
+		origin = std::min_element(mEvents.begin(), mEvents.end(), [](const Event& a, const Event& b)
+		{
+			return a.BeginTicks < b.BeginTicks;
+		})->BeginTicks;
+	}
+
+	const double usPerTick = 1000000.0 / (double)mTicksPerSecond;
+	char number[64];
+
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	bool first = true;
+	for (const auto& track : mTracks)
+	{
+		out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << track.first << ", \"args\": {\"name\": ";
+		WriteString(out, track.second);
+		out << "}}";
+		first = false;
+	}
+
+	for (const Event& event : mEvents)
+	{
+		out << (first ? "" : ",\n") << "{\"name\": ";
+		WriteString(out, event.Name);
+		snprintf(number, sizeof(number), "%.3f", (double)(event.BeginTicks - origin) * usPerTick);
+		out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.Track << ", \"ts\": " << number;
+		snprintf(number, sizeof(number), "%.3f", (double)(event.EndTicks - event.BeginTicks) * usPerTick);
+		out << ", \"dur\": " << number << "}";
+		first = false;
+	}
+	out << "\n]}\n";
+}
+
+bool ChromeTrace::Write(const char* path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	Write(file);
+	return (bool)file;
+}
+
+void ChromeTrace::WriteString(std::ostream& out, const std::string& str)
+{
+	out << '"';
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if ((unsigned char)c < 0x20)
+			out << ' ';
+		else
+			out << c;
+	}
+	out << '"';
+}
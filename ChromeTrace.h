@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+	Collects complete ("X") events in CPU ticks and writes them in the Chrome trace
+	event format, which chrome://tracing and ui.perfetto.dev both open. Every track
+	is a thread of one process; events on a track should nest properly.
+*/
+class ChromeTrace
+{
+public:
+	explicit ChromeTrace(int64_t ticksPerSecond);
+
+	void SetTrackName(uint32_t track, const char* name);
+	void Add(const char* name, uint32_t track, int64_t beginTicks, int64_t endTicks);
+
+	/* Timestamps are relative to the earliest event. */
+	void Write(std::ostream& out) const;
+	bool Write(const char* path) const;
+
+	size_t EventCount() const { return mEvents.size(); }
+
+private:
+	struct Event
+	{
+		std::string Name;
+		uint32_t Track;
+		int64_t BeginTicks;
+		int64_t EndTicks;
+	};
+
+	static void WriteString(std::ostream& out, const std::string& str);
+
+	int64_t mTicksPerSecond;
+	std::vector<Event> mEvents;
+	std::vector<std::pair<uint32_t, std::string>> mTracks;
+};
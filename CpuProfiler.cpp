@@ -0,0 +1,245 @@
+#include "CpuProfiler.h"
+
+#include <algorithm>
+
+std::atomic<bool> CpuProfiler::sCapturing{ false };
+thread_local CpuProfiler::ThreadBuffer* CpuProfiler::tBuffer = nullptr;
+
+void CpuProfiler::Initialize(ReferenceClock referenceClock, int64_t referenceFrequency)
+{
+	State& state = GetState();
+	{
+		std::lock_guard<std::mutex> lock(state.Lock);
+		state.Clock = referenceClock;
+		state.ClockFrequency = referenceClock ? referenceFrequency : 1000000000;
+	}
+	Calibrate(0);
+	Calibrate(1);
+}
+
+uint32_t CpuProfiler::Intern(const char* name)
+{
+	State& state = GetState();
+	std::lock_guard<std::mutex> lock(state.Lock);
+
+	auto it = state.NameIds.find(name);
+	if (it != state.NameIds.end())
+		return it->second;
+
+	uint32_t id = (uint32_t)state.Names.size();
+	state.Names.emplace_back(name);
+	state.NameIds.emplace(name, id);
+	return id;
+}
+
+void CpuProfiler::SetThreadName(const char* name)
+{
+	ThreadBuffer* buffer = tBuffer ? tBuffer : RegisterThread();
+
+	State& state = GetState();
+	std::lock_guard<std::mutex> lock(state.Lock);
+	state.ThreadNames[buffer->Thread] = name;
+}
+
+void CpuProfiler::StartCapture()
+{
+	State& state = GetState();
+	{
+		std::lock_guard<std::mutex> lock(state.Lock);
+		if (state.CalibrationTicks[0] != 0)
+		{
+			sCapturing.store(true, std::memory_order_relaxed);
+			return;
+		}
+	}
+	Calibrate(0);
+	sCapturing.store(true, std::memory_order_relaxed);
+}
+
+void CpuProfiler::StopCapture()
+{
+	sCapturing.store(false, std::memory_order_relaxed);
+	Drain();
+}
+
+void CpuProfiler::Drain()
+{
+	State& state = GetState();
+	std::lock_guard<std::mutex> lock(state.Lock);
+	DrainLocked(state);
+}
+
+void CpuProfiler::Clear()
+{
+	State& state = GetState();
+	std::lock_guard<std::mutex> lock(state.Lock);
+	DrainLocked(state);
+	for (std::vector<CpuZoneEvent>& events : state.Captured)
+		events.clear();
+	for (auto& buffer : state.Buffers)
+		buffer->Dropped.store(0, std::memory_order_relaxed);
+}
+
+void CpuProfiler::AppendTrace(ChromeTrace& trace, uint32_t firstTrack)
+{
+	Calibrate(1);
+
+	State& state = GetState();
+	std::lock_guard<std::mutex> lock(state.Lock);
+	DrainLocked(state);
+
+	const double referencePerTick = state.CalibrationTicks[1] > state.CalibrationTicks[0]
+		? (double)(state.CalibrationReference[1] - state.CalibrationReference[0]) / (double)(state.CalibrationTicks[1] - state.CalibrationTicks[0])
+		: 0.0;
+	auto toReference = [&](uint64_t ticks)
+	{
+		return state.CalibrationReference[0] + (int64_t)((double)(int64_t)(ticks - state.CalibrationTicks[0]) * referencePerTick);
+	};
+
+	for (uint32_t thread = 0; thread < (uint32_t)state.ThreadNames.size(); thread++)
+		trace.SetTrackName(firstTrack + thread, state.ThreadNames[thread].c_str());
+
+	// Each event is a whole zone, so a dropped one loses only itself. Nested zones close, and are written, before their parent.
+	for (uint32_t thread = 0; thread < (uint32_t)state.Captured.size(); thread++)
+	{
+		for (const CpuZoneEvent& event : state.Captured[thread])
+			trace.Add(state.Names[event.Name].c_str(), firstTrack + thread, toReference(event.BeginTicks), toReference(event.EndTicks));
+	}
+}
+
+CpuProfilerStats CpuProfiler::Stats()
+{
+	State& state = GetState();
+	std::lock_guard<std::mutex> lock(state.Lock);
+
+	CpuProfilerStats stats;
+	stats.Threads = (uint32_t)state.Buffers.size();
+	for (const std::vector<CpuZoneEvent>& events : state.Captured)
+		stats.Events += events.size();
+	for (auto& buffer : state.Buffers)
+		stats.Dropped += buffer->Dropped.load(std::memory_order_relaxed);
+	return stats;
+}
+
+CpuProfilerOverhead CpuProfiler::MeasureOverhead(uint32_t zoneCount)
+{
+	using Clock = std::chrono::steady_clock;
+
+	static const uint32_t name = Intern("MeasureOverhead");
+	const uint32_t batch = BufferCapacity / 2;
+
+	CpuProfilerOverhead result;
+	result.Zones = zoneCount;
+	if (zoneCount == 0)
+		return result;
+
+	Clear();
+	StartCapture();
+
+	double capturingNs = 0.0;
+	double drainNs = 0.0;
+	for (uint32_t done = 0; done < zoneCount;)
+	{
+		uint32_t count = std::min(batch, zoneCount - done);
+
+		Clock::time_point begin = Clock::now();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			CpuZone zone(name);
+		}
+		Clock::time_point end = Clock::now();
+		Drain();
+		Clock::time_point drained = Clock::now();
+
+		capturingNs += std::chrono::duration<double, std::nano>(end - begin).count();
+		drainNs += std::chrono::duration<double, std::nano>(drained - end).count();
+		done += count;
+	}
+
+	StopCapture();
+	Clear();
+
+	Clock::time_point begin = Clock::now();
+	for (uint32_t i = 0; i < zoneCount; i++)
+	{
+		CpuZone zone(name);
+	}
+	double idleNs = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+
+	uint64_t sum = 0;
+	begin = Clock::now();
+	for (uint32_t i = 0; i < zoneCount; i++)
+		sum += Now();
+	double timestampNs = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+	// Keeps the loop from being optimized away.
+	if (sum == 1)
+		result.Zones++;
+
+	result.CapturingNsPerZone = capturingNs / zoneCount;
+	result.IdleNsPerZone = idleNs / zoneCount;
+	result.DrainNsPerZone = drainNs / zoneCount;
+	result.TimestampNs = timestampNs / zoneCount;
+	result.RecordNsPerZone = std::max(result.CapturingNsPerZone - 2.0 * result.TimestampNs, 0.0);
+	return result;
+}
+
+CpuProfiler::State& CpuProfiler::GetState()
+{
+	static State state;
+	return state;
+}
+
+CpuProfiler::ThreadBuffer* CpuProfiler::RegisterThread()
+{
+	State& state = GetState();
+	std::lock_guard<std::mutex> lock(state.Lock);
+
+	// Buffers outlive their threads so the collector never races a thread exit.
+	std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+	buffer->Thread = (uint32_t)state.Buffers.size();
+	state.ThreadNames.push_back("Thread " + std::to_string(buffer->Thread));
+	state.Captured.emplace_back();
+
+	tBuffer = buffer.get();
+	state.Buffers.push_back(std::move(buffer));
+	return tBuffer;
+}
+
+int64_t CpuProfiler::ReferenceNow()
+{
+	State& state = GetState();
+	if (state.Clock)
+		return state.Clock();
+	return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CpuProfiler::Calibrate(uint32_t point)
+{
+	uint64_t ticks = Now();
+	int64_t reference = ReferenceNow();
+
+	State& state = GetState();
+	std::lock_guard<std::mutex> lock(state.Lock);
+	state.CalibrationTicks[point] = ticks;
+	state.CalibrationReference[point] = reference;
+}
+
+void CpuProfiler::DrainLocked(State& state)
+{
+	for (auto& buffer : state.Buffers)
+	{
+		uint64_t tail = buffer->Tail.load(std::memory_order_relaxed);
+		uint64_t head = buffer->Head.load(std::memory_order_acquire);
+		std::vector<CpuZoneEvent>& captured = state.Captured[buffer->Thread];
+
+		// At most two contiguous runs: up to the end of the ring, then from its start.
+		while (tail < head)
+		{
+			uint64_t first = tail & (BufferCapacity - 1);
+			uint64_t count = std::min(head - tail, BufferCapacity - first);
+			captured.insert(captured.end(), buffer->Events + first, buffer->Events + first + count);
+			tail += count;
+		}
+		buffer->Tail.store(tail, std::memory_order_release);
+	}
+}
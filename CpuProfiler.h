@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ChromeTrace.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CPU_PROFILER_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CPU_PROFILER_RDTSC 1
+#endif
+
+/* Set to 0 to compile every zone out. */
+#ifndef CPU_PROFILER_ENABLED
+#define CPU_PROFILER_ENABLED 1
+#endif
+
+/* One finished zone, 24 bytes, written by the zone's thread only when the zone closes. */
+struct CpuZoneEvent
+{
+	uint64_t BeginTicks;
+	uint64_t EndTicks;
+	uint32_t Name;
+};
+
+struct CpuProfilerOverhead
+{
+	/* What a zone may cost while capturing, begin and end together. */
+	static constexpr double BudgetNs = 20.0;
+
+	uint32_t Zones = 0;
+	/* Begin + end of one zone while capturing, and while not. */
+	double CapturingNsPerZone = 0.0;
+	double IdleNsPerZone = 0.0;
+	double DrainNsPerZone = 0.0;
+	/* One Now() call; a zone takes two, so this bounds how cheap a zone can get. */
+	double TimestampNs = 0.0;
+	/* CapturingNsPerZone less the two Now() calls: what the profiler itself adds on top of them. */
+	double RecordNsPerZone = 0.0;
+
+	bool WithinBudget() const { return CapturingNsPerZone <= BudgetNs; }
+};
+
+struct CpuProfilerStats
+{
+	uint32_t Threads = 0;
+	uint64_t Events = 0;
+	/* Events lost because a thread's buffer was full before the collector drained it. */
+	uint64_t Dropped = 0;
+};
+
+/*
+	Process-wide zone profiler. A zone (CPU_ZONE) keeps its begin timestamp (rdtsc
+	where available) on the stack and, when it closes, writes one event with both
+	timestamps and an interned name into a lock-free single-producer ring owned by
+	its thread; Drain(), called by one collector thread, moves them out. Nothing is written outside the capture window between
+	StartCapture() and StopCapture(). Timestamps are converted to the reference
+	clock given to Initialize() at export, so zones line up with other traces.
+*/
+class CpuProfiler
+{
+public:
+	static constexpr uint32_t BufferCapacity = 1u << 16;
+	using ReferenceClock = int64_t(*)();
+
+	struct ThreadBuffer
+	{
+		alignas(64) std::atomic<uint64_t> Head{ 0 };
+		/* Producer's copy of Tail, refreshed only when the ring looks full. */
+		uint64_t CachedTail = 0;
+		alignas(64) std::atomic<uint64_t> Tail{ 0 };
+		std::atomic<uint64_t> Dropped{ 0 };
+		uint32_t Thread = 0;
+		CpuZoneEvent Events[BufferCapacity];
+	};
+
+	/* referenceClock defaults to steady_clock nanoseconds. */
+	static void Initialize(ReferenceClock referenceClock = nullptr, int64_t referenceFrequency = 0);
+
+	static uint32_t Intern(const char* name);
+	/* Names the calling thread's track in exported traces, and allocates its buffer if the thread has none yet. */
+	static void SetThreadName(const char* name);
+
+	static void StartCapture();
+	static void StopCapture();
+	static bool IsCapturing() { return sCapturing.load(std::memory_order_relaxed); }
+	/* Ticks per second of the reference clock exported traces are in. */
+	static int64_t ReferenceFrequency() { return GetState().ClockFrequency; }
+
+	/* Collector thread: moves every thread's pending events into the capture. */
+	static void Drain();
+	/* Drops everything captured so far. */
+	static void Clear();
+
+	/* Drains, then adds one track per thread, numbered from firstTrack. */
+	static void AppendTrace(ChromeTrace& trace, uint32_t firstTrack);
+	static CpuProfilerStats Stats();
+
+	/* Times zoneCount empty zones with and without a capture running, in batches the buffer can hold. */
+	static CpuProfilerOverhead MeasureOverhead(uint32_t zoneCount);
+
+	static uint64_t Now()
+	{
+#ifdef CPU_PROFILER_RDTSC
+		return __rdtsc();
+#else
+		return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	/* One thread-local lookup and one slot per zone. */
+	static void Record(uint32_t name, uint64_t beginTicks, uint64_t endTicks)
+	{
+		ThreadBuffer* buffer = tBuffer ? tBuffer : RegisterThread();
+		uint64_t head = buffer->Head.load(std::memory_order_relaxed);
+		if (head - buffer->CachedTail >= BufferCapacity)
+		{
+			buffer->CachedTail = buffer->Tail.load(std::memory_order_acquire);
+			if (head - buffer->CachedTail >= BufferCapacity)
+			{
+				buffer->Dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+		}
+
+		CpuZoneEvent& event = buffer->Events[head & (BufferCapacity - 1)];
+		event.BeginTicks = beginTicks;
+		event.EndTicks = endTicks;
+		event.Name = name;
+		buffer->Head.store(head + 1, std::memory_order_release);
+	}
+
+private:
+	struct State
+	{
+		std::mutex Lock;
+		std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+		std::vector<std::string> ThreadNames;
+		std::unordered_map<std::string, uint32_t> NameIds;
+		std::vector<std::string> Names;
+		/* Per thread, indexed like Buffers, so draining is a bulk copy of each ring. */
+		std::vector<std::vector<CpuZoneEvent>> Captured;
+
+		ReferenceClock Clock = nullptr;
+		int64_t ClockFrequency = 1000000000;
+		/* Two (timestamp, reference) pairs, far apart, define the conversion. */
+		uint64_t CalibrationTicks[2] = {};
+		int64_t CalibrationReference[2] = {};
+	};
+
+	static State& GetState();
+	static ThreadBuffer* RegisterThread();
+	static int64_t ReferenceNow();
+	static void Calibrate(uint32_t point);
+	static void DrainLocked(State& state);
+
+	static std::atomic<bool> sCapturing;
+	static thread_local ThreadBuffer* tBuffer;
+};
+
+/* Times the enclosing scope; recorded when it began while capturing, even if the capture stopped since. */
+class CpuZone
+{
+public:
+	explicit CpuZone(uint32_t name)
+		:
+		mName(name),
+		mBeginTicks(CpuProfiler::IsCapturing() ? CpuProfiler::Now() : 0)
+	{
+	}
+
+	~CpuZone()
+	{
+		if (mBeginTicks != 0)
+			CpuProfiler::Record(mName, mBeginTicks, CpuProfiler::Now());
+	}
+
+	CpuZone(const CpuZone&) = delete;
+	CpuZone& operator=(const CpuZone&) = delete;
+
+private:
+	uint32_t mName;
+	/* 0 when not capturing; neither rdtsc nor steady_clock reads 0 on a running system. */
+	uint64_t mBeginTicks;
+};
+
+#define CPU_ZONE_CONCAT_INNER(a, b) a##b
+#define CPU_ZONE_CONCAT(a, b) CPU_ZONE_CONCAT_INNER(a, b)
+
+#if CPU_PROFILER_ENABLED
+/* name is interned once per call site. */
+#define CPU_ZONE(name) \
+	static const uint32_t CPU_ZONE_CONCAT(cpuZoneName, __LINE__) = CpuProfiler::Intern(name); \
+	CpuZone CPU_ZONE_CONCAT(cpuZone, __LINE__)(CPU_ZONE_CONCAT(cpuZoneName, __LINE__))
+#define CPU_ZONE_FUNCTION() CPU_ZONE(__FUNCTION__)
+#else
+#define CPU_ZONE(name)
+#define CPU_ZONE_FUNCTION()
+#endif
@@ -0,0 +1,139 @@
+#include "DXAdapterSelector.h"
+
+#include <chrono>
+#include <iterator>
+
+using Microsoft::WRL::ComPtr;
+
+HRESULT DXAdapterSelector::Select(DXGI_FORMAT format, const AdapterRequirements& requirements, const char* cachePath)
+{
+	using Clock = std::chrono::steady_clock;
+
+	mAdapters.clear();
+	mInfos.clear();
+	mSelected = AdapterScoring::InvalidAdapter;
+	mProbed = 0;
+	mProbeMs = 0.0;
+
+	ComPtr<IDXGIFactory1> factory;
+	HRESULT hr = CreateDXGIFactory1(IID_PPV_ARGS(&factory));
+	if (FAILED(hr))
+		return hr;
+
+	AdapterCapsCache cache;
+	if (cachePath)
+		cache.Load(cachePath);
+
+	ComPtr<IDXGIAdapter1> adapter;
+	for (UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; i++)
+	{
+		DXGI_ADAPTER_DESC1 desc = {};
+		if (FAILED(adapter->GetDesc1(&desc)))
+			continue;
+
+		AdapterInfo info;
+		info.Luid = ((uint64_t)(uint32_t)desc.AdapterLuid.HighPart << 32) | desc.AdapterLuid.LowPart;
+		info.VendorId = desc.VendorId;
+		info.DeviceId = desc.DeviceId;
+		info.DedicatedVideoMemory = desc.DedicatedVideoMemory;
+		info.SharedSystemMemory = desc.SharedSystemMemory;
+		info.Software = (desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) != 0;
+		for (int c = 0; c < 127 && desc.Description[c] != 0; c++)
+			info.Name[c] = (char)desc.Description[c];
+
+		LARGE_INTEGER driverVersion = {};
+		if (SUCCEEDED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion)))
+			info.DriverVersion = (uint64_t)driverVersion.QuadPart;
+
+		if (const AdapterCaps* cached = cache.Find(info, (uint32_t)format))
+		{
+			info.Caps = *cached;
+		}
+		else
+		{
+			Clock::time_point begin = Clock::now();
+			Probe(adapter.Get(), format, info.Caps);
+			mProbeMs += std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+			mProbed++;
+			cache.Store(info, (uint32_t)format, info.Caps);
+		}
+		info.Probed = true;
+
+		mAdapters.push_back(adapter);
+		mInfos.push_back(info);
+	}
+
+	mCacheStats = cache.Stats();
+	if (cachePath && cache.IsDirty())
+		cache.Save(cachePath);
+
+	mSelected = AdapterScoring::Select(mInfos, requirements);
+	return mSelected != AdapterScoring::InvalidAdapter ? S_OK : E_FAIL;
+}
+
+void DXAdapterSelector::Probe(IDXGIAdapter1* adapter, DXGI_FORMAT format, AdapterCaps& caps)
+{
+	caps = {};
+
+	ComPtr<ID3D12Device> device;
+	if (FAILED(D3D12CreateDevice(adapter, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+		return;
+
+	const D3D_FEATURE_LEVEL levels[] =
+	{
+		D3D_FEATURE_LEVEL_11_0,
+		D3D_FEATURE_LEVEL_11_1,
+		D3D_FEATURE_LEVEL_12_0,
+		D3D_FEATURE_LEVEL_12_1,
+		D3D_FEATURE_LEVEL_12_2
+	};
+	D3D12_FEATURE_DATA_FEATURE_LEVELS featureLevels = {};
+	featureLevels.NumFeatureLevels = (UINT)std::size(levels);
+	featureLevels.pFeatureLevelsRequested = levels;
+	caps.MaxFeatureLevel = SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_FEATURE_LEVELS, &featureLevels, sizeof(featureLevels)))
+		? (uint32_t)featureLevels.MaxSupportedFeatureLevel : (uint32_t)D3D_FEATURE_LEVEL_11_0;
+
+	// Asks for the highest model this SDK knows; the runtime lowers it to what the driver supports.
+	D3D12_FEATURE_DATA_SHADER_MODEL shaderModel = { D3D_SHADER_MODEL_6_6 };
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel))))
+		caps.HighestShaderModel = (uint32_t)shaderModel.HighestShaderModel;
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+	{
+		caps.ResourceBindingTier = (uint32_t)options.ResourceBindingTier;
+		caps.ResourceHeapTier = (uint32_t)options.ResourceHeapTier;
+		caps.TiledResourcesTier = (uint32_t)options.TiledResourcesTier;
+		caps.ConservativeRasterizationTier = (uint32_t)options.ConservativeRasterizationTier;
+	}
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS1 options1 = {};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS1, &options1, sizeof(options1))))
+		caps.WaveOps = options1.WaveOps ? 1 : 0;
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS5 options5 = {};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS5, &options5, sizeof(options5))))
+		caps.RaytracingTier = options5.RaytracingTier == D3D12_RAYTRACING_TIER_NOT_SUPPORTED ? 0 : (uint32_t)options5.RaytracingTier;
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS6 options6 = {};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS6, &options6, sizeof(options6))))
+		caps.VariableShadingRateTier = (uint32_t)options6.VariableShadingRateTier;
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS7 options7 = {};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS7, &options7, sizeof(options7))))
+		caps.MeshShaderTier = options7.MeshShaderTier == D3D12_MESH_SHADER_TIER_NOT_SUPPORTED ? 0 : (uint32_t)options7.MeshShaderTier;
+
+	for (uint32_t bit = 0; bit <= 4; bit++)
+	{
+		D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS qLevels = {};
+		qLevels.Format = format;
+		qLevels.SampleCount = 1u << bit;
+		qLevels.Flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
+		if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS, &qLevels, sizeof(qLevels))) || qLevels.NumQualityLevels == 0)
+			continue;
+
+		caps.MsaaSampleCounts |= 1u << bit;
+		if (qLevels.SampleCount == 4)
+			caps.Msaa4xQualityLevels = qLevels.NumQualityLevels;
+	}
+}
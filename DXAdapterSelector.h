@@ -0,0 +1,39 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <dxgi1_5.h>
+#include <vector>
+#include "AdapterSelection.h"
+
+/*
+	Enumerates the DXGI adapters, probes each one's capabilities with a
+	throwaway device unless the cache file already holds them for this
+	driver, and picks the best scoring one.
+*/
+class DXAdapterSelector
+{
+public:
+	/* cachePath may be nullptr to always probe; E_FAIL if no adapter meets requirements. */
+	HRESULT Select(DXGI_FORMAT format, const AdapterRequirements& requirements, const char* cachePath);
+
+	IDXGIAdapter1* Adapter() const { return mSelected != AdapterScoring::InvalidAdapter ? mAdapters[mSelected].Get() : nullptr; }
+	const AdapterInfo& Selected() const { return mInfos[mSelected]; }
+	const std::vector<AdapterInfo>& Adapters() const { return mInfos; }
+
+	uint32_t ProbedCount() const { return mProbed; }
+	double ProbeMs() const { return mProbeMs; }
+	AdapterCacheStats CacheStats() const { return mCacheStats; }
+
+	/* Creates a device at the lowest feature level D3D12 takes and queries it; caps.MaxFeatureLevel stays 0 if that fails. */
+	static void Probe(IDXGIAdapter1* adapter, DXGI_FORMAT format, AdapterCaps& caps);
+
+private:
+	std::vector<Microsoft::WRL::ComPtr<IDXGIAdapter1>> mAdapters;
+	std::vector<AdapterInfo> mInfos;
+	uint32_t mSelected = AdapterScoring::InvalidAdapter;
+
+	uint32_t mProbed = 0;
+	double mProbeMs = 0.0;
+	AdapterCacheStats mCacheStats;
+};
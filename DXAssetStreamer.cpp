@@ -0,0 +1,222 @@
+#include "DXAssetStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "DXFrameSync.h"
+
+using Microsoft::WRL::ComPtr;
+
+HRESULT DXAssetStreamer::Initialize(DXQueueManager* queues, DXUploadRing* uploadRing, DXGpuMemoryAllocator* memory)
+{
+	mQueues = queues;
+	mUploadRing = uploadRing;
+	mMemory = memory;
+
+	mSink = [this](const StreamChunk& chunk) { return CopyChunk(chunk); };
+	mSubmit = [this] { return SubmitCopies(); };
+
+	// Requests are resident once the copy queue's fence passes their last upload.
+	mStreamer.Start(mQueues->Timeline().Sync(GpuQueueType::Copy));
+	return S_OK;
+}
+
+void DXAssetStreamer::Shutdown()
+{
+	mStreamer.Stop();
+	for (auto& buffer : mBuffers)
+		mMemory->Free(buffer.second);
+	mBuffers.clear();
+}
+
+uint64_t DXAssetStreamer::Request(const PackFile& pack, uint32_t entry, int32_t priority, Callback onResident)
+{
+	return mStreamer.Request(pack, entry, priority, [this, onResident = std::move(onResident)](uint64_t request, void*)
+	{
+		// Empty entries never reach the sink and come back without a buffer.
+		DXGpuAllocation buffer;
+		auto it = mBuffers.find(request);
+		if (it != mBuffers.end())
+		{
+			buffer = std::move(it->second);
+			mBuffers.erase(it);
+		}
+		if (onResident)
+			onResident(request, std::move(buffer));
+	});
+}
+
+HRESULT DXAssetStreamer::Pump(UINT64 byteBudget)
+{
+	// The sink would refuse a chunk that can never fit on every frame from now on.
+	if (byteBudget > mUploadRing->Stats().Capacity / 2)
+		return E_INVALIDARG;
+
+	mError = S_OK;
+	mStreamer.Pump(byteBudget, mSink, mSubmit);
+	return mError;
+}
+
+bool DXAssetStreamer::CopyChunk(const StreamChunk& chunk)
+{
+	if (FAILED(mError))
+		return false;
+
+	DXUploadAllocation upload = mUploadRing->TryAllocate(chunk.Size, 16);
+	if (!upload.IsValid())
+		return false;
+
+	DXGpuAllocation& buffer = mBuffers[chunk.Request];
+	if (!buffer.Resource)
+	{
+		D3D12_RESOURCE_DESC desc = {};
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		desc.Width = chunk.TotalSize;
+		desc.Height = 1;
+		desc.DepthOrArraySize = 1;
+		desc.MipLevels = 1;
+		desc.SampleDesc.Count = 1;
+		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+		// COMMON buffers are promoted to COPY_DEST by the copy and decay back once it completes.
+		mError = mMemory->CreateResource(desc, D3D12_RESOURCE_STATE_COMMON, nullptr, buffer);
+		if (FAILED(mError))
+		{
+			mBuffers.erase(chunk.Request);
+			return false;
+		}
+	}
+
+	if (!mCopyList)
+	{
+		mError = mQueues->BeginCommandList(GpuQueueType::Copy, &mCopyList);
+		if (FAILED(mError))
+			return false;
+	}
+
+	// The only CPU copy: mapped file pages straight into upload memory.
+	memcpy(upload.CpuAddress, chunk.Data, chunk.Size);
+	mCopyList->CopyBufferRegion(buffer.Resource.Get(), chunk.Offset, upload.Resource, upload.Offset, chunk.Size);
+	return true;
+}
+
+uint64_t DXAssetStreamer::SubmitCopies()
+{
+	GpuSyncPoint point = mQueues->Submit(GpuQueueType::Copy, mCopyList);
+	mCopyList = nullptr;
+
+	// The upload ring retires memory with the graphics fence, so that fence must not pass
+	// before the copies that read from the ring have finished.
+	mQueues->GpuWait(GpuQueueType::Graphics, point);
+	return point.Value;
+}
+
+StreamThroughputResult DXAssetStreamer::MeasureThroughput(ID3D12Device* device, const char* path, uint64_t totalBytes, uint64_t entrySize,
+	UINT64 uploadRingSize, UINT64 bytesPerFrame)
+{
+	using Clock = std::chrono::steady_clock;
+
+	StreamThroughputResult result = {};
+	bool written = totalBytes > 0;
+	if (written)
+	{
+		entrySize = std::max<uint64_t>(entrySize, 1);
+		uint32_t count = (uint32_t)std::max<uint64_t>(totalBytes / entrySize, 1);
+		std::vector<PackFile::Source> sources(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			sources[i].Name = "entry" + std::to_string(i);
+			sources[i].Data.resize(entrySize);
+			for (uint64_t b = 0; b < entrySize; b += 64)
+				sources[i].Data[b] = (uint8_t)(i + b);
+		}
+		if (!PackFile::Write(path, sources))
+			return result;
+	}
+
+	// Otherwise the pack just written, or read by whoever made it, streams from memory.
+	result.Cold = PackFile::EvictFromCache(path);
+
+	PackFile pack;
+	if (!pack.Open(path) || pack.EntryCount() == 0)
+	{
+		if (written)
+			std::remove(path);
+		return result;
+	}
+	uint32_t entryCount = pack.EntryCount();
+	uint64_t bytes = 0;
+	for (uint32_t i = 0; i < entryCount; i++)
+		bytes += pack.Entry(i).Size;
+
+	// The renderer's setup without a window: the graphics queue only runs the GPU waits on the copies and the frame fences.
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+	ComPtr<ID3D12CommandQueue> graphicsQueue;
+	DXFrameSync graphicsSync;
+	DXQueueManager queues;
+	DXUploadRing uploadRing;
+	DXGpuMemoryAllocator memory;
+	DXAssetStreamer streamer;
+	FrameRing<FrameContextBase> frames;
+
+	HRESULT hr = device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&graphicsQueue));
+	if (SUCCEEDED(hr))
+		hr = graphicsSync.Initialize(device, graphicsQueue.Get());
+	if (SUCCEEDED(hr))
+		hr = queues.Initialize(device, graphicsQueue.Get(), &graphicsSync);
+	if (SUCCEEDED(hr))
+		hr = uploadRing.Initialize(device, &graphicsSync, uploadRingSize);
+	if (SUCCEEDED(hr))
+		hr = memory.Initialize(device);
+	if (SUCCEEDED(hr))
+		hr = streamer.Initialize(&queues, &uploadRing, &memory);
+
+	if (SUCCEEDED(hr))
+	{
+		frames.Initialize(&graphicsSync, 3);
+
+		uint64_t resident = 0;
+		Clock::time_point begin = Clock::now();
+		for (uint32_t i = 0; i < entryCount; i++)
+		{
+			streamer.Request(pack, i, 0, [&](uint64_t, DXGpuAllocation&& buffer)
+			{
+				memory.Free(buffer);
+				resident++;
+			});
+		}
+
+		while (resident < entryCount && SUCCEEDED(hr))
+		{
+			frames.BeginFrame();
+			uploadRing.Retire();
+			hr = streamer.Pump(bytesPerFrame);
+			frames.EndFrame();
+			uploadRing.FinishFrame(graphicsSync.LastSignaledValue());
+			result.Frames++;
+		}
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+		if (SUCCEEDED(hr))
+		{
+			result.Requests = entryCount;
+			result.Bytes = bytes;
+			result.Ms = ms;
+			result.MBPerSecond = ms > 0.0 ? (double)bytes / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+			result.RequestsPerSecond = ms > 0.0 ? (double)entryCount / (ms / 1000.0) : 0.0;
+			result.SinkStalls = streamer.Stats().SinkStalls;
+		}
+
+		// Buffers still being uploaded after a failure are freed by Shutdown() once the queues are idle.
+		queues.WaitIdle();
+	}
+
+	streamer.Shutdown();
+	pack.Close();
+	if (written)
+		std::remove(path);
+	return result;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <functional>
+#include <unordered_map>
+#include "AssetStreamer.h"
+#include "DXQueueManager.h"
+#include "DXUploadRing.h"
+#include "DXGpuMemoryAllocator.h"
+
+struct StreamThroughputResult
+{
+	uint64_t Requests = 0;
+	uint64_t Bytes = 0;
+	/* Frames pumped until the last request was resident. */
+	uint64_t Frames = 0;
+	double Ms = 0.0;
+	double MBPerSecond = 0.0;
+	double RequestsPerSecond = 0.0;
+	/* Pump() calls cut short because the upload ring was full. */
+	uint64_t SinkStalls = 0;
+	/* False if the pack could not be dropped from the OS file cache, so it may have been read from memory. */
+	bool Cold = false;
+};
+
+/*
+	AssetStreamer that uploads pack entries into DEFAULT heap buffers on the COPY queue.
+	Each chunk is copied once, from the mapped file into the upload ring, and the
+	graphics queue waits on the copy on the GPU so the ring can retire the memory with
+	the frame's fence. Only buffers: textures would need their copyable footprints.
+*/
+class DXAssetStreamer
+{
+public:
+	/* Called from Pump() once the buffer holds the entry; the callee owns it from then on. */
+	using Callback = std::function<void(uint64_t request, DXGpuAllocation&& buffer)>;
+
+	HRESULT Initialize(DXQueueManager* queues, DXUploadRing* uploadRing, DXGpuMemoryAllocator* memory);
+	/* Stops the I/O thread and frees buffers still being uploaded. The caller flushes the queues first. */
+	void Shutdown();
+
+	/* Thread-safe. The pack has to stay open until the callback has run. */
+	uint64_t Request(const PackFile& pack, uint32_t entry, int32_t priority, Callback onResident);
+
+	/*
+		Render thread, between BeginFrame() and EndFrame(): uploads at most byteBudget bytes.
+		A chunk is up to byteBudget bytes and has to fit in the upload ring next to the frame's
+		other allocations, so a budget over half the ring fails with E_INVALIDARG.
+	*/
+	HRESULT Pump(UINT64 byteBudget);
+
+	bool IsIdle() { return mStreamer.IsIdle(); }
+	StreamStats Stats() { return mStreamer.Stats(); }
+
+	/*
+		Writes a pack of totalBytes in entrySize entries to path, or with totalBytes 0 uses the
+		pack already at path, drops it from the OS file cache and streams all of it into DEFAULT
+		heap buffers on device's copy queue, through an upload ring of uploadRingSize retired by
+		a graphics queue running empty frames, from request to the last buffer being resident.
+		A written pack is deleted afterwards.
+	*/
+	static StreamThroughputResult MeasureThroughput(ID3D12Device* device, const char* path, uint64_t totalBytes, uint64_t entrySize,
+		UINT64 uploadRingSize, UINT64 bytesPerFrame);
+
+private:
+	bool CopyChunk(const StreamChunk& chunk);
+	uint64_t SubmitCopies();
+
+	DXQueueManager* mQueues = nullptr;
+	DXUploadRing* mUploadRing = nullptr;
+	DXGpuMemoryAllocator* mMemory = nullptr;
+
+	AssetStreamer mStreamer;
+	AssetStreamer::Sink mSink;
+	AssetStreamer::Submit mSubmit;
+
+	// Render thread only.
+	std::unordered_map<uint64_t, DXGpuAllocation> mBuffers;
+	ID3D12GraphicsCommandList* mCopyList = nullptr;
+	HRESULT mError = S_OK;
+};
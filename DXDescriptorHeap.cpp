@@ -0,0 +1,132 @@
+#include "DXDescriptorHeap.h"
+
+#include <cassert>
+
+HRESULT DXDescriptorHeap::Initialize(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT capacity)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+	desc.Type = type;
+	desc.NumDescriptors = capacity;
+	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	desc.NodeMask = 0u;
+
+	HRESULT hr = device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&mHeap));
+	if (FAILED(hr))
+		return hr;
+
+	mCpuStart = mHeap->GetCPUDescriptorHandleForHeapStart();
+	mIncrement = device->GetDescriptorHandleIncrementSize(type);
+	mFreeList.Initialize(capacity);
+	return S_OK;
+}
+
+DXDescriptor DXDescriptorHeap::Allocate()
+{
+	DXDescriptor descriptor;
+	descriptor.Index = mFreeList.Allocate();
+	if (descriptor.IsValid())
+	{
+		descriptor.Cpu = CpuHandle(descriptor.Index);
+		descriptor.Count = 1;
+	}
+	return descriptor;
+}
+
+void DXDescriptorHeap::Free(DXDescriptor& descriptor)
+{
+	if (!descriptor.IsValid())
+		return;
+
+	mFreeList.Free(descriptor.Index);
+	descriptor = {};
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DXDescriptorHeap::CpuHandle(UINT index) const
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE handle = mCpuStart;
+	handle.ptr += (SIZE_T)index * mIncrement;
+	return handle;
+}
+
+HRESULT DXShaderVisibleHeap::Initialize(ID3D12Device* device, FrameSync* sync, UINT persistentCount, UINT ringCount)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+	desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	desc.NumDescriptors = persistentCount + ringCount;
+	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	desc.NodeMask = 0u;
+
+	HRESULT hr = device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&mHeap));
+	if (FAILED(hr))
+		return hr;
+
+	mDevice = device;
+	mCpuStart = mHeap->GetCPUDescriptorHandleForHeapStart();
+	mGpuStart = mHeap->GetGPUDescriptorHandleForHeapStart();
+	mIncrement = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	mRingStart = persistentCount;
+
+	mPersistent.Initialize(persistentCount);
+	mRing.Initialize(sync, ringCount, nullptr);
+	return S_OK;
+}
+
+DXDescriptor DXShaderVisibleHeap::AllocatePersistent()
+{
+	UINT index = mPersistent.Allocate();
+	if (index == DescriptorFreeList::InvalidIndex)
+		return {};
+	return At(index, 1);
+}
+
+void DXShaderVisibleHeap::FreePersistent(DXDescriptor& descriptor)
+{
+	if (!descriptor.IsValid())
+		return;
+
+	assert(descriptor.Index < mRingStart && "Not a persistent descriptor");
+	mPersistent.Free(descriptor.Index);
+	descriptor = {};
+}
+
+DXDescriptor DXShaderVisibleHeap::AllocateTable(UINT count)
+{
+	UploadAllocation allocation = mRing.Allocate(count, 1);
+	if (!allocation.IsValid())
+		return {};
+	return At(mRingStart + (UINT)allocation.Offset, count);
+}
+
+DXDescriptor DXShaderVisibleHeap::CopyTable(const D3D12_CPU_DESCRIPTOR_HANDLE* sources, UINT count)
+{
+	assert(count <= MaxCopyTableSize && "Table too large for CopyTable, split it");
+
+	DXDescriptor table = AllocateTable(count);
+	if (!table.IsValid())
+		return table;
+
+	UINT sourceSizes[MaxCopyTableSize];
+	for (UINT i = 0; i < count; i++)
+		sourceSizes[i] = 1;
+
+	mDevice->CopyDescriptors(1, &table.Cpu, &count, count, sources, sourceSizes, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	return table;
+}
+
+DXDescriptor DXShaderVisibleHeap::CopyTable(D3D12_CPU_DESCRIPTOR_HANDLE sourceStart, UINT count)
+{
+	DXDescriptor table = AllocateTable(count);
+	if (table.IsValid())
+		mDevice->CopyDescriptorsSimple(count, table.Cpu, sourceStart, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	return table;
+}
+
+DXDescriptor DXShaderVisibleHeap::At(UINT index, UINT count) const
+{
+	DXDescriptor descriptor;
+	descriptor.Index = index;
+	descriptor.Count = count;
+	descriptor.Cpu.ptr = mCpuStart.ptr + (SIZE_T)index * mIncrement;
+	descriptor.Gpu.ptr = mGpuStart.ptr + (UINT64)index * mIncrement;
+	return descriptor;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include "DescriptorAllocator.h"
+#include "UploadRing.h"
+
+struct DXDescriptor
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE Cpu = {};
+	/* Zero for CPU-only heaps. */
+	D3D12_GPU_DESCRIPTOR_HANDLE Gpu = {};
+	UINT Index = DescriptorFreeList::InvalidIndex;
+	/* Number of contiguous descriptors starting at Index. */
+	UINT Count = 0;
+
+	bool IsValid() const { return Index != DescriptorFreeList::InvalidIndex; }
+};
+
+/* CPU-only descriptor heap (RTV, DSV or CBV_SRV_UAV staging) with a free-list allocator. */
+class DXDescriptorHeap
+{
+public:
+	HRESULT Initialize(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT capacity);
+
+	DXDescriptor Allocate();
+	void Free(DXDescriptor& descriptor);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE CpuHandle(UINT index) const;
+
+	UINT Allocated() const { return mFreeList.Allocated(); }
+	UINT Capacity() const { return mFreeList.Capacity(); }
+	UINT HighWaterMark() const { return mFreeList.HighWaterMark(); }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mHeap;
+	D3D12_CPU_DESCRIPTOR_HANDLE mCpuStart = {};
+	UINT mIncrement = 0;
+	DescriptorFreeList mFreeList;
+};
+
+/*
+	The one shader-visible CBV_SRV_UAV heap, so SetDescriptorHeaps is called once per command list.
+	[0, persistentCount) holds long-lived descriptors handed out from a free list,
+	[persistentCount, persistentCount + ringCount) is a per-frame ring of contiguous
+	tables that are retired with the frame's fence value.
+*/
+class DXShaderVisibleHeap
+{
+public:
+	HRESULT Initialize(ID3D12Device* device, FrameSync* sync, UINT persistentCount, UINT ringCount);
+
+	DXDescriptor AllocatePersistent();
+	void FreePersistent(DXDescriptor& descriptor);
+
+	/* count contiguous descriptors that are valid until the current frame retires. */
+	DXDescriptor AllocateTable(UINT count);
+
+	/* Allocates a table and copies count CPU-only descriptors into it, in order. */
+	DXDescriptor CopyTable(const D3D12_CPU_DESCRIPTOR_HANDLE* sources, UINT count);
+
+	/* Copies a contiguous range of CPU-only descriptors into a new table with one CopyDescriptorsSimple. */
+	DXDescriptor CopyTable(D3D12_CPU_DESCRIPTOR_HANDLE sourceStart, UINT count);
+
+	void FinishFrame(UINT64 fenceValue) { mRing.FinishFrame(fenceValue); }
+	/* Reclaims the tables of every frame whose fence value has completed. */
+	void Retire() { mRing.Retire(); }
+
+	ID3D12DescriptorHeap* Heap() const { return mHeap.Get(); }
+	const UploadRingStats& RingStats() const { return mRing.Stats(); }
+	UINT PersistentAllocated() const { return mPersistent.Allocated(); }
+	UINT PersistentHighWaterMark() const { return mPersistent.HighWaterMark(); }
+
+private:
+	DXDescriptor At(UINT index, UINT count) const;
+
+	/* Largest table CopyTable(sources, count) accepts in one call. */
+	static constexpr UINT MaxCopyTableSize = 64;
+
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mHeap;
+	ID3D12Device* mDevice = nullptr;
+	D3D12_CPU_DESCRIPTOR_HANDLE mCpuStart = {};
+	D3D12_GPU_DESCRIPTOR_HANDLE mGpuStart = {};
+	UINT mIncrement = 0;
+	UINT mRingStart = 0;
+
+	DescriptorFreeList mPersistent;
+	/* Counts descriptors instead of bytes; alignment 1 keeps tables contiguous. */
+	UploadRing mRing;
+};
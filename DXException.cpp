@@ -1,35 +1,62 @@
 #include "DXException.h"
 
-#include <sstream>
 #include <format>
+#include <iterator>
+#include "DXUtil.h"
 
-#define HrToString(hr) #hr
+namespace
+{
+	/* Messages are copied here rather than into a malloc'd block per message; longer ones are only counted. */
+	constexpr SIZE_T MessageScratchSize = 4096;
+	alignas(D3D12_MESSAGE) thread_local uint8_t tMessageScratch[MessageScratchSize];
 
-DXException::DXException(ID3D12InfoQueue* d3d12InfoQueue, HRESULT hr, const char* fileName, const char* line, int number)
+	template<typename Fn>
+	void ForEachStoredMessage(ID3D12InfoQueue* infoQueue, Fn&& fn)
+	{
+		UINT64 messageCount = infoQueue->GetNumStoredMessages();
+		for (UINT64 i = 0; i < messageCount; i++)
+		{
+			SIZE_T messageLen = 0;
+			infoQueue->GetMessageW(i, nullptr, &messageLen);
+			if (messageLen == 0)
+				continue;
+
+			if (messageLen > MessageScratchSize)
+			{
+				fn(std::string_view("<info queue message too long to copy>"));
+				continue;
+			}
+
+			D3D12_MESSAGE* msg = (D3D12_MESSAGE*)tMessageScratch;
+			if (SUCCEEDED(infoQueue->GetMessageW(i, msg, &messageLen)) && msg->pDescription)
+				fn(std::string_view(msg->pDescription, msg->DescriptionByteLength > 0 ? msg->DescriptionByteLength - 1 : 0));
+		}
+	}
+}
+
+void CaptureFailure(ErrorCapture& errors, const ErrorSite& site, HRESULT hr, ID3D12InfoQueue* infoQueue)
 {
-	std::stringstream oss;
-	oss << "DXException: " << std::hex << "0x" << hr << "\n";
-	oss << "[FILE]: " << fileName << ":" << number << "\n\n";
-	oss << std::format("[CODE SECTION]: {}\n", line);
-	oss << "[ERROR]: ";
-
-	UINT64 messageCount = d3d12InfoQueue->GetNumStoredMessages();
-	for (UINT64 i = 0; i < messageCount; i++) {
-		SIZE_T messageLen = 0;
-		d3d12InfoQueue->GetMessageW(i, nullptr, &messageLen);
-		D3D12_MESSAGE* msg = (D3D12_MESSAGE*)malloc(messageLen);
-		d3d12InfoQueue->GetMessageW(i, msg, &messageLen);
-		if (messageLen > 0)
-			oss << msg->pDescription << "\n";
-		oss << msg->pDescription;
-		free((void*)msg);
+	bool reported = errors.HasErrors();
+	if (!errors.Begin(site, (int32_t)hr))
+		return;
+
+	if (infoQueue)
+	{
+		if (!reported)
+			ForEachStoredMessage(infoQueue, [&](std::string_view message) { errors.Append(message); });
+		infoQueue->ClearStoredMessages();
 	}
-	errorMessage = oss.str();
+	errors.End();
+}
+
+DXException::DXException(ID3D12InfoQueue* d3d12InfoQueue, HRESULT hr, const char* fileName, const char* line, int number)
+{
+	std::format_to(std::back_inserter(errorMessage), "DXException: 0x{:08X}\n[FILE]: {}:{}\n\n[CODE SECTION]: {}\n[ERROR]: ", (uint32_t)hr, fileName, number, line);
+	if (d3d12InfoQueue)
+		ForEachStoredMessage(d3d12InfoQueue, [&](std::string_view message) { errorMessage.append(message).push_back('\n'); });
 }
 
 DXException::DXException(const char* customTag, const char* message)
 {
-	std::stringstream oss;
-	oss << customTag << message;
-	errorMessage = oss.str();
+	errorMessage.append(customTag).append(message);
 }
@@ -0,0 +1,59 @@
+#include "DXFrameSync.h"
+
+#include <cassert>
+#include <format>
+#include "DXException.h"
+#include "Logger.h"
+
+DXFrameSync::~DXFrameSync()
+{
+	if (mEventHandle)
+		CloseHandle(mEventHandle);
+}
+
+HRESULT DXFrameSync::Initialize(ID3D12Device* device, ID3D12CommandQueue* queue)
+{
+	mQueue = queue;
+	mLastSignaled = 0;
+
+	HRESULT hr = device->CreateFence(0u, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence));
+	if (FAILED(hr))
+		return hr;
+
+	if (!mEventHandle)
+		mEventHandle = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+
+	return mEventHandle ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+}
+
+uint64_t DXFrameSync::Signal()
+{
+	HRESULT hr = mQueue->Signal(mFence.Get(), mLastSignaled + 1);
+	if (FAILED(hr))
+		throw DXException("[DXFrameSync]: ", std::format("Signal failed with 0x{:x}", (unsigned long)hr).c_str());
+
+	return ++mLastSignaled;
+}
+
+uint64_t DXFrameSync::CompletedValue() const
+{
+	return mFence->GetCompletedValue();
+}
+
+void DXFrameSync::WaitForValue(uint64_t value)
+{
+	// A value past the last signal would never complete.
+	assert(value <= mLastSignaled && "Waiting for a fence value that was never signaled");
+
+	if (mFence->GetCompletedValue() >= value)
+		return;
+
+	HRESULT hr = mFence->SetEventOnCompletion(value, mEventHandle);
+	if (FAILED(hr))
+		throw DXException("[DXFrameSync]: ", std::format("SetEventOnCompletion failed with 0x{:x}", (unsigned long)hr).c_str());
+
+	if (WaitForSingleObject(mEventHandle, INFINITE))
+	{
+		LOG_ERROR("Failure at waiting");
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include "FrameRing.h"
+
+/* FrameSync backed by a D3D12 command queue and fence. */
+class DXFrameSync : public FrameSync
+{
+public:
+	DXFrameSync() = default;
+	~DXFrameSync();
+
+	DXFrameSync(const DXFrameSync&) = delete;
+	DXFrameSync& operator=(const DXFrameSync&) = delete;
+
+	HRESULT Initialize(ID3D12Device* device, ID3D12CommandQueue* queue);
+
+	uint64_t Signal() override;
+	uint64_t CompletedValue() const override;
+	uint64_t LastSignaledValue() const override { return mLastSignaled; }
+	void WaitForValue(uint64_t value) override;
+
+	ID3D12Fence* Fence() const { return mFence.Get(); }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+	ID3D12CommandQueue* mQueue = nullptr;
+	HANDLE mEventHandle = nullptr;
+	uint64_t mLastSignaled = 0;
+};
@@ -0,0 +1,88 @@
+#include "DXGpuBreadcrumbs.h"
+
+HRESULT DXGpuBreadcrumbs::Initialize(ID3D12Device* device)
+{
+	D3D12_HEAP_PROPERTIES hProps = {};
+	hProps.Type = D3D12_HEAP_TYPE_READBACK;
+
+	D3D12_RESOURCE_DESC bufferDesc = {};
+	bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	bufferDesc.Width = (UINT64)GpuBreadcrumbs::Capacity * GpuBreadcrumbs::SlotValues * sizeof(uint32_t);
+	bufferDesc.Height = 1;
+	bufferDesc.DepthOrArraySize = 1;
+	bufferDesc.MipLevels = 1;
+	bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+	bufferDesc.SampleDesc.Count = 1;
+	bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	// WriteBufferImmediate needs COPY_DEST, the only state a READBACK buffer has.
+	HRESULT hr = device->CreateCommittedResource(
+		&hProps,
+		D3D12_HEAP_FLAG_NONE,
+		&bufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&mBuffer)
+	);
+	if (FAILED(hr))
+		return hr;
+
+	void* data = nullptr;
+	hr = mBuffer->Map(0, nullptr, &data);
+	if (FAILED(hr))
+		return hr;
+
+	mValues = (const uint32_t*)data;
+	mAddress = mBuffer->GetGPUVirtualAddress();
+	return S_OK;
+}
+
+void DXGpuBreadcrumbs::BeginSubmission(ID3D12GraphicsCommandList* cmdList, const char* name, uint64_t frame)
+{
+	mSlot = mBreadcrumbs.BeginSubmission(name, frame);
+	Write(cmdList, GpuBreadcrumbs::StartedValue, 0, D3D12_WRITEBUFFERIMMEDIATE_MODE_DEFAULT);
+	Write(cmdList, GpuBreadcrumbs::FinishedValue, 0, D3D12_WRITEBUFFERIMMEDIATE_MODE_DEFAULT);
+}
+
+void DXGpuBreadcrumbs::BeginMarker(ID3D12GraphicsCommandList* cmdList, const char* name)
+{
+	uint32_t value = mBreadcrumbs.BeginMarker(name);
+	if (value != 0)
+		Write(cmdList, GpuBreadcrumbs::StartedValue, value, D3D12_WRITEBUFFERIMMEDIATE_MODE_MARKER_IN);
+}
+
+void DXGpuBreadcrumbs::EndMarker(ID3D12GraphicsCommandList* cmdList)
+{
+	uint32_t value = mBreadcrumbs.EndMarker();
+	if (value != 0)
+		Write(cmdList, GpuBreadcrumbs::FinishedValue, value, D3D12_WRITEBUFFERIMMEDIATE_MODE_MARKER_OUT);
+}
+
+std::string DXGpuBreadcrumbs::Report() const
+{
+	if (!mValues)
+		return "GPU breadcrumbs: not initialized\n";
+
+	// The mapped values are read as the GPU left them; nothing else is written to the buffer after a removal.
+	return GpuBreadcrumbs::Format(mBreadcrumbs.Correlate(mValues), mBreadcrumbs.CompletedValue());
+}
+
+void DXGpuBreadcrumbs::Write(ID3D12GraphicsCommandList* cmdList, uint32_t valueIndex, uint32_t value, D3D12_WRITEBUFFERIMMEDIATE_MODE mode)
+{
+	if (!mBuffer)
+		return;
+
+	if (cmdList != mLastList)
+	{
+		mLastList = cmdList;
+		mLastList2.Reset();
+		cmdList->QueryInterface(IID_PPV_ARGS(&mLastList2));
+	}
+	if (!mLastList2)
+		return;
+
+	D3D12_WRITEBUFFERIMMEDIATE_PARAMETER parameter = {};
+	parameter.Dest = mAddress + ((UINT64)mSlot * GpuBreadcrumbs::SlotValues + valueIndex) * sizeof(uint32_t);
+	parameter.Value = value;
+	mLastList2->WriteBufferImmediate(1, &parameter, &mode);
+}
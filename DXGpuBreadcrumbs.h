@@ -0,0 +1,46 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <string>
+#include "GpuBreadcrumbs.h"
+
+/*
+	GpuBreadcrumbs over a persistently mapped READBACK buffer. Markers are
+	WriteBufferImmediate calls: MARKER_IN for a begin, written when the GPU
+	starts on it, MARKER_OUT for an end, written once the work before it is
+	done. The buffer lives in system memory, so it stays readable after the
+	device is removed. Lists without ID3D12GraphicsCommandList2 get no markers.
+*/
+class DXGpuBreadcrumbs
+{
+public:
+	HRESULT Initialize(ID3D12Device* device);
+
+	/* The first list of a submission; resets the submission's slot before any marker. */
+	void BeginSubmission(ID3D12GraphicsCommandList* cmdList, const char* name, uint64_t frame);
+	/* name must be a string literal or otherwise outlive the submission. */
+	void BeginMarker(ID3D12GraphicsCommandList* cmdList, const char* name);
+	void EndMarker(ID3D12GraphicsCommandList* cmdList);
+	void Submit(uint64_t fenceValue) { mBreadcrumbs.Submit(fenceValue); }
+	void SetCompletedValue(uint64_t completed) { mBreadcrumbs.SetCompletedValue(completed); }
+
+	/* Where every submission the GPU never finished stopped. */
+	std::string Report() const;
+
+	const GpuBreadcrumbs& Breadcrumbs() const { return mBreadcrumbs; }
+
+private:
+	void Write(ID3D12GraphicsCommandList* cmdList, uint32_t valueIndex, uint32_t value, D3D12_WRITEBUFFERIMMEDIATE_MODE mode);
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> mBuffer;
+	const uint32_t* mValues = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS mAddress = 0;
+	uint32_t mSlot = 0;
+
+	/* The last list asked for, so QueryInterface runs once per list and submission, not per marker. */
+	ID3D12GraphicsCommandList* mLastList = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> mLastList2;
+
+	GpuBreadcrumbs mBreadcrumbs;
+};
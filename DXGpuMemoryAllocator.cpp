@@ -0,0 +1,110 @@
+#include "DXGpuMemoryAllocator.h"
+
+HRESULT DXGpuMemoryAllocator::Initialize(ID3D12Device* device, UINT64 heapSize)
+{
+	mDevice = device;
+	mAllocator = std::make_unique<GpuMemoryAllocator>(*this, heapSize);
+	return S_OK;
+}
+
+HRESULT DXGpuMemoryAllocator::CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+	const D3D12_CLEAR_VALUE* clearValue, DXGpuAllocation& allocation)
+{
+	// Size and alignment tier (4 KB, 64 KB or 4 MB) as the driver lays the resource out.
+	D3D12_RESOURCE_ALLOCATION_INFO info = mDevice->GetResourceAllocationInfo(0, 1, &desc);
+	if (info.SizeInBytes == UINT64_MAX)
+		return E_INVALIDARG;
+
+	mLastHeapResult = S_OK;
+	GpuAllocation range = mAllocator->Allocate(KindOf(desc), info.SizeInBytes, info.Alignment);
+	if (!range.IsValid())
+		return FAILED(mLastHeapResult) ? mLastHeapResult : E_OUTOFMEMORY;
+
+	HRESULT hr = mDevice->CreatePlacedResource(
+		mHeaps[range.HeapId].Get(),
+		range.Offset,
+		&desc,
+		initialState,
+		clearValue,
+		IID_PPV_ARGS(&allocation.Resource)
+	);
+	if (FAILED(hr))
+	{
+		mAllocator->Free(range);
+		return hr;
+	}
+
+	allocation.Range = range;
+	return S_OK;
+}
+
+void DXGpuMemoryAllocator::Free(DXGpuAllocation& allocation)
+{
+	allocation.Resource.Reset();
+	if (mAllocator)
+		mAllocator->Free(allocation.Range);
+}
+
+HRESULT DXGpuMemoryAllocator::AllocateRange(GpuHeapKind kind, UINT64 size, UINT64 alignment, GpuAllocation& range)
+{
+	mLastHeapResult = S_OK;
+	range = mAllocator->Allocate(kind, size, alignment);
+	if (!range.IsValid())
+		return FAILED(mLastHeapResult) ? mLastHeapResult : E_OUTOFMEMORY;
+	return S_OK;
+}
+
+ID3D12Heap* DXGpuMemoryAllocator::Heap(const GpuAllocation& range) const
+{
+	auto it = mHeaps.find(range.HeapId);
+	return it != mHeaps.end() ? it->second.Get() : nullptr;
+}
+
+GpuHeapKind DXGpuMemoryAllocator::KindOf(const D3D12_RESOURCE_DESC& desc)
+{
+	if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		return GpuHeapKind::Buffers;
+	if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+		return GpuHeapKind::RenderTargets;
+	return GpuHeapKind::Textures;
+}
+
+bool DXGpuMemoryAllocator::CreateHeap(GpuHeapKind kind, uint64_t size, uint32_t heapId)
+{
+	D3D12_HEAP_DESC desc = {};
+	desc.SizeInBytes = size;
+	desc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+	desc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	desc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	desc.Properties.CreationNodeMask = 0u;
+	desc.Properties.VisibleNodeMask = 0u;
+
+	switch (kind)
+	{
+	case GpuHeapKind::Buffers:
+		desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		break;
+	case GpuHeapKind::RenderTargets:
+		desc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+		desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+		break;
+	default:
+		desc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+		desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+		break;
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+	mLastHeapResult = mDevice->CreateHeap(&desc, IID_PPV_ARGS(&heap));
+	if (FAILED(mLastHeapResult))
+		return false;
+
+	mHeaps[heapId] = heap;
+	return true;
+}
+
+void DXGpuMemoryAllocator::DestroyHeap(uint32_t heapId)
+{
+	mHeaps.erase(heapId);
+}
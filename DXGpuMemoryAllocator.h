@@ -0,0 +1,47 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <memory>
+#include <unordered_map>
+#include "GpuMemoryAllocator.h"
+
+struct DXGpuAllocation
+{
+	Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+	GpuAllocation Range;
+};
+
+/* Placed resources in DEFAULT heaps, suballocated by a GpuMemoryAllocator. */
+class DXGpuMemoryAllocator : private GpuHeapProvider
+{
+public:
+	static constexpr UINT64 DefaultHeapSize = 64ull * 1024 * 1024;
+
+	HRESULT Initialize(ID3D12Device* device, UINT64 heapSize = DefaultHeapSize);
+
+	HRESULT CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+		const D3D12_CLEAR_VALUE* clearValue, DXGpuAllocation& allocation);
+
+	/* Releases the resource and its memory. The GPU must be done with it. */
+	void Free(DXGpuAllocation& allocation);
+
+	/* Raw memory for resources the caller places itself, e.g. aliased transients. */
+	HRESULT AllocateRange(GpuHeapKind kind, UINT64 size, UINT64 alignment, GpuAllocation& range);
+	void FreeRange(GpuAllocation& range) { mAllocator->Free(range); }
+	ID3D12Heap* Heap(const GpuAllocation& range) const;
+
+	GpuMemoryStats Stats(GpuHeapKind kind) const { return mAllocator->Stats(kind); }
+	GpuMemoryStats TotalStats() const { return mAllocator->TotalStats(); }
+
+private:
+	static GpuHeapKind KindOf(const D3D12_RESOURCE_DESC& desc);
+
+	bool CreateHeap(GpuHeapKind kind, uint64_t size, uint32_t heapId) override;
+	void DestroyHeap(uint32_t heapId) override;
+
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	std::unordered_map<uint32_t, Microsoft::WRL::ComPtr<ID3D12Heap>> mHeaps;
+	std::unique_ptr<GpuMemoryAllocator> mAllocator;
+	HRESULT mLastHeapResult = S_OK;
+};
@@ -0,0 +1,111 @@
+#include "DXGpuProfiler.h"
+
+HRESULT DXGpuProfiler::Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, uint32_t frameSlots, int64_t cpuFrequency)
+{
+	mQueue = queue;
+	mProfiler.Initialize(frameSlots, cpuFrequency);
+
+	const UINT queryCount = frameSlots * GpuProfiler::QueriesPerFrame;
+
+	D3D12_QUERY_HEAP_DESC heapDesc = {};
+	heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	heapDesc.Count = queryCount;
+	HRESULT hr = device->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&mQueryHeap));
+	if (FAILED(hr))
+		return hr;
+
+	D3D12_HEAP_PROPERTIES hProps = {};
+	hProps.Type = D3D12_HEAP_TYPE_READBACK;
+
+	D3D12_RESOURCE_DESC bufferDesc = {};
+	bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	bufferDesc.Width = (UINT64)queryCount * sizeof(uint64_t);
+	bufferDesc.Height = 1;
+	bufferDesc.DepthOrArraySize = 1;
+	bufferDesc.MipLevels = 1;
+	bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+	bufferDesc.SampleDesc.Count = 1;
+	bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	hr = device->CreateCommittedResource(
+		&hProps,
+		D3D12_HEAP_FLAG_NONE,
+		&bufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&mReadback)
+	);
+	if (FAILED(hr))
+		return hr;
+
+	UINT64 frequency = 0;
+	hr = mQueue->GetTimestampFrequency(&frequency);
+	if (FAILED(hr))
+		return hr;
+
+	mCalibration.GpuFrequency = frequency;
+	mCalibration.CpuFrequency = cpuFrequency;
+	Calibrate();
+	return S_OK;
+}
+
+void DXGpuProfiler::BeginFrame(uint32_t slot, uint64_t frame)
+{
+	if (mProfiler.HasPendingFrame(slot))
+	{
+		UINT64 first = mProfiler.SlotFirstQuery(slot);
+		D3D12_RANGE readRange = { first * sizeof(uint64_t), (first + mProfiler.UsedQueries(slot)) * sizeof(uint64_t) };
+		void* data = nullptr;
+		if (SUCCEEDED(mReadback->Map(0, &readRange, &data)))
+		{
+			// Once per frame keeps CPU and GPU clock drift out of the trace.
+			Calibrate();
+			mProfiler.Collect(slot, (const uint64_t*)data + first, mCalibration);
+
+			D3D12_RANGE writeRange = { 0, 0 };
+			mReadback->Unmap(0, &writeRange);
+		}
+		else
+		{
+			mProfiler.Drop(slot);
+		}
+	}
+
+	mProfiler.BeginFrame(slot, frame);
+}
+
+void DXGpuProfiler::BeginScope(ID3D12GraphicsCommandList* cmdList, const char* name)
+{
+	uint32_t query = mProfiler.BeginScope(name);
+	if (query != GpuProfiler::InvalidQuery)
+		cmdList->EndQuery(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+}
+
+void DXGpuProfiler::EndScope(ID3D12GraphicsCommandList* cmdList)
+{
+	uint32_t query = mProfiler.EndScope();
+	if (query != GpuProfiler::InvalidQuery)
+		cmdList->EndQuery(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+}
+
+void DXGpuProfiler::EndFrame(ID3D12GraphicsCommandList* cmdList)
+{
+	uint32_t slot = mProfiler.CurrentSlot();
+	uint32_t count = mProfiler.UsedQueries(slot);
+	if (count == 0)
+		return;
+
+	uint32_t first = mProfiler.SlotFirstQuery(slot);
+	cmdList->ResolveQueryData(mQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, first, count, mReadback.Get(), (UINT64)first * sizeof(uint64_t));
+}
+
+void DXGpuProfiler::Calibrate()
+{
+	UINT64 gpuTimestamp = 0;
+	UINT64 cpuTicks = 0;
+	if (SUCCEEDED(mQueue->GetClockCalibration(&gpuTimestamp, &cpuTicks)))
+	{
+		mCalibration.GpuTimestamp = gpuTimestamp;
+		mCalibration.CpuTicks = (int64_t)cpuTicks;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include "GpuProfiler.h"
+
+/*
+	GpuProfiler over a TIMESTAMP query heap and a READBACK buffer, both split into one
+	region per frame slot. EndFrame() resolves the slot's queries on the GPU; the next
+	BeginFrame() on the same slot, which the frame ring only reaches once the GPU has
+	retired it, reads them back without waiting. Only for DIRECT and COMPUTE lists:
+	copy queue timestamps need their own heap type.
+*/
+class DXGpuProfiler
+{
+public:
+	HRESULT Initialize(ID3D12Device* device, ID3D12CommandQueue* queue, uint32_t frameSlots, int64_t cpuFrequency);
+
+	/* slot must be retired by the GPU; its previous frame is collected here. */
+	void BeginFrame(uint32_t slot, uint64_t frame);
+	void BeginScope(ID3D12GraphicsCommandList* cmdList, const char* name);
+	void EndScope(ID3D12GraphicsCommandList* cmdList);
+	/* Records the resolve into cmdList, which must be the last list of the frame to execute. */
+	void EndFrame(ID3D12GraphicsCommandList* cmdList);
+
+	GpuProfiler& Profiler() { return mProfiler; }
+	const GpuProfiler& Profiler() const { return mProfiler; }
+
+private:
+	void Calibrate();
+
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap> mQueryHeap;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mReadback;
+	ID3D12CommandQueue* mQueue = nullptr;
+	GpuClockCalibration mCalibration;
+	GpuProfiler mProfiler;
+};
+
+/* Times the enclosing block on cmdList. */
+class DXGpuProfileScope
+{
+public:
+	DXGpuProfileScope(DXGpuProfiler& profiler, ID3D12GraphicsCommandList* cmdList, const char* name)
+		:
+		mProfiler(profiler),
+		mCmdList(cmdList)
+	{
+		mProfiler.BeginScope(mCmdList, name);
+	}
+
+	~DXGpuProfileScope() { mProfiler.EndScope(mCmdList); }
+
+	DXGpuProfileScope(const DXGpuProfileScope&) = delete;
+	DXGpuProfileScope& operator=(const DXGpuProfileScope&) = delete;
+
+private:
+	DXGpuProfiler& mProfiler;
+	ID3D12GraphicsCommandList* mCmdList;
+};
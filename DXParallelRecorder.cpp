@@ -0,0 +1,121 @@
+#include "DXParallelRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+
+HRESULT DXParallelRecorder::Initialize(ID3D12Device* device, JobSystem* jobs, uint32_t frameCount)
+{
+	mJobs = jobs;
+	uint32_t threadCount = std::clamp(jobs->ThreadCount(), 1u, MaxThreads);
+
+	mThreads.clear();
+	mThreads.resize(threadCount);
+	mLists.clear();
+
+	for (ThreadContext& thread : mThreads)
+	{
+		for (uint32_t i = 0; i < frameCount; i++)
+		{
+			HRESULT hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&thread.CmdAllocators[i]));
+			if (FAILED(hr))
+				return hr;
+		}
+
+		HRESULT hr = device->CreateCommandList(0u, D3D12_COMMAND_LIST_TYPE_DIRECT, thread.CmdAllocators[0].Get(), nullptr, IID_PPV_ARGS(&thread.CmdList));
+		if (FAILED(hr))
+			return hr;
+
+		hr = thread.CmdList->Close();
+		if (FAILED(hr))
+			return hr;
+
+		mLists.push_back(thread.CmdList.Get());
+	}
+
+	return S_OK;
+}
+
+HRESULT DXParallelRecorder::Record(uint32_t frameIndex, const RecordChunk& recordChunk)
+{
+	uint32_t chunkCount = ChunkCount();
+
+	mJobs->ParallelFor(chunkCount, 1, [&](uint32_t chunk)
+	{
+		ThreadContext& thread = mThreads[chunk];
+		ID3D12CommandAllocator* allocator = thread.CmdAllocators[frameIndex].Get();
+
+		thread.Result = allocator->Reset();
+		if (SUCCEEDED(thread.Result))
+			thread.Result = thread.CmdList->Reset(allocator, nullptr);
+		if (FAILED(thread.Result))
+			return;
+
+		recordChunk(thread.CmdList.Get(), chunk, chunkCount);
+
+		thread.Result = thread.CmdList->Close();
+	});
+
+	for (const ThreadContext& thread : mThreads)
+	{
+		if (FAILED(thread.Result))
+			return thread.Result;
+	}
+	return S_OK;
+}
+
+std::vector<RecordScalingResult> DXParallelRecorder::MeasureRecording(ID3D12Device* device, uint32_t drawCount, uint32_t maxThreads, uint32_t iterations)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<RecordScalingResult> results;
+	maxThreads = std::clamp(maxThreads, 1u, MaxThreads);
+	iterations = std::max(iterations, 1u);
+
+	D3D12_VIEWPORT viewport = { 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+	D3D12_RECT scissor = { 0, 0, 1280, 720 };
+
+	for (uint32_t threads = 1; threads <= maxThreads; threads++)
+	{
+		JobSystem jobs(threads);
+		DXParallelRecorder recorder;
+		if (FAILED(recorder.Initialize(device, &jobs, 1)))
+			break;
+
+		auto recordChunk = [&](ID3D12GraphicsCommandList* cmdList, uint32_t chunk, uint32_t chunkCount)
+		{
+			uint32_t begin = (uint32_t)((uint64_t)drawCount * chunk / chunkCount);
+			uint32_t end = (uint32_t)((uint64_t)drawCount * (chunk + 1) / chunkCount);
+
+			cmdList->RSSetViewports(1, &viewport);
+			cmdList->RSSetScissorRects(1, &scissor);
+			cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			for (uint32_t draw = begin; draw < end; draw++)
+				cmdList->DrawInstanced(36, 1, 0, draw);
+		};
+
+		// Warm up so allocator growth and thread wake-up are not part of the measurement.
+		if (FAILED(recorder.Record(0, recordChunk)))
+			break;
+
+		RecordScalingResult result = {};
+		result.Threads = recorder.ChunkCount();
+		result.MinMs = 1e30;
+
+		double sum = 0.0;
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			Clock::time_point begin = Clock::now();
+			recorder.Record(0, recordChunk);
+			double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+			sum += ms;
+			result.MinMs = std::min(result.MinMs, ms);
+		}
+
+		result.MeanMs = sum / (double)iterations;
+		result.Speedup = results.empty() ? 1.0 : results.front().MeanMs / result.MeanMs;
+		results.push_back(result);
+	}
+
+	return results;
+}
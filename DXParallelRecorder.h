@@ -0,0 +1,59 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <functional>
+#include <vector>
+#include "FrameRing.h"
+#include "JobSystem.h"
+
+struct RecordScalingResult
+{
+	uint32_t Threads = 0;
+	double MeanMs = 0.0;
+	double MinMs = 0.0;
+	/* MeanMs of the single-threaded run divided by MeanMs. */
+	double Speedup = 0.0;
+};
+
+/*
+	Records one chunk of scene work per job system thread, each chunk into its own
+	command list with its own per-frame allocator. A chunk is recorded by exactly
+	one job, so no two threads ever touch the same list or allocator.
+	CommandLists() returns the lists in chunk order so the submission order does
+	not depend on which thread finished first.
+*/
+class DXParallelRecorder
+{
+public:
+	static constexpr uint32_t MaxThreads = 16;
+
+	using RecordChunk = std::function<void(ID3D12GraphicsCommandList* cmdList, uint32_t chunk, uint32_t chunkCount)>;
+
+	/* One chunk per job system thread, capped at MaxThreads. */
+	HRESULT Initialize(ID3D12Device* device, JobSystem* jobs, uint32_t frameCount);
+
+	/* Resets frameIndex's allocators and records every chunk. Lists are closed on return. */
+	HRESULT Record(uint32_t frameIndex, const RecordChunk& recordChunk);
+
+	uint32_t ChunkCount() const { return (uint32_t)mThreads.size(); }
+	ID3D12CommandList* const* CommandLists() const { return mLists.data(); }
+
+	/*
+		Records drawCount draws through a recorder on device, split into one chunk per
+		thread, for every thread count from 1 to maxThreads. Nothing is executed.
+	*/
+	static std::vector<RecordScalingResult> MeasureRecording(ID3D12Device* device, uint32_t drawCount, uint32_t maxThreads, uint32_t iterations);
+
+private:
+	struct ThreadContext
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdAllocators[FrameRing<FrameContextBase>::MaxFrames];
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> CmdList;
+		HRESULT Result = S_OK;
+	};
+
+	JobSystem* mJobs = nullptr;
+	std::vector<ThreadContext> mThreads;
+	std::vector<ID3D12CommandList*> mLists;
+};
@@ -0,0 +1,519 @@
+#include "DXPipelineCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+#include <type_traits>
+
+using namespace Microsoft::WRL;
+
+namespace
+{
+	/* FNV-1a over every field, so padding and pointer values never reach the key. */
+	struct Hasher
+	{
+		uint64_t Value = 14695981039346656037ull;
+
+		void Bytes(const void* data, size_t size)
+		{
+			const uint8_t* bytes = (const uint8_t*)data;
+			for (size_t i = 0; i < size; i++)
+			{
+				Value ^= bytes[i];
+				Value *= 1099511628211ull;
+			}
+		}
+
+		template<typename T>
+		void Add(T value)
+		{
+			static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Hash fields one by one");
+			Bytes(&value, sizeof(value));
+		}
+
+		void String(const char* str)
+		{
+			Add(str ? (uint64_t)strlen(str) : ~0ull);
+			if (str)
+				Bytes(str, strlen(str));
+		}
+
+		void Shader(const D3D12_SHADER_BYTECODE& code)
+		{
+			Add((uint64_t)code.BytecodeLength);
+			Bytes(code.pShaderBytecode, code.BytecodeLength);
+		}
+	};
+
+	void CopyShader(D3D12_SHADER_BYTECODE& code, std::vector<uint8_t>& storage)
+	{
+		const uint8_t* bytes = (const uint8_t*)code.pShaderBytecode;
+		storage.assign(bytes, bytes + (bytes ? code.BytecodeLength : 0));
+		code.pShaderBytecode = storage.empty() ? nullptr : storage.data();
+		code.BytecodeLength = storage.size();
+	}
+}
+
+DXPipelineCache::~DXPipelineCache()
+{
+	Shutdown();
+}
+
+HRESULT DXPipelineCache::Initialize(ID3D12Device* device, const char* path, uint32_t compileThreads)
+{
+	Shutdown();
+
+	mDevice = device;
+	mPath = path;
+	mEntries = std::make_unique<Entry[]>(MaxPipelines);
+	mStats = {};
+	mFallbackUses = 0;
+
+	// Pipeline libraries need ID3D12Device1 and driver support; without them every run compiles.
+	D3D12_FEATURE_DATA_SHADER_CACHE shaderCache = {};
+	ComPtr<ID3D12Device1> device1;
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_SHADER_CACHE, &shaderCache, sizeof(shaderCache))) &&
+		(shaderCache.SupportFlags & D3D12_SHADER_CACHE_SUPPORT_LIBRARY) &&
+		SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(&device1))))
+	{
+		std::ifstream file(mPath, std::ios::binary);
+		FileHeader header = {};
+		if (file.read((char*)&header, sizeof(header)) &&
+			header.Magic == FileHeader::MagicValue && header.Version == FileHeader::CurrentVersion)
+		{
+			mLibraryBlob.resize((size_t)header.BlobSize);
+			if (!file.read((char*)mLibraryBlob.data(), (std::streamsize)mLibraryBlob.size()))
+				mLibraryBlob.clear();
+		}
+
+		HRESULT hr = E_FAIL;
+		if (!mLibraryBlob.empty())
+			hr = device1->CreatePipelineLibrary(mLibraryBlob.data(), mLibraryBlob.size(), IID_PPV_ARGS(&mLibrary));
+
+		// A blob from another driver version or adapter is rejected; start with an empty library.
+		if (FAILED(hr))
+		{
+			mLibraryBlob.clear();
+			hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&mLibrary));
+			if (FAILED(hr))
+				return hr;
+		}
+	}
+
+	mQuit = false;
+	for (uint32_t i = 0; i < std::max(compileThreads, 1u); i++)
+		mThreads.emplace_back(&DXPipelineCache::CompileMain, this);
+	return S_OK;
+}
+
+void DXPipelineCache::Shutdown()
+{
+	StopThreads();
+
+	if (mLibraryDirty)
+		Save();
+
+	mEntries.reset();
+	mEntryCount = 0;
+	mKeys.clear();
+	mRootSignatures.clear();
+	mLibrary.Reset();
+	mLibraryBlob.clear();
+	mDevice.Reset();
+}
+
+HRESULT DXPipelineCache::Save()
+{
+	if (!mLibrary)
+		return S_FALSE;
+
+	WaitIdle();
+
+	std::vector<uint8_t> blob(mLibrary->GetSerializedSize());
+	HRESULT hr = mLibrary->Serialize(blob.data(), blob.size());
+	if (FAILED(hr))
+		return hr;
+
+	std::ofstream file(mPath, std::ios::binary | std::ios::trunc);
+	FileHeader header = { FileHeader::MagicValue, FileHeader::CurrentVersion, blob.size() };
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)blob.data(), (std::streamsize)blob.size());
+	if (!file)
+		return E_FAIL;
+
+	mLibraryDirty = false;
+	return S_OK;
+}
+
+HRESULT DXPipelineCache::CreateRootSignature(const void* blob, SIZE_T size, ID3D12RootSignature** rootSignature)
+{
+	HRESULT hr = mDevice->CreateRootSignature(0, blob, size, IID_PPV_ARGS(rootSignature));
+	if (FAILED(hr))
+		return hr;
+
+	Hasher hasher;
+	hasher.Bytes(blob, size);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mRootSignatures[*rootSignature] = hasher.Value;
+	return S_OK;
+}
+
+DXPipelineHandle DXPipelineCache::RequestGraphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, DXPipelineHandle fallback)
+{
+	uint64_t key = HashGraphics(desc, RootSignatureHash(desc.pRootSignature));
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mKeys.find(key);
+		if (it != mKeys.end())
+		{
+			mStats.Requests++;
+			mStats.MemoryHits++;
+			return it->second;
+		}
+	}
+
+	std::unique_ptr<Source> source = std::make_unique<Source>();
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC& copy = source->Graphics;
+	copy = desc;
+	copy.CachedPSO = {};
+	source->RootSignature = desc.pRootSignature;
+
+	CopyShader(copy.VS, source->Shaders[0]);
+	CopyShader(copy.PS, source->Shaders[1]);
+	CopyShader(copy.DS, source->Shaders[2]);
+	CopyShader(copy.HS, source->Shaders[3]);
+	CopyShader(copy.GS, source->Shaders[4]);
+
+	source->InputElements.assign(desc.InputLayout.pInputElementDescs, desc.InputLayout.pInputElementDescs + desc.InputLayout.NumElements);
+	for (D3D12_INPUT_ELEMENT_DESC& element : source->InputElements)
+		element.SemanticName = source->Names.emplace_back(element.SemanticName).c_str();
+	copy.InputLayout.pInputElementDescs = source->InputElements.data();
+
+	source->StreamOutput.assign(desc.StreamOutput.pSODeclaration, desc.StreamOutput.pSODeclaration + desc.StreamOutput.NumEntries);
+	for (D3D12_SO_DECLARATION_ENTRY& entry : source->StreamOutput)
+		entry.SemanticName = entry.SemanticName ? source->Names.emplace_back(entry.SemanticName).c_str() : nullptr;
+	source->StreamOutputStrides.assign(desc.StreamOutput.pBufferStrides, desc.StreamOutput.pBufferStrides + desc.StreamOutput.NumStrides);
+	copy.StreamOutput.pSODeclaration = source->StreamOutput.data();
+	copy.StreamOutput.pBufferStrides = source->StreamOutputStrides.data();
+
+	return Request(key, std::move(source), fallback);
+}
+
+DXPipelineHandle DXPipelineCache::RequestCompute(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, DXPipelineHandle fallback)
+{
+	uint64_t key = HashCompute(desc, RootSignatureHash(desc.pRootSignature));
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mKeys.find(key);
+		if (it != mKeys.end())
+		{
+			mStats.Requests++;
+			mStats.MemoryHits++;
+			return it->second;
+		}
+	}
+
+	std::unique_ptr<Source> source = std::make_unique<Source>();
+	source->IsCompute = true;
+	source->Compute = desc;
+	source->Compute.CachedPSO = {};
+	source->RootSignature = desc.pRootSignature;
+	CopyShader(source->Compute.CS, source->Shaders[0]);
+
+	return Request(key, std::move(source), fallback);
+}
+
+ID3D12PipelineState* DXPipelineCache::Get(DXPipelineHandle handle)
+{
+	if (handle >= mEntryCount.load(std::memory_order_acquire))
+		return nullptr;
+
+	Entry& entry = mEntries[handle];
+	ID3D12PipelineState* pipeline = entry.Pipeline.load(std::memory_order_acquire);
+	if (pipeline)
+		return pipeline;
+
+	mFallbackUses.fetch_add(1, std::memory_order_relaxed);
+	return entry.Fallback != InvalidHandle ? mEntries[entry.Fallback].Pipeline.load(std::memory_order_acquire) : nullptr;
+}
+
+bool DXPipelineCache::IsReady(DXPipelineHandle handle) const
+{
+	return handle < mEntryCount.load(std::memory_order_acquire) && mEntries[handle].State.load(std::memory_order_acquire) == EntryState::Ready;
+}
+
+void DXPipelineCache::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mIdle.wait(lock, [&] { return mQueue.empty() && mBusy == 0; });
+}
+
+DXPipelineCacheStats DXPipelineCache::Stats()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	DXPipelineCacheStats stats = mStats;
+	stats.FallbackUses = mFallbackUses.load(std::memory_order_relaxed);
+	stats.Pending = (uint32_t)mQueue.size() + mBusy;
+	return stats;
+}
+
+uint64_t DXPipelineCache::HashGraphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+	Hasher h;
+	h.Add(rootSignatureHash);
+	h.Shader(desc.VS);
+	h.Shader(desc.PS);
+	h.Shader(desc.DS);
+	h.Shader(desc.HS);
+	h.Shader(desc.GS);
+
+	const D3D12_STREAM_OUTPUT_DESC& so = desc.StreamOutput;
+	h.Add(so.NumEntries);
+	for (UINT i = 0; i < so.NumEntries; i++)
+	{
+		const D3D12_SO_DECLARATION_ENTRY& entry = so.pSODeclaration[i];
+		h.Add(entry.Stream);
+		h.String(entry.SemanticName);
+		h.Add(entry.SemanticIndex);
+		h.Add(entry.StartComponent);
+		h.Add(entry.ComponentCount);
+		h.Add(entry.OutputSlot);
+	}
+	h.Add(so.NumStrides);
+	for (UINT i = 0; i < so.NumStrides; i++)
+		h.Add(so.pBufferStrides[i]);
+	h.Add(so.RasterizedStream);
+
+	const D3D12_BLEND_DESC& blend = desc.BlendState;
+	h.Add(blend.AlphaToCoverageEnable);
+	h.Add(blend.IndependentBlendEnable);
+	for (const D3D12_RENDER_TARGET_BLEND_DESC& rt : blend.RenderTarget)
+	{
+		h.Add(rt.BlendEnable);
+		h.Add(rt.LogicOpEnable);
+		h.Add(rt.SrcBlend);
+		h.Add(rt.DestBlend);
+		h.Add(rt.BlendOp);
+		h.Add(rt.SrcBlendAlpha);
+		h.Add(rt.DestBlendAlpha);
+		h.Add(rt.BlendOpAlpha);
+		h.Add(rt.LogicOp);
+		h.Add(rt.RenderTargetWriteMask);
+	}
+	h.Add(desc.SampleMask);
+
+	const D3D12_RASTERIZER_DESC& raster = desc.RasterizerState;
+	h.Add(raster.FillMode);
+	h.Add(raster.CullMode);
+	h.Add(raster.FrontCounterClockwise);
+	h.Add(raster.DepthBias);
+	h.Add(raster.DepthBiasClamp);
+	h.Add(raster.SlopeScaledDepthBias);
+	h.Add(raster.DepthClipEnable);
+	h.Add(raster.MultisampleEnable);
+	h.Add(raster.AntialiasedLineEnable);
+	h.Add(raster.ForcedSampleCount);
+	h.Add(raster.ConservativeRaster);
+
+	const D3D12_DEPTH_STENCIL_DESC& depth = desc.DepthStencilState;
+	h.Add(depth.DepthEnable);
+	h.Add(depth.DepthWriteMask);
+	h.Add(depth.DepthFunc);
+	h.Add(depth.StencilEnable);
+	h.Add(depth.StencilReadMask);
+	h.Add(depth.StencilWriteMask);
+	for (const D3D12_DEPTH_STENCILOP_DESC* face : { &depth.FrontFace, &depth.BackFace })
+	{
+		h.Add(face->StencilFailOp);
+		h.Add(face->StencilDepthFailOp);
+		h.Add(face->StencilPassOp);
+		h.Add(face->StencilFunc);
+	}
+
+	h.Add(desc.InputLayout.NumElements);
+	for (UINT i = 0; i < desc.InputLayout.NumElements; i++)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+		h.String(element.SemanticName);
+		h.Add(element.SemanticIndex);
+		h.Add(element.Format);
+		h.Add(element.InputSlot);
+		h.Add(element.AlignedByteOffset);
+		h.Add(element.InputSlotClass);
+		h.Add(element.InstanceDataStepRate);
+	}
+
+	h.Add(desc.IBStripCutValue);
+	h.Add(desc.PrimitiveTopologyType);
+	h.Add(desc.NumRenderTargets);
+	for (DXGI_FORMAT format : desc.RTVFormats)
+		h.Add(format);
+	h.Add(desc.DSVFormat);
+	h.Add(desc.SampleDesc.Count);
+	h.Add(desc.SampleDesc.Quality);
+	h.Add(desc.NodeMask);
+	h.Add(desc.Flags);
+	return h.Value;
+}
+
+uint64_t DXPipelineCache::HashCompute(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+	Hasher h;
+	// Keeps compute keys apart from graphics ones with the same shader bytes.
+	h.Add(0xC0u);
+	h.Add(rootSignatureHash);
+	h.Shader(desc.CS);
+	h.Add(desc.NodeMask);
+	h.Add(desc.Flags);
+	return h.Value;
+}
+
+uint64_t DXPipelineCache::RootSignatureHash(ID3D12RootSignature* rootSignature)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mRootSignatures.find(rootSignature);
+	if (it != mRootSignatures.end())
+		return it->second;
+
+	// Unknown root signatures still work, but their pipelines never match across runs.
+	return (uint64_t)(uintptr_t)rootSignature;
+}
+
+DXPipelineHandle DXPipelineCache::Request(uint64_t key, std::unique_ptr<Source> source, DXPipelineHandle fallback)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStats.Requests++;
+
+	// Another thread may have added the same description since the lookup.
+	auto it = mKeys.find(key);
+	if (it != mKeys.end())
+	{
+		mStats.MemoryHits++;
+		return it->second;
+	}
+
+	DXPipelineHandle handle = mEntryCount.load(std::memory_order_relaxed);
+	if (handle >= MaxPipelines)
+	{
+		mStats.Failures++;
+		return fallback;
+	}
+
+	Entry& entry = mEntries[handle];
+	entry.Key = key;
+	entry.Fallback = fallback;
+	entry.Desc = std::move(source);
+	mKeys.emplace(key, handle);
+	mEntryCount.store(handle + 1, std::memory_order_release);
+
+	mQueue.push_back(handle);
+	mWake.notify_one();
+	return handle;
+}
+
+void DXPipelineCache::Build(Entry& entry)
+{
+	using Clock = std::chrono::steady_clock;
+
+	Source& source = *entry.Desc;
+	wchar_t name[17];
+	swprintf(name, std::size(name), L"%016llx", (unsigned long long)entry.Key);
+
+	Clock::time_point begin = Clock::now();
+
+	ComPtr<ID3D12PipelineState> pipeline;
+	HRESULT hr = E_FAIL;
+	if (mLibrary)
+	{
+		hr = source.IsCompute
+			? mLibrary->LoadComputePipeline(name, &source.Compute, IID_PPV_ARGS(&pipeline))
+			: mLibrary->LoadGraphicsPipeline(name, &source.Graphics, IID_PPV_ARGS(&pipeline));
+	}
+
+	bool loaded = SUCCEEDED(hr);
+	if (!loaded)
+	{
+		hr = source.IsCompute
+			? mDevice->CreateComputePipelineState(&source.Compute, IID_PPV_ARGS(&pipeline))
+			: mDevice->CreateGraphicsPipelineState(&source.Graphics, IID_PPV_ARGS(&pipeline));
+
+		if (SUCCEEDED(hr) && mLibrary && SUCCEEDED(mLibrary->StorePipeline(name, pipeline.Get())))
+			mLibraryDirty = true;
+	}
+
+	double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+	entry.Desc.reset();
+
+	if (SUCCEEDED(hr))
+	{
+		entry.Owner = pipeline;
+		entry.Pipeline.store(pipeline.Get(), std::memory_order_release);
+		entry.State.store(EntryState::Ready, std::memory_order_release);
+	}
+	else
+	{
+		entry.State.store(EntryState::Failed, std::memory_order_release);
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (FAILED(hr))
+	{
+		mStats.Failures++;
+	}
+	else if (loaded)
+	{
+		mStats.LibraryHits++;
+		mStats.LoadMs += ms;
+	}
+	else
+	{
+		mStats.Compiles++;
+		mStats.CompileMs += ms;
+		mStats.MaxCompileMs = std::max(mStats.MaxCompileMs, ms);
+	}
+}
+
+void DXPipelineCache::CompileMain()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		mWake.wait(lock, [&] { return mQuit || !mQueue.empty(); });
+		if (mQuit)
+			return;
+
+		DXPipelineHandle handle = mQueue.front();
+		mQueue.pop_front();
+		mBusy++;
+
+		lock.unlock();
+		Build(mEntries[handle]);
+		lock.lock();
+
+		mBusy--;
+		if (mQueue.empty() && mBusy == 0)
+			mIdle.notify_all();
+	}
+}
+
+void DXPipelineCache::StopThreads()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+		mQueue.clear();
+	}
+	mWake.notify_all();
+
+	for (std::thread& thread : mThreads)
+		thread.join();
+	mThreads.clear();
+
+	// Wakes WaitIdle() callers that were waiting on the dropped compiles.
+	mIdle.notify_all();
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using DXPipelineHandle = uint32_t;
+
+struct DXPipelineCacheStats
+{
+	uint64_t Requests = 0;
+	/* Requests for a description already in the cache this run. */
+	uint64_t MemoryHits = 0;
+	/* Pipelines loaded from the on-disk library instead of compiled. */
+	uint64_t LibraryHits = 0;
+	uint64_t Compiles = 0;
+	uint64_t Failures = 0;
+	/* Get() calls answered with the fallback because the pipeline was not ready. */
+	uint64_t FallbackUses = 0;
+	uint32_t Pending = 0;
+	double CompileMs = 0.0;
+	double MaxCompileMs = 0.0;
+	double LoadMs = 0.0;
+
+	double HitRate() const { return Requests ? (double)(MemoryHits + LibraryHits) / (double)Requests : 0.0; }
+};
+
+/*
+	Pipeline states keyed by a stable hash of their full description, compiled on
+	background threads. Get() never blocks: until a pipeline is ready it returns the
+	fallback given to Request(). Compiled pipelines are stored in an
+	ID3D12PipelineLibrary (when the driver supports one) that Save() writes to disk,
+	so the next run loads them instead of compiling.
+	Root signatures must come from CreateRootSignature() so they hash by content.
+*/
+class DXPipelineCache
+{
+public:
+	static constexpr DXPipelineHandle InvalidHandle = ~0u;
+	static constexpr uint32_t MaxPipelines = 4096;
+	static constexpr uint32_t DefaultCompileThreads = 2;
+
+	DXPipelineCache() = default;
+	~DXPipelineCache();
+
+	DXPipelineCache(const DXPipelineCache&) = delete;
+	DXPipelineCache& operator=(const DXPipelineCache&) = delete;
+
+	/* Loads path if it holds a library this driver accepts; otherwise starts empty. */
+	HRESULT Initialize(ID3D12Device* device, const char* path, uint32_t compileThreads = DefaultCompileThreads);
+	/* Drops queued compiles, waits for running ones and saves the library if it changed. */
+	void Shutdown();
+
+	/* Writes the library to the path given to Initialize(). Waits for pending compiles. */
+	HRESULT Save();
+
+	HRESULT CreateRootSignature(const void* blob, SIZE_T size, ID3D12RootSignature** rootSignature);
+
+	/*
+		Returns the handle of desc, queueing it for compilation if it is new. The description is
+		copied, so its shaders and input layout need not outlive the call. fallback is drawn with
+		until the pipeline is ready.
+	*/
+	DXPipelineHandle RequestGraphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, DXPipelineHandle fallback = InvalidHandle);
+	DXPipelineHandle RequestCompute(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, DXPipelineHandle fallback = InvalidHandle);
+
+	/* Thread-safe and lock-free: the pipeline, its fallback's while compiling, or nullptr. */
+	ID3D12PipelineState* Get(DXPipelineHandle handle);
+	bool IsReady(DXPipelineHandle handle) const;
+
+	void WaitIdle();
+
+	bool HasLibrary() const { return mLibrary != nullptr; }
+	DXPipelineCacheStats Stats();
+
+	static uint64_t HashGraphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+	static uint64_t HashCompute(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+
+private:
+	/* Layout of the file Save() writes; Blob is ID3D12PipelineLibrary::Serialize() output. */
+	struct FileHeader
+	{
+		static constexpr uint32_t MagicValue = 0x4C505844; // "DXPL"
+		static constexpr uint32_t CurrentVersion = 1;
+
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t BlobSize;
+	};
+
+	/* Deep copy of a description, kept until the pipeline is built. */
+	struct Source
+	{
+		bool IsCompute = false;
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC Graphics = {};
+		D3D12_COMPUTE_PIPELINE_STATE_DESC Compute = {};
+		std::vector<uint8_t> Shaders[5];
+		std::vector<D3D12_INPUT_ELEMENT_DESC> InputElements;
+		std::vector<D3D12_SO_DECLARATION_ENTRY> StreamOutput;
+		std::vector<UINT> StreamOutputStrides;
+		std::deque<std::string> Names;
+		Microsoft::WRL::ComPtr<ID3D12RootSignature> RootSignature;
+	};
+
+	enum class EntryState : uint32_t
+	{
+		Pending,
+		Ready,
+		Failed
+	};
+
+	struct Entry
+	{
+		uint64_t Key = 0;
+		DXPipelineHandle Fallback = InvalidHandle;
+		std::atomic<EntryState> State = EntryState::Pending;
+		/* Published with release once Owner holds the pipeline. */
+		std::atomic<ID3D12PipelineState*> Pipeline = nullptr;
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> Owner;
+		std::unique_ptr<Source> Desc;
+	};
+
+	uint64_t RootSignatureHash(ID3D12RootSignature* rootSignature);
+	DXPipelineHandle Request(uint64_t key, std::unique_ptr<Source> source, DXPipelineHandle fallback);
+	void Build(Entry& entry);
+	void CompileMain();
+	void StopThreads();
+
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> mLibrary;
+	/* The library reads from this until it is released. */
+	std::vector<uint8_t> mLibraryBlob;
+	std::string mPath;
+	std::atomic<bool> mLibraryDirty = false;
+
+	std::unique_ptr<Entry[]> mEntries;
+	std::atomic<uint32_t> mEntryCount = 0;
+
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::condition_variable mIdle;
+	std::deque<DXPipelineHandle> mQueue;
+	uint32_t mBusy = 0;
+	bool mQuit = false;
+	std::vector<std::thread> mThreads;
+	std::unordered_map<uint64_t, DXPipelineHandle> mKeys;
+	std::unordered_map<ID3D12RootSignature*, uint64_t> mRootSignatures;
+
+	DXPipelineCacheStats mStats;
+	std::atomic<uint64_t> mFallbackUses = 0;
+};
@@ -0,0 +1,124 @@
+#include "DXQueueManager.h"
+
+#include <algorithm>
+#include <format>
+#include "DXException.h"
+
+HRESULT DXQueueManager::Initialize(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, DXFrameSync* graphicsSync)
+{
+	mDevice = device;
+
+	QueueState& graphics = mQueues[(uint32_t)GpuQueueType::Graphics];
+	graphics.Queue = graphicsQueue;
+	graphics.Sync = graphicsSync;
+	graphics.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+
+	HRESULT hr = CreateQueue(mQueues[(uint32_t)GpuQueueType::Copy], D3D12_COMMAND_LIST_TYPE_COPY);
+	if (FAILED(hr))
+		return hr;
+
+	mTimeline.Initialize(graphicsSync, mQueues[(uint32_t)GpuQueueType::Copy].Sync);
+	return S_OK;
+}
+
+HRESULT DXQueueManager::CreateQueue(QueueState& state, D3D12_COMMAND_LIST_TYPE type)
+{
+	D3D12_COMMAND_QUEUE_DESC desc = {};
+	desc.Type = type;
+	desc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+	desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	desc.NodeMask = 0u;
+
+	HRESULT hr = mDevice->CreateCommandQueue(&desc, IID_PPV_ARGS(&state.OwnedQueue));
+	if (FAILED(hr))
+		return hr;
+
+	hr = state.OwnedSync.Initialize(mDevice.Get(), state.OwnedQueue.Get());
+	if (FAILED(hr))
+		return hr;
+
+	state.Queue = state.OwnedQueue.Get();
+	state.Sync = &state.OwnedSync;
+	state.Type = type;
+	return S_OK;
+}
+
+HRESULT DXQueueManager::BeginCommandList(GpuQueueType type, ID3D12GraphicsCommandList** cmdList)
+{
+	QueueState& state = mQueues[(uint32_t)type];
+	std::lock_guard<std::mutex> lock(state.Lock);
+
+	PooledList list;
+	if (!state.Submitted.empty() && mTimeline.IsComplete({ type, state.Submitted.front().FenceValue }))
+	{
+		list = std::move(state.Submitted.front());
+		state.Submitted.pop_front();
+
+		HRESULT hr = list.Allocator->Reset();
+		if (FAILED(hr))
+			return hr;
+		hr = list.CmdList->Reset(list.Allocator.Get(), nullptr);
+		if (FAILED(hr))
+			return hr;
+	}
+	else
+	{
+		HRESULT hr = mDevice->CreateCommandAllocator(state.Type, IID_PPV_ARGS(&list.Allocator));
+		if (FAILED(hr))
+			return hr;
+		hr = mDevice->CreateCommandList(0u, state.Type, list.Allocator.Get(), nullptr, IID_PPV_ARGS(&list.CmdList));
+		if (FAILED(hr))
+			return hr;
+		state.Stats.Allocators++;
+	}
+
+	*cmdList = list.CmdList.Get();
+	state.Recording.push_back(std::move(list));
+	return S_OK;
+}
+
+GpuSyncPoint DXQueueManager::Submit(GpuQueueType type, ID3D12GraphicsCommandList* cmdList)
+{
+	QueueState& state = mQueues[(uint32_t)type];
+	std::lock_guard<std::mutex> lock(state.Lock);
+
+	auto it = std::find_if(state.Recording.begin(), state.Recording.end(), [&](const PooledList& list) { return list.CmdList.Get() == cmdList; });
+	if (it == state.Recording.end())
+		throw DXException("[DXQueueManager]: ", "Submit() of a command list that did not come from BeginCommandList()");
+
+	HRESULT hr = cmdList->Close();
+	if (FAILED(hr))
+		throw DXException("[DXQueueManager]: ", std::format("Close failed with 0x{:x}", (unsigned long)hr).c_str());
+
+	ID3D12CommandList* lists[] = { cmdList };
+	state.Queue->ExecuteCommandLists(1u, lists);
+
+	GpuSyncPoint point = mTimeline.Signal(type);
+	it->FenceValue = point.Value;
+	state.Submitted.push_back(std::move(*it));
+	state.Recording.erase(it);
+	state.Stats.Submissions++;
+	return point;
+}
+
+void DXQueueManager::GpuWait(GpuQueueType queue, const GpuSyncPoint& point)
+{
+	// Same-queue work is already ordered, and finished work needs no wait.
+	if (point.Queue == queue || mTimeline.IsComplete(point))
+		return;
+
+	QueueState& state = mQueues[(uint32_t)queue];
+	std::lock_guard<std::mutex> lock(state.Lock);
+
+	HRESULT hr = state.Queue->Wait(mQueues[(uint32_t)point.Queue].Sync->Fence(), point.Value);
+	if (FAILED(hr))
+		throw DXException("[DXQueueManager]: ", std::format("Wait failed with 0x{:x}", (unsigned long)hr).c_str());
+	state.Stats.GpuWaits++;
+}
+
+DXQueueStats DXQueueManager::Stats(GpuQueueType type)
+{
+	QueueState& state = mQueues[(uint32_t)type];
+	std::lock_guard<std::mutex> lock(state.Lock);
+	return state.Stats;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "GpuTimeline.h"
+#include "DXFrameSync.h"
+
+struct DXQueueStats
+{
+	uint64_t Submissions = 0;
+	uint64_t GpuWaits = 0;
+	/* Command allocators created because none in the pool had retired yet. */
+	uint32_t Allocators = 0;
+};
+
+/*
+	The renderer's DIRECT queue plus a dedicated COPY queue, each with its own
+	timeline fence. Work on one queue can wait for the other on the GPU with
+	GpuWait(), so copies overlap graphics instead of going through a CPU flush.
+	A COMPUTE queue belongs here once the renderer has compute work that does not
+	depend on the frame's graphics passes. Command lists and allocators are pooled per queue and reused once
+	the fence value of their last submission has retired.
+	BeginCommandList()/Submit() may be called from any thread, except that the
+	graphics queue is also signaled by the frame ring on the render thread.
+*/
+class DXQueueManager
+{
+public:
+	DXQueueManager() = default;
+	DXQueueManager(const DXQueueManager&) = delete;
+	DXQueueManager& operator=(const DXQueueManager&) = delete;
+
+	/* The graphics queue and its fence stay owned by the caller. */
+	HRESULT Initialize(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, DXFrameSync* graphicsSync);
+
+	ID3D12CommandQueue* Queue(GpuQueueType type) const { return mQueues[(uint32_t)type].Queue; }
+	GpuTimeline& Timeline() { return mTimeline; }
+
+	/* An open command list of the queue's type, recording into an allocator the GPU is done with. */
+	HRESULT BeginCommandList(GpuQueueType type, ID3D12GraphicsCommandList** cmdList);
+
+	/* Closes and executes a list from BeginCommandList() and signals the queue's fence. */
+	GpuSyncPoint Submit(GpuQueueType type, ID3D12GraphicsCommandList* cmdList);
+
+	/* Makes queue wait on the GPU, without blocking the CPU, until point has completed. */
+	void GpuWait(GpuQueueType queue, const GpuSyncPoint& point);
+
+	bool IsComplete(const GpuSyncPoint& point) const { return mTimeline.IsComplete(point); }
+	void Wait(const GpuSyncPoint& point) { mTimeline.Wait(point); }
+	void WaitIdle() { mTimeline.WaitIdle(); }
+
+	DXQueueStats Stats(GpuQueueType type);
+
+private:
+	struct PooledList
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> Allocator;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> CmdList;
+		uint64_t FenceValue = 0;
+	};
+
+	struct QueueState
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandQueue> OwnedQueue;
+		DXFrameSync OwnedSync;
+		ID3D12CommandQueue* Queue = nullptr;
+		DXFrameSync* Sync = nullptr;
+		D3D12_COMMAND_LIST_TYPE Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+
+		std::mutex Lock;
+		/* Submitted lists in submission order, so only the front needs checking. */
+		std::deque<PooledList> Submitted;
+		std::vector<PooledList> Recording;
+		DXQueueStats Stats;
+	};
+
+	HRESULT CreateQueue(QueueState& state, D3D12_COMMAND_LIST_TYPE type);
+
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	QueueState mQueues[GpuTimeline::QueueCount];
+	GpuTimeline mTimeline;
+};
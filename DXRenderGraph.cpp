@@ -0,0 +1,277 @@
+#include "DXRenderGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+HRESULT DXRenderGraph::Initialize(ID3D12Device* device, DXGpuMemoryAllocator* memory, FrameSync* sync)
+{
+	mDevice = device;
+	mMemory = memory;
+	mSync = sync;
+	return S_OK;
+}
+
+void DXRenderGraph::Shutdown()
+{
+	// The caller flushes the queue first.
+	mCache.clear();
+	if (mMemory)
+	{
+		mMemory->FreeRange(mTransientRange);
+		for (Retired& retired : mRetired)
+			mMemory->FreeRange(retired.Range);
+	}
+	mRetired.clear();
+}
+
+void DXRenderGraph::Reset()
+{
+	mGraph.Reset();
+	mPasses.clear();
+	mResources.clear();
+	mTextures.clear();
+	mTextureIndex.clear();
+}
+
+RenderGraphHandle DXRenderGraph::Import(const char* name, ID3D12Resource* resource, RenderGraphState initialState, RenderGraphState finalState)
+{
+	RenderGraphHandle handle = mGraph.Import(name, initialState, finalState);
+	mResources.push_back(resource);
+	mTextureIndex.push_back(RenderGraph::InvalidHandle);
+	return handle;
+}
+
+RenderGraphHandle DXRenderGraph::CreateTexture(const char* name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue)
+{
+	assert((desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) &&
+		"Transient textures live in a render target heap");
+
+	D3D12_RESOURCE_ALLOCATION_INFO info = mDevice->GetResourceAllocationInfo(0, 1, &desc);
+	RenderGraphHandle handle = mGraph.CreateTransient(name, info.SizeInBytes, info.Alignment);
+
+	Texture texture = {};
+	texture.Desc = desc;
+	texture.HasClearValue = clearValue != nullptr;
+	if (clearValue)
+		texture.ClearValue = *clearValue;
+
+	mResources.push_back(nullptr);
+	mTextureIndex.push_back((UINT)mTextures.size());
+	mTextures.push_back(texture);
+	return handle;
+}
+
+uint32_t DXRenderGraph::AddPass(const char* name, PassFunction execute, bool neverCull)
+{
+	mPasses.push_back(std::move(execute));
+	return mGraph.AddPass(name, neverCull);
+}
+
+HRESULT DXRenderGraph::Compile()
+{
+	if (!mGraph.Compile())
+		return E_INVALIDARG;
+
+	mFrame++;
+	ReleaseRetired();
+
+	HRESULT hr = GrowTransientRange(mGraph.Stats().TransientBytes);
+	if (FAILED(hr))
+		return hr;
+
+	for (RenderGraphHandle r = 0; r < mGraph.ResourceCount(); r++)
+	{
+		if (!mGraph.IsTransient(r) || !mGraph.IsUsed(r))
+			continue;
+
+		hr = RealizeTransient(r);
+		if (FAILED(hr))
+			return hr;
+	}
+	return S_OK;
+}
+
+void DXRenderGraph::Execute(ID3D12GraphicsCommandList* cmdList, uint32_t firstBatch, uint32_t lastBatch)
+{
+	const std::vector<RenderGraphBatch>& batches = mGraph.Batches();
+	const std::vector<RenderGraphBarrier>& barriers = mGraph.Barriers();
+
+	lastBatch = std::min<uint32_t>(lastBatch, (uint32_t)batches.size());
+	for (uint32_t b = firstBatch; b < lastBatch; b++)
+	{
+		const RenderGraphBatch& batch = batches[b];
+		bool marked = mBreadcrumbs && batch.Pass != RenderGraph::InvalidHandle;
+		if (marked)
+			mBreadcrumbs->BeginMarker(cmdList, mGraph.PassName(batch.Pass));
+
+		mBarriers.clear();
+		for (uint32_t i = batch.BarrierBegin; i < batch.BarrierBegin + batch.BarrierCount; i++)
+		{
+			const RenderGraphBarrier& barrier = barriers[i];
+
+			D3D12_RESOURCE_BARRIER d3dBarrier = {};
+			switch (barrier.Type)
+			{
+			case RenderGraphBarrierType::Aliasing:
+				d3dBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+				d3dBarrier.Aliasing.pResourceBefore = barrier.AliasBefore != RenderGraph::InvalidHandle ? mResources[barrier.AliasBefore] : nullptr;
+				d3dBarrier.Aliasing.pResourceAfter = mResources[barrier.Resource];
+				break;
+			case RenderGraphBarrierType::Uav:
+				d3dBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+				d3dBarrier.UAV.pResource = mResources[barrier.Resource];
+				break;
+			default:
+				d3dBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+				d3dBarrier.Flags = barrier.Split == RenderGraphSplit::Begin ? D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY
+					: barrier.Split == RenderGraphSplit::End ? D3D12_RESOURCE_BARRIER_FLAG_END_ONLY
+					: D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				d3dBarrier.Transition.pResource = mResources[barrier.Resource];
+				d3dBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+				d3dBarrier.Transition.StateBefore = ToD3D12(barrier.Before);
+				d3dBarrier.Transition.StateAfter = ToD3D12(barrier.After);
+				break;
+			}
+			mBarriers.push_back(d3dBarrier);
+		}
+
+		if (!mBarriers.empty())
+			cmdList->ResourceBarrier((UINT)mBarriers.size(), mBarriers.data());
+
+		// Memory that another resource used earlier this frame holds garbage until discarded,
+		// which render targets and depth buffers have to do in their write state.
+		for (uint32_t i = batch.BarrierBegin; i < batch.BarrierBegin + batch.BarrierCount; i++)
+		{
+			const RenderGraphBarrier& transition = barriers[i];
+			if (transition.Type != RenderGraphBarrierType::Transition || (transition.After != RenderGraphState::RenderTarget && transition.After != RenderGraphState::DepthWrite))
+				continue;
+
+			for (uint32_t j = batch.BarrierBegin; j < batch.BarrierBegin + batch.BarrierCount; j++)
+			{
+				if (barriers[j].Type == RenderGraphBarrierType::Aliasing && barriers[j].Resource == transition.Resource)
+					cmdList->DiscardResource(mResources[transition.Resource], nullptr);
+			}
+		}
+
+		if (batch.Pass != RenderGraph::InvalidHandle && mPasses[batch.Pass])
+			mPasses[batch.Pass](cmdList);
+
+		if (marked)
+			mBreadcrumbs->EndMarker(cmdList);
+	}
+}
+
+uint32_t DXRenderGraph::BatchOfPass(uint32_t pass) const
+{
+	const std::vector<RenderGraphBatch>& batches = mGraph.Batches();
+	for (uint32_t b = 0; b < batches.size(); b++)
+	{
+		if (batches[b].Pass == pass)
+			return b;
+	}
+	return RenderGraph::InvalidHandle;
+}
+
+D3D12_RESOURCE_STATES DXRenderGraph::ToD3D12(RenderGraphState state)
+{
+	D3D12_RESOURCE_STATES result = D3D12_RESOURCE_STATE_COMMON;
+	if ((uint32_t)(state & RenderGraphState::RenderTarget))
+		result |= D3D12_RESOURCE_STATE_RENDER_TARGET;
+	if ((uint32_t)(state & RenderGraphState::DepthWrite))
+		result |= D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	if ((uint32_t)(state & RenderGraphState::DepthRead))
+		result |= D3D12_RESOURCE_STATE_DEPTH_READ;
+	if ((uint32_t)(state & RenderGraphState::ShaderResource))
+		result |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+	if ((uint32_t)(state & RenderGraphState::UnorderedAccess))
+		result |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+	if ((uint32_t)(state & RenderGraphState::CopySource))
+		result |= D3D12_RESOURCE_STATE_COPY_SOURCE;
+	if ((uint32_t)(state & RenderGraphState::CopyDest))
+		result |= D3D12_RESOURCE_STATE_COPY_DEST;
+	// D3D12_RESOURCE_STATE_PRESENT is D3D12_RESOURCE_STATE_COMMON.
+	return result;
+}
+
+HRESULT DXRenderGraph::GrowTransientRange(UINT64 size)
+{
+	if (size == 0 || (mTransientRange.IsValid() && mTransientRange.Size >= size))
+		return S_OK;
+
+	// Frames still in flight may use the old range and its resources.
+	if (mTransientRange.IsValid())
+	{
+		Retired retired;
+		retired.FenceValue = mSync->LastSignaledValue();
+		retired.Range = mTransientRange;
+		for (CachedTexture& cached : mCache)
+			retired.Resources.push_back(std::move(cached.Resource));
+		mRetired.push_back(std::move(retired));
+		mTransientRange = {};
+		mCache.clear();
+	}
+
+	return mMemory->AllocateRange(GpuHeapKind::RenderTargets, size, GpuMemoryAllocator::MsaaAlignment, mTransientRange);
+}
+
+HRESULT DXRenderGraph::RealizeTransient(RenderGraphHandle handle)
+{
+	const Texture& texture = mTextures[mTextureIndex[handle]];
+	UINT64 offset = mTransientRange.Offset + mGraph.TransientOffset(handle);
+
+	for (CachedTexture& cached : mCache)
+	{
+		if (cached.LastFrame != mFrame && cached.Offset == offset && memcmp(&cached.Desc, &texture.Desc, sizeof(D3D12_RESOURCE_DESC)) == 0)
+		{
+			cached.LastFrame = mFrame;
+			mResources[handle] = cached.Resource.Get();
+			return S_OK;
+		}
+	}
+
+	// Transients enter and leave every frame in the common state.
+	CachedTexture cached = {};
+	cached.Desc = texture.Desc;
+	cached.Offset = offset;
+	cached.LastFrame = mFrame;
+	HRESULT hr = mDevice->CreatePlacedResource(
+		mMemory->Heap(mTransientRange),
+		offset,
+		&texture.Desc,
+		D3D12_RESOURCE_STATE_COMMON,
+		texture.HasClearValue ? &texture.ClearValue : nullptr,
+		IID_PPV_ARGS(&cached.Resource)
+	);
+	if (FAILED(hr))
+		return hr;
+
+	mResources[handle] = cached.Resource.Get();
+	mCache.push_back(std::move(cached));
+	return S_OK;
+}
+
+void DXRenderGraph::ReleaseRetired()
+{
+	UINT64 completed = mSync->CompletedValue();
+	for (size_t i = 0; i < mRetired.size();)
+	{
+		if (mRetired[i].FenceValue <= completed)
+		{
+			mRetired[i].Resources.clear();
+			mMemory->FreeRange(mRetired[i].Range);
+			mRetired.erase(mRetired.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	// Layouts that stopped being used a while ago; by now no frame in flight references them.
+	const UINT64 unusedFrames = FrameRing<FrameContextBase>::MaxFrames + 1;
+	mCache.erase(std::remove_if(mCache.begin(), mCache.end(), [&](const CachedTexture& cached)
+	{
+		return cached.LastFrame + unusedFrames < mFrame;
+	}), mCache.end());
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <functional>
+#include <vector>
+#include "RenderGraph.h"
+#include "FrameRing.h"
+#include "DXGpuMemoryAllocator.h"
+#include "DXGpuBreadcrumbs.h"
+
+/*
+	RenderGraph over D3D12 resources. Transient textures are placed resources in one
+	range of a render target heap, so they have to be render targets or depth stencils.
+	Placed resources are cached across frames and only recreated when the compiled
+	layout changes; the old ones are released once the GPU has retired them.
+*/
+class DXRenderGraph
+{
+public:
+	using PassFunction = std::function<void(ID3D12GraphicsCommandList* cmdList)>;
+
+	HRESULT Initialize(ID3D12Device* device, DXGpuMemoryAllocator* memory, FrameSync* sync);
+	void Shutdown();
+
+	/* Wraps every executed pass, its barriers included, in a breadcrumb marker named after the pass. */
+	void SetBreadcrumbs(DXGpuBreadcrumbs* breadcrumbs) { mBreadcrumbs = breadcrumbs; }
+
+	/* Starts declaring a new frame. */
+	void Reset();
+
+	RenderGraphHandle Import(const char* name, ID3D12Resource* resource, RenderGraphState initialState, RenderGraphState finalState);
+	RenderGraphHandle CreateTexture(const char* name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+	/* An empty execute function only records the pass's barriers, e.g. for work recorded elsewhere. */
+	uint32_t AddPass(const char* name, PassFunction execute, bool neverCull = false);
+	void Read(uint32_t pass, RenderGraphHandle resource, RenderGraphState state) { mGraph.Read(pass, resource, state); }
+	void Write(uint32_t pass, RenderGraphHandle resource, RenderGraphState state) { mGraph.Write(pass, resource, state); }
+
+	/* Compiles the graph and creates the placed resources of the transient textures. */
+	HRESULT Compile();
+
+	/* Valid after Compile() for transient textures. */
+	ID3D12Resource* Resource(RenderGraphHandle resource) const { return mResources[resource]; }
+
+	/*
+		Records the barrier batches in [firstBatch, lastBatch) and the pass that follows
+		each of them. Batch i precedes the i-th live pass; the last batch ends the frame.
+	*/
+	void Execute(ID3D12GraphicsCommandList* cmdList, uint32_t firstBatch = 0, uint32_t lastBatch = ~0u);
+
+	/* Index of the batch that precedes pass, or RenderGraph::InvalidHandle if the pass was culled. */
+	uint32_t BatchOfPass(uint32_t pass) const;
+
+	const RenderGraph& Graph() const { return mGraph; }
+
+private:
+	struct Texture
+	{
+		D3D12_RESOURCE_DESC Desc;
+		D3D12_CLEAR_VALUE ClearValue;
+		bool HasClearValue;
+	};
+
+	/* Placed resource at Offset in the current transient range. */
+	struct CachedTexture
+	{
+		D3D12_RESOURCE_DESC Desc;
+		UINT64 Offset;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		/* Frame it was last handed out in; a texture is used by one handle per frame. */
+		UINT64 LastFrame;
+	};
+
+	struct Retired
+	{
+		UINT64 FenceValue;
+		GpuAllocation Range;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> Resources;
+	};
+
+	static D3D12_RESOURCE_STATES ToD3D12(RenderGraphState state);
+
+	HRESULT GrowTransientRange(UINT64 size);
+	HRESULT RealizeTransient(RenderGraphHandle handle);
+	void ReleaseRetired();
+
+	ID3D12Device* mDevice = nullptr;
+	DXGpuMemoryAllocator* mMemory = nullptr;
+	FrameSync* mSync = nullptr;
+	DXGpuBreadcrumbs* mBreadcrumbs = nullptr;
+
+	RenderGraph mGraph;
+	std::vector<PassFunction> mPasses;
+	std::vector<ID3D12Resource*> mResources;
+	std::vector<Texture> mTextures;
+	std::vector<UINT> mTextureIndex;
+
+	GpuAllocation mTransientRange;
+	std::vector<CachedTexture> mCache;
+	std::vector<Retired> mRetired;
+	UINT64 mFrame = 0;
+
+	std::vector<D3D12_RESOURCE_BARRIER> mBarriers;
+};
@@ -1,6 +1,8 @@
 #include "DXRenderer.h"
 
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <sstream>
 #include <cassert>
@@ -8,15 +10,26 @@
 #include <malloc.h>
 #include <format>
 #include <windowsx.h>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <d3dcompiler.h>
 #include "DXException.h"
+#include "ChromeTrace.h"
+#include "CpuProfiler.h"
+#include <dwmapi.h>
 
 using namespace Microsoft::WRL;
 
-HANDLE DXRenderer::mStandardOutput = nullptr;
-
-DXRenderer::DXRenderer(HINSTANCE hInstance)
+DXRenderer::DXRenderer(HINSTANCE hInstance, UINT framesInFlight, UINT maxFrameLatency)
 	:
-	mhInstance(hInstance)
+	mTimestep(mTimer.TicksPerSecond(), SimulationRate),
+	mFrameStats(mTimer.TicksPerSecond()),
+	mFramePacer(mPacerClock),
+	mBufferCount(std::clamp(framesInFlight, FrameRing<FrameContext>::MinFrames, FrameRing<FrameContext>::MaxFrames)),
+	mhInstance(hInstance),
+	mMaxFrameLatency(std::clamp(maxFrameLatency, 1u, mBufferCount))
 {
 #ifdef _DEBUG
 	ComPtr<ID3D12Debug> debug;
@@ -25,81 +38,591 @@ DXRenderer::DXRenderer(HINSTANCE hInstance)
 
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 	AllocConsole();
-
-	mStandardOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+	mLogSink = std::make_unique<ConsoleLogSink>();
+#else
+	mLogSink = std::make_unique<FileLogSink>(LogPath);
 #endif
+	Logger::Start(mLogSink.get());
+
+	CpuProfiler::Initialize(&GameTimer::CurrentTicks, mTimer.TicksPerSecond());
+	CpuProfiler::SetThreadName("Render");
+
+	mInput = std::make_unique<InputQueue>();
+	mInputBatch.resize(InputQueue::Capacity);
+	mResizeScheduler.Initialize(mTimer.TicksPerSecond());
+
+	mJobs = std::make_unique<JobSystem>(std::clamp(std::thread::hardware_concurrency(), 1u, DXParallelRecorder::MaxThreads));
+
 	InitWindow();
 	CreateDXDevice();
-	mEventHandle = CreateEventA(nullptr, FALSE, FALSE, nullptr);
-	mFence = CreateFence();
-	mRtvDescriptorHeapSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-	mDsvDescriptorHeapSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
-	mCbvSrvDescriptorHeapSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 	CheckMSAAQualitySupport();
 	CreateCommandObjects(false);
 	CreateSwapChain();
-	CreateRtvAndDsvDescriptorHeaps();
+	CreateDescriptorHeaps();
+	CreateUpscalePipeline();
 	OnResize();
 }
 
 DXRenderer::~DXRenderer()
 {
+	// Only still running if Run() left through an exception; the render thread's own failure, if any, is secondary.
+	if (mRenderThread.IsRunning())
+	{
+		try { mRenderThread.Stop(); }
+		catch (...) {}
+	}
+
 	ClearCommandQueue();
-	CloseHandle(mEventHandle);
+	mDepthPool.Clear([this](DXGpuAllocation& target) { mGpuMemory.Free(target); });
+	mGpuMemory.Free(mDepthBuffer);
+	mAssetStreamer.Shutdown();
+	mRenderGraph.Shutdown();
+	mPipelines.Shutdown();
+	if (mFrameLatencyWaitable)
+		CloseHandle(mFrameLatencyWaitable);
+	Logger::Stop();
 	FreeConsole();
 }
 
 void DXRenderer::ClearCommandQueue()
 {
-	ThrowIfFailed(mCmdQueue->Signal(mFence.Get(), ++mCurrentFence));
+	mFrameSync.Signal();
 	FlushCommandQueue();
 }
 
 
 int DXRenderer::Run()
 {
-	MSG msg = {};
-
 	mTimer.Reset();
 
+	if (mUseRenderThread)
+		return RunThreaded();
+
+	MSG msg = {};
 	while (msg.message != WM_QUIT)
 	{
-		if (mHasException)
-		{
-			std::stringstream oss;
-			while (!mExceptionSettings.empty())
-			{
-				ExceptionSettings s = mExceptionSettings.front();
-				oss << s._s0 << s._s1 << "\n";
-				mExceptionSettings.pop();
-			}
-			throw DXException("", oss.str().c_str());
-		}
-		// If there are Window messages then process them.
-		if (PeekMessage(&msg, NULL, NULL, NULL, PM_REMOVE))
+		CPU_ZONE("Run");
+
+		ThrowPendingException();
+		// Drain every queued message, so a burst of input cannot hold the frame back by one message per iteration.
+		while (PeekMessage(&msg, NULL, NULL, NULL, PM_REMOVE))
 		{
+			if (msg.message == WM_QUIT)
+				break;
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
+		RethrowWindowFailure();
+		if (msg.message == WM_QUIT)
+			break;
+		// Publishes the mouse motion coalesced while draining.
+		mInput->Flush();
+
+		if (!mAppPaused && !mFrameLatencyReady)
+		{
+			mPaceWaitStart = GameTimer::CurrentTicks();
+			mPaceWaitTicks = mFramePacer.Wait();
+
+			// Input that arrives during the waits is drained by the loop before the frame samples it.
+			WaitForFrameLatency();
+		}
 		else
 		{
 			mTimer.Tick();
 
 			if (!mAppPaused)
 			{
-				CalculateFrameStats();
-				Update(mTimer);
-				Draw(mTimer);
+				mFrameLatencyReady = false;
+				RunFrame();
 			}
 			else
 			{
-				Sleep(100);
+				// Nothing to render until a message unpauses the app; pacing restarts from then.
+				mFramePacer.Reset();
+				WaitMessage();
 			}
 		}
 	}
 	return (int)msg.wParam;
 }
 
+int DXRenderer::RunThreaded()
+{
+	CpuProfiler::SetThreadName("Window");
+	mRenderThread.SetWaitCallback([]
+	{
+		// Present() and ResizeBuffers() on the render thread may send this window messages and block until they are
+		// handled, so waiting on that thread without handling them can deadlock. Posted messages stay queued.
+		MsgWaitForMultipleObjects(0, nullptr, FALSE, 1, QS_SENDMESSAGE);
+		MSG sent;
+		PeekMessage(&sent, NULL, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+	});
+	mRenderThread.Start(this);
+
+	MSG msg = {};
+	while (true)
+	{
+		while (PeekMessage(&msg, NULL, NULL, NULL, PM_REMOVE))
+		{
+			if (msg.message == WM_QUIT)
+				break;
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+		}
+		if (msg.message == WM_QUIT || mRenderThread.Failed())
+			break;
+
+		// Mouse motion arriving within a millisecond still merges into one event before the render thread sees it.
+		if (mInput->HasPending())
+		{
+			if (MsgWaitForMultipleObjectsEx(0, nullptr, 1, QS_ALLINPUT, MWMO_INPUTAVAILABLE) == WAIT_TIMEOUT)
+				mInput->Flush();
+			continue;
+		}
+		WaitMessage();
+	}
+
+	// Rethrows what stopped the render thread, if anything did.
+	mRenderThread.Stop();
+	RethrowWindowFailure();
+	return (int)msg.wParam;
+}
+
+void DXRenderer::RunFrame()
+{
+	ApplyPendingResize();
+	CalculateFrameStats();
+
+	// Kept for the next step if no step runs this frame.
+	uint32_t depth = mInput->Drain(mInputBatch.data() + mInputBatchCount, (uint32_t)mInputBatch.size() - mInputBatchCount);
+	mInputBatchCount += depth;
+	mFrameSample.InputEvents = depth;
+
+	uint32_t steps = mTimestep.Advance(mTimer.DeltaTicks());
+	for (uint32_t step = 0; step < steps; step++)
+		Update();
+	Draw(mTimer, (float)mTimestep.Alpha());
+
+	if (CpuProfiler::IsCapturing())
+		CpuProfiler::Drain();
+}
+
+void DXRenderer::ThrowPendingException()
+{
+	if (!mErrors.HasErrors()) [[likely]]
+		return;
+
+	// Only now is it worth asking the device; a removal is what the breadcrumbs are for.
+	HRESULT removedReason = mDevice ? mDevice->GetDeviceRemovedReason() : S_OK;
+	if (FAILED(removedReason))
+	{
+		static constexpr ErrorSite deviceRemoved{ "GetDeviceRemovedReason()", __FILE__, __LINE__ };
+		std::string report = mBreadcrumbs.Report();
+		mErrors.Record(deviceRemoved, (int32_t)removedReason, report);
+		LOG_ERROR("Device removed (0x{:08X}), last completed fence value {}", (uint32_t)removedReason, mBreadcrumbs.Breadcrumbs().CompletedValue());
+	}
+
+	DXException exception("", mErrors.Format().c_str());
+	mErrors.Clear();
+	throw exception;
+}
+
+void DXRenderer::RethrowWindowFailure()
+{
+	if (!mWindowFailure) [[likely]]
+		return;
+
+	std::exception_ptr failure = mWindowFailure;
+	mWindowFailure = nullptr;
+	std::rethrow_exception(failure);
+}
+
+void DXRenderer::PostWindowCommand(WindowCommandType type, uint32_t param, int32_t width, int32_t height)
+{
+	WindowCommand command;
+	command.Type = type;
+	command.Param = param;
+	command.Width = width;
+	command.Height = height;
+
+	if (mRenderThread.IsRunning())
+	{
+		mRenderThread.Post(command);
+		return;
+	}
+
+	// Without a render thread this runs inside WndProc, where a failed ThrowIfFailed must not unwind.
+	try { ApplyWindowCommand(command); }
+	catch (...) { mWindowFailure = std::current_exception(); }
+}
+
+void DXRenderer::OnRenderThreadStarted()
+{
+	CpuProfiler::SetThreadName("Render");
+	// Parallel recording waits on jobs from this thread now.
+	mJobs->AttachCallingThread();
+}
+
+bool DXRenderer::RenderFrame()
+{
+	CPU_ZONE_FUNCTION();
+
+	ThrowPendingException();
+
+	if (mAppPaused)
+	{
+		// Sleeps until the window thread posts the command that unpauses.
+		mTimer.Tick();
+		mFramePacer.Reset();
+		return false;
+	}
+
+	mPaceWaitStart = GameTimer::CurrentTicks();
+	mPaceWaitTicks = mFramePacer.Wait();
+	WaitForFrameLatency();
+
+	mTimer.Tick();
+	RunFrame();
+	return true;
+}
+
+void DXRenderer::OnRenderThreadFailed()
+{
+	// Wakes the window thread from WaitMessage() so it stops the render thread and rethrows.
+	PostMessage(mHwnd, WM_NULL, 0, 0);
+}
+
+int DXRenderer::RunRecordBenchmark(UINT drawCount, const char* reportPath)
+{
+	ComPtr<ID3D12Device> device;
+	if (FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+		return 1;
+
+	UINT maxThreads = std::clamp(std::thread::hardware_concurrency(), 1u, DXParallelRecorder::MaxThreads);
+	std::vector<RecordScalingResult> results = DXParallelRecorder::MeasureRecording(device.Get(), drawCount, maxThreads, 100);
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	file << std::format("# draws={}\n", drawCount);
+	file << "threads,meanMs,minMs,speedup\n";
+	for (const RecordScalingResult& r : results)
+		file << std::format("{},{:.4f},{:.4f},{:.2f}\n", r.Threads, r.MeanMs, r.MinMs, r.Speedup);
+
+	return 0;
+}
+
+int DXRenderer::RunJobBenchmark(UINT jobCount, const char* reportPath)
+{
+	UINT maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<JobThroughputResult> results = JobSystem::MeasureThroughput(jobCount, maxThreads);
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	file << std::format("# jobs={}\n", jobCount);
+	file << "threads,ms,jobsPerSecond,steals,meanUtilization\n";
+	for (const JobThroughputResult& r : results)
+		file << std::format("{},{:.4f},{:.0f},{},{:.3f}\n", r.Threads, r.Ms, r.JobsPerSecond, r.Steals, r.MeanUtilization);
+
+	return 0;
+}
+
+int DXRenderer::RunGraphBenchmark(UINT maxPasses, const char* reportPath, const char* schedulePath)
+{
+	std::vector<RenderGraphCompileResult> results = RenderGraph::MeasureCompile(maxPasses, 1000);
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	file << "passes,culled,meanUs,minUs,barriers,barrierCalls,split,aliasing,transientKB,unaliasedKB\n";
+	for (const RenderGraphCompileResult& r : results)
+	{
+		file << std::format("{},{},{:.3f},{:.3f},{},{},{},{},{},{}\n", r.Passes, r.Stats.CulledPasses, r.MeanUs, r.MinUs,
+			r.Stats.Barriers, r.Stats.BarrierCalls, r.Stats.SplitBarriers, r.Stats.AliasingBarriers,
+			r.Stats.TransientBytes / 1024, r.Stats.UnaliasedBytes / 1024);
+	}
+
+	// Schedule of a small frame, to check the barriers by hand.
+	RenderGraph graph;
+	RenderGraph::BuildSyntheticFrame(graph, 16);
+	if (!graph.Compile())
+		return 1;
+
+	std::ofstream schedule(schedulePath);
+	if (!schedule)
+		return 1;
+	schedule << graph.DumpSchedule();
+	return 0;
+}
+
+int DXRenderer::RunStreamBenchmark(UINT totalMB, UINT entryKB, const char* packPath, const char* reportPath)
+{
+	ComPtr<ID3D12Device> device;
+	if (FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+		return 1;
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	file << std::format("# uploadRingMB={} bytesPerFrameMB={}\n", UploadRingSize / (1024 * 1024), StreamBytesPerFrame / (1024 * 1024));
+	file << "entryKB,requests,MB,frames,ms,MBPerSecond,requestsPerSecond,sinkStalls,cold\n";
+	// An existing pack is streamed once, as it is.
+	UINT entrySizes[] = { entryKB, 64, 1024 };
+	for (UINT size : entrySizes)
+	{
+		if (size == 0)
+			continue;
+
+		StreamThroughputResult r = DXAssetStreamer::MeasureThroughput(device.Get(), packPath, (uint64_t)totalMB * 1024 * 1024, (uint64_t)size * 1024,
+			UploadRingSize, StreamBytesPerFrame);
+		if (r.Requests == 0)
+			return 1;
+
+		file << std::format("{},{},{},{},{:.3f},{:.1f},{:.0f},{},{}\n", r.Bytes / r.Requests / 1024, r.Requests, r.Bytes / (1024 * 1024),
+			r.Frames, r.Ms, r.MBPerSecond, r.RequestsPerSecond, r.SinkStalls, r.Cold ? 1 : 0);
+		if (totalMB == 0)
+			break;
+	}
+	return 0;
+}
+
+int DXRenderer::RunPipelineBenchmark(UINT pipelineCount, const char* cachePath, const char* reportPath)
+{
+	using Clock = std::chrono::steady_clock;
+
+	ComPtr<ID3D12Device> device;
+	if (FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+		return 1;
+
+	// Every pipeline gets its own pixel shader so none of them can share a driver-side compile.
+	const char* shaderSource =
+		"float4 VSMain(float3 pos : POSITION) : SV_Position { return float4(pos * SCALE, 1.0f); }\n"
+		"float4 PSMain(float4 pos : SV_Position) : SV_Target { return frac(pos * SCALE).xyzx; }\n";
+
+	std::vector<ComPtr<ID3DBlob>> vertexShaders(pipelineCount);
+	std::vector<ComPtr<ID3DBlob>> pixelShaders(pipelineCount);
+	for (UINT i = 0; i < pipelineCount; i++)
+	{
+		std::string scale = std::format("{}.0f", i + 1);
+		D3D_SHADER_MACRO defines[] = { { "SCALE", scale.c_str() }, { nullptr, nullptr } };
+		if (FAILED(D3DCompile(shaderSource, strlen(shaderSource), nullptr, defines, nullptr, "VSMain", "vs_5_0", 0, 0, &vertexShaders[i], nullptr)) ||
+			FAILED(D3DCompile(shaderSource, strlen(shaderSource), nullptr, defines, nullptr, "PSMain", "ps_5_0", 0, 0, &pixelShaders[i], nullptr)))
+			return 1;
+	}
+
+	D3D12_ROOT_SIGNATURE_DESC rootDesc = {};
+	rootDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+	ComPtr<ID3DBlob> rootBlob;
+	if (FAILED(D3D12SerializeRootSignature(&rootDesc, D3D_ROOT_SIGNATURE_VERSION_1, &rootBlob, nullptr)))
+		return 1;
+
+	D3D12_INPUT_ELEMENT_DESC inputElement = { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	std::remove(cachePath);
+	file << std::format("# pipelines={}\n", pipelineCount);
+	file << "run,library,totalMs,firstReadyMs,compiles,compileMs,maxCompileMs,libraryHits,loadMs,hitRate\n";
+
+	const char* runs[] = { "cold", "warm" };
+	for (const char* run : runs)
+	{
+		DXPipelineCache cache;
+		if (FAILED(cache.Initialize(device.Get(), cachePath, std::max(std::thread::hardware_concurrency(), 1u))))
+			return 1;
+
+		ComPtr<ID3D12RootSignature> rootSignature;
+		if (FAILED(cache.CreateRootSignature(rootBlob->GetBufferPointer(), rootBlob->GetBufferSize(), &rootSignature)))
+			return 1;
+
+		Clock::time_point begin = Clock::now();
+
+		std::vector<DXPipelineHandle> handles(pipelineCount);
+		for (UINT i = 0; i < pipelineCount; i++)
+		{
+			D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+			desc.pRootSignature = rootSignature.Get();
+			desc.VS = { vertexShaders[i]->GetBufferPointer(), vertexShaders[i]->GetBufferSize() };
+			desc.PS = { pixelShaders[i]->GetBufferPointer(), pixelShaders[i]->GetBufferSize() };
+			desc.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_ONE;
+			desc.BlendState.RenderTarget[0].DestBlend = D3D12_BLEND_ZERO;
+			desc.BlendState.RenderTarget[0].BlendOp = D3D12_BLEND_OP_ADD;
+			desc.BlendState.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ONE;
+			desc.BlendState.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ZERO;
+			desc.BlendState.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_ADD;
+			desc.BlendState.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_NOOP;
+			desc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+			desc.SampleMask = UINT_MAX;
+			desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+			desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+			desc.RasterizerState.DepthClipEnable = TRUE;
+			desc.DepthStencilState.DepthEnable = TRUE;
+			desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+			desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+			desc.InputLayout = { &inputElement, 1 };
+			desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+			desc.NumRenderTargets = 1;
+			desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+			desc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+			desc.SampleDesc.Count = 1;
+			handles[i] = cache.RequestGraphics(desc);
+		}
+
+		// What a renderer waiting on its first pipeline would see.
+		while (pipelineCount > 0 && !cache.IsReady(handles[0]) && cache.Stats().Pending > 0)
+			std::this_thread::yield();
+		double firstReadyMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+		cache.WaitIdle();
+		double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+		DXPipelineCacheStats stats = cache.Stats();
+		file << std::format("{},{},{:.3f},{:.3f},{},{:.3f},{:.3f},{},{:.3f},{:.3f}\n", run, cache.HasLibrary() ? 1 : 0, totalMs, firstReadyMs,
+			stats.Compiles, stats.CompileMs, stats.MaxCompileMs, stats.LibraryHits, stats.LoadMs, stats.HitRate());
+
+		// Shutdown() saves the library for the warm run.
+		cache.Shutdown();
+	}
+
+	return 0;
+}
+
+int DXRenderer::RunZoneBenchmark(UINT zoneCount, const char* reportPath)
+{
+	CpuProfilerOverhead r = CpuProfiler::MeasureOverhead(zoneCount);
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	file << "zones,capturingNsPerZone,recordNsPerZone,idleNsPerZone,drainNsPerZone,timestampNs,budgetNs,withinBudget\n";
+	file << std::format("{},{:.2f},{:.2f},{:.2f},{:.2f},{:.2f},{:.0f},{}\n", r.Zones, r.CapturingNsPerZone, r.RecordNsPerZone, r.IdleNsPerZone,
+		r.DrainNsPerZone, r.TimestampNs, CpuProfilerOverhead::BudgetNs, r.WithinBudget() ? 1 : 0);
+	// Fails where the host's timestamp alone makes the budget unreachable; timestampNs shows when that is the case.
+	return r.WithinBudget() ? 0 : 1;
+}
+
+int DXRenderer::RunPaceBenchmark(double targetFps, UINT frameCount, const char* reportPath)
+{
+	SystemPacerClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetFps(targetFps);
+
+	for (UINT i = 0; i < frameCount; i++)
+		pacer.Wait();
+
+	FramePacerStats r = pacer.Stats();
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	file << "targetFps,frames,missed,meanErrorUs,p99ErrorUs,maxErrorUs,meanIntervalMs,intervalStdDevMs,sleepMs,spinMs,spinWindowUs\n";
+	file << std::format("{:.2f},{},{},{:.2f},{:.2f},{:.2f},{:.4f},{:.4f},{:.2f},{:.2f},{:.2f}\n", pacer.TargetFps(), r.Frames, r.Missed,
+		r.MeanErrorUs, r.P99ErrorUs, r.MaxErrorUs, r.MeanIntervalMs, r.IntervalStdDevMs, r.SleepMs, r.SpinMs, r.SpinWindowUs);
+	return 0;
+}
+
+int DXRenderer::RunResizeBenchmark(UINT frameCount, double gpuLatencyMs, const char* reportPath)
+{
+	std::vector<ResizeStressResult> results = ResizeScheduler::MeasureResize(frameCount, gpuLatencyMs);
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	file << std::format("# frames={} gpuLatencyMs={}\n", frameCount, gpuLatencyMs);
+	file << "strategy,requests,resizes,allocations,poolHits,stallMs,meanMs,p99Ms,maxMs\n";
+	for (const ResizeStressResult& r : results)
+	{
+		file << std::format("{},{},{},{},{},{:.3f},{:.4f},{:.4f},{:.4f}\n", r.Strategy, r.Requests, r.Resizes, r.Allocations, r.PoolHits,
+			r.StallMs, r.MeanMs, r.P99Ms, r.MaxMs);
+	}
+
+	return 0;
+}
+
+int DXRenderer::RunBreadcrumbBenchmark(UINT markerCount, const char* reportPath)
+{
+	BreadcrumbOverhead result = GpuBreadcrumbs::MeasureOverhead(markerCount);
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	file << "markers,nsPerMarker,hangLocated\n";
+	file << std::format("{},{:.2f},{}\n", result.Markers, result.NsPerMarker, result.HangLocated ? 1 : 0);
+
+	return result.HangLocated ? 0 : 1;
+}
+
+int DXRenderer::RunDynamicResolutionBenchmark(double budgetMs, const char* tracePath, const char* reportPath)
+{
+	std::vector<double> trace;
+	std::ifstream input(tracePath);
+	for (double ms = 0.0; input >> ms;)
+		trace.push_back(ms);
+
+	if (trace.empty())
+	{
+		// 70% of the budget with some jitter, then a stretch at 160% and one at 110%, then back.
+		for (UINT i = 0; i < 900; i++)
+		{
+			double load = i >= 200 && i < 400 ? 1.6 : i >= 550 && i < 700 ? 1.1 : 0.7;
+			trace.push_back(budgetMs * load * (1.0 + 0.05 * sin(i * 0.7)));
+		}
+	}
+
+	DynamicResolutionSettings settings;
+	settings.BudgetMs = budgetMs;
+	// Times come back as many frames late as there are contexts in flight.
+	std::vector<DynamicResolutionSample> samples = DynamicResolutionController::Replay(settings, trace, 3);
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	size_t fixedOver = 0;
+	size_t dynamicOver = 0;
+	double scaleSum = 0.0;
+	for (size_t i = 0; i < trace.size(); i++)
+	{
+		fixedOver += trace[i] > budgetMs ? 1 : 0;
+		dynamicOver += samples[i].GpuMs > budgetMs ? 1 : 0;
+		scaleSum += samples[i].Scale;
+	}
+
+	file << std::format("# frames={} budgetMs={} trace={} overBudgetFixed={} overBudgetDynamic={} meanScale={:.3f}\n", trace.size(), budgetMs,
+		input.is_open() ? tracePath : "synthetic", fixedOver, dynamicOver, scaleSum / (double)trace.size());
+	file << "frame,fullResolutionMs,scale,gpuMs\n";
+	for (size_t i = 0; i < trace.size(); i++)
+		file << std::format("{},{:.3f},{:.4f},{:.3f}\n", i, trace[i], samples[i].Scale, samples[i].GpuMs);
+
+	return 0;
+}
+
+int DXRenderer::RunLogBenchmark(UINT messageCount, const char* reportPath)
+{
+	LoggerOverhead result = Logger::MeasureOverhead(messageCount, std::max(std::thread::hardware_concurrency(), 1u));
+
+	std::ofstream file(reportPath);
+	if (!file)
+		return 1;
+
+	file << "messages,threads,nsPerMessage,nsPerMessageThreaded,nsPerFiltered,dropped\n";
+	file << std::format("{},{},{:.2f},{:.2f},{:.2f},{}\n", result.Messages, result.Threads, result.NsPerMessage,
+		result.NsPerMessageThreaded, result.NsPerFiltered, result.Dropped);
+
+	return 0;
+}
+
 void DXRenderer::InitWindow()
 {
 	WNDCLASS wc;
@@ -135,6 +658,14 @@ void DXRenderer::InitWindow()
 		MessageBox(0, L"CreateWindow Failed.", 0, 0);
 	}
 
+	// Relative mouse motion at the device's full rate, delivered as WM_INPUT.
+	RAWINPUTDEVICE mouse = {};
+	mouse.usUsagePage = 0x01; // HID_USAGE_PAGE_GENERIC
+	mouse.usUsage = 0x02;     // HID_USAGE_GENERIC_MOUSE
+	mouse.hwndTarget = mHwnd;
+	if (!RegisterRawInputDevices(&mouse, 1, sizeof(mouse)))
+		LOG_WARNING("Failed to register for raw mouse input");
+
 	ShowWindow(mHwnd, SW_SHOW);
 	UpdateWindow(mHwnd);
 }
@@ -158,7 +689,100 @@ LRESULT DXRenderer::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		// We pause the game when the window is deactivated and unpause it 
 		// when it becomes active.  
 	case WM_ACTIVATE:
-		if (LOWORD(wParam) == WA_INACTIVE)
+		PostWindowCommand(WindowCommandType::Activate, LOWORD(wParam) != WA_INACTIVE ? 1 : 0);
+		return 0;
+
+		// WM_SIZE is sent when the user resizes the window.  
+	case WM_SIZE:
+		PostWindowCommand(WindowCommandType::Size, (uint32_t)wParam, LOWORD(lParam), HIWORD(lParam));
+		return 0;
+
+		// WM_EXITSIZEMOVE is sent when the user grabs the resize bars.
+	case WM_ENTERSIZEMOVE:
+		PostWindowCommand(WindowCommandType::EnterSizeMove);
+		return 0;
+
+		// WM_EXITSIZEMOVE is sent when the user releases the resize bars.
+		// Here we reset everything based on the new window dimensions.
+	case WM_EXITSIZEMOVE:
+		PostWindowCommand(WindowCommandType::ExitSizeMove);
+		return 0;
+
+		// WM_DESTROY is sent when the window is being destroyed.
+	case WM_CLOSE:
+		// The render thread presents to this window, so it stops before DestroyWindow(); Stop() keeps handling the messages
+		// it sends meanwhile. What it failed with, if anything, is rethrown by RunThreaded() once the message loop is left,
+		// not through DispatchMessage.
+		if (mRenderThread.IsRunning())
+		{
+			try { mRenderThread.Stop(); }
+			catch (...) { mWindowFailure = std::current_exception(); }
+		}
+		DestroyWindow(hWnd);
+		return 0;
+
+	case WM_DESTROY:
+		PostQuitMessage(0);
+		return 0;
+
+	case StatsTitleMessage:
+		SetWindowTextA(hWnd, StatsTitle().c_str());
+		return 0;
+
+		// The WM_MENUCHAR message is sent when a menu is active and the user presses 
+		// a key that does not correspond to any mnemonic or accelerator key. 
+	case WM_MENUCHAR:
+		// Don't beep when we alt-enter.
+		return MAKELRESULT(0, MNC_CLOSE);
+
+		// Catch this message so to prevent the window from becoming too small.
+	case WM_GETMINMAXINFO:
+		((MINMAXINFO*)lParam)->ptMinTrackSize.x = 200;
+		((MINMAXINFO*)lParam)->ptMinTrackSize.y = 200;
+		return 0;
+
+	case WM_LBUTTONDOWN:
+	case WM_MBUTTONDOWN:
+	case WM_RBUTTONDOWN:
+		OnMouseDown(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		return 0;
+	case WM_LBUTTONUP:
+	case WM_MBUTTONUP:
+	case WM_RBUTTONUP:
+		OnMouseUp(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		return 0;
+	case WM_MOUSEMOVE:
+		OnMouseMove(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		return 0;
+	case WM_INPUT:
+		OnRawInput((HRAWINPUT)lParam);
+		// Lets the system release the raw input buffer.
+		return DefWindowProc(hWnd, msg, wParam, lParam);
+	case WM_KEYDOWN:
+		// Bit 30 is set on auto-repeat.
+		if ((lParam & (1 << 30)) == 0)
+			PushKey(wParam, true);
+		return 0;
+	case WM_KEYUP:
+		PushKey(wParam, false);
+		if (wParam == VK_ESCAPE)
+			PostQuitMessage(0);
+		else
+			PostWindowCommand(WindowCommandType::Key, (uint32_t)wParam);
+		return 0;
+	default:
+		return DefWindowProc(hWnd, msg, wParam, lParam);
+	}
+
+	return DefWindowProc(hWnd, msg, wParam, lParam);
+}
+
+void DXRenderer::ApplyWindowCommand(const WindowCommand& command)
+{
+	switch (command.Type)
+	{
+	case WindowCommandType::Activate:
+		if (command.Param == 0)
 		{
 			mAppPaused = true;
 			mTimer.Stop();
@@ -168,33 +792,32 @@ LRESULT DXRenderer::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 			mAppPaused = false;
 			mTimer.Start();
 		}
-		return 0;
+		break;
 
-		// WM_SIZE is sent when the user resizes the window.  
-	case WM_SIZE:
-		// Save the new client area dimensions.
-		mClientWidth = LOWORD(lParam);
-		mClientHeight = HIWORD(lParam);
-		if (this)
+	case WindowCommandType::Size:
+		if (!mDevice)
 		{
-			//Log(std::format("Width: {}, Height: {}\n", mClientWidth, mClientHeight).c_str());
+			// Save the new client area dimensions; the constructor's OnResize() creates buffers of that size.
+			mClientWidth = command.Width;
+			mClientHeight = command.Height;
 		}
-		if (mDevice)
+		else
 		{
-			if (wParam == SIZE_MINIMIZED)
+			int64_t now = GameTimer::CurrentTicks();
+			if (command.Param == SIZE_MINIMIZED)
 			{
 				mAppPaused = true;
 				mMinimized = true;
 				mMaximized = false;
 			}
-			else if (wParam == SIZE_MAXIMIZED)
+			else if (command.Param == SIZE_MAXIMIZED)
 			{
 				mAppPaused = false;
 				mMinimized = false;
 				mMaximized = true;
-				OnResize();
+				mResizeScheduler.Request(command.Width, command.Height, now, true);
 			}
-			else if (wParam == SIZE_RESTORED)
+			else if (command.Param == SIZE_RESTORED)
 			{
 
 				// Restoring from minimized state?
@@ -202,7 +825,7 @@ LRESULT DXRenderer::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				{
 					mAppPaused = false;
 					mMinimized = false;
-					OnResize();
+					mResizeScheduler.Request(command.Width, command.Height, now, true);
 				}
 
 				// Restoring from maximized state?
@@ -210,126 +833,161 @@ LRESULT DXRenderer::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				{
 					mAppPaused = false;
 					mMaximized = false;
-					OnResize();
+					mResizeScheduler.Request(command.Width, command.Height, now, true);
 				}
 				else if (mResizing)
 				{
-					// If user is dragging the resize bars, we do not resize 
-					// the buffers here because as the user continuously 
-					// drags the resize bars, a stream of WM_SIZE messages are
-					// sent to the window, and it would be pointless (and slow)
-					// to resize for each WM_SIZE message received from dragging
-					// the resize bars.  So instead, we reset after the user is 
-					// done resizing the window and releases the resize bars, which 
-					// sends a WM_EXITSIZEMOVE message.
+					// If user is dragging the resize bars, a stream of WM_SIZE
+					// messages is sent to the window, and it would be pointless
+					// (and slow) to resize for each of them. The scheduler keeps
+					// the latest size and applies it once the drag pauses for its
+					// debounce time, or when WM_EXITSIZEMOVE ends the drag.
+					mResizeScheduler.Request(command.Width, command.Height, now, false);
 				}
 				else // API call such as SetWindowPos or mSwapChain->SetFullscreenState.
 				{
-					OnResize();
+					mResizeScheduler.Request(command.Width, command.Height, now, true);
 				}
 			}
 		}
-		return 0;
+		break;
 
-		// WM_EXITSIZEMOVE is sent when the user grabs the resize bars.
-	case WM_ENTERSIZEMOVE:
-		mAppPaused = true;
+	case WindowCommandType::EnterSizeMove:
 		mResizing = true;
-		mTimer.Stop();
-		return 0;
+		// The render thread keeps drawing at the old size while the modal loop runs; DXGI stretches it.
+		if (!mUseRenderThread)
+		{
+			mAppPaused = true;
+			mTimer.Stop();
+		}
+		break;
 
-		// WM_EXITSIZEMOVE is sent when the user releases the resize bars.
-		// Here we reset everything based on the new window dimensions.
-	case WM_EXITSIZEMOVE:
-		mAppPaused = false;
+	case WindowCommandType::ExitSizeMove:
 		mResizing = false;
-		mTimer.Start();
-		OnResize();
-		return 0;
-
-		// WM_DESTROY is sent when the window is being destroyed.
-	case WM_DESTROY:
-		PostQuitMessage(0);
-		return 0;
-
-		// The WM_MENUCHAR message is sent when a menu is active and the user presses 
-		// a key that does not correspond to any mnemonic or accelerator key. 
-	case WM_MENUCHAR:
-		// Don't beep when we alt-enter.
-		return MAKELRESULT(0, MNC_CLOSE);
-
-		// Catch this message so to prevent the window from becoming too small.
-	case WM_GETMINMAXINFO:
-		((MINMAXINFO*)lParam)->ptMinTrackSize.x = 200;
-		((MINMAXINFO*)lParam)->ptMinTrackSize.y = 200;
-		return 0;
-
-	case WM_LBUTTONDOWN:
-	case WM_MBUTTONDOWN:
-	case WM_RBUTTONDOWN:
-		OnMouseDown(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
-		return 0;
-	case WM_LBUTTONUP:
-	case WM_MBUTTONUP:
-	case WM_RBUTTONUP:
-		OnMouseUp(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
-		return 0;
-	case WM_MOUSEMOVE:
-		OnMouseMove(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
-		return 0;
-	case WM_KEYUP:
-		if (wParam == VK_ESCAPE)
+		if (!mUseRenderThread)
 		{
-			PostQuitMessage(0);
+			mAppPaused = false;
+			mTimer.Start();
 		}
-		/*else if ((int)wParam == VK_F2)
-			Set4xMsaaState(!m4xMsaaState);*/
-		return 0;
+		mResizeScheduler.Expedite();
+		break;
+
+	case WindowCommandType::Key:
+		OnKeyUp(command.Param);
+		break;
+
 	default:
-		return DefWindowProc(hWnd, msg, wParam, lParam);
+		break;
 	}
+}
 
-	return DefWindowProc(hWnd, msg, wParam, lParam);
+void DXRenderer::OnKeyUp(WPARAM key)
+{
+	if (key == VK_F4)
+	{
+		mParallelRecording = !mParallelRecording;
+		LOG_INFO("Parallel command list recording {}", mParallelRecording ? "enabled" : "disabled");
+	}
+	else if (key == VK_F5)
+	{
+		LogSubsystemStats();
+	}
+	else if (key == VK_F6)
+	{
+		ToggleCpuCapture();
+	}
+	else if (key == VK_F7)
+	{
+		SetMaxFrameLatency(mMaxFrameLatency % mBufferCount + 1);
+	}
+	else if (key == VK_F8)
+	{
+		SetFramePacing((FramePacingMode)(((uint32_t)mFramePacer.Mode() + 1) % 3), mPacingFps, mVsyncDivisor);
+	}
+	else if (key == VK_F9)
+	{
+		SetDynamicResolution(!mDynamicResolutionEnabled, mDynamicResolution.Settings().BudgetMs);
+	}
+	else if (key == VK_F3)
+	{
+		if (!mFrameStats.Dump("frame_stats"))
+			LOG_WARNING("Failed to write frame_stats.csv/json");
+
+		std::ofstream schedule("render_graph_schedule.txt");
+		schedule << mRenderGraph.Graph().DumpSchedule();
+
+		ChromeTrace trace(mTimer.TicksPerSecond());
+		trace.SetTrackName(0, "CPU render thread");
+		trace.SetTrackName(1, "GPU graphics queue");
+		mGpuProfiler.Profiler().AppendTrace(trace, 0, 1);
+		if (!trace.Write("gpu_trace.json"))
+			LOG_WARNING("Failed to write gpu_trace.json");
+	}
+	/*else if ((int)key == VK_F2)
+		Set4xMsaaState(!m4xMsaaState);*/
 }
 
 void DXRenderer::CalculateFrameStats()
 {
-	static int frameCount = 0;
-	static float timeElapsed = 0.0f;
-	frameCount++;
+	// DeltaTicks() spans the previous Draw, which is what mFrameSample describes.
+	mFrameSample.FrameTicks = mTimer.DeltaTicks();
+	mFrameStats.Push(mFrameSample);
+	mFrameSample = {};
 
-	if ((mTimer.TotalTime() - timeElapsed) >= 1.0f)
+	__int64 now = GameTimer::CurrentTicks();
+	if (now - mLastStatsTitleTicks >= mTimer.TicksPerSecond())
 	{
-		float fps = (float)frameCount;
-		float mspf = 1000.f / fps;
+		mLastStatsTitleTicks = now;
+
+		// The refresh rate drifts slightly and changes when the window moves to another display.
+		int64_t period = 0;
+		int64_t vblank = 0;
+		if (mFramePacer.Mode() == FramePacingMode::VsyncAligned && QueryVsyncTiming(period, vblank))
+			mFramePacer.UpdateVsync(period, vblank);
 
-		std::string windowText = std::format("FPS: {} Frametime: {}", fps, mspf);
-		SetWindowTextA(mHwnd, windowText.c_str());
+		FrameMetricSummary frame = mFrameStats.Summarize(FrameMetric::Frame);
+		FrameMetricSummary wait = mFrameStats.Summarize(FrameMetric::Wait);
+		FrameMetricSummary input = mFrameStats.Summarize(FrameMetric::InputLatency);
 
-		frameCount = 0;
-		timeElapsed += 1.0f;
+		std::string windowText = std::format("Frame p50: {:.2f}ms p95: {:.2f}ms p99: {:.2f}ms max: {:.2f}ms | Wait p99: {:.2f}ms | GPU: {:.2f}ms | Input p50: {:.2f}ms p95: {:.2f}ms (latency {})",
+			frame.P50Ms, frame.P95Ms, frame.P99Ms, frame.MaxMs, wait.P99Ms, mGpuProfiler.Profiler().LatestFrameMs(), input.P50Ms, input.P95Ms, mMaxFrameLatency);
+		{
+			std::lock_guard<std::mutex> lock(mStatsTitleLock);
+			mStatsTitle = std::move(windowText);
+		}
+		// SetWindowText() would send WM_SETTEXT and block this thread until the window thread handles it.
+		PostMessage(mHwnd, StatsTitleMessage, 0, 0);
 	}
 }
 
+std::string DXRenderer::StatsTitle()
+{
+	std::lock_guard<std::mutex> lock(mStatsTitleLock);
+	return mStatsTitle;
+}
+
 void DXRenderer::OnResize()
 {
-	ClearCommandQueue();
+	CPU_ZONE_FUNCTION();
 
-	ThrowIfFailed(mCmdAllocator->Reset());
-	ThrowIfFailed(mCmdList->Reset(mCmdAllocator.Get(), nullptr));
+	__int64 begin = GameTimer::CurrentTicks();
+
+	// ResizeBuffers needs the GPU done with the back buffers. Only the graphics queue touches them,
+	// so copy work keeps running; fence values carry on from where they were.
+	mFrameSync.WaitIdle();
 
 	for (int i = 0; i < mBufferCount; i++)
 		mSwapchainBuffer[i].Reset();
-	mDepthBuffer.Reset();
-
-	mCurrBackBuffer = 0;
-	mCurrentFence = 0;
 
-	ThrowIfFailed(mSwapchain->ResizeBuffers(mBufferCount, mClientWidth, mClientHeight, mBackBufferFormat, DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING | DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH));
+	// The flags have to match creation, or the waitable object stops being signaled.
+	ThrowIfFailed(mSwapchain->ResizeBuffers(mBufferCount, mClientWidth, mClientHeight, mBackBufferFormat, mSwapchainFlags));
+	mCurrBackBuffer = mSwapchain->GetCurrentBackBufferIndex();
+	mResizeScheduler.MarkApplied(mClientWidth, mClientHeight);
 
-	Log("Resizing called\n");
+	LOG_INFO("Resizing called");
 
-	CreateRenderTargetViews(false);
+	CreateRenderTargetViews();
+	AcquireDepthBuffer();
 
 	ZeroMemory(&vp, sizeof(vp));
 	ZeroMemory(&scissor, sizeof(scissor));
@@ -339,62 +997,429 @@ void DXRenderer::OnResize()
 	vp.MaxDepth = 1.0f;
 
 	scissor = { 0, 0, mClientWidth, mClientHeight };
+
+	__int64 ticks = GameTimer::CurrentTicks() - begin;
+	mResizeCount++;
+	mResizeTicks += ticks;
+	mMaxResizeTicks = std::max(mMaxResizeTicks, ticks);
 }
 
-void DXRenderer::Update(const GameTimer& GameTimer)
+void DXRenderer::ApplyPendingResize()
 {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	if (!mResizeScheduler.Poll(GameTimer::CurrentTicks(), width, height))
+		return;
+
+	mClientWidth = (INT)width;
+	mClientHeight = (INT)height;
+	OnResize();
 }
 
-void DXRenderer::Draw(const GameTimer& GameTimer)
+void DXRenderer::Update()
 {
-	ThrowIfFailed(mCmdAllocator->Reset());
-	ThrowIfFailed(mCmdList->Reset(mCmdAllocator.Get(), nullptr));
+	CPU_ZONE_FUNCTION();
+
+	if (mInputBatchCount == 0)
+		return;
+
+	// The first step of a frame takes the whole batch; the frame's input latency starts at its oldest event.
+	// Applying a batch costs far less than scheduling and waiting for a job, so it stays on this thread.
+	if (mFrameInputTicks == 0)
+		mFrameInputTicks = mInputBatch[0].Ticks;
+	for (uint32_t i = 0; i < mInputBatchCount; i++)
+		mInputState.Apply(mInputBatch[i]);
+	mInputBatchCount = 0;
+}
 
-	D3D12_RESOURCE_BARRIER presentToRender = {};
-	presentToRender.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	presentToRender.Transition.pResource = mSwapchainBuffer[mCurrBackBuffer].Get();
-	presentToRender.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-	presentToRender.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
+void DXRenderer::LogSubsystemStats()
+{
+	std::vector<JobWorkerStats> stats = mJobs->Stats();
+	for (size_t i = 0; i < stats.size(); i++)
+	{
+		LOG_INFO("[Jobs] worker {}: {} jobs, {} steals ({} failed), {:.1f}% busy",
+			i, stats[i].JobsExecuted, stats[i].Steals, stats[i].FailedSteals, stats[i].Utilization * 100.0);
+	}
+	mJobs->ResetStats();
+
+	const UploadRingStats& upload = mUploadRing.Stats();
+	LOG_INFO("[Upload] {} / {} KB used, high-water mark {} KB, peak frame {} KB, {} allocations, {} stalls, {} failures",
+		upload.Used / 1024, upload.Capacity / 1024, upload.HighWaterMark / 1024, upload.PeakFrameBytes / 1024,
+		upload.Allocations, upload.Stalls, upload.Failures);
+
+	const UploadRingStats& tables = mShaderVisibleHeap.RingStats();
+	LOG_INFO("[Descriptors] RTV {}/{} DSV {}/{} staging {}/{} (peak {}), persistent {} (peak {}), ring high-water mark {}/{}, {} stalls",
+		mRtvHeap.Allocated(), mRtvHeap.Capacity(), mDsvHeap.Allocated(), mDsvHeap.Capacity(),
+		mCbvSrvUavHeap.Allocated(), mCbvSrvUavHeap.Capacity(), mCbvSrvUavHeap.HighWaterMark(),
+		mShaderVisibleHeap.PersistentAllocated(), mShaderVisibleHeap.PersistentHighWaterMark(),
+		tables.HighWaterMark, tables.Capacity, tables.Stalls);
+
+	const char* queueNames[] = { "graphics", "copy" };
+	for (uint32_t queue = 0; queue < GpuTimeline::QueueCount; queue++)
+	{
+		DXQueueStats stats = mQueues.Stats((GpuQueueType)queue);
+		LOG_INFO("[Queues] {}: fence {} / {} completed, {} submissions, {} GPU waits, {} pooled allocators",
+			queueNames[queue], mQueues.Timeline().CompletedValue((GpuQueueType)queue), mQueues.Timeline().LastSignaled((GpuQueueType)queue).Value,
+			stats.Submissions, stats.GpuWaits, stats.Allocators);
+	}
 
-	mCmdList->ResourceBarrier(1u, &presentToRender);
+	const char* heapKinds[] = { "buffers", "render targets", "textures" };
+	for (uint32_t kind = 0; kind < (uint32_t)GpuHeapKind::Count; kind++)
+	{
+		GpuMemoryStats memory = mGpuMemory.Stats((GpuHeapKind)kind);
+		LOG_INFO("[GpuMemory] {}: {} heaps, {} allocations, {} / {} KB used, largest free {} KB in {} ranges, {:.1f}% fragmented",
+			heapKinds[kind], memory.Heaps, memory.Allocations, memory.UsedBytes / 1024, memory.ReservedBytes / 1024,
+			memory.LargestFreeBytes / 1024, memory.FreeRanges, memory.Fragmentation * 100.0);
+	}
 
-	mCmdList->RSSetViewports(1u, &vp);
-	mCmdList->RSSetScissorRects(1u, &scissor);
+	ResizeSchedulerStats resize = mResizeScheduler.Stats();
+	RenderTargetPoolStats depthPool = mDepthPool.Stats();
+	double ticksPerMs = (double)mTimer.TicksPerSecond() / 1000.0;
+	LOG_INFO("[Resize] {} requests, {} coalesced, {} redundant, {} applied {:.1f} ms after the first request on average (max {:.1f} ms); {} resizes took {:.2f} ms mean, {:.2f} ms max; depth pool {} hits, {} misses, {} retiring, {} free, {} evicted",
+		resize.Requests, resize.Coalesced, resize.Redundant, resize.Applied, resize.MeanDelayMs, resize.MaxDelayMs,
+		mResizeCount, mResizeCount ? (double)mResizeTicks / ticksPerMs / (double)mResizeCount : 0.0, (double)mMaxResizeTicks / ticksPerMs,
+		depthPool.Hits, depthPool.Misses, depthPool.Retiring, depthPool.Free, depthPool.Evictions);
+	mResizeScheduler.ResetStats();
+	mDepthPool.ResetStats();
+	mResizeCount = 0;
+	mResizeTicks = 0;
+	mMaxResizeTicks = 0;
+
+	StreamStats stream = mAssetStreamer.Stats();
+	LOG_INFO("[Stream] {} / {} requests resident ({} KB), {} queued, {} prefetched ({} KB), {} upload stalls",
+		stream.Completed, stream.Requested, stream.BytesCompleted / 1024, stream.Queued, stream.Ready, stream.ReadyBytes / 1024,
+		stream.SinkStalls);
+
+	DXPipelineCacheStats pipelines = mPipelines.Stats();
+	LOG_INFO("[Pipelines] {} requests, {:.1f}% hits ({} in memory, {} from library), {} compiled in {:.1f} ms (max {:.1f} ms), {} pending, {} failed, {} fallback draws",
+		pipelines.Requests, pipelines.HitRate() * 100.0, pipelines.MemoryHits, pipelines.LibraryHits, pipelines.Compiles,
+		pipelines.CompileMs, pipelines.MaxCompileMs, pipelines.Pending, pipelines.Failures, pipelines.FallbackUses);
+
+	FrameMetricSummary input = mFrameStats.Summarize(FrameMetric::InputLatency);
+	FrameMetricSummary wait = mFrameStats.Summarize(FrameMetric::Wait);
+	LOG_INFO("[Present] max frame latency {}, tearing {}, input-to-present p50 {:.2f} ms p95 {:.2f} ms p99 {:.2f} ms, wait mean {:.2f} ms",
+		mMaxFrameLatency, mTearingSupported ? "on" : "off", input.P50Ms, input.P95Ms, input.P99Ms, wait.MeanMs);
+
+	InputQueueStats inputQueue = mInput->Stats();
+	LOG_INFO("[Input] {} raw events, {} coalesced, {} dropped; per frame {:.2f} events mean, p95 {}, max {}",
+		inputQueue.RawEvents, inputQueue.Coalesced, inputQueue.Dropped, inputQueue.MeanDepth, inputQueue.P95Depth, inputQueue.MaxDepth);
+	mInput->ResetStats();
+
+	if (mUseRenderThread)
+	{
+		RenderThreadStats thread = mRenderThread.Stats();
+		LOG_INFO("[RenderThread] {} frames, {} window commands applied {:.1f} us after posting on average (max {:.1f} us), {} idle waits",
+			thread.Frames, thread.Commands, thread.MeanCommandLatencyUs, thread.MaxCommandLatencyUs, thread.IdleWaits);
+		mRenderThread.ResetStats();
+	}
 
-	D3D12_CPU_DESCRIPTOR_HANDLE currBack = CurrentBackBufferView();
-	D3D12_CPU_DESCRIPTOR_HANDLE depth = DepthStencilView();
+	FramePacerStats pacing = mFramePacer.Stats();
+	LOG_INFO("[Pacing] {:.1f} fps target, {} frames, {} missed, wake error mean {:.1f} us p99 {:.1f} us max {:.1f} us, interval {:.3f} +- {:.3f} ms, {:.0f} ms slept, {:.0f} ms spun (window {:.0f} us)",
+		mFramePacer.TargetFps(), pacing.Frames, pacing.Missed, pacing.MeanErrorUs, pacing.P99ErrorUs, pacing.MaxErrorUs,
+		pacing.MeanIntervalMs, pacing.IntervalStdDevMs, pacing.SleepMs, pacing.SpinMs, pacing.SpinWindowUs);
+	mFramePacer.ResetStats();
+
+	const FixedTimestepStats& timestep = mTimestep.Stats();
+	LOG_INFO("[Timestep] {:.2f} Hz, step {}, simulated {:.3f} s, {:.2f} steps per frame (max {}), {} frames hit the catch-up limit, {:.1f} ms dropped",
+		mTimestep.Rate(), mTimestep.StepIndex(), mTimestep.SimulationSeconds(),
+		timestep.Frames ? (double)timestep.Steps / (double)timestep.Frames : 0.0, timestep.MaxStepsInFrame,
+		timestep.ClampedFrames, (double)timestep.DroppedTicks * 1000.0 / (double)mTimer.TicksPerSecond());
+	mTimestep.ResetStats();
+
+	LoggerStats log = Logger::Stats();
+	LOG_INFO("[Log] {} written, {} dropped, {} waited for room ({:.2f} ms), {} truncated, max depth {}/{}",
+		log.Written, log.Dropped, log.BackpressureWaits, log.BackpressureMs, log.Truncated, log.MaxDepth, Logger::Capacity);
+	Logger::ResetStats();
+
+	DynamicResolutionStats dynres = mDynamicResolution.Stats();
+	LOG_INFO("[DynRes] {}, {:.1f} ms budget, scale {:.3f} (mean {:.3f}, min {:.3f}), {} frames, {} over budget, {} scale changes, GPU mean {:.2f} ms",
+		mDynamicResolutionEnabled ? "on" : "off", mDynamicResolution.Settings().BudgetMs, mDynamicResolution.Scale(), dynres.MeanScale,
+		dynres.MinScale, dynres.Frames, dynres.OverBudget, dynres.ScaleChanges, dynres.MeanGpuMs);
+	mDynamicResolution.ResetStats();
+}
 
-	FLOAT col[] = { sinf(mTimer.TotalTime()), -sinf(mTimer.TotalTime()), cosf(mTimer.TotalTime()), 1.0f};
-	mCmdList->ClearRenderTargetView(currBack, col, 1, &scissor);
-	mCmdList->ClearDepthStencilView(depth, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+void DXRenderer::ToggleCpuCapture()
+{
+	if (!CpuProfiler::IsCapturing())
+	{
+		CpuProfiler::Clear();
+		CpuProfiler::StartCapture();
+		LOG_INFO("CPU capture started");
+		return;
+	}
 
-	D3D12_RESOURCE_BARRIER renderToPresent = {};
-	renderToPresent.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	renderToPresent.Transition.pResource = mSwapchainBuffer[mCurrBackBuffer].Get();
-	renderToPresent.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-	renderToPresent.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+	CpuProfiler::StopCapture();
 
-	mCmdList->ResourceBarrier(1u, &renderToPresent);
+	ChromeTrace trace(CpuProfiler::ReferenceFrequency());
+	trace.SetTrackName(0, "Frame phases");
+	trace.SetTrackName(1, "GPU graphics queue");
+	mGpuProfiler.Profiler().AppendTrace(trace, 0, 1);
+	CpuProfiler::AppendTrace(trace, 2);
 
-	mCmdList->OMSetRenderTargets(1u, &currBack, TRUE, &depth);
+	CpuProfilerStats stats = CpuProfiler::Stats();
+	LOG_INFO("CPU capture stopped: {} events from {} threads, {} dropped", stats.Events, stats.Threads, stats.Dropped);
+	if (!trace.Write("cpu_trace.json"))
+		LOG_WARNING("Failed to write cpu_trace.json");
+}
 
-	ThrowIfFailed(mCmdList->Close());
+void DXRenderer::Draw(const GameTimer& GameTimer, float alpha)
+{
+	CPU_ZONE_FUNCTION();
+
+	__int64 waitStart = GameTimer::CurrentTicks();
+
+	// Only blocks if the GPU is still using this context from mBufferCount frames ago.
+	FrameContext& frame = mFrameRing.BeginFrame();
+	// Frames retired by that wait give their ring memory back now rather than when the ring runs out.
+	mUploadRing.Retire();
+	mShaderVisibleHeap.Retire();
+	// The context is retired, so the timestamps this slot resolved last time are ready.
+	mGpuProfiler.BeginFrame(mFrameRing.CurrentIndex(), mFrameStats.TotalFrames());
 
-	ComPtr<ID3D12CommandList> cmdLists[] =
+	// A newly collected frame is the one this context rendered last, at the scale it still records.
+	const GpuProfileFrame* gpuFrame = mGpuProfiler.Profiler().LatestFrame();
+	if (gpuFrame && gpuFrame->Frame != mLastScaledGpuFrame)
 	{
-		mCmdList.Get()
-	};
+		mLastScaledGpuFrame = gpuFrame->Frame;
+		if (mDynamicResolutionEnabled)
+			mDynamicResolution.Update(mGpuProfiler.Profiler().LatestFrameMs(), frame.RenderScale);
+	}
+
+	// Dynamic resolution renders into the top left of a window-sized target and stretches that over the back buffer,
+	// so changing the scale only changes the viewport. Until the upscale pipeline is compiled it renders directly.
+	bool upscale = mDynamicResolutionEnabled && mPipelines.IsReady(mUpscalePipeline);
+	uint32_t renderWidth = (uint32_t)mClientWidth;
+	uint32_t renderHeight = (uint32_t)mClientHeight;
+	if (upscale)
+		mDynamicResolution.ScaledSize((uint32_t)mClientWidth, (uint32_t)mClientHeight, renderWidth, renderHeight);
+	frame.RenderScale = upscale ? mDynamicResolution.Scale() : 1.0;
+
+	D3D12_VIEWPORT sceneViewport = vp;
+	sceneViewport.Width = (float)renderWidth;
+	sceneViewport.Height = (float)renderHeight;
+	D3D12_RECT sceneScissor = { 0, 0, (LONG)renderWidth, (LONG)renderHeight };
+
+	__int64 submitStart = GameTimer::CurrentTicks();
+
+	FrameConstants constants = {};
+	// Between the last two simulated states, so motion stays smooth when the frame rate and step rate differ.
+	const double renderTime = mTimestep.InterpolatedSeconds();
+	constants.TotalTime = (float)renderTime;
+	constants.DeltaTime = mTimer.DeltaTime();
+	constants.RenderTargetSize[0] = (float)renderWidth;
+	constants.RenderTargetSize[1] = (float)renderHeight;
+	constants.InterpolationAlpha = alpha;
+	DXUploadAllocation constantsAllocation = mUploadRing.UploadConstants(constants);
+	frame.FrameConstants = constantsAllocation.GpuAddress;
+
+	DXDescriptor frameTable = mShaderVisibleHeap.AllocateTable(1);
+	if (frameTable.IsValid() && constantsAllocation.IsValid())
+	{
+		D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
+		cbvDesc.BufferLocation = constantsAllocation.GpuAddress;
+		cbvDesc.SizeInBytes = (UINT)constantsAllocation.Size;
+		mDevice->CreateConstantBufferView(&cbvDesc, frameTable.Cpu);
+	}
+	frame.FrameTable = frameTable.Gpu;
 
-	mCmdQueue->ExecuteCommandLists((UINT)std::size(cmdLists), cmdLists->GetAddressOf());
+	// Before this frame's submission, so the graphics queue waits for the copies reading from its ring memory.
+	ThrowIfFailed(mAssetStreamer.Pump(StreamBytesPerFrame));
 
-	mCurrentFence++;
-	ThrowIfFailed(mCmdQueue->Signal(mFence.Get(), mCurrentFence));
+	ID3D12DescriptorHeap* descriptorHeaps[] = { mShaderVisibleHeap.Heap() };
 
-	ThrowIfFailed(mSwapchain->Present(0u, DXGI_PRESENT_ALLOW_TEARING));
+	// Declare this frame's passes; the graph works out the barriers between them.
+	mRenderGraph.Reset();
+	RenderGraphHandle backBuffer = mRenderGraph.Import("BackBuffer", mSwapchainBuffer[mCurrBackBuffer].Get(), RenderGraphState::Present, RenderGraphState::Present);
+	RenderGraphHandle depthBuffer = mRenderGraph.Import("Depth", mDepthBuffer.Resource.Get(), RenderGraphState::DepthWrite, RenderGraphState::DepthWrite);
 
-	mCurrBackBuffer = (mCurrBackBuffer + 1) % mBufferCount;
+	RenderGraphHandle sceneColor = backBuffer;
+	D3D12_CPU_DESCRIPTOR_HANDLE sceneRtv = CurrentBackBufferView();
+	if (upscale)
+	{
+		// Always the window's size, so the render graph keeps the same placed resource whatever the scale.
+		D3D12_RESOURCE_DESC colorDesc = {};
+		colorDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		colorDesc.Width = (UINT64)mClientWidth;
+		colorDesc.Height = (UINT)mClientHeight;
+		colorDesc.DepthOrArraySize = 1;
+		colorDesc.MipLevels = 1;
+		colorDesc.Format = mBackBufferFormat;
+		colorDesc.SampleDesc.Count = 1;
+		colorDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+		colorDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+		sceneColor = mRenderGraph.CreateTexture("SceneColor", colorDesc);
+		sceneRtv = mSceneColorRtv.Cpu;
+	}
 
-	FlushCommandQueue();
+	uint32_t clearPass = mRenderGraph.AddPass("Clear", [this, sceneViewport, sceneScissor, sceneRtv](ID3D12GraphicsCommandList* cmdList)
+	{
+		DXGpuProfileScope gpuScope(mGpuProfiler, cmdList, "Clear");
+		cmdList->RSSetViewports(1u, &sceneViewport);
+		cmdList->RSSetScissorRects(1u, &sceneScissor);
+
+		FLOAT col[] = { (FLOAT)sin(renderTime), (FLOAT)-sin(renderTime), (FLOAT)cos(renderTime), 1.0f };
+		cmdList->ClearRenderTargetView(sceneRtv, col, 1, &sceneScissor);
+		cmdList->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH, 1.0f, 1, &sceneScissor);
+	});
+	mRenderGraph.Write(clearPass, sceneColor, RenderGraphState::RenderTarget);
+	mRenderGraph.Write(clearPass, depthBuffer, RenderGraphState::DepthWrite);
+
+	// With parallel recording the scene goes into the recorder's lists, the pass only carries its barriers.
+	DXRenderGraph::PassFunction recordScene;
+	if (!mParallelRecording)
+	{
+		recordScene = [this, sceneRtv](ID3D12GraphicsCommandList* cmdList)
+		{
+			DXGpuProfileScope gpuScope(mGpuProfiler, cmdList, "Scene");
+			D3D12_CPU_DESCRIPTOR_HANDLE depth = DepthStencilView();
+			cmdList->OMSetRenderTargets(1u, &sceneRtv, TRUE, &depth);
+			RecordScene(cmdList, 0, 1);
+		};
+	}
+	uint32_t scenePass = mRenderGraph.AddPass("Scene", std::move(recordScene));
+	mRenderGraph.Write(scenePass, sceneColor, RenderGraphState::RenderTarget);
+	mRenderGraph.Write(scenePass, depthBuffer, RenderGraphState::DepthWrite);
+
+	DXDescriptor sceneTable = {};
+	if (upscale)
+	{
+		sceneTable = mShaderVisibleHeap.AllocateTable(1);
+		// UV scale of the rendered rectangle, and the last UV bilinear filtering may use without reading past it.
+		float upscaleConstants[4] =
+		{
+			(float)renderWidth / (float)mClientWidth,
+			(float)renderHeight / (float)mClientHeight,
+			((float)renderWidth - 0.5f) / (float)mClientWidth,
+			((float)renderHeight - 0.5f) / (float)mClientHeight
+		};
+
+		uint32_t upscalePass = mRenderGraph.AddPass("Upscale", [this, sceneTable, upscaleConstants](ID3D12GraphicsCommandList* cmdList)
+		{
+			DXGpuProfileScope gpuScope(mGpuProfiler, cmdList, "Upscale");
+			D3D12_CPU_DESCRIPTOR_HANDLE currBack = CurrentBackBufferView();
+			cmdList->OMSetRenderTargets(1u, &currBack, TRUE, nullptr);
+			cmdList->RSSetViewports(1u, &vp);
+			cmdList->RSSetScissorRects(1u, &scissor);
+			cmdList->SetPipelineState(mPipelines.Get(mUpscalePipeline));
+			cmdList->SetGraphicsRootSignature(mUpscaleRootSignature.Get());
+			cmdList->SetGraphicsRoot32BitConstants(0, 4, upscaleConstants, 0);
+			cmdList->SetGraphicsRootDescriptorTable(1, sceneTable.Gpu);
+			cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			cmdList->DrawInstanced(3, 1, 0, 0);
+		});
+		mRenderGraph.Read(upscalePass, sceneColor, RenderGraphState::ShaderResource);
+		mRenderGraph.Write(upscalePass, backBuffer, RenderGraphState::RenderTarget);
+	}
+
+	ThrowIfFailed(mRenderGraph.Compile());
+
+	if (upscale)
+	{
+		// The placed resource only changes with the window size, but the views are cheap enough to write every frame.
+		ID3D12Resource* sceneResource = mRenderGraph.Resource(sceneColor);
+		mDevice->CreateRenderTargetView(sceneResource, nullptr, mSceneColorRtv.Cpu);
+		if (sceneTable.IsValid())
+			mDevice->CreateShaderResourceView(sceneResource, nullptr, sceneTable.Cpu);
+	}
+
+	ThrowIfFailed(frame.CmdAllocator->Reset());
+	ThrowIfFailed(mCmdList->Reset(frame.CmdAllocator.Get(), nullptr));
+	mBreadcrumbs.SetCompletedValue(mFrameSync.CompletedValue());
+	mBreadcrumbs.BeginSubmission(mCmdList.Get(), "Frame", mFrameStats.TotalFrames());
+	mCmdList->SetDescriptorHeaps((UINT)std::size(descriptorHeaps), descriptorHeaps);
+	mGpuProfiler.BeginScope(mCmdList.Get(), "Frame");
+
+	if (mParallelRecording)
+	{
+		// Everything up to and including the scene pass's barriers goes first, the rest into mPostCmdList.
+		uint32_t postBatch = mRenderGraph.BatchOfPass(scenePass) + 1;
+		mRenderGraph.Execute(mCmdList.Get(), 0, postBatch);
+		// The recorder's lists execute between mCmdList and mPostCmdList, inside this scope and breadcrumb marker,
+		// so a hang in the scene's draws is reported in it rather than after the graph's Scene pass.
+		mGpuProfiler.BeginScope(mCmdList.Get(), "Scene");
+		mBreadcrumbs.BeginMarker(mCmdList.Get(), "Scene draws");
+		ThrowIfFailed(mCmdList->Close());
+
+		D3D12_CPU_DESCRIPTOR_HANDLE depth = DepthStencilView();
+		ThrowIfFailed(mParallelRecorder.Record(mFrameRing.CurrentIndex(), [&](ID3D12GraphicsCommandList* cmdList, uint32_t chunk, uint32_t chunkCount)
+		{
+			cmdList->SetDescriptorHeaps((UINT)std::size(descriptorHeaps), descriptorHeaps);
+			cmdList->RSSetViewports(1u, &sceneViewport);
+			cmdList->RSSetScissorRects(1u, &sceneScissor);
+			cmdList->OMSetRenderTargets(1u, &sceneRtv, TRUE, &depth);
+			RecordScene(cmdList, chunk, chunkCount);
+		}));
+
+		ThrowIfFailed(mPostCmdList->Reset(frame.CmdAllocator.Get(), nullptr));
+		// The Upscale pass samples from the shader visible heap.
+		mPostCmdList->SetDescriptorHeaps((UINT)std::size(descriptorHeaps), descriptorHeaps);
+		mBreadcrumbs.EndMarker(mPostCmdList.Get());
+		mGpuProfiler.EndScope(mPostCmdList.Get());
+		mRenderGraph.Execute(mPostCmdList.Get(), postBatch);
+		mGpuProfiler.EndScope(mPostCmdList.Get());
+		mGpuProfiler.EndFrame(mPostCmdList.Get());
+		ThrowIfFailed(mPostCmdList->Close());
+
+		UINT chunkCount = mParallelRecorder.ChunkCount();
+		ID3D12CommandList* cmdLists[DXParallelRecorder::MaxThreads + 2] = {};
+		cmdLists[0] = mCmdList.Get();
+		for (UINT i = 0; i < chunkCount; i++)
+			cmdLists[i + 1] = mParallelRecorder.CommandLists()[i];
+		cmdLists[chunkCount + 1] = mPostCmdList.Get();
+
+		mCmdQueue->ExecuteCommandLists(chunkCount + 2, cmdLists);
+	}
+	else
+	{
+		mRenderGraph.Execute(mCmdList.Get());
+		mGpuProfiler.EndScope(mCmdList.Get());
+		mGpuProfiler.EndFrame(mCmdList.Get());
+
+		ThrowIfFailed(mCmdList->Close());
+
+		ComPtr<ID3D12CommandList> cmdLists[] =
+		{
+			mCmdList.Get()
+		};
+
+		mCmdQueue->ExecuteCommandLists((UINT)std::size(cmdLists), cmdLists->GetAddressOf());
+	}
+
+	mFrameRing.EndFrame();
+	mBreadcrumbs.Submit(mFrameSync.LastSignaledValue());
+	mUploadRing.FinishFrame(mFrameSync.LastSignaledValue());
+	mShaderVisibleHeap.FinishFrame(mFrameSync.LastSignaledValue());
+
+	__int64 presentStart = GameTimer::CurrentTicks();
+
+	// Tearing is only allowed in windowed mode.
+	ThrowIfFailed(mSwapchain->Present(0u, mTearingSupported && !mFullscreenState ? DXGI_PRESENT_ALLOW_TEARING : 0u));
+
+	__int64 presentEnd = GameTimer::CurrentTicks();
+	mFrameSample.WaitTicks = submitStart - waitStart + mLatencyWaitTicks;
+	mFrameSample.SubmitTicks = presentStart - submitStart;
+	mFrameSample.PresentTicks = presentEnd - presentStart;
+	if (mFrameInputTicks != 0)
+		mFrameSample.InputLatencyTicks = presentEnd - mFrameInputTicks;
+	mFrameInputTicks = 0;
+
+	if (mPaceWaitTicks != 0)
+		mGpuProfiler.Profiler().AddCpuEvent("Pace", mPaceWaitStart, mPaceWaitStart + mPaceWaitTicks);
+	if (mLatencyWaitTicks != 0)
+		mGpuProfiler.Profiler().AddCpuEvent("Latency wait", mLatencyWaitStart, mLatencyWaitStart + mLatencyWaitTicks);
+	mGpuProfiler.Profiler().AddCpuEvent("Wait", waitStart, submitStart);
+	mGpuProfiler.Profiler().AddCpuEvent("Submit", submitStart, presentStart);
+	mGpuProfiler.Profiler().AddCpuEvent("Present", presentStart, presentEnd);
+
+	mPaceWaitTicks = 0;
+	mLatencyWaitTicks = 0;
+	mCurrBackBuffer = mSwapchain->GetCurrentBackBufferIndex();
+}
+
+void DXRenderer::RecordScene(ID3D12GraphicsCommandList* cmdList, UINT chunk, UINT chunkCount)
+{
+	// Scene draws are split into chunkCount contiguous ranges; this records range [chunk].
+	// Render target, viewport and scissor are already bound.
 }
 
 void DXRenderer::OnMouseDown(WPARAM btnState, int x, int y)
@@ -409,43 +1434,181 @@ void DXRenderer::OnMouseMove(WPARAM btnState, int x, int y)
 {
 }
 
-void DXRenderer::CreateDXDevice()
+void DXRenderer::OnRawInput(HRAWINPUT input)
 {
-	ComPtr<IDXGIFactory> factory;
-	ThrowIfFailed(CreateDXGIFactory(IID_PPV_ARGS(&factory)));
-	ComPtr<IDXGIAdapter> adapter;
-	std::vector<ComPtr<IDXGIAdapter>> adapters;
+	RAWINPUT raw;
+	UINT size = sizeof(raw);
+	if (GetRawInputData(input, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == (UINT)-1 || raw.header.dwType != RIM_TYPEMOUSE)
+		return;
+
+	InputEvent event;
+	event.Ticks = GameTimer::CurrentTicks();
+
+	const RAWMOUSE& mouse = raw.data.mouse;
+	int32_t dx = mouse.lLastX;
+	int32_t dy = mouse.lLastY;
+	if (mouse.usFlags & MOUSE_MOVE_ABSOLUTE)
+	{
+		// Remote desktop and pen tablets report positions normalized to 0..65535 across the screen;
+		// they are scaled to pixels so deltas match relative mice, and the first one only sets the origin.
+		bool virtualDesktop = (mouse.usFlags & MOUSE_VIRTUAL_DESKTOP) != 0;
+		LONG x = MulDiv(mouse.lLastX, GetSystemMetrics(virtualDesktop ? SM_CXVIRTUALSCREEN : SM_CXSCREEN), 65535);
+		LONG y = MulDiv(mouse.lLastY, GetSystemMetrics(virtualDesktop ? SM_CYVIRTUALSCREEN : SM_CYSCREEN), 65535);
+		dx = mHasAbsoluteMouse ? x - mAbsoluteMouseX : 0;
+		dy = mHasAbsoluteMouse ? y - mAbsoluteMouseY : 0;
+		mAbsoluteMouseX = x;
+		mAbsoluteMouseY = y;
+		mHasAbsoluteMouse = true;
+	}
+	if (dx != 0 || dy != 0)
+	{
+		event.Type = InputEventType::MouseMove;
+		event.X = dx;
+		event.Y = dy;
+		mInput->Push(event);
+	}
 
-	UINT memSize = 0;
+	static const USHORT downFlags[] = { RI_MOUSE_BUTTON_1_DOWN, RI_MOUSE_BUTTON_2_DOWN, RI_MOUSE_BUTTON_3_DOWN, RI_MOUSE_BUTTON_4_DOWN, RI_MOUSE_BUTTON_5_DOWN };
+	static const USHORT upFlags[] = { RI_MOUSE_BUTTON_1_UP, RI_MOUSE_BUTTON_2_UP, RI_MOUSE_BUTTON_3_UP, RI_MOUSE_BUTTON_4_UP, RI_MOUSE_BUTTON_5_UP };
+	event.Type = InputEventType::MouseButton;
+	event.Y = 0;
+	for (uint32_t button = 0; button < (uint32_t)std::size(downFlags); button++)
+	{
+		event.Code = button;
+		if (mouse.usButtonFlags & downFlags[button])
+		{
+			event.X = 1;
+			mInput->Push(event);
+		}
+		if (mouse.usButtonFlags & upFlags[button])
+		{
+			event.X = 0;
+			mInput->Push(event);
+		}
+	}
 
-	for (UINT i = 0; factory->EnumAdapters(i, &adapter) != DXGI_ERROR_NOT_FOUND; i++)
+	event.Type = InputEventType::MouseWheel;
+	if (mouse.usButtonFlags & RI_MOUSE_WHEEL)
+	{
+		event.Code = 0;
+		event.X = (SHORT)mouse.usButtonData;
+		mInput->Push(event);
+	}
+	if (mouse.usButtonFlags & RI_MOUSE_HWHEEL)
 	{
-		DXGI_ADAPTER_DESC desc = {};
-		adapter->GetDesc(&desc);
+		event.Code = 1;
+		event.X = (SHORT)mouse.usButtonData;
+		mInput->Push(event);
+	}
+}
 
-		std::stringstream ss;
-		ss << "Found adapter: ";
+void DXRenderer::PushKey(WPARAM key, bool pressed)
+{
+	InputEvent event;
+	event.Ticks = GameTimer::CurrentTicks();
+	event.Type = InputEventType::Key;
+	event.Code = (uint32_t)key;
+	event.X = pressed ? 1 : 0;
+	mInput->Push(event);
+}
 
-		for (int i = 0; i < 128; i++)
-		{
-			if (desc.Description[i] != 0)
-			{
-				ss << (char)desc.Description[i];
-			}
-		}
+void DXRenderer::WaitForFrameLatency()
+{
+	CPU_ZONE_FUNCTION();
+
+	mLatencyWaitStart = GameTimer::CurrentTicks();
+	// A timeout only means DXGI lost a signal (e.g. around a mode switch); render anyway rather than hang.
+	WaitForSingleObjectEx(mFrameLatencyWaitable, 1000, TRUE);
+	mLatencyWaitTicks = GameTimer::CurrentTicks() - mLatencyWaitStart;
+	mFrameLatencyReady = true;
+}
 
-		ss << "\n"
-			<< "Dedicated video memory: " << ((float)desc.DedicatedVideoMemory / 1024.f / 1024.f / 1024.f) << "\n";
+void DXRenderer::SetSimulationRate(double stepsPerSecond, UINT maxCatchUpSteps)
+{
+	mTimestep.SetRate(stepsPerSecond);
+	mTimestep.SetMaxStepsPerFrame(maxCatchUpSteps);
+	LOG_INFO("Simulation rate: {:.2f} Hz, at most {} steps per frame", mTimestep.Rate(), maxCatchUpSteps);
+}
+
+void DXRenderer::SetDynamicResolution(bool enabled, double budgetMs)
+{
+	DynamicResolutionSettings settings = mDynamicResolution.Settings();
+	settings.BudgetMs = std::max(budgetMs, 1.0);
+	mDynamicResolution.Initialize(settings);
+	mDynamicResolutionEnabled = enabled;
+
+	if (enabled && mUpscalePipeline == DXPipelineCache::InvalidHandle)
+		LOG_WARNING("Upscale pipeline unavailable, rendering at full resolution");
+	LOG_INFO("Dynamic resolution {}, {:.1f} ms GPU budget", enabled ? "enabled" : "disabled", settings.BudgetMs);
+}
 
-		Log(ss.str().c_str());
+void DXRenderer::SetFramePacing(FramePacingMode mode, double targetFps, UINT vsyncDivisor)
+{
+	mPacingFps = targetFps;
+	mVsyncDivisor = std::max(vsyncDivisor, 1u);
 
-		if (desc.DedicatedVideoMemory > memSize) {
-			memSize = (UINT)desc.DedicatedVideoMemory;
-			mAdapter = adapter;
-		}
+	int64_t period = 0;
+	int64_t vblank = 0;
+	if (mode == FramePacingMode::VsyncAligned && !QueryVsyncTiming(period, vblank))
+	{
+		LOG_WARNING("DWM composition timing unavailable, pacing to the target frame rate instead");
+		mode = FramePacingMode::TargetFps;
+	}
+
+	switch (mode)
+	{
+	case FramePacingMode::TargetFps:
+		mFramePacer.SetTargetFps(mPacingFps);
+		break;
+	case FramePacingMode::VsyncAligned:
+		mFramePacer.SetVsync(period, vblank, mVsyncDivisor);
+		break;
+	default:
+		mFramePacer.SetUnlimited();
+		break;
+	}
+	mFramePacer.ResetStats();
+
+	const char* modeNames[] = { "unlimited", "target frame rate", "vsync aligned" };
+	LOG_INFO("Frame pacing: {}, {:.1f} fps", modeNames[(uint32_t)mFramePacer.Mode()], mFramePacer.TargetFps());
+}
+
+bool DXRenderer::QueryVsyncTiming(int64_t& periodTicks, int64_t& vblankTicks) const
+{
+	DWM_TIMING_INFO timing = {};
+	timing.cbSize = sizeof(timing);
+	if (FAILED(DwmGetCompositionTimingInfo(nullptr, &timing)) || timing.qpcRefreshPeriod == 0)
+		return false;
+
+	periodTicks = (int64_t)timing.qpcRefreshPeriod;
+	vblankTicks = (int64_t)timing.qpcVBlank;
+	return true;
+}
+
+void DXRenderer::SetMaxFrameLatency(UINT maxFrameLatency)
+{
+	mMaxFrameLatency = std::clamp(maxFrameLatency, 1u, mBufferCount);
+	ThrowIfFailed(mSwapchain->SetMaximumFrameLatency(mMaxFrameLatency));
+	LOG_INFO("Maximum frame latency set to {}", mMaxFrameLatency);
+}
+
+void DXRenderer::CreateDXDevice()
+{
+	AdapterRequirements requirements;
+	ThrowIfFailed(mAdapterSelector.Select(mBackBufferFormat, requirements, AdapterCachePath));
 
-		adapters.push_back(adapter);
+	for (const AdapterInfo& info : mAdapterSelector.Adapters())
+	{
+		LOG_INFO("Found adapter: {}, dedicated video memory: {:.2f} GB, feature level {:x}, binding tier {}, score {}", info.Name,
+			(double)info.DedicatedVideoMemory / 1024.0 / 1024.0 / 1024.0, info.Caps.MaxFeatureLevel, info.Caps.ResourceBindingTier,
+			AdapterScoring::Score(info, requirements));
 	}
+	AdapterCacheStats cacheStats = mAdapterSelector.CacheStats();
+	LOG_INFO("Adapter selection: {} probed in {:.1f} ms, {} from {}", mAdapterSelector.ProbedCount(), mAdapterSelector.ProbeMs(), cacheStats.Hits, AdapterCachePath);
+
+	mAdapter = mAdapterSelector.Adapter();
+	if (mAdapter)
+		mAdapterCaps = mAdapterSelector.Selected().Caps;
 
 	/*ComPtr<IDXGIOutput> monitor;
 	std::vector<ComPtr<IDXGIOutput>> monitors;
@@ -483,7 +1646,8 @@ void DXRenderer::CreateDXDevice()
 		}
 	}*/
 
-	D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_0;
+	// The highest level the probe found; 11_0 if nothing was selected and the default adapter is used.
+	D3D_FEATURE_LEVEL featureLevel = mAdapterCaps.MaxFeatureLevel != 0 ? (D3D_FEATURE_LEVEL)mAdapterCaps.MaxFeatureLevel : D3D_FEATURE_LEVEL_11_0;
 
 	ThrowIfFailed(D3D12CreateDevice(mAdapter.Get(), featureLevel, IID_PPV_ARGS(&mDevice)));
 
@@ -526,17 +1690,21 @@ void DXRenderer::CreateDXDevice()
 	DWORD v = 0;
 	ThrowIfFailed(mInfoQueue->RegisterMessageCallback(&messageCallback, D3D12_MESSAGE_CALLBACK_IGNORE_FILTERS, this, &v));
 #endif
-}
 
-Microsoft::WRL::ComPtr<ID3D12Fence> DXRenderer::CreateFence()
-{
-	ComPtr<ID3D12Fence> fence;
-	mDevice->CreateFence(0u, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
-	return fence;
+	ThrowIfFailed(mPipelines.Initialize(mDevice.Get(), PipelineCachePath));
+	if (!mPipelines.HasLibrary())
+		LOG_WARNING("Pipeline libraries are not supported, pipelines will be compiled every run");
 }
 
 void DXRenderer::CheckMSAAQualitySupport()
 {
+	// Probed with the adapter, possibly in an earlier run.
+	if (mAdapterCaps.Msaa4xQualityLevels != 0)
+	{
+		m4xMsaaQuality = mAdapterCaps.Msaa4xQualityLevels;
+		return;
+	}
+
 	D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS qLevels = {};
 	qLevels.Format = mBackBufferFormat;
 	qLevels.SampleCount = 4;
@@ -565,6 +1733,27 @@ void DXRenderer::CreateCommandObjects(bool bReset)
 
 	ThrowIfFailed(mDevice->CreateCommandQueue(&cmdQueueDesc, IID_PPV_ARGS(&mCmdQueue)));
 
+	ThrowIfFailed(mFrameSync.Initialize(mDevice.Get(), mCmdQueue.Get()));
+	ThrowIfFailed(mQueues.Initialize(mDevice.Get(), mCmdQueue.Get(), &mFrameSync));
+	mFrameRing.Initialize(&mFrameSync, mBufferCount);
+	ThrowIfFailed(mGpuProfiler.Initialize(mDevice.Get(), mCmdQueue.Get(), mBufferCount, mTimer.TicksPerSecond()));
+	ThrowIfFailed(mBreadcrumbs.Initialize(mDevice.Get()));
+
+	for (UINT i = 0; i < mBufferCount; i++)
+		ThrowIfFailed(mDevice->CreateCommandAllocator(type, IID_PPV_ARGS(&mFrameRing[i].CmdAllocator)));
+
+	ThrowIfFailed(mDevice->CreateCommandList(0u, type, mFrameRing[0].CmdAllocator.Get(), nullptr, IID_PPV_ARGS(&mPostCmdList)));
+	ThrowIfFailed(mPostCmdList->Close());
+
+	ThrowIfFailed(mParallelRecorder.Initialize(mDevice.Get(), mJobs.get(), mBufferCount));
+
+	ThrowIfFailed(mUploadRing.Initialize(mDevice.Get(), &mFrameSync, UploadRingSize));
+	ThrowIfFailed(mGpuMemory.Initialize(mDevice.Get()));
+	ThrowIfFailed(mRenderGraph.Initialize(mDevice.Get(), &mGpuMemory, &mFrameSync));
+	mRenderGraph.SetBreadcrumbs(&mBreadcrumbs);
+	mDepthPool.Initialize(&mFrameSync);
+	ThrowIfFailed(mAssetStreamer.Initialize(&mQueues, &mUploadRing, &mGpuMemory));
+
 	ThrowIfFailed(mCmdList->Close());
 
 	if (bReset)
@@ -573,81 +1762,156 @@ void DXRenderer::CreateCommandObjects(bool bReset)
 
 void DXRenderer::FlushCommandQueue()
 {
-	if (mFence->GetCompletedValue() < mCurrentFence)
-	{
-		ThrowIfFailed(mFence->SetEventOnCompletion(mCurrentFence, mEventHandle));
+	CPU_ZONE_FUNCTION();
 
-		if (WaitForSingleObject(mEventHandle, DWORD_MAX))
-		{
-			Log("Failure at waiting\n");
-		}
-	}
+	// Copy work may still reference resources the caller is about to release.
+	mQueues.WaitIdle();
 }
 
 void DXRenderer::CreateSwapChain()
 {
 	m4xMsaaQuality = 0;
 	mSwapchain.Reset();
-	ComPtr<IDXGIFactory> factory;
-	CreateDXGIFactory(IID_PPV_ARGS(&factory));
-	DXGI_SWAP_CHAIN_DESC desc = {};
-	desc.BufferDesc.Width = mClientWidth;
-	desc.BufferDesc.Height = mClientHeight;
-	desc.BufferDesc.RefreshRate.Denominator = 0;
-	desc.BufferDesc.RefreshRate.Numerator = 0;
-	desc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-	desc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-	desc.BufferDesc.Format = mBackBufferFormat;
+	if (mFrameLatencyWaitable)
+	{
+		CloseHandle(mFrameLatencyWaitable);
+		mFrameLatencyWaitable = nullptr;
+	}
+
+	ComPtr<IDXGIFactory4> factory;
+	ThrowIfFailed(CreateDXGIFactory1(IID_PPV_ARGS(&factory)));
+
+	BOOL allowTearing = FALSE;
+	ComPtr<IDXGIFactory5> factory5;
+	if (SUCCEEDED(factory.As(&factory5)))
+	{
+		if (FAILED(factory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing))))
+			allowTearing = FALSE;
+	}
+	mTearingSupported = allowTearing == TRUE;
+
+	mSwapchainFlags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT | DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+	if (mTearingSupported)
+		mSwapchainFlags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+
+	DXGI_SWAP_CHAIN_DESC1 desc = {};
+	desc.Width = mClientWidth;
+	desc.Height = mClientHeight;
+	desc.Format = mBackBufferFormat;
 	desc.SampleDesc.Count = mMsaaCount;
 	desc.SampleDesc.Quality = m4xMsaaQuality;
 	desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-	desc.OutputWindow = mHwnd;
 	desc.BufferCount = mBufferCount;
-	desc.Windowed = TRUE;
+	desc.Scaling = DXGI_SCALING_STRETCH;
 	desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-	desc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING | DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+	desc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+	desc.Flags = mSwapchainFlags;
 
-	ThrowIfFailed(factory->CreateSwapChain(mCmdQueue.Get(), &desc, mSwapchain.GetAddressOf()));
+	ComPtr<IDXGISwapChain1> swapchain;
+	ThrowIfFailed(factory->CreateSwapChainForHwnd(mCmdQueue.Get(), mHwnd, &desc, nullptr, nullptr, swapchain.GetAddressOf()));
+	ThrowIfFailed(swapchain.As(&mSwapchain));
+
+	// With the waitable flag DXGI no longer blocks in Present(); the render loop waits on this handle instead.
+	ThrowIfFailed(mSwapchain->SetMaximumFrameLatency(mMaxFrameLatency));
+	mFrameLatencyWaitable = mSwapchain->GetFrameLatencyWaitableObject();
+	mCurrBackBuffer = mSwapchain->GetCurrentBackBufferIndex();
 }
 
-void DXRenderer::CreateRtvAndDsvDescriptorHeaps()
+void DXRenderer::CreateDescriptorHeaps()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC dsvDesc = {};
-	dsvDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	dsvDesc.NodeMask = 0u;
-	dsvDesc.NumDescriptors = 1u;
-	dsvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+	ThrowIfFailed(mRtvHeap.Initialize(mDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, RtvHeapSize));
+	ThrowIfFailed(mDsvHeap.Initialize(mDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, DsvHeapSize));
+	ThrowIfFailed(mCbvSrvUavHeap.Initialize(mDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, CbvSrvUavHeapSize));
+	ThrowIfFailed(mShaderVisibleHeap.Initialize(mDevice.Get(), &mFrameSync, PersistentDescriptorCount, RingDescriptorCount));
 
-	D3D12_DESCRIPTOR_HEAP_DESC rtvDesc = {};
-	rtvDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	rtvDesc.NodeMask = 0u;
-	rtvDesc.NumDescriptors = mBufferCount;
-	rtvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-	
-	ThrowIfFailed(mDevice->CreateDescriptorHeap(&dsvDesc, IID_PPV_ARGS(&mDsvHeap)));
-	ThrowIfFailed(mDevice->CreateDescriptorHeap(&rtvDesc, IID_PPV_ARGS(&mRtvHeap)));
+	// Swapchain and depth views keep their slots across resizes, only the views are recreated.
+	for (UINT i = 0; i < mBufferCount; i++)
+		mBackBufferRtv[i] = mRtvHeap.Allocate();
+	mDepthDsv = mDsvHeap.Allocate();
+	mSceneColorRtv = mRtvHeap.Allocate();
+}
+
+void DXRenderer::CreateUpscalePipeline()
+{
+	// A fullscreen triangle; UvMax keeps bilinear taps inside the rectangle that was rendered.
+	const char* shaderSource =
+		"cbuffer Upscale : register(b0) { float2 UvScale; float2 UvMax; };\n"
+		"Texture2D SceneColor : register(t0);\n"
+		"SamplerState LinearClamp : register(s0);\n"
+		"void VSMain(uint id : SV_VertexID, out float4 pos : SV_Position, out float2 uv : TEXCOORD0)\n"
+		"{ uv = float2((id << 1) & 2, id & 2); pos = float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f); }\n"
+		"float4 PSMain(float4 pos : SV_Position, float2 uv : TEXCOORD0) : SV_Target\n"
+		"{ return SceneColor.SampleLevel(LinearClamp, min(uv * UvScale, UvMax), 0.0f); }\n";
+
+	ComPtr<ID3DBlob> vertexShader;
+	ComPtr<ID3DBlob> pixelShader;
+	ComPtr<ID3DBlob> errors;
+	if (FAILED(D3DCompile(shaderSource, strlen(shaderSource), "Upscale", nullptr, nullptr, "VSMain", "vs_5_0", 0, 0, &vertexShader, &errors)) ||
+		FAILED(D3DCompile(shaderSource, strlen(shaderSource), "Upscale", nullptr, nullptr, "PSMain", "ps_5_0", 0, 0, &pixelShader, &errors)))
+	{
+		LOG_WARNING("Upscale shader failed to compile, dynamic resolution is unavailable: {}",
+			errors ? (const char*)errors->GetBufferPointer() : "no compiler output");
+		return;
+	}
+
+	D3D12_DESCRIPTOR_RANGE sceneRange = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, 0 };
+	D3D12_ROOT_PARAMETER params[2] = {};
+	params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	params[0].Constants = { 0, 0, 4 };
+	params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+	params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	params[1].DescriptorTable = { 1, &sceneRange };
+	params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+	D3D12_STATIC_SAMPLER_DESC sampler = {};
+	sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+	sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	sampler.MaxLOD = D3D12_FLOAT32_MAX;
+	sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+	D3D12_ROOT_SIGNATURE_DESC rootDesc = {};
+	rootDesc.NumParameters = (UINT)std::size(params);
+	rootDesc.pParameters = params;
+	rootDesc.NumStaticSamplers = 1;
+	rootDesc.pStaticSamplers = &sampler;
+	ComPtr<ID3DBlob> rootBlob;
+	ThrowIfFailed(D3D12SerializeRootSignature(&rootDesc, D3D_ROOT_SIGNATURE_VERSION_1, &rootBlob, nullptr));
+	ThrowIfFailed(mPipelines.CreateRootSignature(rootBlob->GetBufferPointer(), rootBlob->GetBufferSize(), &mUpscaleRootSignature));
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+	desc.pRootSignature = mUpscaleRootSignature.Get();
+	desc.VS = { vertexShader->GetBufferPointer(), vertexShader->GetBufferSize() };
+	desc.PS = { pixelShader->GetBufferPointer(), pixelShader->GetBufferSize() };
+	desc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+	desc.SampleMask = UINT_MAX;
+	desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+	desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+	desc.RasterizerState.DepthClipEnable = TRUE;
+	desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	desc.NumRenderTargets = 1;
+	desc.RTVFormats[0] = mBackBufferFormat;
+	desc.SampleDesc.Count = 1;
+	mUpscalePipeline = mPipelines.RequestGraphics(desc);
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE DXRenderer::CurrentBackBufferView() const
 {
-	D3D12_CPU_DESCRIPTOR_HANDLE descHandle = mRtvHeap->GetCPUDescriptorHandleForHeapStart();
-	descHandle.ptr += mCurrBackBuffer * mRtvDescriptorHeapSize;
-	return descHandle;
+	return mBackBufferRtv[mCurrBackBuffer].Cpu;
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE DXRenderer::BackBufferViewByIndex(UINT index) const
 {
-	D3D12_CPU_DESCRIPTOR_HANDLE descHandle = mRtvHeap->GetCPUDescriptorHandleForHeapStart();
-	descHandle.ptr += (SIZE_T)index * mRtvDescriptorHeapSize;
-	return descHandle;
+	return mBackBufferRtv[index].Cpu;
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE DXRenderer::DepthStencilView() const
 {
-	return mDsvHeap->GetCPUDescriptorHandleForHeapStart();
+	return mDepthDsv.Cpu;
 }
 
-void DXRenderer::CreateRenderTargetViews(bool bResetCmdList)
+void DXRenderer::CreateRenderTargetViews()
 {
 	for (UINT i = 0; i < mBufferCount; i++)
 	{
@@ -655,107 +1919,76 @@ void DXRenderer::CreateRenderTargetViews(bool bResetCmdList)
 
 		mDevice->CreateRenderTargetView(mSwapchainBuffer[i].Get(), nullptr, BackBufferViewByIndex(i));
 	}
-	D3D12_RESOURCE_DESC depthDesc = {};
-	depthDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	depthDesc.Format = mDepthFormat;
-	depthDesc.MipLevels = 1;
-	depthDesc.SampleDesc.Count = mMsaaCount;
-	depthDesc.SampleDesc.Quality = m4xMsaaQuality;
-	depthDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-	depthDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-	depthDesc.Width = mClientWidth;
-	depthDesc.Height = mClientHeight;
-	depthDesc.DepthOrArraySize = 1;
-
-	D3D12_HEAP_PROPERTIES hProps = {};
-	hProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	hProps.CreationNodeMask = 0u;
-	hProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-	hProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-	hProps.VisibleNodeMask = 0u;
-
-	D3D12_HEAP_FLAGS hFlags = D3D12_HEAP_FLAG_NONE;
-
-	D3D12_CLEAR_VALUE clearValue = {};
-	clearValue.Format = mDepthFormat;
-	clearValue.DepthStencil.Depth = 1.0f;
-	clearValue.DepthStencil.Stencil = 0;
-
-	ThrowIfFailed(mDevice->CreateCommittedResource(
-		&hProps, 
-		hFlags, 
-		&depthDesc, 
-		D3D12_RESOURCE_STATE_COMMON,
-		&clearValue,
-		IID_PPV_ARGS(&mDepthBuffer)
-	));
+}
 
-	mDevice->CreateDepthStencilView(mDepthBuffer.Get(), nullptr, DepthStencilView());
+void DXRenderer::AcquireDepthBuffer()
+{
+	RenderTargetKey key = mDepthPool.Bucket((uint32_t)mClientWidth, (uint32_t)mClientHeight, mDepthFormat, mMsaaCount);
+	// The viewport just covers less of the bucket.
+	if (mDepthBuffer.Resource && key == mDepthKey)
+		return;
 
-	D3D12_RESOURCE_BARRIER depthBarrier = {};
-	depthBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	depthBarrier.Transition.pResource = mDepthBuffer.Get();
-	depthBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COMMON;
-	depthBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	// Frames up to the last signaled one may still be drawing into it.
+	if (mDepthBuffer.Resource)
+		mDepthPool.Release(mDepthKey, std::move(mDepthBuffer), mFrameSync.LastSignaledValue());
+	mDepthKey = key;
 
-	if (bResetCmdList)
+	if (!mDepthPool.Acquire(key, mDepthBuffer))
 	{
-		ThrowIfFailed(mCmdAllocator->Reset());
-		ThrowIfFailed(mCmdList->Reset(mCmdAllocator.Get(), nullptr));
+		D3D12_RESOURCE_DESC depthDesc = {};
+		depthDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		depthDesc.Format = mDepthFormat;
+		depthDesc.MipLevels = 1;
+		depthDesc.SampleDesc.Count = mMsaaCount;
+		depthDesc.SampleDesc.Quality = m4xMsaaQuality;
+		depthDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+		depthDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+		depthDesc.Width = key.Width;
+		depthDesc.Height = key.Height;
+		depthDesc.DepthOrArraySize = 1;
+
+		D3D12_CLEAR_VALUE clearValue = {};
+		clearValue.Format = mDepthFormat;
+		clearValue.DepthStencil.Depth = 1.0f;
+		clearValue.DepthStencil.Stencil = 0;
+
+		// Created in the state the render graph imports it in, so there is no transition to submit and wait for.
+		// The Clear pass initializes the placed resource before anything reads it.
+		ThrowIfFailed(mGpuMemory.CreateResource(depthDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &clearValue, mDepthBuffer));
 	}
 
-	mCmdList->ResourceBarrier(1u, &depthBarrier);
-
-	ID3D12CommandList* cmdLists[] = {
-		mCmdList.Get()
-	};
-
-	ThrowIfFailed(mCmdList->Close());
-
-	mCmdQueue->ExecuteCommandLists(1u, cmdLists);
-
-	mCurrentFence++;
-	ThrowIfFailed(mCmdQueue->Signal(mFence.Get(), mCurrentFence));
-
-	FlushCommandQueue();
+	mDevice->CreateDepthStencilView(mDepthBuffer.Resource.Get(), nullptr, DepthStencilView());
+	mDepthPool.Trim([this](DXGpuAllocation& target) { mGpuMemory.Free(target); });
 }
 
 void DXRenderer::messageCallback(D3D12_MESSAGE_CATEGORY category, D3D12_MESSAGE_SEVERITY severity, D3D12_MESSAGE_ID id, LPCSTR pDescription, void* pContext)
 {
-	std::stringstream oss;
+	static constexpr ErrorSite corruption{ "DirectX Corruption", __FILE__, __LINE__ };
+	static constexpr ErrorSite error{ "DirectX Error", __FILE__, __LINE__ };
+	static constexpr ErrorSite warning{ "DirectX Warning", __FILE__, __LINE__ };
+
 	DXRenderer* r = (DXRenderer*)pContext;
-	if (!mStandardOutput || !r) return;
+	if (!r) return;
 	switch (severity)
 	{
 	case D3D12_MESSAGE_SEVERITY_CORRUPTION:
-		r->DirectXError("DirectX Corruption: ", pDescription);
+		r->mErrors.Record(corruption, 0, pDescription);
 		break;
 	case D3D12_MESSAGE_SEVERITY_ERROR:
-		r->DirectXError("DirectX Error: ", pDescription);
+		r->mErrors.Record(error, 0, pDescription);
 		break;
 	case D3D12_MESSAGE_SEVERITY_WARNING:
 #ifdef _WARNINGS_AS_CRASH
-		r->DirectXError("DirectX Warning: ", pDescription);
+		r->mErrors.Record(warning, 0, pDescription);
 		break;
 #endif
-		oss << "DirectX Warning: " << pDescription << "\n";
-		Log(oss.str().c_str());
+		LOG_WARNING("DirectX: {}", pDescription);
 		break;
 	case D3D12_MESSAGE_SEVERITY_INFO:
-		oss << "DirectX Info: " << pDescription << "\n";
-		//Log(oss.str().c_str());
-		break;
 	case D3D12_MESSAGE_SEVERITY_MESSAGE:
-		oss << "DirectX Message: " << pDescription << "\n";
-		//Log(oss.str().c_str());
+		// Too chatty to be worth even a log record.
 		break;
 	default:
 		break;
 	}
 }
-
-void DXRenderer::DirectXError(const char* _s0, const char* _s1)
-{
-	mExceptionSettings.push({ _s0, _s1 });
-	mHasException = true;
-}
\ No newline at end of file
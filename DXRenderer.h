@@ -2,36 +2,101 @@
 
 #include <wrl.h>
 #include <d3d12.h>
-#include <dxgi1_4.h>
+#include <dxgi1_5.h>
 #include <exception>
-#include <queue>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+#include "ErrorCapture.h"
 #include "GameTimer.h"
+#include "Logger.h"
+#include "FixedTimestep.h"
+#include "FrameStats.h"
+#include "FrameRing.h"
+#include "DXAdapterSelector.h"
+#include "DXFrameSync.h"
+#include "DXQueueManager.h"
+#include "DXParallelRecorder.h"
+#include "DXUploadRing.h"
+#include "DXDescriptorHeap.h"
+#include "DXGpuMemoryAllocator.h"
+#include "DXRenderGraph.h"
+#include "DXAssetStreamer.h"
+#include "DXPipelineCache.h"
+#include "DXGpuProfiler.h"
+#include "DXGpuBreadcrumbs.h"
+#include "DynamicResolution.h"
+#include "FramePacer.h"
+#include "InputQueue.h"
+#include "RenderThread.h"
+#include "RenderTargetPool.h"
+#include "ResizeScheduler.h"
 
-class DXRenderer
+class DXRenderer : private RenderThreadClient
 {
 public:
-	DXRenderer(HINSTANCE hInstance);
+	/*
+		framesInFlight is clamped to [FrameRing::MinFrames, FrameRing::MaxFrames];
+		maxFrameLatency, the presents DXGI may queue, to [1, framesInFlight].
+	*/
+	DXRenderer(HINSTANCE hInstance, UINT framesInFlight = 3, UINT maxFrameLatency = 1);
 	~DXRenderer();
 
 	void ClearCommandQueue();
 
 	int Run();
 
-	__forceinline static void Log(const char* str)
-	{
-#ifdef _DEBUG
-		static DWORD strS;
-		strS = 0;
-		for (int i = 0; str[i] != 0; i++)
-			strS++;
-
-		if (!WriteConsoleA(mStandardOutput, str, strS, NULL, NULL))
-		{
-			throw std::exception("Failed to write to console from DXRenderer::Log");
-		}
-#endif
-	}
+	/* Call before Run(): Update and Draw move to a dedicated thread, the window thread only forwards events. */
+	void EnableRenderThread(bool enable) { mUseRenderThread = enable; }
+
+	/* Update() runs at stepsPerSecond, at most maxCatchUpSteps times per frame. */
+	void SetSimulationRate(double stepsPerSecond, UINT maxCatchUpSteps = FixedTimestep::DefaultMaxStepsPerFrame);
+
+	/* Unlimited by default; F8 cycles through the modes with these settings. */
+	void SetFramePacing(FramePacingMode mode, double targetFps = 60.0, UINT vsyncDivisor = 1);
+
+	/* Scales the scene's resolution to keep GPU frame time under budgetMs; F9 toggles it. */
+	void SetDynamicResolution(bool enabled, double budgetMs = 16.0);
+
+	/* Measures how recording drawCount draws through DXParallelRecorder scales with the number of recording threads. */
+	static int RunRecordBenchmark(UINT drawCount, const char* reportPath);
+
+	/* Measures job system throughput on jobCount empty jobs for 1..N threads. */
+	static int RunJobBenchmark(UINT jobCount, const char* reportPath);
+
+	/* Measures render graph build + compile time for 8..maxPasses passes and dumps one compiled schedule. */
+	static int RunGraphBenchmark(UINT maxPasses, const char* reportPath, const char* schedulePath);
+
+	/*
+		Measures pack file streaming throughput from request to GPU residency through the copy queue,
+		for totalMB of entryKB entries written to packPath, or with totalMB 0 for the pack already at packPath.
+	*/
+	static int RunStreamBenchmark(UINT totalMB, UINT entryKB, const char* packPath, const char* reportPath);
+
+	/* Builds pipelineCount pipelines with no cache file (cold) and again from the saved library (warm). */
+	static int RunPipelineBenchmark(UINT pipelineCount, const char* cachePath, const char* reportPath);
+
+	/* Measures the cost of a CPU_ZONE with and without a capture running. */
+	static int RunZoneBenchmark(UINT zoneCount, const char* reportPath);
+
+	/* Paces frameCount empty frames at targetFps and reports how close each wake-up was to its deadline. */
+	static int RunPaceBenchmark(double targetFps, UINT frameCount, const char* reportPath);
+
+	/* Drags a null-backend window for frameCount frames and compares resizing per request, per frame and debounced. */
+	static int RunResizeBenchmark(UINT frameCount, double gpuLatencyMs, const char* reportPath);
+
+	/* Times the logger's Write() from one thread and from every hardware thread. */
+	static int RunLogBenchmark(UINT messageCount, const char* reportPath);
+
+	/* Times the CPU side of markerCount breadcrumb markers and checks a simulated hang is located. */
+	static int RunBreadcrumbBenchmark(UINT markerCount, const char* reportPath);
+
+	/*
+		Replays a GPU frame time trace, one full resolution time in ms per line, through the dynamic
+		resolution controller; without a trace file it uses a synthetic load that spikes over budgetMs.
+	*/
+	static int RunDynamicResolutionBenchmark(double budgetMs, const char* tracePath, const char* reportPath);
 
 private:
 	void InitWindow();
@@ -39,61 +104,147 @@ private:
 	inline static LRESULT CALLBACK MainWndProc(HWND, UINT, WPARAM, LPARAM);
 	inline LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 	
+	/* Window thread loop of the threaded mode. */
+	int RunThreaded();
+	/* Steps the simulation and draws one frame; the caller has done the pacing and latency waits. */
+	void RunFrame();
+	/* Rethrows what messageCallback queued. */
+	void ThrowPendingException();
+	void RethrowWindowFailure();
+
+	/* Applies the command right away, or queues it for the render thread's next frame boundary. */
+	void PostWindowCommand(WindowCommandType type, uint32_t param = 0, int32_t width = 0, int32_t height = 0);
+	void OnKeyUp(WPARAM key);
+
+	void OnRenderThreadStarted() override;
+	void ApplyWindowCommand(const WindowCommand& command) override;
+	bool RenderFrame() override;
+	void OnRenderThreadFailed() override;
+
 	inline void CalculateFrameStats();
+	/* Window thread: the title CalculateFrameStats() last posted. */
+	std::string StatsTitle();
 	inline void OnResize();
-	inline void Update(const GameTimer& GameTimer);
-	inline void Draw(const GameTimer& GameTimer);
+	/* Between frames: resizes if the scheduler says a requested size is due. */
+	void ApplyPendingResize();
+	/* One fixed simulation step. */
+	inline void Update();
+	/* alpha is how far the frame is between the last two simulated states. */
+	inline void Draw(const GameTimer& GameTimer, float alpha);
+	inline void RecordScene(ID3D12GraphicsCommandList* cmdList, UINT chunk, UINT chunkCount);
+
+	void LogSubsystemStats();
+	/* F6: starts a CPU zone capture, or stops it and writes cpu_trace.json with the GPU scopes. */
+	void ToggleCpuCapture();
+	/* Blocks until the swap chain can queue another present, at most a second. */
+	void WaitForFrameLatency();
+	/* F7: cycles the maximum frame latency through [1, mBufferCount]. */
+	void SetMaxFrameLatency(UINT maxFrameLatency);
+	/* Pushes a WM_INPUT mouse packet into mInput. */
+	void OnRawInput(HRAWINPUT input);
+	void PushKey(WPARAM key, bool pressed);
+	/* Refresh period and last vblank from DWM, on the QPC clock; false if composition timing is unavailable. */
+	bool QueryVsyncTiming(int64_t& periodTicks, int64_t& vblankTicks) const;
 
 	inline void OnMouseDown(WPARAM btnState, int x, int y);
 	inline void OnMouseUp(WPARAM btnState, int x, int y);
 	inline void OnMouseMove(WPARAM btnState, int x, int y);
 
 	inline void CreateDXDevice();
-	inline _NODISCARD Microsoft::WRL::ComPtr<ID3D12Fence> CreateFence();
 	inline void CheckMSAAQualitySupport();
 	inline void CreateCommandObjects(bool bReset);
 	inline void FlushCommandQueue();
 	inline void CreateSwapChain();
-	inline void CreateRtvAndDsvDescriptorHeaps();
+	inline void CreateDescriptorHeaps();
+	void CreateUpscalePipeline();
 	inline D3D12_CPU_DESCRIPTOR_HANDLE CurrentBackBufferView() const;
 	inline D3D12_CPU_DESCRIPTOR_HANDLE BackBufferViewByIndex(UINT index) const;
 	inline D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView() const;
-	inline void CreateRenderTargetViews(bool bReset = true);
+	inline void CreateRenderTargetViews();
+	/* Keeps the depth buffer if its size bucket still fits the client area, otherwise swaps it through mDepthPool. */
+	inline void AcquireDepthBuffer();
 
 	inline float AspectRatio() const { return (float)mClientWidth / (float)mClientHeight; }
 
 	static void __stdcall messageCallback(D3D12_MESSAGE_CATEGORY category, D3D12_MESSAGE_SEVERITY severity, D3D12_MESSAGE_ID id, LPCSTR pDescription, void* pContext);
 
-	void DirectXError(const char* _s0, const char* _s1);
-
 private:
 
-	struct ExceptionSettings
+	/* Everything the CPU writes for one frame, recycled once the GPU retires FenceValue. */
+	struct FrameContext : FrameContextBase
 	{
-		std::string _s0;
-		std::string _s1;
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdAllocator;
+		/* Both live in ring memory until this context's fence value retires. */
+		D3D12_GPU_VIRTUAL_ADDRESS FrameConstants = 0;
+		D3D12_GPU_DESCRIPTOR_HANDLE FrameTable = {};
+		/* Scale the scene was rendered at, so its GPU time can be read back against it. */
+		double RenderScale = 1.0;
 	};
 
-	std::queue<ExceptionSettings> mExceptionSettings;
+	/* Per-frame constant buffer, rewritten into the upload ring every frame. */
+	struct FrameConstants
+	{
+		/* Interpolated simulation time; wraps to a float only here. */
+		float TotalTime;
+		float DeltaTime;
+		float RenderTargetSize[2];
+		float InterpolationAlpha;
+	};
+
+	static constexpr double SimulationRate = 60.0;
+
+	static constexpr UINT64 UploadRingSize = 8ull * 1024 * 1024;
+	/* Streamed bytes uploaded per frame; leaves the rest of the ring to per-frame data. */
+	static constexpr UINT64 StreamBytesPerFrame = 4ull * 1024 * 1024;
 
-	bool mHasException = false;
+	static constexpr UINT RtvHeapSize = 64;
+	static constexpr UINT DsvHeapSize = 16;
+	static constexpr UINT CbvSrvUavHeapSize = 4096;
+	static constexpr UINT PersistentDescriptorCount = 4096;
+	static constexpr UINT RingDescriptorCount = 16384;
+
+	static constexpr UINT MaxBufferCount = FrameRing<FrameContext>::MaxFrames;
+
+	static constexpr const char* PipelineCachePath = "pipeline_cache.bin";
+	static constexpr const char* AdapterCachePath = "adapter_cache.bin";
+	/* Where release builds, which have no console, send the log. */
+	static constexpr const char* LogPath = "renderer.log";
+	std::unique_ptr<LogSink> mLogSink;
+
+	/* Failed checks, thrown where they fail, and debug layer errors, thrown by the frame loop; both through ThrowPendingException(). */
+	ErrorCapture mErrors;
 
 	GameTimer mTimer;
+	/* Decides how many Update() steps each frame runs. */
+	FixedTimestep mTimestep;
+
+	/* Created on the message loop thread, which becomes worker 0. */
+	std::unique_ptr<JobSystem> mJobs;
+
+	/* Fed once per frame by CalculateFrameStats, dumped with F3. */
+	FrameStats mFrameStats;
+	FrameSample mFrameSample;
+	__int64 mLastStatsTitleTicks = 0;
+	/* Posted to the window, which sets it as its title; the render thread must not send it messages. */
+	static constexpr UINT StatsTitleMessage = WM_APP + 1;
+	std::mutex mStatsTitleLock;
+	std::string mStatsTitle;
+
+	/* Waited on before the frame latency waitable, so input is still sampled as late as possible. */
+	SystemPacerClock mPacerClock;
+	FramePacer mFramePacer;
+	double mPacingFps = 60.0;
+	UINT mVsyncDivisor = 1;
+	__int64 mPaceWaitStart = 0;
+	__int64 mPaceWaitTicks = 0;
 
-	SIZE_T mRtvDescriptorHeapSize = 0;
-	SIZE_T mDsvDescriptorHeapSize = 0;
-	SIZE_T mCbvSrvDescriptorHeapSize = 0;
 	UINT m4xMsaaQuality = 0;
 	INT mClientWidth = INT_MAX;
 	INT mClientHeight = INT_MAX;
 	UINT mMsaaCount = 1;
-	static constexpr UINT mBufferCount = 2;
-	UINT64 mCurrentFence = 0;
+	UINT mBufferCount = 3;
 	UINT mCurrBackBuffer = 0;
 	HINSTANCE mhInstance = nullptr;
-	HANDLE mEventHandle = nullptr;
-
-	static HANDLE mStandardOutput;
 
 	bool mAppPaused = false;
 	bool mMinimized = false;
@@ -102,17 +253,93 @@ private:
 	bool mFullscreenState = false;
 
 	Microsoft::WRL::ComPtr<IDXGIAdapter> mAdapter;
+	/* Picks mAdapter by score; probe results persist in AdapterCachePath. */
+	DXAdapterSelector mAdapterSelector;
+	AdapterCaps mAdapterCaps;
 	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
 	Microsoft::WRL::ComPtr<ID3D12InfoQueue1> mInfoQueue;
+	/* Pipelines compile in the background and persist in PipelineCachePath across runs. */
+	DXPipelineCache mPipelines;
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> mCmdQueue;
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCmdList;
+	/* Only used for setup work that flushes the queue anyway. */
 	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mCmdAllocator;
-	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
-	Microsoft::WRL::ComPtr<IDXGISwapChain> mSwapchain;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mDsvHeap;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mRtvHeap;
-	Microsoft::WRL::ComPtr<ID3D12Resource> mSwapchainBuffer[mBufferCount];
-	Microsoft::WRL::ComPtr<ID3D12Resource> mDepthBuffer;
+	DXFrameSync mFrameSync;
+	/* Adds a COPY queue next to mCmdQueue, both synchronized through timeline fences. */
+	DXQueueManager mQueues;
+	FrameRing<FrameContext> mFrameRing;
+	/* GPU scopes of every frame, read back mBufferCount frames later; F3 exports them with the CPU phases. */
+	DXGpuProfiler mGpuProfiler;
+	/* Always on; the render graph marks every pass, ThrowPendingException() reports them after a device removal. */
+	DXGpuBreadcrumbs mBreadcrumbs;
+
+	/* Fed every frame mGpuProfiler reads back; the scene renders into SceneColor and the Upscale pass stretches it. */
+	DynamicResolutionController mDynamicResolution;
+	bool mDynamicResolutionEnabled = false;
+	uint64_t mLastScaledGpuFrame = 0;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> mUpscaleRootSignature;
+	DXPipelineHandle mUpscalePipeline = DXPipelineCache::InvalidHandle;
+
+	/* F4 toggles recording the scene on mParallelRecorder's threads. */
+	DXParallelRecorder mParallelRecorder;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mPostCmdList;
+	bool mParallelRecording = false;
+
+	DXUploadRing mUploadRing;
+	/* Render targets and other DEFAULT heap resources are placed resources from here. */
+	DXGpuMemoryAllocator mGpuMemory;
+	/* Rebuilt by Draw every frame; F3 also dumps its barrier schedule. */
+	DXRenderGraph mRenderGraph;
+	/* Pack file entries uploaded on the copy queue, StreamBytesPerFrame at a time. */
+	DXAssetStreamer mAssetStreamer;
+	Microsoft::WRL::ComPtr<IDXGISwapChain3> mSwapchain;
+	/* Signaled when fewer than mMaxFrameLatency presents are queued. */
+	HANDLE mFrameLatencyWaitable = nullptr;
+	UINT mMaxFrameLatency = 1;
+	UINT mSwapchainFlags = 0;
+	bool mTearingSupported = false;
+	/* Set once the waitable was signaled for the next frame, so messages are drained before it runs. */
+	bool mFrameLatencyReady = false;
+	__int64 mLatencyWaitStart = 0;
+	__int64 mLatencyWaitTicks = 0;
+	/* Oldest event the first step of this frame consumed; 0 when none. */
+	__int64 mFrameInputTicks = 0;
+
+	/* Only the window thread touches WndProc state; everything else belongs to the thread that renders. */
+	RenderThread mRenderThread;
+	bool mUseRenderThread = false;
+	/* Caught inside WndProc, which must not throw through DispatchMessage, and rethrown by the message loop. */
+	std::exception_ptr mWindowFailure;
+
+	/* Filled by WndProc, drained once per frame into mInputBatch, consumed by the next Update() step. */
+	std::unique_ptr<InputQueue> mInput;
+	std::vector<InputEvent> mInputBatch;
+	uint32_t mInputBatchCount = 0;
+	InputState mInputState;
+	LONG mAbsoluteMouseX = 0;
+	LONG mAbsoluteMouseY = 0;
+	bool mHasAbsoluteMouse = false;
+
+	/* CPU-only heaps; views are created here and copied into mShaderVisibleHeap tables. */
+	DXDescriptorHeap mRtvHeap;
+	DXDescriptorHeap mDsvHeap;
+	DXDescriptorHeap mCbvSrvUavHeap;
+	DXShaderVisibleHeap mShaderVisibleHeap;
+	DXDescriptor mBackBufferRtv[MaxBufferCount];
+	DXDescriptor mDepthDsv;
+	/* Rewritten every frame for the render graph's SceneColor texture. */
+	DXDescriptor mSceneColorRtv;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mSwapchainBuffer[MaxBufferCount];
+	DXGpuAllocation mDepthBuffer;
+	RenderTargetKey mDepthKey;
+	/* Depth buffers of earlier sizes, reused once the frames that used them retire. */
+	RenderTargetPool<DXGpuAllocation> mDepthPool;
+
+	/* WM_SIZE only requests a size; mClientWidth/mClientHeight change when OnResize() applies it. */
+	ResizeScheduler mResizeScheduler;
+	UINT64 mResizeCount = 0;
+	__int64 mResizeTicks = 0;
+	__int64 mMaxResizeTicks = 0;
 
 	D3D12_VIEWPORT vp;
 	D3D12_RECT scissor;
@@ -0,0 +1,70 @@
+#include "DXUploadRing.h"
+
+HRESULT DXUploadRing::Initialize(ID3D12Device* device, FrameSync* sync, UINT64 capacity)
+{
+	D3D12_HEAP_PROPERTIES hProps = {};
+	hProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+	hProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	hProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	hProps.CreationNodeMask = 0u;
+	hProps.VisibleNodeMask = 0u;
+
+	D3D12_RESOURCE_DESC bufferDesc = {};
+	bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	bufferDesc.Alignment = 0;
+	bufferDesc.Width = capacity;
+	bufferDesc.Height = 1;
+	bufferDesc.DepthOrArraySize = 1;
+	bufferDesc.MipLevels = 1;
+	bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+	bufferDesc.SampleDesc.Count = 1;
+	bufferDesc.SampleDesc.Quality = 0;
+	bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	bufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	HRESULT hr = device->CreateCommittedResource(
+		&hProps,
+		D3D12_HEAP_FLAG_NONE,
+		&bufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&mBuffer)
+	);
+	if (FAILED(hr))
+		return hr;
+
+	// Upload heaps can stay mapped for the lifetime of the resource. We never read from it.
+	D3D12_RANGE readRange = { 0, 0 };
+	void* mapped = nullptr;
+	hr = mBuffer->Map(0, &readRange, &mapped);
+	if (FAILED(hr))
+		return hr;
+
+	mGpuBase = mBuffer->GetGPUVirtualAddress();
+	mRing.Initialize(sync, capacity, mapped);
+	return S_OK;
+}
+
+DXUploadAllocation DXUploadRing::Allocate(UINT64 size, UINT64 alignment)
+{
+	return Wrap(mRing.Allocate(size, alignment));
+}
+
+DXUploadAllocation DXUploadRing::TryAllocate(UINT64 size, UINT64 alignment)
+{
+	return Wrap(mRing.TryAllocate(size, alignment));
+}
+
+DXUploadAllocation DXUploadRing::Wrap(const UploadAllocation& a) const
+{
+	DXUploadAllocation allocation = {};
+	if (!a.IsValid())
+		return allocation;
+
+	allocation.CpuAddress = a.CpuAddress;
+	allocation.GpuAddress = mGpuBase + a.Offset;
+	allocation.Offset = a.Offset;
+	allocation.Size = a.Size;
+	allocation.Resource = mBuffer.Get();
+	return allocation;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <cstring>
+#include "UploadRing.h"
+
+struct DXUploadAllocation
+{
+	void* CpuAddress = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS GpuAddress = 0;
+	UINT64 Offset = 0;
+	UINT64 Size = 0;
+	ID3D12Resource* Resource = nullptr;
+
+	bool IsValid() const { return CpuAddress != nullptr; }
+};
+
+/* UploadRing over one persistently mapped UPLOAD heap buffer. */
+class DXUploadRing
+{
+public:
+	HRESULT Initialize(ID3D12Device* device, FrameSync* sync, UINT64 capacity);
+
+	DXUploadAllocation Allocate(UINT64 size, UINT64 alignment);
+	/* Never waits on the GPU; returns an invalid allocation when the ring is full. */
+	DXUploadAllocation TryAllocate(UINT64 size, UINT64 alignment);
+
+	/* Size and placement rounded to 256 bytes, as required for constant buffer views. */
+	DXUploadAllocation AllocateConstants(UINT64 size)
+	{
+		const UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+		return Allocate((size + alignment - 1) & ~(alignment - 1), alignment);
+	}
+
+	template<typename T>
+	DXUploadAllocation UploadConstants(const T& data)
+	{
+		DXUploadAllocation allocation = AllocateConstants(sizeof(T));
+		if (allocation.IsValid())
+			memcpy(allocation.CpuAddress, &data, sizeof(T));
+		return allocation;
+	}
+
+	void FinishFrame(UINT64 fenceValue) { mRing.FinishFrame(fenceValue); }
+	void Retire() { mRing.Retire(); }
+
+	const UploadRingStats& Stats() const { return mRing.Stats(); }
+	ID3D12Resource* Resource() const { return mBuffer.Get(); }
+
+private:
+	DXUploadAllocation Wrap(const UploadAllocation& a) const;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> mBuffer;
+	D3D12_GPU_VIRTUAL_ADDRESS mGpuBase = 0;
+	UploadRing mRing;
+};
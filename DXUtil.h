@@ -1,32 +1,25 @@
 #pragma once
 
-#include <string>
-#include <sstream>
-#include <malloc.h>
+#include <d3d12.h>
+#include "ErrorCapture.h"
 
-#ifdef _DEBUG
+/*
+	Records a failed HRESULT in mErrors and throws it at once through the
+	caller's ThrowPendingException(), so nothing that depends on the call runs;
+	everything but the compare and branch lives out of line. Stays on in
+	release builds, where mInfoQueue is null.
+*/
 #define ThrowIfFailed(x)\
-{\
-	HRESULT hres = (x);\
-	if (FAILED(hres)) {\
-		std::stringstream oss;\
-		oss << "DirectX Error: " << std::hex << "0x" << hres << " at:\n\n";\
-		oss << #x << "\n\n";\
-		UINT64 messageCount = mInfoQueue->GetNumStoredMessages();\
-		for (UINT64 i = 0; i < messageCount; i++) {\
-			SIZE_T messageLen = 0;\
-			mInfoQueue->GetMessageW(i, nullptr, &messageLen);\
-			D3D12_MESSAGE* msg = (D3D12_MESSAGE*)malloc(messageLen);\
-			mInfoQueue->GetMessageW(i, msg, &messageLen);\
-			if (messageLen > 0)\
-				oss << msg->pDescription << "\n";\
-			free((void*)msg);\
+	do\
+	{\
+		HRESULT hres = (x);\
+		if (FAILED(hres)) [[unlikely]]\
+		{\
+			static constexpr ErrorSite site{ #x, __FILE__, __LINE__ };\
+			CaptureFailure(mErrors, site, hres, mInfoQueue.Get());\
+			ThrowPendingException();\
 		}\
-		if (!mHasException)\
-			mExceptionSettings.push({ "", oss.str() });\
-		mInfoQueue->ClearStoredMessages();\
-	}\
-}
-#else
-#define ThrowIfFailed(x) (x)
-#endif
+	} while (0)
+
+/* Adds the stored info queue messages unless the debug layer callback already reported them, then clears the queue. */
+__declspec(noinline) void CaptureFailure(ErrorCapture& errors, const ErrorSite& site, HRESULT hr, ID3D12InfoQueue* infoQueue);
@@ -0,0 +1,42 @@
+#include "DescriptorAllocator.h"
+
+#include <cassert>
+
+void DescriptorFreeList::Initialize(uint32_t capacity)
+{
+	assert(capacity < AllocatedMarker);
+
+	mNext.resize(capacity);
+	for (uint32_t i = 0; i < capacity; i++)
+		mNext[i] = i + 1 < capacity ? i + 1 : InvalidIndex;
+
+	mHead = capacity > 0 ? 0 : InvalidIndex;
+	mAllocated = 0;
+	mHighWaterMark = 0;
+}
+
+uint32_t DescriptorFreeList::Allocate()
+{
+	if (mHead == InvalidIndex)
+		return InvalidIndex;
+
+	uint32_t index = mHead;
+	mHead = mNext[index];
+	mNext[index] = AllocatedMarker;
+
+	mAllocated++;
+	if (mAllocated > mHighWaterMark)
+		mHighWaterMark = mAllocated;
+
+	return index;
+}
+
+void DescriptorFreeList::Free(uint32_t index)
+{
+	assert(index < mNext.size() && "Descriptor index out of range");
+	assert(mNext[index] == AllocatedMarker && "Descriptor freed twice");
+
+	mNext[index] = mHead;
+	mHead = index;
+	mAllocated--;
+}
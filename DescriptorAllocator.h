@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/*
+	O(1) allocator of descriptor indices in [0, capacity).
+	Free slots form an intrusive singly linked list stored in one array that is
+	sized once in Initialize(), so Allocate()/Free() never touch the heap.
+*/
+class DescriptorFreeList
+{
+public:
+	static constexpr uint32_t InvalidIndex = ~0u;
+
+	void Initialize(uint32_t capacity);
+
+	/* Returns InvalidIndex when every slot is in use. */
+	uint32_t Allocate();
+	void Free(uint32_t index);
+
+	uint32_t Capacity() const { return (uint32_t)mNext.size(); }
+	uint32_t Allocated() const { return mAllocated; }
+	uint32_t HighWaterMark() const { return mHighWaterMark; }
+
+private:
+	static constexpr uint32_t AllocatedMarker = ~0u - 1;
+
+	std::vector<uint32_t> mNext;
+	uint32_t mHead = InvalidIndex;
+	uint32_t mAllocated = 0;
+	uint32_t mHighWaterMark = 0;
+};
@@ -0,0 +1,103 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolutionController::Initialize(const DynamicResolutionSettings& settings)
+{
+	mSettings = settings;
+	mSettings.MinScale = std::clamp(settings.MinScale, 0.05, 1.0);
+	mSettings.MaxScale = std::clamp(settings.MaxScale, mSettings.MinScale, 1.0);
+	mSettings.Gain = std::clamp(settings.Gain, 0.0, 1.0);
+	mSettings.Smoothing = std::clamp(settings.Smoothing, 0.0, 1.0);
+	mSettings.Step = std::max(settings.Step, 0.0);
+	Reset();
+	ResetStats();
+}
+
+void DynamicResolutionController::Reset()
+{
+	mScale = mSettings.MaxScale;
+	mFullResolutionMs = 0.0;
+}
+
+double DynamicResolutionController::Update(double gpuMs, double scale)
+{
+	if (gpuMs <= 0.0 || scale <= 0.0)
+		return mScale;
+
+	mFrames++;
+	mOverBudget += gpuMs > mSettings.BudgetMs ? 1 : 0;
+	mScaleSum += scale;
+	mGpuMsSum += gpuMs;
+	mMinScale = std::min(mMinScale, scale);
+
+	double fullResolutionMs = gpuMs / (scale * scale);
+	mFullResolutionMs = mFullResolutionMs == 0.0 ? fullResolutionMs
+		: mFullResolutionMs + mSettings.Smoothing * (fullResolutionMs - mFullResolutionMs);
+	// A missed frame's cost is taken as is; smoothing it in would take several more misses to catch up with a jump.
+	if (gpuMs > mSettings.BudgetMs)
+		mFullResolutionMs = std::max(mFullResolutionMs, fullResolutionMs);
+
+	double target = std::sqrt(mSettings.BudgetMs * mSettings.Headroom / mFullResolutionMs);
+	double next = mScale + mSettings.Gain * (target - mScale);
+	// Over budget is worse than a little blurry: a frame that missed moves down at once.
+	if (gpuMs > mSettings.BudgetMs)
+		next = std::min(next, target);
+	if (mSettings.Step > 0.0)
+		next = std::round(next / mSettings.Step) * mSettings.Step;
+	next = std::clamp(next, mSettings.MinScale, mSettings.MaxScale);
+
+	if (next != mScale)
+		mScaleChanges++;
+	mScale = next;
+	return mScale;
+}
+
+void DynamicResolutionController::ScaledSize(uint32_t maxWidth, uint32_t maxHeight, uint32_t& width, uint32_t& height) const
+{
+	width = std::clamp((uint32_t)std::lround(maxWidth * mScale), 1u, std::max(maxWidth, 1u));
+	height = std::clamp((uint32_t)std::lround(maxHeight * mScale), 1u, std::max(maxHeight, 1u));
+}
+
+DynamicResolutionStats DynamicResolutionController::Stats() const
+{
+	DynamicResolutionStats stats;
+	stats.Frames = mFrames;
+	stats.OverBudget = mOverBudget;
+	stats.ScaleChanges = mScaleChanges;
+	stats.MinScale = mMinScale;
+	if (mFrames > 0)
+	{
+		stats.MeanScale = mScaleSum / (double)mFrames;
+		stats.MeanGpuMs = mGpuMsSum / (double)mFrames;
+	}
+	return stats;
+}
+
+void DynamicResolutionController::ResetStats()
+{
+	mFrames = 0;
+	mOverBudget = 0;
+	mScaleChanges = 0;
+	mMinScale = mScale;
+	mScaleSum = 0.0;
+	mGpuMsSum = 0.0;
+}
+
+std::vector<DynamicResolutionSample> DynamicResolutionController::Replay(const DynamicResolutionSettings& settings, const std::vector<double>& fullResolutionMs, uint32_t latencyFrames)
+{
+	DynamicResolutionController controller;
+	controller.Initialize(settings);
+
+	std::vector<DynamicResolutionSample> samples(fullResolutionMs.size());
+	for (size_t i = 0; i < fullResolutionMs.size(); i++)
+	{
+		// The frame renders at the scale decided so far; its time only arrives latencyFrames later.
+		samples[i].Scale = controller.Scale();
+		samples[i].GpuMs = fullResolutionMs[i] * samples[i].Scale * samples[i].Scale;
+		if (i >= latencyFrames)
+			controller.Update(samples[i - latencyFrames].GpuMs, samples[i - latencyFrames].Scale);
+	}
+	return samples;
+}
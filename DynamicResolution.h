@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct DynamicResolutionSettings
+{
+	/* GPU time per frame the controller aims for. */
+	double BudgetMs = 16.0;
+	/* Fraction of the budget to target, leaving room for spikes. */
+	double Headroom = 0.9;
+	/* Scale of each axis; the pixel count goes with its square. */
+	double MinScale = 0.5;
+	double MaxScale = 1.0;
+	/* Fraction of the way to the estimated scale taken per measurement; below 1 to ride out the frames in flight. */
+	double Gain = 0.3;
+	/* Weight of the newest sample in the smoothed GPU cost per pixel. */
+	double Smoothing = 0.25;
+	/* Scales snap to multiples of this, so tiny corrections do not change the resolution every frame. */
+	double Step = 1.0 / 32.0;
+};
+
+struct DynamicResolutionStats
+{
+	uint64_t Frames = 0;
+	uint64_t OverBudget = 0;
+	uint64_t ScaleChanges = 0;
+	double MinScale = 1.0;
+	double MeanScale = 0.0;
+	double MeanGpuMs = 0.0;
+};
+
+/* One frame of a replayed trace. */
+struct DynamicResolutionSample
+{
+	double Scale = 1.0;
+	double GpuMs = 0.0;
+};
+
+/*
+	Picks the render scale from measured GPU frame times. The controller
+	assumes GPU time is proportional to the pixel count, keeps a smoothed
+	estimate of the time a full resolution frame would take, raised at once
+	by a frame over budget, and moves part of the way toward the scale that
+	fits the budget, snapped to Step.
+	Purely arithmetic: the same measurements always give the same scales.
+*/
+class DynamicResolutionController
+{
+public:
+	void Initialize(const DynamicResolutionSettings& settings);
+	/* Back to MaxScale, forgetting the cost estimate. */
+	void Reset();
+
+	/* gpuMs is one frame's GPU time, rendered at scale; returns the scale for the next frame. */
+	double Update(double gpuMs, double scale);
+	double Scale() const { return mScale; }
+
+	/* maxWidth x maxHeight at the current scale, each at least 1 pixel. */
+	void ScaledSize(uint32_t maxWidth, uint32_t maxHeight, uint32_t& width, uint32_t& height) const;
+
+	const DynamicResolutionSettings& Settings() const { return mSettings; }
+	DynamicResolutionStats Stats() const;
+	void ResetStats();
+
+	/*
+		Runs the controller over fullResolutionMs, GPU times of a recorded frame sequence at
+		scale 1, as if each frame cost its time times the pixel fraction it was rendered at.
+		latencyFrames is how many frames old each measurement is when it arrives.
+	*/
+	static std::vector<DynamicResolutionSample> Replay(const DynamicResolutionSettings& settings, const std::vector<double>& fullResolutionMs, uint32_t latencyFrames);
+
+private:
+	DynamicResolutionSettings mSettings;
+	double mScale = 1.0;
+	/* Smoothed GPU time of a full resolution frame; 0 until the first measurement. */
+	double mFullResolutionMs = 0.0;
+
+	uint64_t mFrames = 0;
+	uint64_t mOverBudget = 0;
+	uint64_t mScaleChanges = 0;
+	double mMinScale = 1.0;
+	double mScaleSum = 0.0;
+	double mGpuMsSum = 0.0;
+};
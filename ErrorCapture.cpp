@@ -0,0 +1,100 @@
+#include "ErrorCapture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <iterator>
+
+bool ErrorCapture::Begin(const ErrorSite& site, int32_t result)
+{
+	mMutex.lock();
+	mCaptured++;
+
+	uint32_t count = mCount.load(std::memory_order_relaxed);
+	if (count == Capacity)
+	{
+		mDropped++;
+		mOverflow++;
+		mMutex.unlock();
+		return false;
+	}
+
+	ErrorRecord& record = mRecords[count];
+	record.Site = &site;
+	record.Result = result;
+	record.MessageOffset = mArenaUsed;
+	record.MessageLength = 0;
+	mOpen = &record;
+	return true;
+}
+
+void ErrorCapture::Append(std::string_view message)
+{
+	// One byte for the line break.
+	size_t room = ArenaSize - mArenaUsed;
+	size_t length = std::min(message.size(), room > 0 ? room - 1 : 0);
+	mTruncatedBytes += message.size() - length;
+	if (room == 0)
+		return;
+
+	std::memcpy(mArena + mArenaUsed, message.data(), length);
+	mArena[mArenaUsed + length] = '\n';
+	mArenaUsed += (uint32_t)length + 1;
+	mOpen->MessageLength += (uint32_t)length + 1;
+}
+
+void ErrorCapture::End()
+{
+	mOpen = nullptr;
+	mCount.store(mCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	mMutex.unlock();
+}
+
+void ErrorCapture::Record(const ErrorSite& site, int32_t result, std::string_view message)
+{
+	if (!Begin(site, result))
+		return;
+	Append(message);
+	End();
+}
+
+std::string ErrorCapture::Format() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	std::string text;
+	uint32_t count = mCount.load(std::memory_order_relaxed);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const ErrorRecord& record = mRecords[i];
+		if (record.Result != 0)
+			std::format_to(std::back_inserter(text), "0x{:08X} from {}\n[FILE]: {}:{}\n", (uint32_t)record.Result, record.Site->Expression, record.Site->File, record.Site->Line);
+		else
+			std::format_to(std::back_inserter(text), "{}: ", record.Site->Expression);
+		text.append(mArena + record.MessageOffset, record.MessageLength);
+		text.push_back('\n');
+	}
+
+	if (mOverflow > 0)
+		std::format_to(std::back_inserter(text), "{} more failures not kept\n", mOverflow);
+	return text;
+}
+
+void ErrorCapture::Clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mCount.store(0, std::memory_order_relaxed);
+	mArenaUsed = 0;
+	mOverflow = 0;
+}
+
+ErrorCaptureStats ErrorCapture::Stats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	ErrorCaptureStats stats;
+	stats.Captured = mCaptured;
+	stats.Dropped = mDropped;
+	stats.TruncatedBytes = mTruncatedBytes;
+	return stats;
+}
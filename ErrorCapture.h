@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+/* One failing call in the source; a function-local static, so its address doubles as the call-site id. */
+struct ErrorSite
+{
+	const char* Expression;
+	const char* File;
+	uint32_t Line;
+};
+
+struct ErrorRecord
+{
+	const ErrorSite* Site = nullptr;
+	/* The HRESULT; 0 for messages that did not come with one, e.g. from the debug layer callback. */
+	int32_t Result = 0;
+	/* Bytes of the arena holding this record's messages, one per line. */
+	uint32_t MessageOffset = 0;
+	uint32_t MessageLength = 0;
+};
+
+struct ErrorCaptureStats
+{
+	uint64_t Captured = 0;
+	/* Failures after the table was full, kept only as a count. */
+	uint64_t Dropped = 0;
+	/* Message bytes cut because the arena was full. */
+	uint64_t TruncatedBytes = 0;
+};
+
+/*
+	Failure records for the checked calls of one device. Everything is allocated
+	up front: a fixed table of records and an arena for their messages, both
+	reused once Clear() runs. Only the first Capacity failures are kept, since
+	the first is usually the cause and the rest its fallout. Checking a result
+	costs a compare and a branch the compiler lays out as not taken, so the
+	checks stay on in release builds. Thread-safe; the debug layer reports from
+	whichever thread made the call.
+*/
+class ErrorCapture
+{
+public:
+	static constexpr uint32_t Capacity = 32;
+	static constexpr uint32_t ArenaSize = 32 * 1024;
+
+	ErrorCapture() = default;
+	ErrorCapture(const ErrorCapture&) = delete;
+	ErrorCapture& operator=(const ErrorCapture&) = delete;
+
+	/* One relaxed load; meant to be polled every frame. */
+	bool HasErrors() const { return mCount.load(std::memory_order_relaxed) != 0; }
+
+	/* Starts a record; its messages follow with Append() until End(). False, with no record started, once the table is full. */
+	bool Begin(const ErrorSite& site, int32_t result);
+	void Append(std::string_view message);
+	void End();
+
+	/* Begin(), one Append() and End() in one call. */
+	void Record(const ErrorSite& site, int32_t result, std::string_view message);
+
+	/* The text an exception reports: every record with its messages. Allocates, so only call it on the way out. */
+	std::string Format() const;
+	void Clear();
+
+	ErrorCaptureStats Stats() const;
+
+private:
+	mutable std::mutex mMutex;
+	std::atomic<uint32_t> mCount{ 0 };
+	ErrorRecord mRecords[Capacity];
+	char mArena[ArenaSize];
+	uint32_t mArenaUsed = 0;
+	/* The record between Begin() and End(), or nullptr. */
+	ErrorRecord* mOpen = nullptr;
+	/* Failures dropped since the last Clear(). */
+	uint32_t mOverflow = 0;
+
+	uint64_t mCaptured = 0;
+	uint64_t mDropped = 0;
+	uint64_t mTruncatedBytes = 0;
+};
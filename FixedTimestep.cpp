@@ -0,0 +1,79 @@
+#include "FixedTimestep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+FixedTimestep::FixedTimestep(int64_t ticksPerSecond, double stepsPerSecond, uint32_t maxStepsPerFrame)
+	:
+	mTicksPerSecond(ticksPerSecond),
+	mStepCost(ticksPerSecond * 1000),
+	mMaxStepsPerFrame(std::clamp(maxStepsPerFrame, 1u, MaxStepsPerFrameLimit))
+{
+	SetRate(stepsPerSecond);
+}
+
+void FixedTimestep::SetRate(double stepsPerSecond)
+{
+	// mAccumulator is a fraction of mStepCost whatever the rate, so Alpha() carries over as is.
+	mBaseTicks = SimulationTicks();
+	mStepsAtRate = 0;
+	mRateMilliHz = std::max<int64_t>(1, std::llround(stepsPerSecond * 1000.0));
+}
+
+void FixedTimestep::SetMaxStepsPerFrame(uint32_t maxStepsPerFrame)
+{
+	mMaxStepsPerFrame = std::clamp(maxStepsPerFrame, 1u, MaxStepsPerFrameLimit);
+}
+
+uint32_t FixedTimestep::Advance(int64_t frameTicks)
+{
+	// A stall longer than the catch-up limit (breakpoint, window drag) is dropped here anyway,
+	// so clamping first keeps frameTicks * rate far from overflowing.
+	const int64_t maxTicks = (int64_t)(mMaxStepsPerFrame + 1) * (mStepCost / mRateMilliHz + 1);
+	int64_t ticks = std::clamp<int64_t>(frameTicks, 0, maxTicks);
+
+	mAccumulator += ticks * mRateMilliHz;
+	uint64_t owed = (uint64_t)(mAccumulator / mStepCost);
+	uint32_t steps = (uint32_t)std::min<uint64_t>(owed, mMaxStepsPerFrame);
+	mAccumulator -= (int64_t)steps * mStepCost;
+
+	mStats.Frames++;
+	if (owed > mMaxStepsPerFrame)
+	{
+		// Keep the fraction so Alpha() stays continuous, drop the whole steps that are left.
+		int64_t dropped = mAccumulator - mAccumulator % mStepCost;
+		mAccumulator -= dropped;
+		mStats.ClampedFrames++;
+		// One frame's drop always fits; the running total saturates instead of overflowing after a few huge frames.
+		int64_t droppedTicks = dropped / mRateMilliHz + (frameTicks - ticks);
+		mStats.DroppedTicks += std::min(droppedTicks, std::numeric_limits<int64_t>::max() - mStats.DroppedTicks);
+	}
+
+	mSteps += steps;
+	mStepsAtRate += steps;
+	mStats.Steps += steps;
+	mStats.MaxStepsInFrame = std::max(mStats.MaxStepsInFrame, steps);
+	return steps;
+}
+
+void FixedTimestep::Reset()
+{
+	mAccumulator = 0;
+	mSteps = 0;
+	mBaseTicks = 0;
+	mStepsAtRate = 0;
+}
+
+int64_t FixedTimestep::SimulationTicks() const
+{
+	// steps * mStepCost / rate, split so the product cannot overflow after days of uptime.
+	int64_t quotient = (int64_t)(mStepsAtRate / (uint64_t)mRateMilliHz);
+	int64_t remainder = (int64_t)(mStepsAtRate % (uint64_t)mRateMilliHz);
+	return mBaseTicks + quotient * mStepCost + remainder * mStepCost / mRateMilliHz;
+}
+
+double FixedTimestep::InterpolatedSeconds() const
+{
+	return std::max(0.0, SimulationSeconds() - (1.0 - Alpha()) * StepSeconds());
+}
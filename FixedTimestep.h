@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+struct FixedTimestepStats
+{
+	uint64_t Frames = 0;
+	uint64_t Steps = 0;
+	/* Frames that owed more than MaxStepsPerFrame steps; the rest of their time was dropped. */
+	uint64_t ClampedFrames = 0;
+	int64_t DroppedTicks = 0;
+	uint32_t MaxStepsInFrame = 0;
+};
+
+/*
+	Turns variable frame times into a whole number of fixed simulation steps.
+	Time is kept in clock ticks scaled by the step rate, so a rate that does not
+	divide the clock frequency (60 Hz on a 10 MHz QPC) never drifts. What is left
+	over after the steps is Alpha(): how far the frame is between the last two
+	simulated states, for the renderer to interpolate with.
+*/
+class FixedTimestep
+{
+public:
+	static constexpr uint32_t DefaultMaxStepsPerFrame = 8;
+	/* Keeps a frame's accumulated ticks * rate well inside 64 bits. */
+	static constexpr uint32_t MaxStepsPerFrameLimit = 1024;
+
+	FixedTimestep(int64_t ticksPerSecond, double stepsPerSecond = 60.0, uint32_t maxStepsPerFrame = DefaultMaxStepsPerFrame);
+
+	/* Keeps the simulation time reached so far and Alpha(). */
+	void SetRate(double stepsPerSecond);
+	void SetMaxStepsPerFrame(uint32_t maxStepsPerFrame);
+
+	/* Adds one frame's elapsed ticks and returns how many steps to run for it. */
+	uint32_t Advance(int64_t frameTicks);
+	void Reset();
+
+	/* In [0, 1): fraction of a step accumulated but not simulated yet. */
+	double Alpha() const { return (double)mAccumulator / (double)mStepCost; }
+
+	double Rate() const { return (double)mRateMilliHz / 1000.0; }
+	double StepSeconds() const { return 1000.0 / (double)mRateMilliHz; }
+	uint64_t StepIndex() const { return mSteps; }
+	/* Simulation time after the last step, exact to the tick. */
+	int64_t SimulationTicks() const;
+	double SimulationSeconds() const { return (double)SimulationTicks() / (double)mTicksPerSecond; }
+	/* Time of the state a renderer shows at Alpha(): the previous step plus Alpha() of a step. */
+	double InterpolatedSeconds() const;
+
+	const FixedTimestepStats& Stats() const { return mStats; }
+	void ResetStats() { mStats = {}; }
+
+private:
+	int64_t mTicksPerSecond;
+	/* The rate in 1/1000 Hz, so fractional rates (59.94) stay exact too. */
+	int64_t mRateMilliHz = 60000;
+	/* One step in accumulator units: ticksPerSecond * 1000. */
+	int64_t mStepCost;
+	/* Elapsed ticks * mRateMilliHz not simulated yet, always < mStepCost after Advance(). */
+	int64_t mAccumulator = 0;
+	uint32_t mMaxStepsPerFrame;
+	uint64_t mSteps = 0;
+	/* Simulation time when the rate last changed, and steps taken at the current rate since. */
+	int64_t mBaseTicks = 0;
+	uint64_t mStepsAtRate = 0;
+	FixedTimestepStats mStats;
+};
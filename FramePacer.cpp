@@ -0,0 +1,279 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include "SystemClock.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#endif
+
+SystemPacerClock::SystemPacerClock()
+	:
+	mFrequency(SystemClock::Frequency())
+{
+#ifdef _WIN32
+	// High resolution timers wake within ~0.5 ms instead of the 1-15.6 ms scheduler tick.
+	mTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (!mTimer)
+		mTimer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+#endif
+}
+
+SystemPacerClock::~SystemPacerClock()
+{
+#ifdef _WIN32
+	if (mTimer)
+		CloseHandle(mTimer);
+#endif
+}
+
+int64_t SystemPacerClock::Now()
+{
+	return SystemClock::Now();
+}
+
+void SystemPacerClock::Sleep(int64_t ticks)
+{
+	if (ticks <= 0)
+		return;
+
+#ifdef _WIN32
+	if (mTimer)
+	{
+		// Negative due times are relative, in 100 ns units.
+		LARGE_INTEGER due;
+		due.QuadPart = -std::max<int64_t>(1, ticks * 10000000 / mFrequency);
+		if (SetWaitableTimer(mTimer, &due, 0, nullptr, nullptr, FALSE))
+		{
+			WaitForSingleObject(mTimer, INFINITE);
+			return;
+		}
+	}
+	::Sleep((DWORD)(ticks * 1000 / mFrequency));
+#else
+	timespec duration;
+	duration.tv_sec = (time_t)(ticks / 1000000000);
+	duration.tv_nsec = (long)(ticks % 1000000000);
+	clock_nanosleep(CLOCK_MONOTONIC, 0, &duration, nullptr);
+#endif
+}
+
+void SystemPacerClock::Spin()
+{
+#ifdef _WIN32
+	YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#endif
+}
+
+FramePacer::FramePacer(PacerClock& clock)
+	:
+	mClock(clock),
+	mMinSpin(clock.Frequency() / 10000),
+	mMaxSpin(clock.Frequency() / 500),
+	mSleepOvershoot(clock.Frequency() / 1000)
+{
+}
+
+void FramePacer::SetUnlimited()
+{
+	mMode = FramePacingMode::Unlimited;
+	Reset();
+}
+
+void FramePacer::SetTargetFps(double fps)
+{
+	if (fps <= 0.0)
+	{
+		SetUnlimited();
+		return;
+	}
+
+	mMode = FramePacingMode::TargetFps;
+	mInterval = std::max<int64_t>(1, (int64_t)std::llround((double)mClock.Frequency() / fps));
+	Reset();
+}
+
+void FramePacer::SetVsync(int64_t periodTicks, int64_t vblankTicks, uint32_t divisor)
+{
+	mMode = FramePacingMode::VsyncAligned;
+	mInterval = std::max<int64_t>(1, periodTicks);
+	mVblank = vblankTicks;
+	mDivisor = std::max(divisor, 1u);
+	Reset();
+}
+
+void FramePacer::UpdateVsync(int64_t periodTicks, int64_t vblankTicks)
+{
+	mInterval = std::max<int64_t>(1, periodTicks);
+	mVblank = vblankTicks;
+}
+
+double FramePacer::TargetFps() const
+{
+	switch (mMode)
+	{
+	case FramePacingMode::TargetFps: return (double)mClock.Frequency() / (double)mInterval;
+	case FramePacingMode::VsyncAligned: return (double)mClock.Frequency() / (double)(mInterval * mDivisor);
+	default: return 0.0;
+	}
+}
+
+int64_t FramePacer::Wait()
+{
+	int64_t start = mClock.Now();
+	int64_t wake = start;
+
+	if (mMode != FramePacingMode::Unlimited)
+	{
+		int64_t deadline = NextDeadline(start);
+		if (deadline > start)
+		{
+			WaitUntil(deadline);
+			wake = mClock.Now();
+
+			int64_t error = wake - deadline;
+			mErrors[mWaited % ErrorHistory] = error;
+			mErrorSum += error;
+			mErrorMax = std::max(mErrorMax, error);
+			mWaited++;
+		}
+		mDeadline = deadline;
+	}
+
+	if (mStarted)
+	{
+		double interval = (double)(wake - mLastWake);
+		mIntervalSum += interval;
+		mIntervalSquares += interval * interval;
+		mIntervals++;
+	}
+	mLastWake = wake;
+	mStarted = true;
+	mFrames++;
+
+	return wake - start;
+}
+
+void FramePacer::Reset()
+{
+	mStarted = false;
+}
+
+FramePacerStats FramePacer::Stats() const
+{
+	const double ticksToMs = 1000.0 / (double)mClock.Frequency();
+
+	FramePacerStats stats;
+	stats.Frames = mFrames;
+	stats.Missed = mMissed;
+	stats.SleepMs = (double)mSleepTicks * ticksToMs;
+	stats.SpinMs = (double)mSpinTicks * ticksToMs;
+	stats.SpinWindowUs = TicksToUs(std::clamp(2 * mSleepOvershoot, mMinSpin, mMaxSpin));
+
+	if (mWaited > 0)
+	{
+		uint32_t count = (uint32_t)std::min<uint64_t>(mWaited, ErrorHistory);
+		int64_t errors[ErrorHistory];
+		std::copy(mErrors, mErrors + count, errors);
+
+		uint32_t index = std::min(count - 1, (uint32_t)std::ceil(0.99 * count) - 1);
+		std::nth_element(errors, errors + index, errors + count);
+
+		stats.MeanErrorUs = TicksToUs(mErrorSum) / (double)mWaited;
+		stats.P99ErrorUs = TicksToUs(errors[index]);
+		stats.MaxErrorUs = TicksToUs(mErrorMax);
+	}
+
+	if (mIntervals > 0)
+	{
+		double mean = mIntervalSum / (double)mIntervals;
+		double variance = std::max(0.0, mIntervalSquares / (double)mIntervals - mean * mean);
+		stats.MeanIntervalMs = mean * ticksToMs;
+		stats.IntervalStdDevMs = std::sqrt(variance) * ticksToMs;
+	}
+	return stats;
+}
+
+void FramePacer::ResetStats()
+{
+	mFrames = 0;
+	mMissed = 0;
+	mWaited = 0;
+	mErrorSum = 0;
+	mErrorMax = 0;
+	mIntervals = 0;
+	mIntervalSum = 0.0;
+	mIntervalSquares = 0.0;
+	mSleepTicks = 0;
+	mSpinTicks = 0;
+}
+
+int64_t FramePacer::NextDeadline(int64_t now)
+{
+	if (mMode == FramePacingMode::TargetFps)
+	{
+		if (!mStarted)
+			return now;
+
+		int64_t deadline = mDeadline + mInterval;
+		if (deadline >= now)
+			return deadline;
+
+		mMissed++;
+		return now;
+	}
+
+	// First vblank at or after ticks; the phase may lie on either side of it.
+	auto vblankAfter = [this](int64_t ticks)
+	{
+		int64_t offset = ticks - mVblank;
+		int64_t periods = offset >= 0 ? (offset + mInterval - 1) / mInterval : -(-offset / mInterval);
+		return mVblank + periods * mInterval;
+	};
+
+	if (!mStarted)
+		return vblankAfter(now);
+
+	// Snapping to the nearest vblank absorbs period and phase updates between frames.
+	int64_t deadline = vblankAfter(mDeadline + mInterval * mDivisor - mInterval / 2);
+	if (deadline >= now)
+		return deadline;
+
+	mMissed++;
+	return vblankAfter(now);
+}
+
+void FramePacer::WaitUntil(int64_t deadline)
+{
+	int64_t spinWindow = std::clamp(2 * mSleepOvershoot, mMinSpin, mMaxSpin);
+	int64_t now = mClock.Now();
+
+	if (deadline - now > spinWindow)
+	{
+		int64_t sleep = deadline - now - spinWindow;
+		mClock.Sleep(sleep);
+
+		int64_t after = mClock.Now();
+		int64_t overshoot = std::max<int64_t>(0, after - now - sleep);
+		// Grows at once and decays slowly, so one late wake-up widens the window for a while.
+		mSleepOvershoot = std::max(overshoot, mSleepOvershoot - mSleepOvershoot / 16);
+		mSleepTicks += after - now;
+		now = after;
+	}
+
+	int64_t spinStart = now;
+	while (now < deadline)
+	{
+		mClock.Spin();
+		now = mClock.Now();
+	}
+	mSpinTicks += now - spinStart;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+	Time source of the frame pacer. SystemPacerClock is the real one; a test
+	clock can advance its time in Sleep()/Spin() instead of blocking.
+*/
+class PacerClock
+{
+public:
+	virtual ~PacerClock() = default;
+
+	virtual int64_t Now() = 0;
+	virtual int64_t Frequency() const = 0;
+	/* Coarse OS sleep of about ticks; may overshoot by the scheduler's granularity. */
+	virtual void Sleep(int64_t ticks) = 0;
+	/* One iteration of the spin that finishes a wait. */
+	virtual void Spin() {}
+};
+
+/* SystemClock ticks; sleeps on a high resolution waitable timer on Windows, clock_nanosleep elsewhere. */
+class SystemPacerClock : public PacerClock
+{
+public:
+	SystemPacerClock();
+	~SystemPacerClock() override;
+
+	SystemPacerClock(const SystemPacerClock&) = delete;
+	SystemPacerClock& operator=(const SystemPacerClock&) = delete;
+
+	int64_t Now() override;
+	int64_t Frequency() const override { return mFrequency; }
+	void Sleep(int64_t ticks) override;
+	void Spin() override;
+
+private:
+	int64_t mFrequency;
+	void* mTimer = nullptr;
+};
+
+enum class FramePacingMode : uint32_t
+{
+	/* Wait() returns immediately. */
+	Unlimited,
+	/* Frames start every 1 / fps seconds. */
+	TargetFps,
+	/* Frames start on every divisor-th vblank of the display. */
+	VsyncAligned
+};
+
+struct FramePacerStats
+{
+	uint64_t Frames = 0;
+	/* Frames that were already late when Wait() was called; the schedule restarts from them. */
+	uint64_t Missed = 0;
+	/* Wake-up time minus deadline, over the frames that were waited for. */
+	double MeanErrorUs = 0.0;
+	double P99ErrorUs = 0.0;
+	double MaxErrorUs = 0.0;
+	/* Time between consecutive Wait() returns. */
+	double MeanIntervalMs = 0.0;
+	double IntervalStdDevMs = 0.0;
+	double SleepMs = 0.0;
+	double SpinMs = 0.0;
+	/* Current spin window, grown to cover the worst recent sleep overshoot. */
+	double SpinWindowUs = 0.0;
+};
+
+/*
+	Spaces frame starts by a target interval. Each deadline follows the previous
+	one, not the previous wake-up, so errors do not accumulate. Waits sleep on the
+	clock until the spin window before the deadline, then spin the rest.
+*/
+class FramePacer
+{
+public:
+	static constexpr uint32_t ErrorHistory = 512;
+
+	explicit FramePacer(PacerClock& clock);
+
+	void SetUnlimited();
+	void SetTargetFps(double fps);
+	/* vblankTicks is any past vblank on the pacer clock, periodTicks the refresh period. */
+	void SetVsync(int64_t periodTicks, int64_t vblankTicks, uint32_t divisor = 1);
+	/* Follows a refresh period or phase measured again by the caller, keeping the schedule. */
+	void UpdateVsync(int64_t periodTicks, int64_t vblankTicks);
+
+	FramePacingMode Mode() const { return mMode; }
+	double TargetFps() const;
+
+	/* Blocks until the next frame may start and returns the ticks waited. Call once per frame. */
+	int64_t Wait();
+	/* Restarts the schedule from now, e.g. after the app was paused. */
+	void Reset();
+
+	FramePacerStats Stats() const;
+	void ResetStats();
+
+private:
+	int64_t NextDeadline(int64_t now);
+	void WaitUntil(int64_t deadline);
+	double TicksToUs(int64_t ticks) const { return (double)ticks * 1000000.0 / (double)mClock.Frequency(); }
+
+	PacerClock& mClock;
+	FramePacingMode mMode = FramePacingMode::Unlimited;
+	int64_t mInterval = 0;
+	int64_t mVblank = 0;
+	uint32_t mDivisor = 1;
+
+	/* False until the first Wait() after a Reset(); until then mDeadline and mLastWake are stale. */
+	bool mStarted = false;
+	int64_t mDeadline = 0;
+	int64_t mLastWake = 0;
+
+	int64_t mMinSpin = 0;
+	int64_t mMaxSpin = 0;
+	int64_t mSleepOvershoot = 0;
+
+	uint64_t mFrames = 0;
+	uint64_t mMissed = 0;
+	uint64_t mWaited = 0;
+	int64_t mErrorSum = 0;
+	int64_t mErrorMax = 0;
+	int64_t mErrors[ErrorHistory] = {};
+	uint64_t mIntervals = 0;
+	double mIntervalSum = 0.0;
+	double mIntervalSquares = 0.0;
+	int64_t mSleepTicks = 0;
+	int64_t mSpinTicks = 0;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <cassert>
+
+/*
+	Timeline fence as seen by the frame ring.
+	DXFrameSync implements it on top of an ID3D12CommandQueue/ID3D12Fence pair,
+	a mock can implement it by completing values on demand.
+	Values only ever grow; nothing resets them on resize, so a value recorded
+	before one still compares correctly against CompletedValue() after it.
+*/
+class FrameSync
+{
+public:
+	virtual ~FrameSync() = default;
+
+	/* Enqueues a signal of the next fence value and returns that value. */
+	virtual uint64_t Signal() = 0;
+	virtual uint64_t CompletedValue() const = 0;
+	virtual uint64_t LastSignaledValue() const = 0;
+	/* Blocks the calling thread until value has been reached. */
+	virtual void WaitForValue(uint64_t value) = 0;
+
+	void WaitIdle() { WaitForValue(LastSignaledValue()); }
+};
+
+/* Every frame context must at least carry the fence value of its last submission. */
+struct FrameContextBase
+{
+	uint64_t FenceValue = 0;
+};
+
+struct FrameRingStats
+{
+	uint64_t Frames = 0;
+	/* Number of BeginFrame() calls that had to block on the GPU. */
+	uint64_t Stalls = 0;
+	/* Deepest CPU/GPU pipelining observed at BeginFrame(), in frames. */
+	uint32_t MaxFramesInFlight = 0;
+};
+
+/*
+	Ring of N frame contexts (N in [MinFrames, MaxFrames]).
+	The CPU only blocks when it wraps onto a context whose fence value has not
+	been retired by the GPU yet, instead of flushing the queue every frame.
+*/
+template<typename Context>
+class FrameRing
+{
+public:
+	static constexpr uint32_t MinFrames = 2;
+	static constexpr uint32_t MaxFrames = 4;
+
+	FrameRing() = default;
+	FrameRing(const FrameRing&) = delete;
+	FrameRing& operator=(const FrameRing&) = delete;
+
+	void Initialize(FrameSync* sync, uint32_t frameCount)
+	{
+		assert(sync != nullptr && "FrameRing needs a FrameSync");
+		assert(frameCount >= MinFrames && frameCount <= MaxFrames && "Invalid frames in flight count");
+
+		mSync = sync;
+		mFrameCount = frameCount;
+		mCurrent = 0;
+		mInFrame = false;
+		mStats = {};
+
+		for (uint32_t i = 0; i < MaxFrames; i++)
+			mContexts[i].FenceValue = 0;
+	}
+
+	/* Waits until the next context is retired and returns it. */
+	Context& BeginFrame()
+	{
+		assert(!mInFrame && "BeginFrame() called twice without EndFrame()");
+		Context& ctx = mContexts[mCurrent];
+
+		uint32_t inFlight = FramesInFlight();
+		if (inFlight > mStats.MaxFramesInFlight)
+			mStats.MaxFramesInFlight = inFlight;
+
+		if (mSync->CompletedValue() < ctx.FenceValue)
+		{
+			mStats.Stalls++;
+			mSync->WaitForValue(ctx.FenceValue);
+		}
+
+		mInFrame = true;
+		return ctx;
+	}
+
+	/* Signals the fence for the current context and advances the ring. */
+	void EndFrame()
+	{
+		assert(mInFrame && "EndFrame() called without BeginFrame()");
+		mContexts[mCurrent].FenceValue = mSync->Signal();
+		mCurrent = (mCurrent + 1) % mFrameCount;
+		mStats.Frames++;
+		mInFrame = false;
+	}
+
+	/* Number of submitted contexts the GPU has not retired yet. */
+	uint32_t FramesInFlight() const
+	{
+		uint64_t completed = mSync->CompletedValue();
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < mFrameCount; i++)
+		{
+			if (mContexts[i].FenceValue > completed)
+				count++;
+		}
+		return count;
+	}
+
+	void WaitIdle() { mSync->WaitIdle(); }
+
+	Context& Current() { return mContexts[mCurrent]; }
+	Context& operator[](uint32_t index) { assert(index < mFrameCount); return mContexts[index]; }
+	const Context& operator[](uint32_t index) const { assert(index < mFrameCount); return mContexts[index]; }
+
+	uint32_t CurrentIndex() const { return mCurrent; }
+	uint32_t FrameCount() const { return mFrameCount; }
+	const FrameRingStats& Stats() const { return mStats; }
+
+private:
+	Context mContexts[MaxFrames] = {};
+	FrameSync* mSync = nullptr;
+	uint32_t mFrameCount = MinFrames;
+	uint32_t mCurrent = 0;
+	bool mInFrame = false;
+	FrameRingStats mStats;
+};
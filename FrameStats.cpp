@@ -0,0 +1,189 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <string>
+
+static const char* MetricName(FrameMetric metric)
+{
+	switch (metric)
+	{
+	case FrameMetric::Frame: return "frame";
+	case FrameMetric::Submit: return "submit";
+	case FrameMetric::Wait: return "wait";
+	case FrameMetric::Present: return "present";
+	case FrameMetric::InputLatency: return "inputLatency";
+	default: return "unknown";
+	}
+}
+
+FrameStats::FrameStats(int64_t ticksPerSecond)
+	:
+	mTicksPerMicrosecond(std::max<int64_t>(ticksPerSecond / 1000000, 1)),
+	mMsPerTick(1000.0 / (double)ticksPerSecond)
+{
+}
+
+void FrameStats::Push(const FrameSample& sample)
+{
+	uint32_t slot = (mHead + mCount) % Capacity;
+
+	if (mCount == Capacity)
+	{
+		// Window is full: the oldest sample leaves the histogram.
+		for (uint32_t m = 0; m < (uint32_t)FrameMetric::Count; m++)
+		{
+			if (HasSample(mSamples[mHead], (FrameMetric)m))
+				mHistogram[m][Bucket(Get(mSamples[mHead], (FrameMetric)m))]--;
+		}
+
+		mHead = (mHead + 1) % Capacity;
+	}
+	else
+	{
+		mCount++;
+	}
+
+	mSamples[slot] = sample;
+	for (uint32_t m = 0; m < (uint32_t)FrameMetric::Count; m++)
+	{
+		if (HasSample(sample, (FrameMetric)m))
+			mHistogram[m][Bucket(Get(sample, (FrameMetric)m))]++;
+	}
+
+	mTotalFrames++;
+}
+
+void FrameStats::Clear()
+{
+	mHead = 0;
+	mCount = 0;
+	mTotalFrames = 0;
+	for (auto& metric : mHistogram)
+		std::fill(std::begin(metric), std::end(metric), 0u);
+}
+
+FrameMetricSummary FrameStats::Summarize(FrameMetric metric)
+{
+	FrameMetricSummary summary = {};
+
+	uint32_t count = 0;
+	int64_t sum = 0;
+	for (uint32_t i = 0; i < mCount; i++)
+	{
+		const FrameSample& sample = mSamples[(mHead + i) % Capacity];
+		if (!HasSample(sample, metric))
+			continue;
+
+		mScratch[count] = Get(sample, metric);
+		sum += mScratch[count++];
+	}
+
+	if (count == 0)
+		return summary;
+
+	std::sort(mScratch, mScratch + count);
+
+	auto percentile = [this, count](double p)
+	{
+		uint32_t index = (uint32_t)std::ceil(p * (double)count);
+		return TicksToMs(mScratch[std::clamp(index, 1u, count) - 1]);
+	};
+
+	summary.MeanMs = TicksToMs(sum) / (double)count;
+	summary.P50Ms = percentile(0.50);
+	summary.P95Ms = percentile(0.95);
+	summary.P99Ms = percentile(0.99);
+	summary.MaxMs = TicksToMs(mScratch[count - 1]);
+	return summary;
+}
+
+double FrameStats::BucketUpperBoundMs(uint32_t bucket)
+{
+	return (double)(1ull << bucket) / 1000.0;
+}
+
+void FrameStats::WriteCsv(std::ostream& out) const
+{
+	out << "frame,frameMs,submitMs,waitMs,presentMs,inputLatencyMs,inputEvents\n";
+
+	uint64_t firstFrame = mTotalFrames - mCount;
+	for (uint32_t i = 0; i < mCount; i++)
+	{
+		const FrameSample& s = mSamples[(mHead + i) % Capacity];
+		out << (firstFrame + i) << ","
+			<< TicksToMs(s.FrameTicks) << ","
+			<< TicksToMs(s.SubmitTicks) << ","
+			<< TicksToMs(s.WaitTicks) << ","
+			<< TicksToMs(s.PresentTicks) << ","
+			<< TicksToMs(s.InputLatencyTicks) << ","
+			<< s.InputEvents << "\n";
+	}
+}
+
+void FrameStats::WriteJson(std::ostream& out)
+{
+	out << "{\n\t\"frames\": " << mTotalFrames << ",\n\t\"window\": " << mCount << ",\n\t\"metrics\": {\n";
+
+	for (uint32_t m = 0; m < (uint32_t)FrameMetric::Count; m++)
+	{
+		FrameMetricSummary s = Summarize((FrameMetric)m);
+		out << "\t\t\"" << MetricName((FrameMetric)m) << "\": {"
+			<< "\"meanMs\": " << s.MeanMs
+			<< ", \"p50Ms\": " << s.P50Ms
+			<< ", \"p95Ms\": " << s.P95Ms
+			<< ", \"p99Ms\": " << s.P99Ms
+			<< ", \"maxMs\": " << s.MaxMs
+			<< ", \"histogram\": [";
+
+		for (uint32_t b = 0; b < HistogramBuckets; b++)
+			out << (b ? ", " : "") << mHistogram[m][b];
+
+		out << "]}" << (m + 1 < (uint32_t)FrameMetric::Count ? "," : "") << "\n";
+	}
+
+	out << "\t},\n\t\"bucketUpperBoundsMs\": [";
+	for (uint32_t b = 0; b < HistogramBuckets; b++)
+		out << (b ? ", " : "") << BucketUpperBoundMs(b);
+	out << "]\n}\n";
+}
+
+bool FrameStats::Dump(const char* basePath)
+{
+	std::string base(basePath);
+
+	std::ofstream csv(base + ".csv");
+	std::ofstream json(base + ".json");
+	if (!csv || !json)
+		return false;
+
+	WriteCsv(csv);
+	WriteJson(json);
+	return true;
+}
+
+int64_t FrameStats::Get(const FrameSample& sample, FrameMetric metric)
+{
+	switch (metric)
+	{
+	case FrameMetric::Frame: return sample.FrameTicks;
+	case FrameMetric::Submit: return sample.SubmitTicks;
+	case FrameMetric::Wait: return sample.WaitTicks;
+	case FrameMetric::Present: return sample.PresentTicks;
+	case FrameMetric::InputLatency: return sample.InputLatencyTicks;
+	default: return 0;
+	}
+}
+
+bool FrameStats::HasSample(const FrameSample& sample, FrameMetric metric)
+{
+	return metric != FrameMetric::InputLatency || sample.InputLatencyTicks > 0;
+}
+
+uint32_t FrameStats::Bucket(int64_t ticks) const
+{
+	uint64_t us = ticks > 0 ? (uint64_t)(ticks / mTicksPerMicrosecond) : 0;
+	return std::min((uint32_t)std::bit_width(us), HistogramBuckets - 1);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+/* Raw tick durations for one frame, as produced by GameTimer. */
+struct FrameSample
+{
+	int64_t FrameTicks = 0;   // Tick() to Tick()
+	int64_t SubmitTicks = 0;  // Recording + ExecuteCommandLists
+	int64_t WaitTicks = 0;    // Blocked on the frame latency waitable and the frame fence
+	int64_t PresentTicks = 0; // Inside Present()
+	int64_t InputLatencyTicks = 0; // Oldest input the frame sampled to Present() returning; 0 without input
+	uint32_t InputEvents = 0;       // Input queue depth drained at the start of the frame
+};
+
+enum class FrameMetric : uint32_t
+{
+	Frame,
+	Submit,
+	Wait,
+	Present,
+	/* Only frames that sampled input count towards this metric. */
+	InputLatency,
+	Count
+};
+
+struct FrameMetricSummary
+{
+	double MeanMs = 0.0;
+	double P50Ms = 0.0;
+	double P95Ms = 0.0;
+	double P99Ms = 0.0;
+	double MaxMs = 0.0;
+};
+
+/*
+	Rolling window of the last Capacity frames plus a log2-bucketed histogram
+	of the same window. Push() never allocates; percentiles are computed on demand.
+*/
+class FrameStats
+{
+public:
+	static constexpr uint32_t Capacity = 1024;
+	/* Bucket 0 holds samples under 1us, bucket i holds [2^(i-1), 2^i) us. */
+	static constexpr uint32_t HistogramBuckets = 24;
+
+	explicit FrameStats(int64_t ticksPerSecond);
+
+	void Push(const FrameSample& sample);
+	void Clear();
+
+	uint32_t Count() const { return mCount; }
+	uint64_t TotalFrames() const { return mTotalFrames; }
+
+	/* Not const: sorts into an internal scratch buffer. */
+	FrameMetricSummary Summarize(FrameMetric metric);
+
+	uint32_t HistogramCount(FrameMetric metric, uint32_t bucket) const { return mHistogram[(uint32_t)metric][bucket]; }
+	static double BucketUpperBoundMs(uint32_t bucket);
+
+	void WriteCsv(std::ostream& out) const;
+	void WriteJson(std::ostream& out);
+
+	/* Writes <basePath>.csv and <basePath>.json. */
+	bool Dump(const char* basePath);
+
+	double TicksToMs(int64_t ticks) const { return (double)ticks * mMsPerTick; }
+
+private:
+	static int64_t Get(const FrameSample& sample, FrameMetric metric);
+	static bool HasSample(const FrameSample& sample, FrameMetric metric);
+	uint32_t Bucket(int64_t ticks) const;
+
+	FrameSample mSamples[Capacity];
+	int64_t mScratch[Capacity];
+	uint32_t mHistogram[(uint32_t)FrameMetric::Count][HistogramBuckets] = {};
+	uint32_t mHead = 0;
+	uint32_t mCount = 0;
+	uint64_t mTotalFrames = 0;
+	int64_t mTicksPerMicrosecond;
+	double mMsPerTick;
+};
@@ -5,26 +5,31 @@
 #include "GameTimer.h"
 
 #include <Windows.h>
-#include "DXRenderer.h"
+#include "Logger.h"
+#include "SystemClock.h"
 
-#define mGetCurrTime(currTime) (QueryPerformanceCounter((LARGE_INTEGER*)&currTime))
+#define mGetCurrTime(currTime) (currTime = SystemClock::Now())
 
 GameTimer::GameTimer()
 {
-    __int64 countsPerSecond;
-    QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSecond);
+    mCountsPerSecond = SystemClock::Frequency();
 
-    mSecondsPerCount = 1.0 / (double)countsPerSecond;
+    mSecondsPerCount = 1.0 / (double)mCountsPerSecond;
+}
+
+int64_t GameTimer::CurrentTicks()
+{
+    return SystemClock::Now();
 }
 
 void GameTimer::Reset()
 {
     if (mBaseTime != 0)
     {
-        DXRenderer::Log("[WARNING]: Calling GameTimer::Reset() more than once.\n");
+        LOG_WARNING("Calling GameTimer::Reset() more than once.");
     }
 
-    __int64 currTime;
+    int64_t currTime;
     mGetCurrTime(currTime);
 
     mBaseTime = currTime;
@@ -37,7 +42,7 @@ void GameTimer::Start()
 {
     if (mStopped)
     {
-        __int64 startTime;
+        int64_t startTime;
         mGetCurrTime(startTime);
 
         mPausedTime += startTime - mStopTime;
@@ -47,7 +52,7 @@ void GameTimer::Start()
     }
     else
     {
-        DXRenderer::Log("[WARNING]: GameTimer is not paused for you to call GameTimer::Start()\n");
+        LOG_WARNING("GameTimer is not paused for you to call GameTimer::Start()");
     }
 }
 
@@ -60,7 +65,7 @@ void GameTimer::Stop()
     }
     else
     {
-        DXRenderer::Log("[WARNING]: GameTimer is not running for you to call GameTimer::Stop()\n");
+        LOG_WARNING("GameTimer is not running for you to call GameTimer::Stop()");
     }
 }
 
@@ -69,6 +74,7 @@ void GameTimer::Tick()
     if (mStopped)
     {
         mDeltaTime = 0.0;
+        mDeltaTicks = 0;
         return;
     }
 
@@ -76,7 +82,8 @@ void GameTimer::Tick()
     mGetCurrTime(mCurrTime);
 
     // Time difference between this frame and the previous
-    mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
+    mDeltaTicks = mCurrTime - mPrevTime;
+    mDeltaTime = mDeltaTicks * mSecondsPerCount;
 
     // Prepare for next frame.
     mPrevTime = mCurrTime;
@@ -88,7 +95,10 @@ void GameTimer::Tick()
         another processor, then mDeltaTime can be
         negative.
     */
-    if (mDeltaTime < 0.0)
+    if (mDeltaTicks < 0)
+    {
+        mDeltaTicks = 0;
         mDeltaTime = 0.0;
+    }
 
 }
\ No newline at end of file
@@ -1,23 +1,29 @@
 #pragma once
+
+#include <cstdint>
+
 class GameTimer
 {
 public:
 	GameTimer();
 
-	/* In seconds */
-	float TotalTime() const
+	/* Unpaused ticks since Reset(); 64-bit, so it stays exact for any uptime. */
+	int64_t TotalTicks() const
 	{
-		if (mStopped)
-		{
-			return (float)(((mStopTime - mPausedTime) - mBaseTime) * mSecondsPerCount);
-		}
-		else
-		{
-			return (float)(((mCurrTime - mPausedTime) - mBaseTime) * mSecondsPerCount);
-		}
+		return ((mStopped ? mStopTime : mCurrTime) - mPausedTime) - mBaseTime;
 	}
+	double TotalSeconds() const { return (double)TotalTicks() * mSecondsPerCount; }
+	double DeltaSeconds() const { return mDeltaTime; }
+
+	/* In seconds. A float only resolves ~2 ms after 4.5 hours; prefer TotalSeconds(). */
+	float TotalTime() const { return (float)TotalSeconds(); }
 	__forceinline float DeltaTime() const { return (float)mDeltaTime; }
 
+	/* Raw SystemClock ticks, for consumers that must not lose precision (FrameStats). */
+	__forceinline int64_t DeltaTicks() const { return mDeltaTicks; }
+	__forceinline int64_t TicksPerSecond() const { return mCountsPerSecond; }
+	static int64_t CurrentTicks();
+
 	void Reset(); // Call before message loop.
 	void Start(); // Call when unpaused.
 	void Stop(); // Call when paused.
@@ -27,11 +33,14 @@ private:
 	double mSecondsPerCount = 0.0;
 	double mDeltaTime = 0.0;
 
-	__int64 mBaseTime = 0;
-	__int64 mPausedTime = 0;
-	__int64 mStopTime = 0;
-	__int64 mPrevTime = 0;
-	__int64 mCurrTime = 0;
+	int64_t mCountsPerSecond = 0;
+	int64_t mDeltaTicks = 0;
+
+	int64_t mBaseTime = 0;
+	int64_t mPausedTime = 0;
+	int64_t mStopTime = 0;
+	int64_t mPrevTime = 0;
+	int64_t mCurrTime = 0;
 
 	bool mStopped = false;
 };
@@ -0,0 +1,218 @@
+#include "GpuBreadcrumbs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iterator>
+
+uint32_t GpuBreadcrumbs::BeginSubmission(const char* name, uint64_t frame)
+{
+	uint32_t slot = (uint32_t)(mNext % Capacity);
+	Submission& submission = mSubmissions[slot];
+	if (submission.FenceValue > mCompleted)
+		mOverruns++;
+
+	submission.Name = name;
+	submission.Frame = frame;
+	submission.FenceValue = 0;
+	submission.MarkerCount = 0;
+	submission.EventCount = 0;
+	mOpen = &submission;
+	mDepth = 0;
+	mNext++;
+	return slot;
+}
+
+uint32_t GpuBreadcrumbs::BeginMarker(const char* name)
+{
+	if (!mOpen || mOpen->MarkerCount == MaxMarkers || mDepth == MaxDepth)
+	{
+		// Still pushed, so EndMarker() pairs up; 0 means nothing is written.
+		if (mDepth < MaxDepth)
+			mStack[mDepth++] = 0;
+		return 0;
+	}
+
+	uint32_t marker = mOpen->MarkerCount++;
+	mOpen->Markers[marker] = name;
+	mOpen->Events[mOpen->EventCount++] = (uint8_t)marker;
+	mStack[mDepth++] = marker + 1;
+	return mOpen->EventCount;
+}
+
+uint32_t GpuBreadcrumbs::EndMarker()
+{
+	if (mDepth == 0)
+		return 0;
+	uint32_t marker = mStack[--mDepth];
+	if (marker == 0)
+		return 0;
+
+	mOpen->Events[mOpen->EventCount++] = (uint8_t)(marker - 1) | EndEvent;
+	return mOpen->EventCount;
+}
+
+void GpuBreadcrumbs::Submit(uint64_t fenceValue)
+{
+	for (; mUnsubmitted < mNext; mUnsubmitted++)
+		mSubmissions[mUnsubmitted % Capacity].FenceValue = fenceValue;
+	mOpen = nullptr;
+	mDepth = 0;
+}
+
+void GpuBreadcrumbs::SetCompletedValue(uint64_t completed)
+{
+	if (completed != UINT64_MAX && completed > mCompleted)
+		mCompleted = completed;
+}
+
+std::vector<BreadcrumbFault> GpuBreadcrumbs::Correlate(const uint32_t* slotValues) const
+{
+	std::vector<BreadcrumbFault> faults;
+
+	uint64_t first = mNext > Capacity ? mNext - Capacity : 0;
+	for (uint64_t i = first; i < mUnsubmitted; i++)
+	{
+		uint32_t slot = (uint32_t)(i % Capacity);
+		const Submission& submission = mSubmissions[slot];
+		if (submission.FenceValue <= mCompleted)
+			continue;
+
+		// Clamped, since a slot is garbage if the GPU wrote it after the device was lost.
+		uint32_t started = std::min(slotValues[slot * SlotValues + StartedValue], submission.EventCount);
+		uint32_t finished = std::min(slotValues[slot * SlotValues + FinishedValue], submission.EventCount);
+
+		// Begins up to started were reached and ends up to finished done; whatever is left on the stack is still open.
+		uint32_t open[MaxDepth];
+		uint32_t depth = 0;
+		int32_t lastStarted = -1;
+		int32_t lastFinished = -1;
+		for (uint32_t event = 1; event <= std::max(started, finished); event++)
+		{
+			uint32_t marker = submission.Events[event - 1] & ~EndEvent;
+			if ((submission.Events[event - 1] & EndEvent) == 0)
+			{
+				if (event <= started && depth < MaxDepth)
+				{
+					open[depth++] = marker;
+					lastStarted = (int32_t)marker;
+				}
+			}
+			else if (event <= finished && depth > 0 && open[depth - 1] == marker)
+			{
+				depth--;
+				lastFinished = (int32_t)marker;
+			}
+		}
+
+		BreadcrumbFault fault;
+		fault.Name = submission.Name;
+		fault.Frame = submission.Frame;
+		fault.FenceValue = submission.FenceValue;
+		fault.MarkerCount = submission.MarkerCount;
+		fault.LastFinished = lastFinished >= 0 ? submission.Markers[lastFinished] : nullptr;
+		if (lastStarted < 0)
+		{
+			fault.State = BreadcrumbFault::Progress::NotStarted;
+		}
+		else if (depth > 0)
+		{
+			fault.State = BreadcrumbFault::Progress::InMarker;
+			fault.LastStarted = submission.Markers[open[depth - 1]];
+		}
+		else
+		{
+			fault.State = BreadcrumbFault::Progress::BetweenMarkers;
+			fault.LastStarted = submission.Markers[lastStarted];
+		}
+		faults.push_back(fault);
+	}
+
+	return faults;
+}
+
+std::string GpuBreadcrumbs::Format(const std::vector<BreadcrumbFault>& faults, uint64_t completedValue)
+{
+	std::string text = std::format("GPU breadcrumbs: last completed fence value {}, {} unfinished submissions\n", completedValue, faults.size());
+	for (const BreadcrumbFault& fault : faults)
+	{
+		std::format_to(std::back_inserter(text), "  {} (frame {}, fence {}, {} markers): ", fault.Name ? fault.Name : "?", fault.Frame, fault.FenceValue, fault.MarkerCount);
+		switch (fault.State)
+		{
+		case BreadcrumbFault::Progress::NotStarted:
+			text.append("not started\n");
+			break;
+		case BreadcrumbFault::Progress::InMarker:
+			std::format_to(std::back_inserter(text), "stopped in {}, last finished {}\n", fault.LastStarted, fault.LastFinished ? fault.LastFinished : "none");
+			break;
+		default:
+			std::format_to(std::back_inserter(text), "stopped after {}\n", fault.LastFinished);
+			break;
+		}
+	}
+	return text;
+}
+
+BreadcrumbOverhead GpuBreadcrumbs::MeasureOverhead(uint32_t markerCount)
+{
+	using Clock = std::chrono::steady_clock;
+
+	BreadcrumbOverhead result;
+	result.Markers = markerCount;
+
+	static const char* const passNames[] = { "Shadows", "GBuffer", "Lighting", "Post" };
+	std::vector<uint32_t> values(Capacity * SlotValues, 0);
+	// volatile, so the stores standing in for WriteBufferImmediate are not optimized away.
+	volatile uint32_t* gpu = values.data();
+
+	GpuBreadcrumbs breadcrumbs;
+	uint64_t fence = 0;
+	Clock::time_point begin = Clock::now();
+	for (uint32_t done = 0; done < markerCount;)
+	{
+		uint32_t slot = breadcrumbs.BeginSubmission("Frame", fence);
+		gpu[slot * SlotValues + StartedValue] = 0;
+		gpu[slot * SlotValues + FinishedValue] = 0;
+		for (uint32_t i = 0; i < MaxMarkers && done < markerCount; i++, done++)
+		{
+			gpu[slot * SlotValues + StartedValue] = breadcrumbs.BeginMarker(passNames[i % std::size(passNames)]);
+			gpu[slot * SlotValues + FinishedValue] = breadcrumbs.EndMarker();
+		}
+		breadcrumbs.Submit(++fence);
+		breadcrumbs.SetCompletedValue(fence);
+	}
+	if (markerCount > 0)
+		result.NsPerMarker = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / markerCount;
+
+	// A frame that started Lighting and never finished it, behind one the GPU completed.
+	GpuBreadcrumbs hang;
+	for (uint32_t frame = 0; frame < 2; frame++)
+	{
+		uint32_t slot = hang.BeginSubmission("Frame", frame);
+		uint32_t* gpuSlot = &values[slot * SlotValues];
+		gpuSlot[StartedValue] = 0;
+		gpuSlot[FinishedValue] = 0;
+
+		bool hung = false;
+		for (const char* name : passNames)
+		{
+			uint32_t started = hang.BeginMarker(name);
+			uint32_t finished = hang.EndMarker();
+			if (hung)
+				continue;
+			gpuSlot[StartedValue] = started;
+			hung = frame == 1 && name == passNames[2];
+			if (!hung)
+				gpuSlot[FinishedValue] = finished;
+		}
+		hang.Submit(frame + 1);
+	}
+	// A removed device reports UINT64_MAX; the last value seen before it is what counts.
+	hang.SetCompletedValue(1);
+	hang.SetCompletedValue(UINT64_MAX);
+
+	std::vector<BreadcrumbFault> faults = hang.Correlate(values.data());
+	result.HangLocated = faults.size() == 1 && faults[0].Frame == 1 && faults[0].State == BreadcrumbFault::Progress::InMarker
+		&& faults[0].LastStarted == passNames[2] && faults[0].LastFinished == passNames[1];
+	return result;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* What one submission the GPU never finished had got to. */
+struct BreadcrumbFault
+{
+	enum class Progress : uint32_t
+	{
+		/* No marker started. Usually an earlier submission hung, or this one was still queued. */
+		NotStarted,
+		/* Hung inside LastStarted, with every marker it encloses that started finished. */
+		InMarker,
+		/* Every started marker finished; the hang came between markers or after the last one. */
+		BetweenMarkers
+	};
+
+	const char* Name = nullptr;
+	uint64_t Frame = 0;
+	uint64_t FenceValue = 0;
+	Progress State = Progress::NotStarted;
+	/* The innermost marker still open for InMarker, else the last one started; nullptr when none. */
+	const char* LastStarted = nullptr;
+	/* The last marker whose end the GPU reached; nullptr when none. */
+	const char* LastFinished = nullptr;
+	uint32_t MarkerCount = 0;
+};
+
+struct BreadcrumbOverhead
+{
+	uint32_t Markers = 0;
+	/* BeginMarker() and EndMarker() bookkeeping plus the two GPU writes, simulated by plain stores. */
+	double NsPerMarker = 0.0;
+	/* Whether Correlate() found the pass a simulated hang was left in. */
+	bool HangLocated = false;
+};
+
+/*
+	CPU side of GPU breadcrumbs. Every submission, i.e. the command lists
+	executed before one fence signal, gets a slot of SlotValues uint32s in
+	GPU-visible memory. Marker begins and ends are numbered in one sequence
+	per submission; begins write their number into the slot's first value as
+	the GPU reaches them, ends into the second once the work before them is
+	done. Which marker each number begins or ends stays here, in a fixed ring
+	of submissions keyed by fence value, so after a device removal Correlate()
+	can replay the sequence up to the slot values and tell, with the last
+	fence value seen complete, which markers of each unfinished submission
+	were still open, nested ones included.
+	Nothing allocates while recording. Not thread-safe; the submitting
+	thread records.
+*/
+class GpuBreadcrumbs
+{
+public:
+	/* Must exceed the submissions in flight; a slot is reused Capacity submissions later. */
+	static constexpr uint32_t Capacity = 32;
+	static constexpr uint32_t MaxMarkers = 64;
+	/* Every recorded marker has one begin and at most one end. */
+	static constexpr uint32_t MaxEvents = 2 * MaxMarkers;
+	static constexpr uint32_t MaxDepth = 16;
+	static constexpr uint32_t SlotValues = 2;
+	static constexpr uint32_t StartedValue = 0;
+	static constexpr uint32_t FinishedValue = 1;
+
+	/* Returns the slot for this submission's markers; the backend resets its values to 0 first. */
+	uint32_t BeginSubmission(const char* name, uint64_t frame);
+	/* The value the backend writes to StartedValue, or 0 to write nothing when the submission is out of markers. */
+	uint32_t BeginMarker(const char* name);
+	/* The value for FinishedValue, ending the innermost open marker, or 0 when that one was not recorded. */
+	uint32_t EndMarker();
+	/* fenceValue is what the queue signals after the submission's lists. */
+	void Submit(uint64_t fenceValue);
+
+	/* Remembers the completed fence value; a removed device reports UINT64_MAX, which is ignored. */
+	void SetCompletedValue(uint64_t completed);
+	uint64_t CompletedValue() const { return mCompleted; }
+
+	/* One fault per submitted, unfinished submission, oldest first; slotValues is the whole GPU buffer. */
+	std::vector<BreadcrumbFault> Correlate(const uint32_t* slotValues) const;
+	static std::string Format(const std::vector<BreadcrumbFault>& faults, uint64_t completedValue);
+
+	/* Submissions whose slot was reused before their fence value was seen complete. */
+	uint64_t Overruns() const { return mOverruns; }
+
+	/* Times markerCount markers with plain stores for the GPU writes, then hangs a simulated submission and correlates it. */
+	static BreadcrumbOverhead MeasureOverhead(uint32_t markerCount);
+
+private:
+	struct Submission
+	{
+		const char* Name = nullptr;
+		uint64_t Frame = 0;
+		/* 0 until Submit(). */
+		uint64_t FenceValue = 0;
+		uint32_t MarkerCount = 0;
+		const char* Markers[MaxMarkers] = {};
+		/* Per sequence number less one: the marker's index, with EndEvent set for an end. */
+		uint32_t EventCount = 0;
+		uint8_t Events[MaxEvents] = {};
+	};
+
+	static constexpr uint8_t EndEvent = 0x80;
+	static_assert(MaxMarkers <= EndEvent, "Marker indices must leave room for the end flag");
+
+	Submission mSubmissions[Capacity];
+	uint64_t mNext = 0;
+	/* Oldest submission still waiting for Submit(). */
+	uint64_t mUnsubmitted = 0;
+	Submission* mOpen = nullptr;
+	/* Open markers' indices plus one; 0 for one that was not recorded. */
+	uint32_t mStack[MaxDepth] = {};
+	uint32_t mDepth = 0;
+	uint64_t mCompleted = 0;
+	uint64_t mOverruns = 0;
+};
@@ -0,0 +1,122 @@
+#include "GpuMemoryAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+GpuMemoryAllocator::GpuMemoryAllocator(GpuHeapProvider& provider, uint64_t heapSize)
+	:
+	mProvider(provider),
+	mHeapSize(heapSize)
+{
+}
+
+GpuMemoryAllocator::~GpuMemoryAllocator()
+{
+	for (const std::unique_ptr<Heap>& heap : mHeaps)
+		mProvider.DestroyHeap(heap->Id);
+}
+
+GpuAllocation GpuMemoryAllocator::Allocate(GpuHeapKind kind, uint64_t size, uint64_t alignment)
+{
+	alignment = std::max(alignment, DefaultAlignment);
+
+	for (const std::unique_ptr<Heap>& heap : mHeaps)
+	{
+		if (heap->Kind != kind)
+			continue;
+
+		TlsfAllocator::Allocation a = heap->Allocator.Allocate(size, alignment);
+		if (a.IsValid())
+			return { heap->Id, a.Offset, a.Size, a.Handle, kind };
+	}
+
+	// Resources bigger than a heap get a heap of their own. Heap sizes stay a multiple
+	// of the MSAA alignment so any heap can be created with that alignment.
+	uint64_t heapSize = std::max(mHeapSize, (size + alignment - 1 + MsaaAlignment - 1) & ~(MsaaAlignment - 1));
+	uint32_t id = mNextHeapId++;
+	if (!mProvider.CreateHeap(kind, heapSize, id))
+		return {};
+
+	std::unique_ptr<Heap> heap = std::make_unique<Heap>();
+	heap->Id = id;
+	heap->Kind = kind;
+	heap->Allocator.Initialize(heapSize, DefaultAlignment);
+
+	TlsfAllocator::Allocation a = heap->Allocator.Allocate(size, alignment);
+	assert(a.IsValid() && "Allocation does not fit in a fresh heap");
+
+	mHeaps.push_back(std::move(heap));
+	return { id, a.Offset, a.Size, a.Handle, kind };
+}
+
+void GpuMemoryAllocator::Free(GpuAllocation& allocation)
+{
+	if (!allocation.IsValid())
+		return;
+
+	Heap* heap = FindHeap(allocation.HeapId);
+	assert(heap && "Allocation does not belong to this allocator");
+
+	heap->Allocator.Free(allocation.Handle);
+
+	if (heap->Allocator.IsEmpty())
+	{
+		size_t sameKind = std::count_if(mHeaps.begin(), mHeaps.end(), [&](const std::unique_ptr<Heap>& h) { return h->Kind == heap->Kind; });
+		if (sameKind > 1)
+		{
+			mProvider.DestroyHeap(heap->Id);
+			mHeaps.erase(std::find_if(mHeaps.begin(), mHeaps.end(), [&](const std::unique_ptr<Heap>& h) { return h.get() == heap; }));
+		}
+	}
+
+	allocation = {};
+}
+
+GpuMemoryStats GpuMemoryAllocator::Stats(GpuHeapKind kind) const
+{
+	GpuMemoryStats stats;
+	uint64_t freeBytes = 0;
+	for (const std::unique_ptr<Heap>& heap : mHeaps)
+	{
+		if (heap->Kind == kind)
+			AccumulateStats(*heap, stats, freeBytes);
+	}
+	FinishStats(stats, freeBytes);
+	return stats;
+}
+
+GpuMemoryStats GpuMemoryAllocator::TotalStats() const
+{
+	GpuMemoryStats stats;
+	uint64_t freeBytes = 0;
+	for (const std::unique_ptr<Heap>& heap : mHeaps)
+		AccumulateStats(*heap, stats, freeBytes);
+	FinishStats(stats, freeBytes);
+	return stats;
+}
+
+GpuMemoryAllocator::Heap* GpuMemoryAllocator::FindHeap(uint32_t heapId)
+{
+	for (const std::unique_ptr<Heap>& heap : mHeaps)
+	{
+		if (heap->Id == heapId)
+			return heap.get();
+	}
+	return nullptr;
+}
+
+void GpuMemoryAllocator::AccumulateStats(const Heap& heap, GpuMemoryStats& stats, uint64_t& freeBytes) const
+{
+	stats.Heaps++;
+	stats.Allocations += heap.Allocator.AllocationCount();
+	stats.ReservedBytes += heap.Allocator.Size();
+	stats.UsedBytes += heap.Allocator.UsedBytes();
+	stats.LargestFreeBytes = std::max(stats.LargestFreeBytes, heap.Allocator.LargestFreeBytes());
+	stats.FreeRanges += heap.Allocator.FreeBlockCount();
+	freeBytes += heap.Allocator.Size() - heap.Allocator.UsedBytes();
+}
+
+void GpuMemoryAllocator::FinishStats(GpuMemoryStats& stats, uint64_t freeBytes)
+{
+	stats.Fragmentation = freeBytes > 0 ? 1.0 - (double)stats.LargestFreeBytes / (double)freeBytes : 0.0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "TlsfAllocator.h"
+
+/* Resource heap tier 1 cannot mix these in one heap, so each kind gets its own blocks. */
+enum class GpuHeapKind : uint32_t
+{
+	Buffers,
+	RenderTargets, // Render target and depth stencil textures
+	Textures,      // Every other texture
+	Count
+};
+
+/*
+	Creates and destroys the large heaps the allocator suballocates from.
+	DXGpuMemoryAllocator backs this with ID3D12Heap; a mock only needs to track ids.
+*/
+class GpuHeapProvider
+{
+public:
+	virtual ~GpuHeapProvider() = default;
+
+	virtual bool CreateHeap(GpuHeapKind kind, uint64_t size, uint32_t heapId) = 0;
+	virtual void DestroyHeap(uint32_t heapId) = 0;
+};
+
+struct GpuAllocation
+{
+	static constexpr uint32_t InvalidHeap = ~0u;
+
+	uint32_t HeapId = InvalidHeap;
+	uint64_t Offset = 0;
+	uint64_t Size = 0;
+	uint32_t Handle = TlsfAllocator::InvalidHandle;
+	GpuHeapKind Kind = GpuHeapKind::Buffers;
+
+	bool IsValid() const { return HeapId != InvalidHeap; }
+};
+
+struct GpuMemoryStats
+{
+	uint32_t Heaps = 0;
+	uint32_t Allocations = 0;
+	uint64_t ReservedBytes = 0;
+	uint64_t UsedBytes = 0;
+	uint64_t LargestFreeBytes = 0;
+	uint32_t FreeRanges = 0;
+	/* 1 - largest free range / total free bytes: 0 when all free memory is contiguous. */
+	double Fragmentation = 0.0;
+};
+
+/*
+	Suballocates placed resources out of large heaps, one TLSF allocator per heap.
+	Allocations that do not fit in any heap of their kind create a new one; heaps
+	that become empty are destroyed, except the last one of each kind.
+*/
+class GpuMemoryAllocator
+{
+public:
+	/*
+		Placed resource alignment tiers. Heaps are managed in DefaultAlignment units,
+		so only MSAA resources ever need padding; 4 KB small textures round up.
+	*/
+	static constexpr uint64_t DefaultAlignment = 64ull * 1024;
+	static constexpr uint64_t MsaaAlignment = 4ull * 1024 * 1024;
+
+	GpuMemoryAllocator(GpuHeapProvider& provider, uint64_t heapSize);
+	~GpuMemoryAllocator();
+
+	GpuMemoryAllocator(const GpuMemoryAllocator&) = delete;
+	GpuMemoryAllocator& operator=(const GpuMemoryAllocator&) = delete;
+
+	GpuAllocation Allocate(GpuHeapKind kind, uint64_t size, uint64_t alignment);
+
+	/* The memory must no longer be in use by the GPU. */
+	void Free(GpuAllocation& allocation);
+
+	GpuMemoryStats Stats(GpuHeapKind kind) const;
+	GpuMemoryStats TotalStats() const;
+
+private:
+	struct Heap
+	{
+		uint32_t Id;
+		GpuHeapKind Kind;
+		TlsfAllocator Allocator;
+	};
+
+	Heap* FindHeap(uint32_t heapId);
+	void AccumulateStats(const Heap& heap, GpuMemoryStats& stats, uint64_t& freeBytes) const;
+	static void FinishStats(GpuMemoryStats& stats, uint64_t freeBytes);
+
+	GpuHeapProvider& mProvider;
+	uint64_t mHeapSize;
+	uint32_t mNextHeapId = 0;
+	std::vector<std::unique_ptr<Heap>> mHeaps;
+};
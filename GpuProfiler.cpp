@@ -0,0 +1,140 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+void GpuProfiler::Initialize(uint32_t frameSlots, int64_t cpuFrequency)
+{
+	mSlots.assign(frameSlots, Slot());
+	for (Slot& slot : mSlots)
+		slot.Frame.Scopes.reserve(MaxScopesPerFrame);
+
+	mCurrentSlot = 0;
+	mDepth = 0;
+	mDroppedOpen = 0;
+	mDroppedScopes = 0;
+	mHistoryHead = 0;
+	mHistoryCount = 0;
+	mCpuFrequency = cpuFrequency;
+}
+
+void GpuProfiler::BeginFrame(uint32_t slot, uint64_t frame)
+{
+	assert(!mSlots[slot].Pending && "Collect() the slot's previous frame first");
+	assert(mDepth == 0 && mDroppedOpen == 0 && "Scope left open at the end of the frame");
+
+	mCurrentSlot = slot;
+	mDepth = 0;
+	mDroppedOpen = 0;
+
+	GpuProfileFrame& current = mSlots[slot].Frame;
+	current.Frame = frame;
+	current.Scopes.clear();
+	current.CpuEvents.clear();
+	mSlots[slot].Pending = true;
+}
+
+uint32_t GpuProfiler::BeginScope(const char* name)
+{
+	if (mDepth >= MaxScopeDepth)
+	{
+		mDroppedOpen++;
+		mDroppedScopes++;
+		return InvalidQuery;
+	}
+
+	std::vector<GpuProfileScope>& scopes = mSlots[mCurrentSlot].Frame.Scopes;
+	if (scopes.size() >= MaxScopesPerFrame)
+	{
+		mOpen[mDepth++] = InvalidQuery;
+		mDroppedScopes++;
+		return InvalidQuery;
+	}
+
+	GpuProfileScope scope;
+	scope.Name = name;
+	scope.Depth = mDepth;
+	scope.BeginQuery = SlotFirstQuery(mCurrentSlot) + (uint32_t)scopes.size() * 2;
+	scopes.push_back(scope);
+
+	mOpen[mDepth++] = (uint32_t)scopes.size() - 1;
+	return scope.BeginQuery;
+}
+
+uint32_t GpuProfiler::EndScope()
+{
+	if (mDroppedOpen > 0)
+	{
+		mDroppedOpen--;
+		return InvalidQuery;
+	}
+
+	assert(mDepth > 0 && "EndScope() without BeginScope()");
+	uint32_t scope = mOpen[--mDepth];
+	if (scope == InvalidQuery)
+		return InvalidQuery;
+
+	return mSlots[mCurrentSlot].Frame.Scopes[scope].BeginQuery + 1;
+}
+
+void GpuProfiler::AddCpuEvent(const char* name, int64_t beginTicks, int64_t endTicks)
+{
+	mSlots[mCurrentSlot].Frame.CpuEvents.push_back({ name, beginTicks, endTicks });
+}
+
+void GpuProfiler::Collect(uint32_t slot, const uint64_t* timestamps, const GpuClockCalibration& calibration)
+{
+	Slot& source = mSlots[slot];
+	if (!source.Pending)
+		return;
+
+	for (GpuProfileScope& scope : source.Frame.Scopes)
+	{
+		uint32_t query = scope.BeginQuery - SlotFirstQuery(slot);
+		scope.BeginTicks = calibration.ToCpuTicks(timestamps[query]);
+		scope.EndTicks = calibration.ToCpuTicks(timestamps[query + 1]);
+	}
+
+	// Swapping hands the old history frame's buffers back to the slot, so nothing reallocates.
+	std::swap(mHistory[mHistoryHead], source.Frame);
+	mHistoryHead = (mHistoryHead + 1) % HistoryFrames;
+	mHistoryCount = std::min(mHistoryCount + 1, HistoryFrames);
+	source.Pending = false;
+}
+
+const GpuProfileFrame* GpuProfiler::LatestFrame() const
+{
+	if (mHistoryCount == 0)
+		return nullptr;
+	return &mHistory[(mHistoryHead + HistoryFrames - 1) % HistoryFrames];
+}
+
+double GpuProfiler::LatestFrameMs() const
+{
+	const GpuProfileFrame* frame = LatestFrame();
+	if (!frame)
+		return 0.0;
+
+	int64_t begin = INT64_MAX;
+	int64_t end = INT64_MIN;
+	for (const GpuProfileScope& scope : frame->Scopes)
+	{
+		if (scope.Depth != 0)
+			continue;
+		begin = std::min(begin, scope.BeginTicks);
+		end = std::max(end, scope.EndTicks);
+	}
+	return end > begin ? (double)(end - begin) * 1000.0 / (double)mCpuFrequency : 0.0;
+}
+
+void GpuProfiler::AppendTrace(ChromeTrace& trace, uint32_t cpuTrack, uint32_t gpuTrack) const
+{
+	for (uint32_t i = 0; i < mHistoryCount; i++)
+	{
+		const GpuProfileFrame& frame = mHistory[(mHistoryHead + HistoryFrames - mHistoryCount + i) % HistoryFrames];
+		for (const GpuProfileCpuEvent& event : frame.CpuEvents)
+			trace.Add(event.Name, cpuTrack, event.BeginTicks, event.EndTicks);
+		for (const GpuProfileScope& scope : frame.Scopes)
+			trace.Add(scope.Name, gpuTrack, scope.BeginTicks, scope.EndTicks);
+	}
+}
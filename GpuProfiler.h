@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ChromeTrace.h"
+
+/* A GPU timestamp and the CPU tick it was taken at, from GetClockCalibration(). */
+struct GpuClockCalibration
+{
+	uint64_t GpuTimestamp = 0;
+	int64_t CpuTicks = 0;
+	uint64_t GpuFrequency = 1;
+	int64_t CpuFrequency = 1;
+
+	int64_t ToCpuTicks(uint64_t timestamp) const
+	{
+		double gpuTicks = (double)(int64_t)(timestamp - GpuTimestamp);
+		return CpuTicks + (int64_t)(gpuTicks * (double)CpuFrequency / (double)GpuFrequency);
+	}
+};
+
+/* A named region of one frame; times are in CPU ticks once the frame has been collected. */
+struct GpuProfileScope
+{
+	const char* Name = nullptr;
+	uint32_t Depth = 0;
+	uint32_t BeginQuery = 0;
+	int64_t BeginTicks = 0;
+	int64_t EndTicks = 0;
+};
+
+struct GpuProfileCpuEvent
+{
+	const char* Name = nullptr;
+	int64_t BeginTicks = 0;
+	int64_t EndTicks = 0;
+};
+
+struct GpuProfileFrame
+{
+	uint64_t Frame = 0;
+	std::vector<GpuProfileScope> Scopes;
+	std::vector<GpuProfileCpuEvent> CpuEvents;
+};
+
+/*
+	Bookkeeping for timestamp queries: every frame slot owns QueriesPerFrame queries,
+	two per scope. The backend writes the timestamps, resolves them into the slot's
+	readback memory and hands them to Collect() once the slot's fence has retired,
+	frameSlots frames later, so nothing ever waits on the GPU. Collected frames are
+	kept for HistoryFrames frames for export. Scope names must be string literals.
+*/
+class GpuProfiler
+{
+public:
+	static constexpr uint32_t MaxScopesPerFrame = 256;
+	static constexpr uint32_t QueriesPerFrame = MaxScopesPerFrame * 2;
+	static constexpr uint32_t MaxScopeDepth = 32;
+	static constexpr uint32_t HistoryFrames = 64;
+	static constexpr uint32_t InvalidQuery = ~0u;
+
+	void Initialize(uint32_t frameSlots, int64_t cpuFrequency);
+
+	void BeginFrame(uint32_t slot, uint64_t frame);
+	/* Query index for the begin timestamp, or InvalidQuery if the frame is out of scopes. */
+	uint32_t BeginScope(const char* name);
+	/* Query index for the end timestamp of the innermost open scope. */
+	uint32_t EndScope();
+	/* CPU work of the current frame, exported next to its GPU scopes. */
+	void AddCpuEvent(const char* name, int64_t beginTicks, int64_t endTicks);
+
+	uint32_t SlotFirstQuery(uint32_t slot) const { return slot * QueriesPerFrame; }
+	uint32_t CurrentSlot() const { return mCurrentSlot; }
+	uint32_t UsedQueries(uint32_t slot) const { return (uint32_t)mSlots[slot].Frame.Scopes.size() * 2; }
+	bool HasPendingFrame(uint32_t slot) const { return mSlots[slot].Pending; }
+
+	/*
+		Converts the slot's timestamps, indexed from SlotFirstQuery(slot), to CPU ticks and
+		moves the frame into the history. Call after the slot's fence has completed.
+	*/
+	void Collect(uint32_t slot, const uint64_t* timestamps, const GpuClockCalibration& calibration);
+	/* Forgets the slot's frame when its timestamps cannot be read. */
+	void Drop(uint32_t slot) { mSlots[slot].Pending = false; }
+
+	/* Most recently collected frame, and the span of its outermost scopes in milliseconds. */
+	const GpuProfileFrame* LatestFrame() const;
+	double LatestFrameMs() const;
+
+	uint64_t DroppedScopes() const { return mDroppedScopes; }
+
+	/* Adds every frame in the history; GPU scopes go to gpuTrack, CPU events to cpuTrack. */
+	void AppendTrace(ChromeTrace& trace, uint32_t cpuTrack, uint32_t gpuTrack) const;
+
+private:
+	struct Slot
+	{
+		GpuProfileFrame Frame;
+		bool Pending = false;
+	};
+
+	std::vector<Slot> mSlots;
+	uint32_t mCurrentSlot = 0;
+	uint32_t mOpen[MaxScopeDepth] = {};
+	uint32_t mDepth = 0;
+	/* Scopes that did not fit into their frame, counted so EndScope() still pairs up. */
+	uint32_t mDroppedOpen = 0;
+	uint64_t mDroppedScopes = 0;
+
+	GpuProfileFrame mHistory[HistoryFrames];
+	uint32_t mHistoryHead = 0;
+	uint32_t mHistoryCount = 0;
+	int64_t mCpuFrequency = 1;
+};
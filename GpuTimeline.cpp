@@ -0,0 +1,56 @@
+#include "GpuTimeline.h"
+
+void GpuTimeline::Initialize(FrameSync* graphics, FrameSync* copy)
+{
+	mSyncs[(uint32_t)GpuQueueType::Graphics] = graphics;
+	mSyncs[(uint32_t)GpuQueueType::Copy] = copy;
+
+	for (uint32_t q = 0; q < QueueCount; q++)
+		mCompleted[q].store(mSyncs[q]->CompletedValue(), std::memory_order_relaxed);
+}
+
+GpuSyncPoint GpuTimeline::Signal(GpuQueueType queue)
+{
+	return { queue, mSyncs[(uint32_t)queue]->Signal() };
+}
+
+GpuSyncPoint GpuTimeline::LastSignaled(GpuQueueType queue) const
+{
+	return { queue, mSyncs[(uint32_t)queue]->LastSignaledValue() };
+}
+
+bool GpuTimeline::IsComplete(const GpuSyncPoint& point) const
+{
+	if (point.Value <= mCompleted[(uint32_t)point.Queue].load(std::memory_order_relaxed))
+		return true;
+
+	return point.Value <= CompletedValue(point.Queue);
+}
+
+uint64_t GpuTimeline::CompletedValue(GpuQueueType queue) const
+{
+	uint64_t completed = mSyncs[(uint32_t)queue]->CompletedValue();
+
+	// Fences only move forward, but another thread may have stored a newer value meanwhile.
+	std::atomic<uint64_t>& cached = mCompleted[(uint32_t)queue];
+	uint64_t previous = cached.load(std::memory_order_relaxed);
+	while (previous < completed && !cached.compare_exchange_weak(previous, completed, std::memory_order_relaxed))
+	{
+	}
+	return completed > previous ? completed : previous;
+}
+
+void GpuTimeline::Wait(const GpuSyncPoint& point)
+{
+	if (IsComplete(point))
+		return;
+
+	mSyncs[(uint32_t)point.Queue]->WaitForValue(point.Value);
+	CompletedValue(point.Queue);
+}
+
+void GpuTimeline::WaitIdle()
+{
+	for (uint32_t q = 0; q < QueueCount; q++)
+		Wait(LastSignaled((GpuQueueType)q));
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "FrameRing.h"
+
+enum class GpuQueueType : uint32_t
+{
+	Graphics,
+	Copy,
+	Count
+};
+
+/* A fence value on one queue's timeline. Value 0 is always complete. */
+struct GpuSyncPoint
+{
+	GpuQueueType Queue = GpuQueueType::Graphics;
+	uint64_t Value = 0;
+};
+
+/*
+	Completion tracking over one timeline fence (FrameSync) per queue.
+	IsComplete() only reads the fence when the cached completed value is too
+	old, so it is cheap enough to poll from any thread.
+*/
+class GpuTimeline
+{
+public:
+	static constexpr uint32_t QueueCount = (uint32_t)GpuQueueType::Count;
+
+	void Initialize(FrameSync* graphics, FrameSync* copy);
+
+	/* Enqueues a signal on queue. Not thread-safe per queue, the submitter serializes. */
+	GpuSyncPoint Signal(GpuQueueType queue);
+	GpuSyncPoint LastSignaled(GpuQueueType queue) const;
+
+	bool IsComplete(const GpuSyncPoint& point) const;
+	uint64_t CompletedValue(GpuQueueType queue) const;
+
+	/* Blocks the calling thread. */
+	void Wait(const GpuSyncPoint& point);
+	void WaitIdle();
+
+	FrameSync* Sync(GpuQueueType queue) const { return mSyncs[(uint32_t)queue]; }
+
+private:
+	FrameSync* mSyncs[QueueCount] = {};
+	mutable std::atomic<uint64_t> mCompleted[QueueCount] = {};
+};
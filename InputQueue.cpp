@@ -0,0 +1,143 @@
+#include "InputQueue.h"
+
+#include <algorithm>
+#include <cmath>
+
+void InputState::Apply(const InputEvent& event)
+{
+	switch (event.Type)
+	{
+	case InputEventType::MouseMove:
+		MouseX += event.X;
+		MouseY += event.Y;
+		break;
+	case InputEventType::MouseButton:
+		if (event.Code < 32)
+			Buttons = event.X ? Buttons | (1u << event.Code) : Buttons & ~(1u << event.Code);
+		break;
+	case InputEventType::MouseWheel:
+		if (event.Code == 0)
+			Wheel += event.X;
+		break;
+	default:
+		break;
+	}
+}
+
+void InputQueue::Push(const InputEvent& event)
+{
+	mRawEvents.fetch_add(1, std::memory_order_relaxed);
+
+	if (mHasPending && CanMerge(mPending, event))
+	{
+		// The pending event keeps the oldest timestamp, so latency is measured from the first message.
+		mPending.X += event.X;
+		mPending.Y += event.Y;
+		mPending.Merged += event.Merged;
+		mCoalesced.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Flush();
+
+	if (event.Type == InputEventType::MouseMove || event.Type == InputEventType::MouseWheel)
+	{
+		mPending = event;
+		mHasPending = true;
+		return;
+	}
+	Publish(event);
+}
+
+void InputQueue::Flush()
+{
+	if (!mHasPending)
+		return;
+
+	mHasPending = false;
+	Publish(mPending);
+}
+
+uint32_t InputQueue::Drain(InputEvent* out, uint32_t maxEvents)
+{
+	uint64_t tail = mTail.load(std::memory_order_relaxed);
+	uint64_t head = mHead.load(std::memory_order_acquire);
+	uint32_t count = (uint32_t)std::min<uint64_t>(head - tail, maxEvents);
+
+	for (uint32_t i = 0; i < count; i++)
+		out[i] = mEventsRing[(tail + i) & (Capacity - 1)];
+	mTail.store(tail + count, std::memory_order_release);
+
+	mDrains++;
+	mEvents += count;
+	mMaxDepth = std::max(mMaxDepth, count);
+	mDepthHistogram[std::min(count, DepthBuckets - 1)]++;
+	return count;
+}
+
+InputQueueStats InputQueue::Stats() const
+{
+	InputQueueStats stats;
+	stats.RawEvents = mRawEvents.load(std::memory_order_relaxed) - mRawEventsBase;
+	stats.Coalesced = mCoalesced.load(std::memory_order_relaxed) - mCoalescedBase;
+	stats.Dropped = mDropped.load(std::memory_order_relaxed) - mDroppedBase;
+	stats.Drains = mDrains;
+	stats.Events = mEvents;
+	stats.MaxDepth = mMaxDepth;
+
+	if (mDrains > 0)
+	{
+		stats.MeanDepth = (double)mEvents / (double)mDrains;
+
+		uint64_t target = (uint64_t)std::ceil(0.95 * (double)mDrains);
+		uint64_t seen = 0;
+		for (uint32_t depth = 0; depth < DepthBuckets; depth++)
+		{
+			seen += mDepthHistogram[depth];
+			if (seen >= target)
+			{
+				stats.P95Depth = depth;
+				break;
+			}
+		}
+	}
+	return stats;
+}
+
+void InputQueue::ResetStats()
+{
+	// Storing zero would race the producer's increments and lose them.
+	mRawEventsBase = mRawEvents.load(std::memory_order_relaxed);
+	mCoalescedBase = mCoalesced.load(std::memory_order_relaxed);
+	mDroppedBase = mDropped.load(std::memory_order_relaxed);
+	mDrains = 0;
+	mEvents = 0;
+	mMaxDepth = 0;
+	std::fill(std::begin(mDepthHistogram), std::end(mDepthHistogram), 0u);
+}
+
+void InputQueue::Publish(const InputEvent& event)
+{
+	uint64_t head = mHead.load(std::memory_order_relaxed);
+	if (head - mCachedTail >= Capacity)
+	{
+		mCachedTail = mTail.load(std::memory_order_acquire);
+		if (head - mCachedTail >= Capacity)
+		{
+			mDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+
+	mEventsRing[head & (Capacity - 1)] = event;
+	mHead.store(head + 1, std::memory_order_release);
+}
+
+bool InputQueue::CanMerge(const InputEvent& pending, const InputEvent& event)
+{
+	if (pending.Type != event.Type)
+		return false;
+	if (event.Type == InputEventType::MouseMove)
+		return true;
+	return event.Type == InputEventType::MouseWheel && pending.Code == event.Code;
+}
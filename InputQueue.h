@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+enum class InputEventType : uint32_t
+{
+	/* X, Y: relative motion. */
+	MouseMove,
+	/* Code: button index, X: 1 pressed, 0 released. */
+	MouseButton,
+	/* Code: 0 vertical, 1 horizontal; X: delta in WHEEL_DELTA units. */
+	MouseWheel,
+	/* Code: virtual key, X: 1 pressed, 0 released. */
+	Key
+};
+
+struct InputEvent
+{
+	/* Arrival of the first raw message merged into this event. */
+	int64_t Ticks = 0;
+	InputEventType Type = InputEventType::MouseMove;
+	uint32_t Code = 0;
+	int32_t X = 0;
+	int32_t Y = 0;
+	/* Raw messages folded into this event by coalescing. */
+	uint32_t Merged = 1;
+};
+
+/* What the events of one batch add up to, for code that only wants the net effect. */
+struct InputState
+{
+	int64_t MouseX = 0;
+	int64_t MouseY = 0;
+	int64_t Wheel = 0;
+	uint32_t Buttons = 0;
+
+	void Apply(const InputEvent& event);
+};
+
+struct InputQueueStats
+{
+	/* Raw messages pushed, and how many of them were merged into an earlier event. */
+	uint64_t RawEvents = 0;
+	uint64_t Coalesced = 0;
+	/* Events lost because the ring was full. */
+	uint64_t Dropped = 0;
+
+	/* Events per Drain(), i.e. per frame. */
+	uint64_t Drains = 0;
+	uint64_t Events = 0;
+	double MeanDepth = 0.0;
+	uint32_t P95Depth = 0;
+	uint32_t MaxDepth = 0;
+};
+
+/*
+	Single-producer/single-consumer ring of timestamped input events. The
+	window thread pushes; consecutive mouse moves, and wheel turns on the same
+	axis, are merged in a producer-side pending event until anything else
+	arrives or Flush() is called, so a 1000 Hz mouse costs one event per frame
+	rather than one per message. The consumer takes every published event in
+	one Drain() per frame.
+*/
+class InputQueue
+{
+public:
+	static constexpr uint32_t Capacity = 4096;
+	/* Depth histogram range; deeper batches count in the last bucket. */
+	static constexpr uint32_t DepthBuckets = 256;
+
+	InputQueue() = default;
+	InputQueue(const InputQueue&) = delete;
+	InputQueue& operator=(const InputQueue&) = delete;
+
+	/* Producer. */
+	void Push(const InputEvent& event);
+	void Flush();
+	/* Producer: a merged event is waiting for Flush() or a different event. */
+	bool HasPending() const { return mHasPending; }
+
+	/* Consumer: moves up to maxEvents published events into out and returns the count. */
+	uint32_t Drain(InputEvent* out, uint32_t maxEvents);
+
+	/* Consumer thread; producer counters are read relaxed. */
+	InputQueueStats Stats() const;
+	/* Consumer thread; producer counters are never written, only remembered as the new baseline. */
+	void ResetStats();
+
+private:
+	void Publish(const InputEvent& event);
+	static bool CanMerge(const InputEvent& pending, const InputEvent& event);
+
+	alignas(64) std::atomic<uint64_t> mHead{ 0 };
+	/* Producer-only. */
+	uint64_t mCachedTail = 0;
+	InputEvent mPending;
+	bool mHasPending = false;
+	std::atomic<uint64_t> mRawEvents{ 0 };
+	std::atomic<uint64_t> mCoalesced{ 0 };
+	std::atomic<uint64_t> mDropped{ 0 };
+
+	alignas(64) std::atomic<uint64_t> mTail{ 0 };
+	/* Consumer-only. */
+	uint64_t mRawEventsBase = 0;
+	uint64_t mCoalescedBase = 0;
+	uint64_t mDroppedBase = 0;
+	uint64_t mDrains = 0;
+	uint64_t mEvents = 0;
+	uint32_t mMaxDepth = 0;
+	uint32_t mDepthHistogram[DepthBuckets] = {};
+
+	InputEvent mEventsRing[Capacity];
+};
@@ -0,0 +1,362 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include "CpuProfiler.h"
+
+namespace
+{
+	thread_local JobSystem* tOwner = nullptr;
+	thread_local uint32_t tWorkerIndex = 0;
+}
+
+bool JobSystem::Deque::Push(Job* job)
+{
+	int64_t bottom = mBottom.load(std::memory_order_relaxed);
+	int64_t top = mTop.load(std::memory_order_acquire);
+	if (bottom - top >= (int64_t)MaxJobsPerWorker)
+		return false;
+
+	mBuffer[bottom & Mask].store(job, std::memory_order_relaxed);
+	// Publishes the job contents to thieves that acquire mBottom.
+	mBottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+Job* JobSystem::Deque::Pop()
+{
+	int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+	mBottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = mTop.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Empty.
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = mBuffer[bottom & Mask].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// Last job: race the thieves for it.
+		if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobSystem::Deque::Steal()
+{
+	int64_t top = mTop.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = mBottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+		return nullptr;
+
+	Job* job = mBuffer[top & Mask].load(std::memory_order_relaxed);
+	if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+	return job;
+}
+
+JobSystem::JobSystem(uint32_t threadCount)
+	:
+	mWorkerCount(std::max(threadCount, 1u)),
+	mWorkers(std::make_unique<Worker[]>(mWorkerCount)),
+	mStatsStart(std::chrono::steady_clock::now())
+{
+	assert(tOwner == nullptr && "Only one JobSystem per thread");
+	tOwner = this;
+	tWorkerIndex = 0;
+
+	for (uint32_t i = 0; i < mWorkerCount; i++)
+		mWorkers[i].RandomState = 0x9E3779B9u * (i + 1);
+
+	mThreads.reserve(mWorkerCount - 1);
+	for (uint32_t i = 1; i < mWorkerCount; i++)
+		mThreads.emplace_back(&JobSystem::WorkerMain, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mQuit.store(true, std::memory_order_release);
+	}
+	mSleep.notify_all();
+
+	for (std::thread& thread : mThreads)
+		thread.join();
+
+	tOwner = nullptr;
+}
+
+void JobSystem::AttachCallingThread()
+{
+	assert((tOwner == nullptr || tOwner == this) && "Thread already belongs to another JobSystem");
+	tOwner = this;
+	tWorkerIndex = 0;
+}
+
+void JobSystem::Schedule(JobFunction function, void* data, uint32_t index, JobCounter* signal, JobCounter* dependency)
+{
+	uint32_t worker = CurrentWorker();
+
+	Job* job = AllocateJob(worker);
+	if (!job)
+	{
+		// Every pool slot is in flight: run it here, once its dependency is met, rather than overwrite a live job.
+		if (dependency)
+			Wait(dependency);
+		Job inlineJob;
+		inlineJob.Function = function;
+		inlineJob.Data = data;
+		inlineJob.Index = index;
+		inlineJob.Signal = signal;
+		if (signal)
+			signal->mValue.fetch_add(1, std::memory_order_relaxed);
+		Execute(worker, &inlineJob);
+		return;
+	}
+
+	job->Function = function;
+	job->Data = data;
+	job->Index = index;
+	job->Signal = signal;
+
+	if (signal)
+		signal->mValue.fetch_add(1, std::memory_order_relaxed);
+
+	if (dependency)
+	{
+		dependency->Lock();
+		if (dependency->mValue.load(std::memory_order_acquire) != 0)
+		{
+			assert(dependency->mContinuationCount < JobCounter::MaxContinuations && "Too many jobs depend on one counter");
+			dependency->mContinuations[dependency->mContinuationCount++] = job;
+			dependency->Unlock();
+			return;
+		}
+		dependency->Unlock();
+	}
+
+	Push(worker, job);
+}
+
+void JobSystem::Wait(JobCounter* counter)
+{
+	uint32_t worker = CurrentWorker();
+
+	while (!counter->IsDone())
+	{
+		if (Job* job = FindJob(worker))
+			Execute(worker, job);
+		else
+			std::this_thread::yield();
+	}
+
+	// The finishing thread may still hold the lock after publishing zero.
+	counter->Lock();
+	counter->Unlock();
+}
+
+std::vector<JobWorkerStats> JobSystem::Stats() const
+{
+	double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStatsStart).count();
+
+	std::vector<JobWorkerStats> stats(mWorkerCount);
+	for (uint32_t i = 0; i < mWorkerCount; i++)
+	{
+		const Worker& w = mWorkers[i];
+		stats[i].JobsExecuted = w.JobsExecuted.load(std::memory_order_relaxed);
+		stats[i].Steals = w.Steals.load(std::memory_order_relaxed);
+		stats[i].FailedSteals = w.FailedSteals.load(std::memory_order_relaxed);
+		stats[i].BusyMs = (double)w.BusyNs.load(std::memory_order_relaxed) / 1e6;
+		stats[i].Utilization = elapsedMs > 0.0 ? stats[i].BusyMs / elapsedMs : 0.0;
+	}
+	return stats;
+}
+
+void JobSystem::ResetStats()
+{
+	for (uint32_t i = 0; i < mWorkerCount; i++)
+	{
+		Worker& w = mWorkers[i];
+		w.JobsExecuted.store(0, std::memory_order_relaxed);
+		w.Steals.store(0, std::memory_order_relaxed);
+		w.FailedSteals.store(0, std::memory_order_relaxed);
+		w.BusyNs.store(0, std::memory_order_relaxed);
+	}
+	mStatsStart = std::chrono::steady_clock::now();
+}
+
+std::vector<JobThroughputResult> JobSystem::MeasureThroughput(uint32_t jobCount, uint32_t maxThreads)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<JobThroughputResult> results;
+	for (uint32_t threads = 1; threads <= std::max(maxThreads, 1u); threads++)
+	{
+		JobSystem jobs(threads);
+		JobFunction empty = [](void*, uint32_t) {};
+
+		// Spawn in batches that fit the deque and job pool of worker 0.
+		const uint32_t batch = MaxJobsPerWorker / 2;
+
+		jobs.ResetStats();
+		Clock::time_point begin = Clock::now();
+		for (uint32_t spawned = 0; spawned < jobCount; spawned += batch)
+		{
+			JobCounter counter;
+			for (uint32_t i = spawned; i < std::min(spawned + batch, jobCount); i++)
+				jobs.Schedule(empty, nullptr, i, &counter);
+			jobs.Wait(&counter);
+		}
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+		JobThroughputResult result = {};
+		result.Threads = threads;
+		result.Jobs = jobCount;
+		result.Ms = ms;
+		result.JobsPerSecond = ms > 0.0 ? (double)jobCount / (ms / 1000.0) : 0.0;
+		for (const JobWorkerStats& s : jobs.Stats())
+		{
+			result.Steals += s.Steals;
+			result.MeanUtilization += s.Utilization / (double)threads;
+		}
+		results.push_back(result);
+	}
+	return results;
+}
+
+uint32_t JobSystem::CurrentWorker() const
+{
+	assert(tOwner == this && "JobSystem used from a thread that is not one of its workers");
+	return tWorkerIndex;
+}
+
+Job* JobSystem::AllocateJob(uint32_t worker)
+{
+	Worker& w = mWorkers[worker];
+	Job* job = &w.Jobs[w.NextJob & (MaxJobsPerWorker - 1)];
+	if (job->Pending.load(std::memory_order_acquire))
+		return nullptr;
+
+	w.NextJob++;
+	job->Pending.store(true, std::memory_order_relaxed);
+	return job;
+}
+
+void JobSystem::Push(uint32_t worker, Job* job)
+{
+	if (!mWorkers[worker].Queue.Push(job))
+	{
+		// Deque is full: run it right here rather than dropping it.
+		Execute(worker, job);
+		return;
+	}
+
+	mQueuedJobs.fetch_add(1, std::memory_order_release);
+	mSleep.notify_one();
+}
+
+Job* JobSystem::FindJob(uint32_t worker)
+{
+	Worker& self = mWorkers[worker];
+
+	Job* job = self.Queue.Pop();
+	if (!job && mWorkerCount > 1)
+	{
+		// xorshift32 to pick where to start stealing.
+		uint32_t x = self.RandomState;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		self.RandomState = x;
+
+		for (uint32_t i = 0; i < mWorkerCount - 1 && !job; i++)
+		{
+			uint32_t victim = (worker + 1 + (x + i) % (mWorkerCount - 1)) % mWorkerCount;
+			job = mWorkers[victim].Queue.Steal();
+			if (job)
+				self.Steals.fetch_add(1, std::memory_order_relaxed);
+			else
+				self.FailedSteals.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (job)
+		mQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+	return job;
+}
+
+void JobSystem::Execute(uint32_t worker, Job* job)
+{
+	Worker& w = mWorkers[worker];
+
+	CPU_ZONE("Job");
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	job->Function(job->Data, job->Index);
+	w.BusyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count(), std::memory_order_relaxed);
+	w.JobsExecuted.fetch_add(1, std::memory_order_relaxed);
+
+	// The slot may be reused as soon as Pending clears, so Signal is read first.
+	JobCounter* signal = job->Signal;
+	job->Pending.store(false, std::memory_order_release);
+	if (signal)
+		Finish(worker, signal);
+}
+
+void JobSystem::Finish(uint32_t worker, JobCounter* counter)
+{
+	// The last decrement happens under the lock so a waiter cannot free the counter while we release continuations.
+	counter->Lock();
+	if (counter->mValue.fetch_sub(1, std::memory_order_acq_rel) != 1)
+	{
+		counter->Unlock();
+		return;
+	}
+
+	Job* continuations[JobCounter::MaxContinuations];
+	uint32_t count = counter->mContinuationCount;
+	std::copy(counter->mContinuations, counter->mContinuations + count, continuations);
+	counter->mContinuationCount = 0;
+	counter->Unlock();
+
+	for (uint32_t i = 0; i < count; i++)
+		Push(worker, continuations[i]);
+}
+
+void JobSystem::WorkerMain(uint32_t worker)
+{
+	tOwner = this;
+	tWorkerIndex = worker;
+	CpuProfiler::SetThreadName(("Job worker " + std::to_string(worker)).c_str());
+
+	uint32_t idleSpins = 0;
+	while (!mQuit.load(std::memory_order_acquire))
+	{
+		if (Job* job = FindJob(worker))
+		{
+			Execute(worker, job);
+			idleSpins = 0;
+		}
+		else if (++idleSpins < 64)
+		{
+			std::this_thread::yield();
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock(mSleepMutex);
+			mSleep.wait_for(lock, std::chrono::milliseconds(1), [this]
+			{
+				return mQuit.load(std::memory_order_acquire) || mQueuedJobs.load(std::memory_order_acquire) > 0;
+			});
+		}
+	}
+}
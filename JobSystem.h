@@ -0,0 +1,198 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class JobCounter;
+
+using JobFunction = void(*)(void* data, uint32_t index);
+
+struct Job
+{
+	JobFunction Function = nullptr;
+	void* Data = nullptr;
+	uint32_t Index = 0;
+	/* Decremented when the job finishes. */
+	JobCounter* Signal = nullptr;
+	/* From Schedule() until the job has run; the pool slot is not handed out again before. */
+	std::atomic<bool> Pending = false;
+};
+
+/*
+	Number of unfinished jobs that signal it. Jobs can be scheduled to start
+	once a counter reaches zero; they are kept as continuations until then.
+*/
+class JobCounter
+{
+public:
+	static constexpr uint32_t MaxContinuations = 16;
+
+	JobCounter() = default;
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool IsDone() const { return mValue.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	void Lock() { while (mLock.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+	void Unlock() { mLock.clear(std::memory_order_release); }
+
+	std::atomic<int32_t> mValue = 0;
+	std::atomic_flag mLock = ATOMIC_FLAG_INIT;
+	Job* mContinuations[MaxContinuations] = {};
+	uint32_t mContinuationCount = 0;
+};
+
+struct JobWorkerStats
+{
+	uint64_t JobsExecuted = 0;
+	uint64_t Steals = 0;
+	uint64_t FailedSteals = 0;
+	double BusyMs = 0.0;
+	/* BusyMs over the time since the last ResetStats(). */
+	double Utilization = 0.0;
+};
+
+struct JobThroughputResult
+{
+	uint32_t Threads = 0;
+	uint64_t Jobs = 0;
+	double Ms = 0.0;
+	double JobsPerSecond = 0.0;
+	uint64_t Steals = 0;
+	double MeanUtilization = 0.0;
+};
+
+/*
+	Work-stealing scheduler with one Chase-Lev deque per worker.
+	The thread that creates the JobSystem is worker 0 and only runs jobs while
+	it waits on a counter; the remaining workers are background threads.
+	Jobs may only be scheduled from worker threads.
+*/
+class JobSystem
+{
+public:
+	/*
+		Upper bound of jobs in flight per worker, both for the deque and the job pool.
+		Past it Schedule() runs the job on the calling thread instead of queuing it.
+	*/
+	static constexpr uint32_t MaxJobsPerWorker = 4096;
+
+	/* threadCount includes the creating thread. */
+	explicit JobSystem(uint32_t threadCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	/* Runs job once dependency (if any) reaches zero; increments signal (if any) right away. */
+	void Schedule(JobFunction function, void* data, uint32_t index, JobCounter* signal, JobCounter* dependency = nullptr);
+
+	/* Runs other jobs until counter reaches zero. */
+	void Wait(JobCounter* counter);
+
+	/*
+		Makes the calling thread worker 0, e.g. when rendering moves to its own thread.
+		The previous worker 0 must be idle and must not use the job system afterwards.
+	*/
+	void AttachCallingThread();
+
+	/* Calls fn(i) for every i in [0, count), grain indices per job, and waits. */
+	template<typename Fn>
+	void ParallelFor(uint32_t count, uint32_t grain, Fn&& fn)
+	{
+		using Callable = std::remove_reference_t<Fn>;
+
+		struct Context
+		{
+			Callable* Function;
+			uint32_t Count;
+			uint32_t Grain;
+		};
+
+		JobFunction run = [](void* data, uint32_t index)
+		{
+			Context* ctx = (Context*)data;
+			uint32_t begin = index * ctx->Grain;
+			uint32_t end = begin + ctx->Grain < ctx->Count ? begin + ctx->Grain : ctx->Count;
+			for (uint32_t i = begin; i < end; i++)
+				(*ctx->Function)(i);
+		};
+
+		grain = grain ? grain : 1;
+		Context ctx = { &fn, count, grain };
+		JobCounter counter;
+		for (uint32_t job = 0; job * grain < count; job++)
+			Schedule(run, &ctx, job, &counter);
+		Wait(&counter);
+	}
+
+	uint32_t ThreadCount() const { return mWorkerCount; }
+
+	std::vector<JobWorkerStats> Stats() const;
+	void ResetStats();
+
+	/* Throughput of jobCount empty jobs spawned from worker 0, for 1..maxThreads threads. */
+	static std::vector<JobThroughputResult> MeasureThroughput(uint32_t jobCount, uint32_t maxThreads);
+
+private:
+	/* Chase-Lev deque: the owner pushes and pops at the bottom, thieves steal from the top. */
+	class Deque
+	{
+	public:
+		bool Push(Job* job);
+		Job* Pop();
+		Job* Steal();
+
+	private:
+		static constexpr int64_t Mask = MaxJobsPerWorker - 1;
+
+		alignas(64) std::atomic<int64_t> mTop = 0;
+		alignas(64) std::atomic<int64_t> mBottom = 0;
+		std::atomic<Job*> mBuffer[MaxJobsPerWorker] = {};
+	};
+
+	struct alignas(64) Worker
+	{
+		Deque Queue;
+		Job Jobs[MaxJobsPerWorker];
+		uint32_t NextJob = 0;
+		uint32_t RandomState = 0;
+
+		std::atomic<uint64_t> JobsExecuted = 0;
+		std::atomic<uint64_t> Steals = 0;
+		std::atomic<uint64_t> FailedSteals = 0;
+		std::atomic<int64_t> BusyNs = 0;
+	};
+
+	uint32_t CurrentWorker() const;
+	/* nullptr if the next pool slot still holds a job that has not run. */
+	Job* AllocateJob(uint32_t worker);
+	void Push(uint32_t worker, Job* job);
+	Job* FindJob(uint32_t worker);
+	void Execute(uint32_t worker, Job* job);
+	void Finish(uint32_t worker, JobCounter* counter);
+	void WorkerMain(uint32_t worker);
+
+	static_assert((MaxJobsPerWorker & (MaxJobsPerWorker - 1)) == 0, "MaxJobsPerWorker must be a power of two");
+
+	uint32_t mWorkerCount;
+	std::unique_ptr<Worker[]> mWorkers;
+	std::vector<std::thread> mThreads;
+
+	std::atomic<int64_t> mQueuedJobs = 0;
+	std::atomic<bool> mQuit = false;
+	std::mutex mSleepMutex;
+	std::condition_variable mSleep;
+
+	std::chrono::steady_clock::time_point mStatsStart;
+};
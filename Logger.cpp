@@ -0,0 +1,317 @@
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "SystemClock.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+alignas(64) Logger::Record Logger::sRecords[Capacity];
+alignas(64) std::atomic<uint64_t> Logger::sHead{ 0 };
+alignas(64) std::atomic<uint64_t> Logger::sTail{ 0 };
+std::atomic<bool> Logger::sRunning{ false };
+std::atomic<uint64_t> Logger::sDropped{ 0 };
+std::atomic<uint64_t> Logger::sBackpressureWaits{ 0 };
+std::atomic<int64_t> Logger::sBackpressureTicks{ 0 };
+std::atomic<uint64_t> Logger::sTruncated{ 0 };
+std::atomic<uint64_t> Logger::sWritten{ 0 };
+std::atomic<uint32_t> Logger::sMaxDepth{ 0 };
+LogSink* Logger::sSink = nullptr;
+std::thread Logger::sThread;
+int64_t Logger::sStartTicks = 0;
+
+void ConsoleLogSink::Write(LogLevel level, std::string_view line)
+{
+#ifdef _WIN32
+	HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+	if (output && output != INVALID_HANDLE_VALUE)
+		WriteConsoleA(output, line.data(), (DWORD)line.size(), nullptr, nullptr);
+#else
+	std::fwrite(line.data(), 1, line.size(), stdout);
+#endif
+}
+
+FileLogSink::FileLogSink(const char* path)
+{
+#ifdef _MSC_VER
+	if (fopen_s(&mFile, path, "w") != 0)
+		mFile = nullptr;
+#else
+	mFile = std::fopen(path, "w");
+#endif
+}
+
+FileLogSink::~FileLogSink()
+{
+	if (mFile)
+		std::fclose(mFile);
+}
+
+void FileLogSink::Write(LogLevel level, std::string_view line)
+{
+	if (mFile)
+		std::fwrite(line.data(), 1, line.size(), mFile);
+}
+
+void FileLogSink::Flush()
+{
+	if (mFile)
+		std::fflush(mFile);
+}
+
+void Logger::Start(LogSink* sink)
+{
+	if (IsRunning())
+		return;
+
+	sSink = sink;
+	sStartTicks = Now();
+	sRunning.store(true, std::memory_order_release);
+	sThread = std::thread(&Logger::SinkMain);
+}
+
+void Logger::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	// Writers stop waiting for room from here on; the sink thread drains what is published and exits.
+	sRunning.store(false, std::memory_order_release);
+	sThread.join();
+}
+
+void Logger::Flush()
+{
+	uint64_t target = sHead.load(std::memory_order_acquire);
+	while (IsRunning() && sTail.load(std::memory_order_acquire) < target)
+		std::this_thread::yield();
+}
+
+LoggerStats Logger::Stats()
+{
+	LoggerStats stats;
+	stats.Written = sWritten.load(std::memory_order_relaxed);
+	stats.Dropped = sDropped.load(std::memory_order_relaxed);
+	stats.BackpressureWaits = sBackpressureWaits.load(std::memory_order_relaxed);
+	stats.BackpressureMs = (double)sBackpressureTicks.load(std::memory_order_relaxed) * 1000.0 / (double)SystemClock::Frequency();
+	stats.Truncated = sTruncated.load(std::memory_order_relaxed);
+	stats.MaxDepth = sMaxDepth.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void Logger::ResetStats()
+{
+	sWritten.store(0, std::memory_order_relaxed);
+	sDropped.store(0, std::memory_order_relaxed);
+	sBackpressureWaits.store(0, std::memory_order_relaxed);
+	sBackpressureTicks.store(0, std::memory_order_relaxed);
+	sTruncated.store(0, std::memory_order_relaxed);
+	sMaxDepth.store(0, std::memory_order_relaxed);
+}
+
+Logger::Record* Logger::Acquire(LogLevel level, uint64_t& position)
+{
+	uint64_t head = sHead.load(std::memory_order_relaxed);
+	int64_t waitStart = 0;
+
+	while (true)
+	{
+		Record& record = sRecords[head & (Capacity - 1)];
+		uint64_t sequence = record.Sequence.load(std::memory_order_acquire);
+		uint64_t free = 2 * (head / Capacity);
+
+		if (sequence == free)
+		{
+			if (sHead.compare_exchange_weak(head, head + 1, std::memory_order_relaxed))
+			{
+				if (waitStart != 0)
+					sBackpressureTicks.fetch_add(Now() - waitStart, std::memory_order_relaxed);
+				position = head;
+				return &record;
+			}
+		}
+		else if (sequence < free)
+		{
+			// Still holds the previous lap's record: the ring is full. Only a running sink can make room.
+			if (level < LogLevel::Warning || !IsRunning())
+			{
+				sDropped.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			if (waitStart == 0)
+			{
+				waitStart = Now();
+				sBackpressureWaits.fetch_add(1, std::memory_order_relaxed);
+			}
+			std::this_thread::yield();
+			head = sHead.load(std::memory_order_relaxed);
+		}
+		else
+		{
+			// Another writer claimed this position first.
+			head = sHead.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void Logger::Publish(Record* record, uint64_t position)
+{
+	record->Sequence.store(2 * (position / Capacity) + 1, std::memory_order_release);
+}
+
+int64_t Logger::Now()
+{
+	return SystemClock::Now();
+}
+
+void Logger::SinkMain()
+{
+	std::string line;
+	line.reserve(1024);
+
+	while (IsRunning())
+	{
+		if (DrainRecords(line) == 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// Writers that claimed a record before Stop() publish it shortly after.
+	while (sTail.load(std::memory_order_relaxed) < sHead.load(std::memory_order_acquire))
+	{
+		if (DrainRecords(line) == 0)
+			std::this_thread::yield();
+	}
+}
+
+uint32_t Logger::DrainRecords(std::string& line)
+{
+	uint64_t tail = sTail.load(std::memory_order_relaxed);
+	uint32_t depth = (uint32_t)std::min<uint64_t>(sHead.load(std::memory_order_relaxed) - tail, Capacity);
+	if (depth > sMaxDepth.load(std::memory_order_relaxed))
+		sMaxDepth.store(depth, std::memory_order_relaxed);
+
+	const char* levelNames[] = { "[DEBUG]: ", "", "[WARNING]: ", "[ERROR]: " };
+	const double ticksPerSecond = (double)SystemClock::Frequency();
+
+	uint32_t count = 0;
+	while (true)
+	{
+		Record& record = sRecords[tail & (Capacity - 1)];
+		uint64_t lap = tail / Capacity;
+		if (record.Sequence.load(std::memory_order_acquire) != 2 * lap + 1)
+			break;
+
+		line.clear();
+		std::format_to(std::back_inserter(line), "{:10.4f} {}", (double)(record.Ticks - sStartTicks) / ticksPerSecond, levelNames[(uint32_t)record.Level]);
+		try
+		{
+			record.Decode(record.Format, record.Payload, line);
+		}
+		catch (const std::format_error& e)
+		{
+			line.append("<bad log format \"").append(record.Format).append("\": ").append(e.what()).append(">");
+		}
+		line.push_back('\n');
+		LogLevel level = record.Level;
+
+		// The record is free for the next lap as soon as it is formatted; Flush() waits for the sink as well.
+		record.Sequence.store(2 * (lap + 1), std::memory_order_release);
+		if (sSink)
+			sSink->Write(level, line);
+
+		tail++;
+		sTail.store(tail, std::memory_order_release);
+		count++;
+	}
+
+	if (count > 0)
+	{
+		sWritten.fetch_add(count, std::memory_order_relaxed);
+		if (sSink)
+			sSink->Flush();
+	}
+	return count;
+}
+
+LoggerOverhead Logger::MeasureOverhead(uint32_t messageCount, uint32_t threads)
+{
+	using Clock = std::chrono::steady_clock;
+
+	class NullSink : public LogSink
+	{
+	public:
+		void Write(LogLevel, std::string_view) override {}
+	};
+
+	LoggerOverhead result;
+	result.Messages = messageCount;
+	result.Threads = std::max(threads, 1u);
+	if (messageCount == 0)
+		return result;
+
+	NullSink sink;
+	LogSink* previous = sSink;
+	bool wasRunning = IsRunning();
+	Stop();
+	Start(&sink);
+	ResetStats();
+
+	// Batches the ring can hold, so the sink keeping up is not what gets measured.
+	const uint32_t batch = Capacity / 2;
+	double ns = 0.0;
+	for (uint32_t done = 0; done < messageCount;)
+	{
+		uint32_t count = std::min(batch, messageCount - done);
+		Clock::time_point begin = Clock::now();
+		for (uint32_t i = 0; i < count; i++)
+			Write<LogLevel::Info>("Overhead {} {} {:.2f} {}", i, done, 0.5, "message");
+		ns += std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+		Flush();
+		done += count;
+	}
+	result.NsPerMessage = ns / messageCount;
+
+	// Every thread writes a share of a batch at a time, contending for the ring's head.
+	const uint32_t perThread = std::max(batch / result.Threads, 1u);
+	std::vector<double> threadNs(result.Threads, 0.0);
+	for (uint32_t done = 0; done < messageCount; done += perThread * result.Threads)
+	{
+		std::vector<std::thread> workers;
+		for (uint32_t t = 0; t < result.Threads; t++)
+		{
+			workers.emplace_back([&threadNs, t, perThread, done]()
+			{
+				Clock::time_point begin = Clock::now();
+				for (uint32_t i = 0; i < perThread; i++)
+					Write<LogLevel::Info>("Overhead {} {} {:.2f} {}", i, done, 0.5, "message");
+				threadNs[t] += std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+			});
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+		Flush();
+	}
+	double threadedSum = 0.0;
+	for (double value : threadNs)
+		threadedSum += value;
+	uint32_t rounds = (messageCount + perThread * result.Threads - 1) / (perThread * result.Threads);
+	result.NsPerMessageThreaded = threadedSum / ((double)rounds * perThread * result.Threads);
+
+#if LOG_MIN_LEVEL > 0
+	Clock::time_point begin = Clock::now();
+	for (uint32_t i = 0; i < messageCount; i++)
+		LOG_DEBUG("Filtered {}", i);
+	result.NsPerFiltered = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / messageCount;
+#endif
+
+	result.Dropped = Stats().Dropped;
+
+	Stop();
+	if (wasRunning)
+		Start(previous);
+	return result;
+}
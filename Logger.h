@@ -0,0 +1,289 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+
+enum class LogLevel : uint32_t
+{
+	Debug,
+	Info,
+	Warning,
+	Error
+};
+
+/* Messages below this level compile to nothing, arguments included. */
+#ifndef LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define LOG_MIN_LEVEL 0
+#else
+#define LOG_MIN_LEVEL 2
+#endif
+#endif
+
+/* The format must be a string literal: records keep its address and format on the sink thread. */
+#define LOG_AT(level, ...) \
+	do \
+	{ \
+		if constexpr ((uint32_t)(level) >= LOG_MIN_LEVEL) \
+			Logger::Write<level>(__VA_ARGS__); \
+	} while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
+
+/* Receives formatted lines on the logger's sink thread, one at a time. */
+class LogSink
+{
+public:
+	virtual ~LogSink() = default;
+
+	/* line ends with a newline. */
+	virtual void Write(LogLevel level, std::string_view line) = 0;
+	/* After every batch of records drained from the ring. */
+	virtual void Flush() {}
+};
+
+/* The process console; WriteConsoleA on Windows, stdout elsewhere. */
+class ConsoleLogSink : public LogSink
+{
+public:
+	void Write(LogLevel level, std::string_view line) override;
+};
+
+class FileLogSink : public LogSink
+{
+public:
+	explicit FileLogSink(const char* path);
+	~FileLogSink() override;
+
+	FileLogSink(const FileLogSink&) = delete;
+	FileLogSink& operator=(const FileLogSink&) = delete;
+
+	bool IsOpen() const { return mFile != nullptr; }
+
+	void Write(LogLevel level, std::string_view line) override;
+	void Flush() override;
+
+private:
+	std::FILE* mFile = nullptr;
+};
+
+struct LoggerStats
+{
+	uint64_t Written = 0;
+	/* Debug and Info records lost because the ring was full. */
+	uint64_t Dropped = 0;
+	/* Warning and Error records that had to wait for the sink to make room, and how long they waited in total. */
+	uint64_t BackpressureWaits = 0;
+	double BackpressureMs = 0.0;
+	/* Strings cut to fit a record. */
+	uint64_t Truncated = 0;
+	/* Deepest the ring was seen by the sink thread, in records. */
+	uint32_t MaxDepth = 0;
+};
+
+struct LoggerOverhead
+{
+	uint32_t Messages = 0;
+	uint32_t Threads = 0;
+	/* Write() of a message with three numbers and a short string, per calling thread. */
+	double NsPerMessage = 0.0;
+	double NsPerMessageThreaded = 0.0;
+	/* A Debug message below LOG_MIN_LEVEL, i.e. nothing; 0 in builds that keep Debug messages. */
+	double NsPerFiltered = 0.0;
+	uint64_t Dropped = 0;
+};
+
+/*
+	Process-wide asynchronous logger. Write() copies the format string's address
+	and the raw argument bytes into a fixed-size record of a lock-free
+	multi-producer ring; a sink thread formats records and hands the lines to
+	the LogSink. Callers never format, allocate or make a syscall. When the ring
+	is full Debug and Info records are dropped, Warning and Error records wait
+	for room. Records written before Start() wait in the ring for it.
+*/
+class Logger
+{
+public:
+	static constexpr uint32_t Capacity = 2048;
+	/* Debug layer messages run to a few hundred characters. */
+	static constexpr uint32_t RecordSize = 512;
+
+	/* The sink must outlive Stop(). */
+	static void Start(LogSink* sink);
+	/* Formats everything written so far, then joins the sink thread. */
+	static void Stop();
+	static bool IsRunning() { return sRunning.load(std::memory_order_acquire); }
+	/* Blocks until the sink has taken every record written before the call. */
+	static void Flush();
+
+	static LoggerStats Stats();
+	static void ResetStats();
+
+	/* Times messageCount messages from one thread and from threads threads into a sink that discards them. */
+	static LoggerOverhead MeasureOverhead(uint32_t messageCount, uint32_t threads);
+
+	template<LogLevel Level, typename... Args>
+	static void Write(const char* format, const Args&... args)
+	{
+		static_assert((LogArgument<Args>::FixedSize + ... + 0) <= PayloadSize, "Too many arguments for one log record");
+
+		uint64_t position = 0;
+		Record* record = Acquire(Level, position);
+		if (!record)
+			return;
+
+		record->Level = Level;
+		record->Format = format;
+		record->Decode = &DecodeRecord<Args...>;
+		record->Ticks = Now();
+
+		uint8_t* cursor = record->Payload;
+		uint8_t* end = record->Payload + PayloadSize;
+		// Fixed bytes still needed by the arguments after the current one, which strings must leave room for.
+		size_t reserved = (LogArgument<Args>::FixedSize + ... + 0);
+		bool truncated = false;
+		(LogArgument<Args>::Encode(cursor, end, reserved, args, truncated), ...);
+		if (truncated)
+			sTruncated.fetch_add(1, std::memory_order_relaxed);
+
+		Publish(record, position);
+	}
+
+private:
+	using DecodeFunction = void(*)(const char* format, const uint8_t* payload, std::string& out);
+
+	/* Sequence is 2 * lap while free for that lap's writer, 2 * lap + 1 once published. */
+	struct RecordHeader
+	{
+		std::atomic<uint64_t> Sequence;
+		LogLevel Level;
+		const char* Format;
+		DecodeFunction Decode;
+		int64_t Ticks;
+	};
+
+	/* The payload takes whatever the header leaves, which depends on the pointer size. */
+	struct Record : RecordHeader
+	{
+		uint8_t Payload[RecordSize - sizeof(RecordHeader)];
+	};
+	static constexpr size_t PayloadSize = sizeof(Record::Payload);
+	static_assert(sizeof(Record) == RecordSize, "Log records must stay RecordSize bytes");
+	static_assert((Capacity & (Capacity - 1)) == 0, "Logger capacity must be a power of two");
+
+	template<typename T, bool = std::is_enum_v<T>>
+	struct RawValue
+	{
+		using Type = T;
+	};
+
+	template<typename T>
+	struct RawValue<T, true>
+	{
+		using Type = std::underlying_type_t<T>;
+	};
+
+	/* Numbers, bools, enums (as their underlying type) and pointers are copied raw. */
+	template<typename T, typename = void>
+	struct LogArgument
+	{
+		using Value = typename RawValue<T>::Type;
+		static constexpr size_t FixedSize = sizeof(Value);
+
+		static void Encode(uint8_t*& cursor, uint8_t*, size_t& reserved, const T& arg, bool&)
+		{
+			reserved -= FixedSize;
+			Value value = (Value)arg;
+			std::memcpy(cursor, &value, sizeof(Value));
+			cursor += sizeof(Value);
+		}
+
+		static Value Decode(const uint8_t*& cursor)
+		{
+			Value value;
+			std::memcpy(&value, cursor, sizeof(Value));
+			cursor += sizeof(Value);
+			return value;
+		}
+	};
+
+	/* Strings are copied with a length prefix, cut to what is left of the record. */
+	template<typename T>
+	struct LogArgument<T, std::enable_if_t<std::is_convertible_v<const T&, std::string_view>>>
+	{
+		using Value = std::string_view;
+		static constexpr size_t FixedSize = sizeof(uint16_t);
+
+		static void Encode(uint8_t*& cursor, uint8_t* end, size_t& reserved, const T& arg, bool& truncated)
+		{
+			reserved -= FixedSize;
+			std::string_view text = arg;
+			size_t room = (size_t)(end - cursor) - FixedSize - reserved;
+			if (text.size() > room)
+			{
+				text = text.substr(0, room);
+				truncated = true;
+			}
+
+			uint16_t length = (uint16_t)text.size();
+			std::memcpy(cursor, &length, sizeof(length));
+			std::memcpy(cursor + sizeof(length), text.data(), text.size());
+			cursor += sizeof(length) + text.size();
+		}
+
+		static Value Decode(const uint8_t*& cursor)
+		{
+			uint16_t length;
+			std::memcpy(&length, cursor, sizeof(length));
+			std::string_view text((const char*)cursor + sizeof(length), length);
+			cursor += sizeof(length) + length;
+			return text;
+		}
+	};
+
+	template<typename... Args>
+	static void DecodeRecord(const char* format, const uint8_t* payload, std::string& out)
+	{
+		// Braced initialization decodes left to right, in the order Write() encoded.
+		std::tuple<typename LogArgument<Args>::Value...> values{ LogArgument<Args>::Decode(payload)... };
+		std::apply([&](auto&... value)
+		{
+			std::vformat_to(std::back_inserter(out), format, std::make_format_args(value...));
+		}, values);
+	}
+
+	/* Claims the record at position, or returns nullptr if the record is dropped. */
+	static Record* Acquire(LogLevel level, uint64_t& position);
+	static void Publish(Record* record, uint64_t position);
+	static int64_t Now();
+	static void SinkMain();
+	/* Sink thread: formats and writes every published record; returns how many. */
+	static uint32_t DrainRecords(std::string& line);
+
+	alignas(64) static Record sRecords[Capacity];
+	alignas(64) static std::atomic<uint64_t> sHead;
+	alignas(64) static std::atomic<uint64_t> sTail;
+	static std::atomic<bool> sRunning;
+	static std::atomic<uint64_t> sDropped;
+	static std::atomic<uint64_t> sBackpressureWaits;
+	static std::atomic<int64_t> sBackpressureTicks;
+	static std::atomic<uint64_t> sTruncated;
+	static std::atomic<uint64_t> sWritten;
+	static std::atomic<uint32_t> sMaxDepth;
+	static LogSink* sSink;
+	static std::thread sThread;
+	static int64_t sStartTicks;
+};
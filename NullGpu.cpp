@@ -0,0 +1,54 @@
+#include "NullGpu.h"
+
+#include <cassert>
+#include <thread>
+
+NullGpuQueue::NullGpuQueue(double gpuLatencyMs)
+	:
+	mLatency(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(gpuLatencyMs))),
+	mGpuBusyUntil(Clock::now())
+{
+}
+
+uint64_t NullGpuQueue::Signal()
+{
+	Clock::time_point now = Clock::now();
+	Retire(now);
+
+	if (mPendingCount == MaxPendingSignals)
+		WaitForValue(mPending[mPendingHead].Value);
+
+	// The simulated GPU starts this batch once it is done with the previous one.
+	mGpuBusyUntil = (mGpuBusyUntil > now ? mGpuBusyUntil : now) + mLatency;
+
+	uint32_t slot = (mPendingHead + mPendingCount) % MaxPendingSignals;
+	mPending[slot] = { ++mLastSignaled, mGpuBusyUntil };
+	mPendingCount++;
+
+	return mLastSignaled;
+}
+
+uint64_t NullGpuQueue::CompletedValue() const
+{
+	Retire(Clock::now());
+	return mCompleted;
+}
+
+void NullGpuQueue::WaitForValue(uint64_t value)
+{
+	while (CompletedValue() < value)
+	{
+		assert(mPendingCount > 0 && "Waiting on a fence value that was never signaled");
+		std::this_thread::sleep_until(mPending[mPendingHead].CompletionTime);
+	}
+}
+
+void NullGpuQueue::Retire(Clock::time_point now) const
+{
+	while (mPendingCount > 0 && mPending[mPendingHead].CompletionTime <= now)
+	{
+		mCompleted = mPending[mPendingHead].Value;
+		mPendingHead = (mPendingHead + 1) % MaxPendingSignals;
+		mPendingCount--;
+	}
+}
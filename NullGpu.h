@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include "FrameRing.h"
+
+/*
+	Simulates a GPU queue that executes signaled batches back to back, each one
+	taking gpuLatencyMs. Fence values complete when their simulated end time passes,
+	so benchmarks can keep frames in flight without a D3D12 device.
+*/
+class NullGpuQueue : public FrameSync
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit NullGpuQueue(double gpuLatencyMs);
+
+	uint64_t Signal() override;
+	uint64_t CompletedValue() const override;
+	uint64_t LastSignaledValue() const override { return mLastSignaled; }
+	void WaitForValue(uint64_t value) override;
+
+private:
+	/* Enough for every frame in flight plus setup signals; the oldest entry is waited on when full. */
+	static constexpr uint32_t MaxPendingSignals = 64;
+
+	struct PendingSignal
+	{
+		uint64_t Value;
+		Clock::time_point CompletionTime;
+	};
+
+	void Retire(Clock::time_point now) const;
+
+	Clock::duration mLatency;
+	Clock::time_point mGpuBusyUntil;
+	uint64_t mLastSignaled = 0;
+
+	mutable PendingSignal mPending[MaxPendingSignals] = {};
+	mutable uint32_t mPendingHead = 0;
+	mutable uint32_t mPendingCount = 0;
+	mutable uint64_t mCompleted = 0;
+};
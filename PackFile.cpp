@@ -0,0 +1,213 @@
+#include "PackFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+PackFile::~PackFile()
+{
+	Close();
+}
+
+bool PackFile::Open(const char* path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	mFile = file;
+
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	mSize = (uint64_t)size.QuadPart;
+
+	mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mMapping)
+	{
+		Close();
+		return false;
+	}
+
+	mBase = (const uint8_t*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	mFile = open(path, O_RDONLY);
+	if (mFile < 0)
+		return false;
+
+	struct stat st = {};
+	if (fstat(mFile, &st) != 0 || st.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+	mSize = (uint64_t)st.st_size;
+
+	void* base = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, mFile, 0);
+	mBase = base != MAP_FAILED ? (const uint8_t*)base : nullptr;
+#endif
+	if (!mBase)
+	{
+		Close();
+		return false;
+	}
+
+	// Validate everything the index points at once, so lookups need no checks.
+	PackHeader header;
+	if (mSize < sizeof(header))
+	{
+		Close();
+		return false;
+	}
+	memcpy(&header, mBase, sizeof(header));
+
+	uint64_t indexEnd = sizeof(PackHeader) + (uint64_t)header.EntryCount * sizeof(PackEntry);
+	bool alignmentValid = header.Alignment != 0 && (header.Alignment & (header.Alignment - 1)) == 0;
+	if (header.Magic != PackHeader::MagicValue || header.Version != PackHeader::CurrentVersion || indexEnd > mSize || !alignmentValid)
+	{
+		Close();
+		return false;
+	}
+
+	mEntries = (const PackEntry*)(mBase + sizeof(PackHeader));
+	mEntryCount = header.EntryCount;
+	for (uint32_t i = 0; i < mEntryCount; i++)
+	{
+		const PackEntry& entry = mEntries[i];
+		if (entry.Offset < indexEnd || entry.Size > mSize || entry.Offset > mSize - entry.Size ||
+			(entry.Offset & (header.Alignment - 1)) != 0 || (i > 0 && mEntries[i - 1].NameHash > entry.NameHash))
+		{
+			Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void PackFile::Close()
+{
+#ifdef _WIN32
+	if (mBase)
+		UnmapViewOfFile(mBase);
+	if (mMapping)
+		CloseHandle(mMapping);
+	if (mFile)
+		CloseHandle(mFile);
+	mMapping = nullptr;
+	mFile = nullptr;
+#else
+	if (mBase)
+		munmap((void*)mBase, mSize);
+	if (mFile >= 0)
+		close(mFile);
+	mFile = -1;
+#endif
+	mBase = nullptr;
+	mSize = 0;
+	mEntries = nullptr;
+	mEntryCount = 0;
+}
+
+uint64_t PackFile::HashName(const char* name)
+{
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (const char* c = name; *c; c++)
+	{
+		hash ^= (uint8_t)*c;
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+uint32_t PackFile::Find(uint64_t nameHash) const
+{
+	const PackEntry* end = mEntries + mEntryCount;
+	const PackEntry* it = std::lower_bound(mEntries, end, nameHash, [](const PackEntry& entry, uint64_t hash) { return entry.NameHash < hash; });
+	return it != end && it->NameHash == nameHash ? (uint32_t)(it - mEntries) : InvalidEntry;
+}
+
+bool PackFile::EvictFromCache(const char* path)
+{
+#ifdef _WIN32
+	// The cache manager purges a file's clean pages when it is opened without buffering.
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	CloseHandle(file);
+	return true;
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+		return false;
+	// Dirty pages are not dropped, so they are written back first.
+	bool evicted = fdatasync(file) == 0 && posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(file);
+	return evicted;
+#endif
+}
+
+bool PackFile::Write(const char* path, const std::vector<Source>& sources, uint32_t alignment)
+{
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+		return false;
+
+	std::vector<PackEntry> entries(sources.size());
+	std::vector<uint32_t> order(sources.size());
+
+	uint64_t offset = sizeof(PackHeader) + sources.size() * sizeof(PackEntry);
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		offset = (offset + alignment - 1) & ~(uint64_t)(alignment - 1);
+		entries[i].NameHash = HashName(sources[i].Name.c_str());
+		entries[i].Offset = offset;
+		entries[i].Size = sources[i].Data.size();
+		offset += entries[i].Size;
+		order[i] = (uint32_t)i;
+	}
+
+	// The index is sorted for binary search, the payloads stay in source order.
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return entries[a].NameHash < entries[b].NameHash; });
+	for (size_t i = 1; i < order.size(); i++)
+	{
+		if (entries[order[i]].NameHash == entries[order[i - 1]].NameHash)
+			return false;
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	PackHeader header;
+	header.EntryCount = (uint32_t)sources.size();
+	header.Alignment = alignment;
+	file.write((const char*)&header, sizeof(header));
+	for (uint32_t i : order)
+		file.write((const char*)&entries[i], sizeof(PackEntry));
+
+	uint64_t position = sizeof(PackHeader) + sources.size() * sizeof(PackEntry);
+	const char zeros[256] = {};
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		for (uint64_t pad = entries[i].Offset - position; pad > 0; pad -= std::min<uint64_t>(pad, sizeof(zeros)))
+			file.write(zeros, std::min<uint64_t>(pad, sizeof(zeros)));
+
+		file.write((const char*)sources[i].Data.data(), sources[i].Data.size());
+		position = entries[i].Offset + entries[i].Size;
+	}
+	return (bool)file;
+}
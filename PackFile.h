@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+	Pack file layout, little endian:
+		PackHeader
+		PackEntry[EntryCount], sorted by NameHash
+		payloads, each starting at a multiple of Alignment
+*/
+struct PackHeader
+{
+	static constexpr uint32_t MagicValue = 0x4B505844; // "DXPK"
+	static constexpr uint32_t CurrentVersion = 1;
+
+	uint32_t Magic = MagicValue;
+	uint32_t Version = CurrentVersion;
+	uint32_t EntryCount = 0;
+	uint32_t Alignment = 0;
+};
+
+struct PackEntry
+{
+	uint64_t NameHash = 0;
+	uint64_t Offset = 0;
+	uint64_t Size = 0;
+};
+
+/* Read-only pack file mapped into memory. Payload pointers stay valid until Close(). */
+class PackFile
+{
+public:
+	/* Page aligned, so payloads can be prefetched and released page by page. */
+	static constexpr uint32_t DefaultAlignment = 4096;
+
+	static constexpr uint32_t InvalidEntry = ~0u;
+
+	PackFile() = default;
+	~PackFile();
+
+	PackFile(const PackFile&) = delete;
+	PackFile& operator=(const PackFile&) = delete;
+
+	/* Fails unless the header, the alignment and every entry's bounds and payload alignment check out. */
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen() const { return mBase != nullptr; }
+
+	static uint64_t HashName(const char* name);
+
+	uint32_t Find(uint64_t nameHash) const;
+	uint32_t Find(const char* name) const { return Find(HashName(name)); }
+
+	uint32_t EntryCount() const { return mEntryCount; }
+	const PackEntry& Entry(uint32_t entry) const { return mEntries[entry]; }
+	const uint8_t* Data(uint32_t entry) const { return mBase + mEntries[entry].Offset; }
+
+	struct Source
+	{
+		std::string Name;
+		std::vector<uint8_t> Data;
+	};
+
+	/* Drops the file's pages from the OS file cache so the next read comes from disk. False if that failed. */
+	static bool EvictFromCache(const char* path);
+
+	/* Writes sources into a new pack file at path. */
+	static bool Write(const char* path, const std::vector<Source>& sources, uint32_t alignment = DefaultAlignment);
+
+private:
+	const uint8_t* mBase = nullptr;
+	uint64_t mSize = 0;
+	const PackEntry* mEntries = nullptr;
+	uint32_t mEntryCount = 0;
+
+#ifdef _WIN32
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#else
+	int mFile = -1;
+#endif
+};
@@ -0,0 +1,582 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <sstream>
+
+static bool IsReadOnly(RenderGraphState state)
+{
+	const uint32_t reads = (uint32_t)(RenderGraphState::DepthRead | RenderGraphState::ShaderResource | RenderGraphState::CopySource);
+	return ((uint32_t)state & ~reads) == 0;
+}
+
+static const char* StateName(RenderGraphState state)
+{
+	switch (state)
+	{
+	case RenderGraphState::Common: return "Common";
+	case RenderGraphState::RenderTarget: return "RenderTarget";
+	case RenderGraphState::DepthWrite: return "DepthWrite";
+	case RenderGraphState::DepthRead: return "DepthRead";
+	case RenderGraphState::ShaderResource: return "ShaderResource";
+	case RenderGraphState::UnorderedAccess: return "UnorderedAccess";
+	case RenderGraphState::CopySource: return "CopySource";
+	case RenderGraphState::CopyDest: return "CopyDest";
+	case RenderGraphState::Present: return "Present";
+	default: return nullptr;
+	}
+}
+
+static std::string StateString(RenderGraphState state)
+{
+	if (const char* name = StateName(state))
+		return name;
+
+	// Combined read states.
+	std::string result;
+	for (uint32_t bit = 1; bit != 0 && bit <= (uint32_t)state; bit <<= 1)
+	{
+		if ((uint32_t)state & bit)
+		{
+			if (!result.empty())
+				result += "|";
+			result += StateName((RenderGraphState)bit);
+		}
+	}
+	return result;
+}
+
+void RenderGraph::Reset()
+{
+	mResources.clear();
+	mPasses.clear();
+	mAccesses.clear();
+	mBatches.clear();
+	mBarriers.clear();
+	mStats = {};
+}
+
+RenderGraphHandle RenderGraph::Import(const char* name, RenderGraphState initialState, RenderGraphState finalState)
+{
+	Resource resource = {};
+	resource.Name = name;
+	resource.Transient = false;
+	resource.Initial = initialState;
+	resource.Final = finalState;
+	mResources.push_back(resource);
+	return (RenderGraphHandle)mResources.size() - 1;
+}
+
+RenderGraphHandle RenderGraph::CreateTransient(const char* name, uint64_t size, uint64_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	Resource resource = {};
+	resource.Name = name;
+	resource.Transient = true;
+	resource.Initial = RenderGraphState::Common;
+	resource.Final = RenderGraphState::Common;
+	resource.Size = size;
+	resource.Alignment = alignment;
+	mResources.push_back(resource);
+	return (RenderGraphHandle)mResources.size() - 1;
+}
+
+uint32_t RenderGraph::AddPass(const char* name, bool neverCull)
+{
+	Pass pass = {};
+	pass.Name = name;
+	pass.NeverCull = neverCull;
+	pass.AccessBegin = (uint32_t)mAccesses.size();
+	pass.AccessCount = 0;
+	mPasses.push_back(pass);
+	return (uint32_t)mPasses.size() - 1;
+}
+
+void RenderGraph::Read(uint32_t pass, RenderGraphHandle resource, RenderGraphState state)
+{
+	assert(IsReadOnly(state) && state != RenderGraphState::Common && "Not a read state");
+	AddAccess(pass, resource, state, false);
+}
+
+void RenderGraph::Write(uint32_t pass, RenderGraphHandle resource, RenderGraphState state)
+{
+	assert(!IsReadOnly(state) && StateName(state) != nullptr && "Writes take exactly one write state");
+	AddAccess(pass, resource, state, true);
+}
+
+void RenderGraph::AddAccess(uint32_t pass, RenderGraphHandle resource, RenderGraphState state, bool write)
+{
+	assert(pass + 1 == mPasses.size() && "Declare usages right after AddPass()");
+	assert(resource < mResources.size() && "Invalid resource");
+
+	// A pass declares each resource once; a second read widens the state, a write replaces it.
+	Pass& p = mPasses[pass];
+	for (uint32_t i = p.AccessBegin; i < p.AccessBegin + p.AccessCount; i++)
+	{
+		Access& access = mAccesses[i];
+		if (access.Resource != resource)
+			continue;
+
+		assert(!(access.Write && write) && "A pass can only write a resource once");
+		if (write)
+		{
+			access.State = state;
+			access.Write = true;
+		}
+		else if (!access.Write)
+		{
+			access.State = access.State | state;
+		}
+		return;
+	}
+
+	mAccesses.push_back({ resource, state, write });
+	p.AccessCount++;
+}
+
+bool RenderGraph::Compile()
+{
+	mBatches.clear();
+	mBarriers.clear();
+	mStats = {};
+
+	CullPasses();
+	if (!ComputeLifetimes())
+		return false;
+	PlaceTransients();
+	BuildBarriers();
+
+	mStats.Passes = (uint32_t)mPasses.size();
+	mStats.CulledPasses = (uint32_t)(mPasses.size() - mAlivePasses.size());
+	mStats.Resources = (uint32_t)mResources.size();
+	mStats.Barriers = (uint32_t)mBarriers.size();
+	for (const RenderGraphBatch& batch : mBatches)
+		mStats.BarrierCalls += batch.BarrierCount > 0 ? 1 : 0;
+	return true;
+}
+
+void RenderGraph::CullPasses()
+{
+	// Walk backwards from the imported resources: a pass is needed if it writes
+	// something a needed pass (or the outside world) consumes.
+	mNeeded.assign(mResources.size(), 0);
+	for (size_t r = 0; r < mResources.size(); r++)
+		mNeeded[r] = mResources[r].Transient ? 0 : 1;
+
+	mAlivePasses.clear();
+	for (uint32_t p = (uint32_t)mPasses.size(); p-- > 0;)
+	{
+		const Pass& pass = mPasses[p];
+
+		bool alive = pass.NeverCull;
+		for (uint32_t i = pass.AccessBegin; !alive && i < pass.AccessBegin + pass.AccessCount; i++)
+			alive = mAccesses[i].Write && mNeeded[mAccesses[i].Resource];
+
+		if (!alive)
+			continue;
+
+		for (uint32_t i = pass.AccessBegin; i < pass.AccessBegin + pass.AccessCount; i++)
+			mNeeded[mAccesses[i].Resource] = 1;
+		mAlivePasses.push_back(p);
+	}
+	std::reverse(mAlivePasses.begin(), mAlivePasses.end());
+}
+
+bool RenderGraph::ComputeLifetimes()
+{
+	for (Resource& resource : mResources)
+	{
+		resource.FirstPass = InvalidHandle;
+		resource.LastPass = InvalidHandle;
+		resource.Offset = 0;
+		resource.AliasBefore = InvalidHandle;
+		resource.Predecessors = 0;
+		resource.NextOccupantPass = InvalidHandle;
+	}
+
+	mNextAccess.assign(mAccesses.size(), InvalidHandle);
+	mLastAccess.assign(mResources.size(), InvalidHandle);
+
+	for (uint32_t k = 0; k < mAlivePasses.size(); k++)
+	{
+		const Pass& pass = mPasses[mAlivePasses[k]];
+		for (uint32_t i = pass.AccessBegin; i < pass.AccessBegin + pass.AccessCount; i++)
+		{
+			const Access& access = mAccesses[i];
+			Resource& resource = mResources[access.Resource];
+
+			if (mLastAccess[access.Resource] != InvalidHandle)
+				mNextAccess[mLastAccess[access.Resource]] = i;
+			mLastAccess[access.Resource] = i;
+
+			if (resource.FirstPass == InvalidHandle)
+			{
+				// Transient contents are undefined until something writes them.
+				if (resource.Transient && !access.Write)
+					return false;
+				resource.FirstPass = k;
+			}
+			resource.LastPass = k;
+		}
+	}
+	return true;
+}
+
+void RenderGraph::PlaceTransients()
+{
+	mPlacementOrder.clear();
+	for (RenderGraphHandle r = 0; r < mResources.size(); r++)
+	{
+		if (mResources[r].Transient && mResources[r].FirstPass != InvalidHandle)
+			mPlacementOrder.push_back(r);
+	}
+
+	// Largest first, then first fit below the resources whose lifetimes overlap.
+	std::sort(mPlacementOrder.begin(), mPlacementOrder.end(), [&](RenderGraphHandle a, RenderGraphHandle b)
+	{
+		if (mResources[a].Size != mResources[b].Size)
+			return mResources[a].Size > mResources[b].Size;
+		return a < b;
+	});
+
+	auto overlapsInTime = [&](const Resource& a, const Resource& b)
+	{
+		return a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass;
+	};
+	auto overlapsInMemory = [&](const Resource& a, const Resource& b)
+	{
+		return a.Offset < b.Offset + b.Size && b.Offset < a.Offset + a.Size;
+	};
+
+	for (size_t i = 0; i < mPlacementOrder.size(); i++)
+	{
+		Resource& resource = mResources[mPlacementOrder[i]];
+
+		// Sweep the lifetime-overlapping resources by offset for the first gap that fits.
+		mConflicts.clear();
+		for (size_t j = 0; j < i; j++)
+		{
+			if (overlapsInTime(resource, mResources[mPlacementOrder[j]]))
+				mConflicts.push_back(mPlacementOrder[j]);
+		}
+		std::sort(mConflicts.begin(), mConflicts.end(), [&](RenderGraphHandle a, RenderGraphHandle b)
+		{
+			return mResources[a].Offset < mResources[b].Offset;
+		});
+
+		uint64_t offset = 0;
+		for (RenderGraphHandle c : mConflicts)
+		{
+			const Resource& placed = mResources[c];
+			uint64_t aligned = (offset + resource.Alignment - 1) & ~(resource.Alignment - 1);
+			if (aligned + resource.Size <= placed.Offset)
+				break;
+			offset = std::max(offset, placed.Offset + placed.Size);
+		}
+		offset = (offset + resource.Alignment - 1) & ~(resource.Alignment - 1);
+
+		resource.Offset = offset;
+		mStats.TransientBytes = std::max(mStats.TransientBytes, offset + resource.Size);
+		mStats.UnaliasedBytes += resource.Size;
+		mStats.Transients++;
+	}
+
+	// Resources that used the same memory earlier in the frame; a single one can be named in the aliasing barrier.
+	for (RenderGraphHandle a : mPlacementOrder)
+	{
+		Resource& resource = mResources[a];
+		for (RenderGraphHandle b : mPlacementOrder)
+		{
+			Resource& other = mResources[b];
+			if (a == b || !overlapsInMemory(resource, other) || other.LastPass >= resource.FirstPass)
+				continue;
+
+			resource.AliasBefore = resource.Predecessors++ == 0 ? b : InvalidHandle;
+			other.NextOccupantPass = std::min(other.NextOccupantPass, resource.FirstPass);
+		}
+	}
+}
+
+void RenderGraph::BuildBarriers()
+{
+	const uint32_t passCount = (uint32_t)mAlivePasses.size();
+	const uint32_t finalBatch = passCount;
+
+	mPending.clear();
+	mStates.resize(mResources.size());
+	mLastUse.assign(mResources.size(), InvalidHandle);
+	mLastWasUav.assign(mResources.size(), 0);
+	for (size_t r = 0; r < mResources.size(); r++)
+		mStates[r] = mResources[r].Initial;
+
+	for (uint32_t k = 0; k < passCount; k++)
+	{
+		const Pass& pass = mPasses[mAlivePasses[k]];
+		for (uint32_t i = pass.AccessBegin; i < pass.AccessBegin + pass.AccessCount; i++)
+		{
+			const Access& access = mAccesses[i];
+			RenderGraphHandle r = access.Resource;
+			const Resource& resource = mResources[r];
+
+			if (resource.Transient && k == resource.FirstPass && resource.Predecessors > 0)
+			{
+				RenderGraphBarrier barrier;
+				barrier.Type = RenderGraphBarrierType::Aliasing;
+				barrier.Resource = r;
+				barrier.AliasBefore = resource.AliasBefore;
+				Emit(k, 1, barrier);
+				mStats.AliasingBarriers++;
+			}
+
+			RenderGraphState current = mStates[r];
+			bool satisfied = access.Write
+				? current == access.State
+				: current != RenderGraphState::Common && (current & access.State) == access.State && IsReadOnly(current);
+
+			if (!satisfied)
+			{
+				// Widen a read transition to cover the following reads, up to the next write.
+				RenderGraphState target = access.State;
+				for (uint32_t next = mNextAccess[i]; !access.Write && next != InvalidHandle && !mAccesses[next].Write; next = mNextAccess[next])
+					target = target | mAccesses[next].State;
+
+				AddTransition(r, mLastUse[r], k, current, target, 2);
+				mStates[r] = target;
+			}
+			else if (access.Write && access.State == RenderGraphState::UnorderedAccess && mLastWasUav[r])
+			{
+				RenderGraphBarrier barrier;
+				barrier.Type = RenderGraphBarrierType::Uav;
+				barrier.Resource = r;
+				Emit(k, 2, barrier);
+				mStats.UavBarriers++;
+			}
+
+			mLastWasUav[r] = access.State == RenderGraphState::UnorderedAccess ? 1 : 0;
+			mLastUse[r] = k;
+		}
+	}
+
+	// Return every resource to its final state: imported ones at the end of the frame,
+	// transient ones before the next occupant of their memory takes over.
+	for (RenderGraphHandle r = 0; r < mResources.size(); r++)
+	{
+		const Resource& resource = mResources[r];
+		if (mStates[r] == resource.Final)
+			continue;
+
+		uint32_t batch = finalBatch;
+		if (resource.Transient && resource.NextOccupantPass != InvalidHandle)
+			batch = resource.NextOccupantPass;
+		AddTransition(r, mLastUse[r], batch, mStates[r], resource.Final, 0);
+	}
+
+	std::stable_sort(mPending.begin(), mPending.end(), [](const PendingBarrier& a, const PendingBarrier& b)
+	{
+		return a.Batch != b.Batch ? a.Batch < b.Batch : a.Order < b.Order;
+	});
+
+	mBatches.resize(passCount + 1);
+	size_t next = 0;
+	for (uint32_t batch = 0; batch <= passCount; batch++)
+	{
+		mBatches[batch].Pass = batch < passCount ? mAlivePasses[batch] : InvalidHandle;
+		mBatches[batch].BarrierBegin = (uint32_t)mBarriers.size();
+		for (; next < mPending.size() && mPending[next].Batch == batch; next++)
+			mBarriers.push_back(mPending[next].Barrier);
+		mBatches[batch].BarrierCount = (uint32_t)mBarriers.size() - mBatches[batch].BarrierBegin;
+	}
+}
+
+void RenderGraph::AddTransition(RenderGraphHandle resource, uint32_t lastUse, uint32_t batch, RenderGraphState before, RenderGraphState after, uint32_t order)
+{
+	RenderGraphBarrier barrier;
+	barrier.Type = RenderGraphBarrierType::Transition;
+	barrier.Resource = resource;
+	barrier.Before = before;
+	barrier.After = after;
+
+	// With at least one pass between the last use and this batch, let the GPU start the transition early.
+	if (lastUse != InvalidHandle && lastUse + 1 < batch)
+	{
+		barrier.Split = RenderGraphSplit::Begin;
+		Emit(lastUse + 1, order, barrier);
+		barrier.Split = RenderGraphSplit::End;
+		Emit(batch, order, barrier);
+		mStats.SplitBarriers++;
+		return;
+	}
+
+	Emit(batch, order, barrier);
+}
+
+void RenderGraph::Emit(uint32_t batch, uint32_t order, const RenderGraphBarrier& barrier)
+{
+	mPending.push_back({ batch, order, barrier });
+}
+
+std::string RenderGraph::DumpSchedule() const
+{
+	std::ostringstream out;
+	out << "# " << mStats.Passes << " passes (" << mStats.CulledPasses << " culled), "
+		<< mStats.Resources << " resources (" << mStats.Transients << " transient), "
+		<< mStats.Barriers << " barriers in " << mStats.BarrierCalls << " calls, "
+		<< mStats.SplitBarriers << " split, " << mStats.AliasingBarriers << " aliasing, " << mStats.UavBarriers << " uav\n";
+	out << "# transient heap " << mStats.TransientBytes / 1024 << " KB, " << mStats.UnaliasedBytes / 1024 << " KB without aliasing\n";
+
+	for (RenderGraphHandle r = 0; r < mResources.size(); r++)
+	{
+		const Resource& resource = mResources[r];
+		if (resource.Transient && resource.FirstPass != InvalidHandle)
+		{
+			out << "# resource " << r << " '" << resource.Name << "': offset " << resource.Offset / 1024 << " KB, size "
+				<< resource.Size / 1024 << " KB, passes " << resource.FirstPass << "-" << resource.LastPass << "\n";
+		}
+	}
+
+	for (size_t b = 0; b < mBatches.size(); b++)
+	{
+		const RenderGraphBatch& batch = mBatches[b];
+		if (batch.Pass != InvalidHandle)
+			out << "pass " << b << " '" << mPasses[batch.Pass].Name << "'\n";
+		else
+			out << "end of frame\n";
+
+		for (uint32_t i = batch.BarrierBegin; i < batch.BarrierBegin + batch.BarrierCount; i++)
+		{
+			const RenderGraphBarrier& barrier = mBarriers[i];
+			out << "  ";
+			switch (barrier.Type)
+			{
+			case RenderGraphBarrierType::Aliasing:
+				out << "aliasing   " << barrier.Resource << ":" << mResources[barrier.Resource].Name;
+				if (barrier.AliasBefore != InvalidHandle)
+					out << " (was " << barrier.AliasBefore << ":" << mResources[barrier.AliasBefore].Name << ")";
+				else
+					out << " (was several)";
+				break;
+			case RenderGraphBarrierType::Uav:
+				out << "uav        " << barrier.Resource << ":" << mResources[barrier.Resource].Name;
+				break;
+			default:
+				out << "transition " << barrier.Resource << ":" << mResources[barrier.Resource].Name << " "
+					<< StateString(barrier.Before) << " -> " << StateString(barrier.After);
+				if (barrier.Split == RenderGraphSplit::Begin)
+					out << " (begin)";
+				else if (barrier.Split == RenderGraphSplit::End)
+					out << " (end)";
+				break;
+			}
+			out << "\n";
+		}
+	}
+
+	for (uint32_t p = 0; p < mPasses.size(); p++)
+	{
+		if (std::find(mAlivePasses.begin(), mAlivePasses.end(), p) == mAlivePasses.end())
+			out << "culled '" << mPasses[p].Name << "'\n";
+	}
+	return out.str();
+}
+
+void RenderGraph::BuildSyntheticFrame(RenderGraph& graph, uint32_t passCount)
+{
+	const uint64_t alignment = 64ull * 1024;
+	const uint64_t screenSize = (1920ull * 1080 * 4 + alignment - 1) & ~(alignment - 1);
+
+	graph.Reset();
+	RenderGraphHandle backBuffer = graph.Import("BackBuffer", RenderGraphState::Present, RenderGraphState::Present);
+	RenderGraphHandle depth = graph.Import("Depth", RenderGraphState::DepthWrite, RenderGraphState::DepthWrite);
+
+	RenderGraphHandle shadow = graph.CreateTransient("ShadowMap", 2048ull * 2048 * 4, alignment);
+	uint32_t pass = graph.AddPass("Shadow");
+	graph.Write(pass, shadow, RenderGraphState::DepthWrite);
+
+	RenderGraphHandle gbuffer[3] =
+	{
+		graph.CreateTransient("GBufferAlbedo", screenSize, alignment),
+		graph.CreateTransient("GBufferNormal", screenSize * 2, alignment),
+		graph.CreateTransient("GBufferMaterial", screenSize, alignment)
+	};
+	pass = graph.AddPass("GBuffer");
+	for (RenderGraphHandle target : gbuffer)
+		graph.Write(pass, target, RenderGraphState::RenderTarget);
+	graph.Write(pass, depth, RenderGraphState::DepthWrite);
+
+	RenderGraphHandle lighting = graph.CreateTransient("Lighting", screenSize * 2, alignment);
+	pass = graph.AddPass("Lighting");
+	for (RenderGraphHandle target : gbuffer)
+		graph.Read(pass, target, RenderGraphState::ShaderResource);
+	graph.Read(pass, shadow, RenderGraphState::ShaderResource);
+	graph.Read(pass, depth, RenderGraphState::DepthRead);
+	graph.Write(pass, lighting, RenderGraphState::RenderTarget);
+
+	// Post chain: every fourth pass is a debug view nobody reads, every other one a compute blur.
+	RenderGraphHandle previous = lighting;
+	for (uint32_t i = 0; i + 4 < passCount; i++)
+	{
+		if (i % 4 == 3)
+		{
+			RenderGraphHandle debug = graph.CreateTransient("DebugView", screenSize, alignment);
+			pass = graph.AddPass("Debug");
+			graph.Read(pass, previous, RenderGraphState::ShaderResource);
+			graph.Write(pass, debug, RenderGraphState::RenderTarget);
+		}
+		else if (i % 4 == 1)
+		{
+			RenderGraphHandle blur = graph.CreateTransient("Blur", screenSize * 2, alignment);
+			pass = graph.AddPass("BlurH");
+			graph.Read(pass, previous, RenderGraphState::ShaderResource);
+			graph.Write(pass, blur, RenderGraphState::UnorderedAccess);
+			previous = blur;
+		}
+		else
+		{
+			RenderGraphHandle post = graph.CreateTransient("Post", screenSize * 2, alignment);
+			pass = graph.AddPass("Post");
+			graph.Read(pass, previous, RenderGraphState::ShaderResource);
+			graph.Read(pass, depth, RenderGraphState::DepthRead);
+			graph.Write(pass, post, RenderGraphState::RenderTarget);
+			previous = post;
+		}
+	}
+
+	pass = graph.AddPass("Composite");
+	graph.Read(pass, previous, RenderGraphState::ShaderResource);
+	graph.Read(pass, lighting, RenderGraphState::ShaderResource | RenderGraphState::CopySource);
+	graph.Write(pass, backBuffer, RenderGraphState::RenderTarget);
+}
+
+std::vector<RenderGraphCompileResult> RenderGraph::MeasureCompile(uint32_t maxPasses, uint32_t iterations)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<RenderGraphCompileResult> results;
+	RenderGraph graph;
+	for (uint32_t passes = 8; passes <= std::max(maxPasses, 8u); passes *= 2)
+	{
+		RenderGraphCompileResult result = {};
+		result.Passes = passes;
+		result.MinUs = 1e300;
+
+		// Building is part of the per-frame cost, so it is timed together with Compile().
+		double totalUs = 0.0;
+		for (uint32_t i = 0; i < std::max(iterations, 1u); i++)
+		{
+			Clock::time_point begin = Clock::now();
+			BuildSyntheticFrame(graph, passes);
+			graph.Compile();
+			double us = std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+
+			totalUs += us;
+			result.MinUs = std::min(result.MinUs, us);
+		}
+
+		result.MeanUs = totalUs / std::max(iterations, 1u);
+		result.Stats = graph.Stats();
+		results.push_back(result);
+	}
+	return results;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Usages a pass can declare on a resource. Read usages can be combined, write usages cannot. */
+enum class RenderGraphState : uint32_t
+{
+	Common = 0,
+	RenderTarget = 1u << 0,
+	DepthWrite = 1u << 1,
+	DepthRead = 1u << 2,
+	ShaderResource = 1u << 3,
+	UnorderedAccess = 1u << 4,
+	CopySource = 1u << 5,
+	CopyDest = 1u << 6,
+	Present = 1u << 7
+};
+
+inline RenderGraphState operator|(RenderGraphState a, RenderGraphState b) { return (RenderGraphState)((uint32_t)a | (uint32_t)b); }
+inline RenderGraphState operator&(RenderGraphState a, RenderGraphState b) { return (RenderGraphState)((uint32_t)a & (uint32_t)b); }
+
+enum class RenderGraphBarrierType : uint32_t
+{
+	Transition,
+	Aliasing,
+	Uav
+};
+
+/* Split transitions begin right after the last use and end right before the next one. */
+enum class RenderGraphSplit : uint32_t
+{
+	None,
+	Begin,
+	End
+};
+
+using RenderGraphHandle = uint32_t;
+
+struct RenderGraphBarrier
+{
+	RenderGraphBarrierType Type = RenderGraphBarrierType::Transition;
+	RenderGraphSplit Split = RenderGraphSplit::None;
+	RenderGraphHandle Resource = 0;
+	/* Aliasing barriers only: the resource that used the memory before, invalid if there were several. */
+	RenderGraphHandle AliasBefore = ~0u;
+	RenderGraphState Before = RenderGraphState::Common;
+	RenderGraphState After = RenderGraphState::Common;
+};
+
+/* Barriers recorded in one ResourceBarrier call before Pass, or after the last pass when Pass is invalid. */
+struct RenderGraphBatch
+{
+	uint32_t Pass = ~0u;
+	uint32_t BarrierBegin = 0;
+	uint32_t BarrierCount = 0;
+};
+
+struct RenderGraphStats
+{
+	uint32_t Passes = 0;
+	uint32_t CulledPasses = 0;
+	uint32_t Resources = 0;
+	uint32_t Transients = 0;
+	uint32_t Barriers = 0;
+	uint32_t SplitBarriers = 0;
+	uint32_t AliasingBarriers = 0;
+	uint32_t UavBarriers = 0;
+	/* Batches that contain at least one barrier, i.e. ResourceBarrier calls. */
+	uint32_t BarrierCalls = 0;
+	/* Size of the transient heap after aliasing, and without it. */
+	uint64_t TransientBytes = 0;
+	uint64_t UnaliasedBytes = 0;
+};
+
+struct RenderGraphCompileResult
+{
+	uint32_t Passes = 0;
+	double MeanUs = 0.0;
+	double MinUs = 0.0;
+	RenderGraphStats Stats;
+};
+
+/*
+	Frame graph rebuilt every frame. Passes are added in execution order and
+	declare the resources they read and write; Compile() culls passes whose
+	output is never used, places transient resources in one heap so that
+	resources with disjoint lifetimes share memory, and turns the declared
+	usages into one barrier batch per pass.
+	Transient resources start and end every frame in the Common state.
+	API-agnostic: DXRenderGraph owns the D3D12 resources and records the batches.
+*/
+class RenderGraph
+{
+public:
+	static constexpr RenderGraphHandle InvalidHandle = ~0u;
+
+	/* Drops all passes and resources, keeping the allocations for the next frame. */
+	void Reset();
+
+	/* A resource owned outside the graph, in initialState before the first pass and left in finalState. */
+	RenderGraphHandle Import(const char* name, RenderGraphState initialState, RenderGraphState finalState);
+	/* A resource that only lives for this frame; size and alignment come from the backend. */
+	RenderGraphHandle CreateTransient(const char* name, uint64_t size, uint64_t alignment);
+
+	/* Passes with side effects outside the graph are never culled. */
+	uint32_t AddPass(const char* name, bool neverCull = false);
+	/* Usages must be declared right after AddPass(), before the next pass is added. */
+	void Read(uint32_t pass, RenderGraphHandle resource, RenderGraphState state);
+	void Write(uint32_t pass, RenderGraphHandle resource, RenderGraphState state);
+
+	/* Returns false if a transient resource is read before anything writes it. */
+	bool Compile();
+
+	const std::vector<RenderGraphBatch>& Batches() const { return mBatches; }
+	const std::vector<RenderGraphBarrier>& Barriers() const { return mBarriers; }
+	const RenderGraphStats& Stats() const { return mStats; }
+
+	uint32_t PassCount() const { return (uint32_t)mPasses.size(); }
+	uint32_t ResourceCount() const { return (uint32_t)mResources.size(); }
+	const char* PassName(uint32_t pass) const { return mPasses[pass].Name; }
+	const char* ResourceName(RenderGraphHandle resource) const { return mResources[resource].Name; }
+	bool IsTransient(RenderGraphHandle resource) const { return mResources[resource].Transient; }
+	/* Offset of a transient resource inside the transient heap, valid after Compile(). */
+	uint64_t TransientOffset(RenderGraphHandle resource) const { return mResources[resource].Offset; }
+	bool IsUsed(RenderGraphHandle resource) const { return mResources[resource].FirstPass != InvalidHandle; }
+
+	/* Human readable barrier schedule of the last Compile(). */
+	std::string DumpSchedule() const;
+
+	/* A deferred-shading style frame with passCount passes, some of them culled. */
+	static void BuildSyntheticFrame(RenderGraph& graph, uint32_t passCount);
+	/* Build and compile time of BuildSyntheticFrame() graphs for 8, 16, ... up to maxPasses. */
+	static std::vector<RenderGraphCompileResult> MeasureCompile(uint32_t maxPasses, uint32_t iterations);
+
+private:
+	struct Resource
+	{
+		const char* Name;
+		bool Transient;
+		RenderGraphState Initial;
+		RenderGraphState Final;
+		uint64_t Size;
+		uint64_t Alignment;
+
+		// Filled in by Compile(), in compiled pass indices.
+		uint32_t FirstPass;
+		uint32_t LastPass;
+		uint64_t Offset;
+		RenderGraphHandle AliasBefore;
+		uint32_t Predecessors;
+		uint32_t NextOccupantPass;
+	};
+
+	struct Access
+	{
+		RenderGraphHandle Resource;
+		RenderGraphState State;
+		bool Write;
+	};
+
+	struct Pass
+	{
+		const char* Name;
+		bool NeverCull;
+		uint32_t AccessBegin;
+		uint32_t AccessCount;
+	};
+
+	/* Barrier waiting to be sorted into its batch. */
+	struct PendingBarrier
+	{
+		uint32_t Batch;
+		/* Within a batch: retiring resources first, then aliasing, then everything else. */
+		uint32_t Order;
+		RenderGraphBarrier Barrier;
+	};
+
+	void AddAccess(uint32_t pass, RenderGraphHandle resource, RenderGraphState state, bool write);
+	void CullPasses();
+	bool ComputeLifetimes();
+	void PlaceTransients();
+	void BuildBarriers();
+	void AddTransition(RenderGraphHandle resource, uint32_t lastUse, uint32_t batch, RenderGraphState before, RenderGraphState after, uint32_t order);
+	void Emit(uint32_t batch, uint32_t order, const RenderGraphBarrier& barrier);
+
+	std::vector<Resource> mResources;
+	std::vector<Pass> mPasses;
+	std::vector<Access> mAccesses;
+
+	// Compile() scratch, kept to avoid per-frame allocations.
+	std::vector<uint8_t> mNeeded;
+	std::vector<uint32_t> mAlivePasses;
+	std::vector<RenderGraphHandle> mPlacementOrder;
+	std::vector<RenderGraphHandle> mConflicts;
+	/* Next access of the same resource by a live pass, per access. */
+	std::vector<uint32_t> mNextAccess;
+	std::vector<uint32_t> mLastAccess;
+	std::vector<PendingBarrier> mPending;
+	std::vector<RenderGraphState> mStates;
+	std::vector<uint32_t> mLastUse;
+	std::vector<uint8_t> mLastWasUav;
+
+	std::vector<RenderGraphBatch> mBatches;
+	std::vector<RenderGraphBarrier> mBarriers;
+	RenderGraphStats mStats;
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "FrameRing.h"
+
+/* Size bucket a pooled target was created for; Format and SampleCount are the API's values. */
+struct RenderTargetKey
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t Format = 0;
+	uint32_t SampleCount = 1;
+
+	bool operator==(const RenderTargetKey& other) const = default;
+};
+
+struct RenderTargetPoolStats
+{
+	uint64_t Hits = 0;
+	uint64_t Misses = 0;
+	/* Targets handed to the destroy callback by Trim(). */
+	uint64_t Evictions = 0;
+	/* Released targets the GPU may still be using. */
+	uint32_t Retiring = 0;
+	/* Released targets that can be handed out again. */
+	uint32_t Free = 0;
+};
+
+/*
+	Keeps released render targets until the GPU retires the fence value they were
+	released at, then hands them out again for the same size bucket. Sizes are
+	rounded up to a multiple of the granularity, so flipping between common
+	window sizes, or dragging an edge by a few pixels, reuses memory instead of
+	flushing the queue and allocating. Target is whatever owns the resource and
+	must be movable; the pool never creates or destroys one itself.
+*/
+template<typename Target>
+class RenderTargetPool
+{
+public:
+	static constexpr uint32_t DefaultGranularity = 256;
+	static constexpr uint32_t DefaultMaxFree = 4;
+
+	RenderTargetPool() = default;
+	RenderTargetPool(const RenderTargetPool&) = delete;
+	RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+	void Initialize(FrameSync* sync, uint32_t granularity = DefaultGranularity, uint32_t maxFree = DefaultMaxFree)
+	{
+		assert(sync != nullptr && "RenderTargetPool needs a FrameSync");
+		assert(granularity > 0 && "Bucket granularity must not be zero");
+		assert(mEntries.empty() && "Clear() the pool before initializing it again");
+
+		mSync = sync;
+		mGranularity = granularity;
+		mMaxFree = maxFree;
+		mStats = {};
+	}
+
+	/* The smallest bucket holding width x height. */
+	RenderTargetKey Bucket(uint32_t width, uint32_t height, uint32_t format, uint32_t sampleCount = 1) const
+	{
+		RenderTargetKey key;
+		key.Width = RoundUp(width);
+		key.Height = RoundUp(height);
+		key.Format = format;
+		key.SampleCount = sampleCount;
+		return key;
+	}
+
+	/* Moves a retired target of exactly this bucket into target; false on a miss, the caller then creates one. */
+	bool Acquire(const RenderTargetKey& key, Target& target)
+	{
+		uint64_t completed = mSync->CompletedValue();
+		for (size_t i = 0; i < mEntries.size(); i++)
+		{
+			if (mEntries[i].Key == key && mEntries[i].FenceValue <= completed)
+			{
+				target = std::move(mEntries[i].Value);
+				mEntries.erase(mEntries.begin() + i);
+				mStats.Hits++;
+				return true;
+			}
+		}
+
+		mStats.Misses++;
+		return false;
+	}
+
+	/* fenceValue is the last one signaled after work using target; nothing waits for it here. */
+	void Release(const RenderTargetKey& key, Target&& target, uint64_t fenceValue)
+	{
+		assert(fenceValue <= mSync->LastSignaledValue() && "Release() with a fence value that was never signaled");
+
+		// Oldest release first, which Trim() relies on.
+		Entry entry;
+		entry.Key = key;
+		entry.Value = std::move(target);
+		entry.FenceValue = fenceValue;
+		mEntries.push_back(std::move(entry));
+	}
+
+	/* Hands retired targets beyond the pool's maxFree to destroy, least recently released first. */
+	template<typename Destroy>
+	void Trim(Destroy&& destroy)
+	{
+		uint64_t completed = mSync->CompletedValue();
+		uint32_t free = 0;
+		for (const Entry& entry : mEntries)
+			free += entry.FenceValue <= completed ? 1 : 0;
+
+		for (size_t i = 0; i < mEntries.size() && free > mMaxFree;)
+		{
+			if (mEntries[i].FenceValue > completed)
+			{
+				i++;
+				continue;
+			}
+
+			destroy(mEntries[i].Value);
+			mEntries.erase(mEntries.begin() + i);
+			mStats.Evictions++;
+			free--;
+		}
+	}
+
+	/* Hands every target to destroy. The GPU must be done with all of them. */
+	template<typename Destroy>
+	void Clear(Destroy&& destroy)
+	{
+		for (Entry& entry : mEntries)
+			destroy(entry.Value);
+		mEntries.clear();
+	}
+
+	RenderTargetPoolStats Stats() const
+	{
+		RenderTargetPoolStats stats = mStats;
+		uint64_t completed = mSync ? mSync->CompletedValue() : 0;
+		for (const Entry& entry : mEntries)
+		{
+			if (entry.FenceValue <= completed)
+				stats.Free++;
+			else
+				stats.Retiring++;
+		}
+		return stats;
+	}
+
+	void ResetStats()
+	{
+		mStats = {};
+	}
+
+private:
+	struct Entry
+	{
+		RenderTargetKey Key;
+		Target Value = {};
+		uint64_t FenceValue = 0;
+	};
+
+	uint32_t RoundUp(uint32_t size) const
+	{
+		uint64_t rounded = ((uint64_t)size + mGranularity - 1) / mGranularity * mGranularity;
+		return rounded > UINT32_MAX ? size : (uint32_t)rounded;
+	}
+
+	FrameSync* mSync = nullptr;
+	uint32_t mGranularity = DefaultGranularity;
+	uint32_t mMaxFree = DefaultMaxFree;
+	/* A handful of entries at most, so a linear scan beats anything keyed. */
+	std::vector<Entry> mEntries;
+	RenderTargetPoolStats mStats;
+};
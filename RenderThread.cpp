@@ -0,0 +1,167 @@
+#include "RenderThread.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+bool WindowCommandQueue::Push(const WindowCommand& command)
+{
+	uint64_t head = mHead.load(std::memory_order_relaxed);
+	if (head - mTail.load(std::memory_order_acquire) >= Capacity)
+		return false;
+
+	mCommands[head & (Capacity - 1)] = command;
+	mHead.store(head + 1, std::memory_order_release);
+	mHead.notify_one();
+	return true;
+}
+
+uint32_t WindowCommandQueue::Drain(WindowCommand* out, uint32_t maxCommands)
+{
+	uint64_t tail = mTail.load(std::memory_order_relaxed);
+	uint64_t head = mHead.load(std::memory_order_acquire);
+	uint32_t count = (uint32_t)std::min<uint64_t>(head - tail, maxCommands);
+
+	for (uint32_t i = 0; i < count; i++)
+		out[i] = mCommands[(tail + i) & (Capacity - 1)];
+	mTail.store(tail + count, std::memory_order_release);
+	return count;
+}
+
+void WindowCommandQueue::WaitForCommands()
+{
+	// Returns at once if Push() moved the head past what Drain() consumed.
+	mHead.wait(mTail.load(std::memory_order_relaxed), std::memory_order_acquire);
+}
+
+RenderThread::~RenderThread()
+{
+	assert(!IsRunning() && "Stop() the render thread before destroying it");
+}
+
+void RenderThread::Start(RenderThreadClient* client)
+{
+	assert(!IsRunning() && "Render thread already started");
+	mClient = client;
+	mExited.store(false, std::memory_order_relaxed);
+	mFailed.store(false, std::memory_order_relaxed);
+	mFailure = nullptr;
+	mThread = std::thread(&RenderThread::Main, this);
+}
+
+void RenderThread::Post(const WindowCommand& command)
+{
+	WindowCommand posted = command;
+	posted.PostedNs = NowNs();
+	while (!mQueue.Push(posted))
+	{
+		// A dead render thread never drains; Stop() reports why.
+		if (Failed())
+			return;
+		if (mWaitCallback)
+			mWaitCallback();
+		else
+			std::this_thread::yield();
+	}
+}
+
+void RenderThread::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	WindowCommand quit;
+	quit.Type = WindowCommandType::Quit;
+	Post(quit);
+	while (!mExited.load(std::memory_order_acquire))
+	{
+		if (mWaitCallback)
+			mWaitCallback();
+		else
+			mExited.wait(false, std::memory_order_acquire);
+	}
+	mThread.join();
+
+	if (mFailure)
+	{
+		std::exception_ptr failure = mFailure;
+		mFailure = nullptr;
+		std::rethrow_exception(failure);
+	}
+}
+
+RenderThreadStats RenderThread::Stats() const
+{
+	RenderThreadStats stats;
+	stats.Frames = mFrames;
+	stats.Commands = mCommands;
+	stats.IdleWaits = mIdleWaits;
+	if (mCommands > 0)
+		stats.MeanCommandLatencyUs = (double)mLatencySumNs / 1000.0 / (double)mCommands;
+	stats.MaxCommandLatencyUs = (double)mLatencyMaxNs / 1000.0;
+	return stats;
+}
+
+void RenderThread::ResetStats()
+{
+	mFrames = 0;
+	mCommands = 0;
+	mLatencySumNs = 0;
+	mLatencyMaxNs = 0;
+	mIdleWaits = 0;
+}
+
+void RenderThread::Main()
+{
+	try
+	{
+		mClient->OnRenderThreadStarted();
+		Loop();
+	}
+	catch (...)
+	{
+		mFailure = std::current_exception();
+		mFailed.store(true, std::memory_order_release);
+		mClient->OnRenderThreadFailed();
+	}
+
+	mExited.store(true, std::memory_order_release);
+	mExited.notify_all();
+}
+
+void RenderThread::Loop()
+{
+	WindowCommand commands[WindowCommandQueue::Capacity];
+
+	while (true)
+	{
+		uint32_t count = mQueue.Drain(commands, WindowCommandQueue::Capacity);
+		int64_t now = NowNs();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (commands[i].Type == WindowCommandType::Quit)
+				return;
+
+			int64_t latency = now - commands[i].PostedNs;
+			mLatencySumNs += latency;
+			mLatencyMaxNs = std::max(mLatencyMaxNs, latency);
+			mCommands++;
+			mClient->ApplyWindowCommand(commands[i]);
+		}
+
+		if (mClient->RenderFrame())
+		{
+			mFrames++;
+		}
+		else
+		{
+			mIdleWaits++;
+			mQueue.WaitForCommands();
+		}
+	}
+}
+
+int64_t RenderThread::NowNs()
+{
+	return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
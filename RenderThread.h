@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <thread>
+
+enum class WindowCommandType : uint32_t
+{
+	/* Param: 1 activated, 0 deactivated. */
+	Activate,
+	/* Param: SIZE_* kind; Width, Height: new client size. */
+	Size,
+	EnterSizeMove,
+	ExitSizeMove,
+	/* Param: virtual key released. */
+	Key,
+	/* Posted by RenderThread::Stop(). */
+	Quit
+};
+
+struct WindowCommand
+{
+	WindowCommandType Type = WindowCommandType::Quit;
+	uint32_t Param = 0;
+	int32_t Width = 0;
+	int32_t Height = 0;
+	/* steady_clock time of Post(), for the handoff latency stats. */
+	int64_t PostedNs = 0;
+};
+
+/* Lock-free single-producer/single-consumer ring from the window thread to the render thread. */
+class WindowCommandQueue
+{
+public:
+	static constexpr uint32_t Capacity = 256;
+
+	bool Push(const WindowCommand& command);
+	uint32_t Drain(WindowCommand* out, uint32_t maxCommands);
+	/* Consumer: blocks until something was pushed since the last Drain(). */
+	void WaitForCommands();
+
+private:
+	alignas(64) std::atomic<uint64_t> mHead{ 0 };
+	alignas(64) std::atomic<uint64_t> mTail{ 0 };
+	WindowCommand mCommands[Capacity];
+};
+
+/* Implemented by whatever runs on the render thread; every call is made on that thread. */
+class RenderThreadClient
+{
+public:
+	virtual ~RenderThreadClient() = default;
+
+	virtual void OnRenderThreadStarted() {}
+	/* Between frames, in the order the window thread posted them. */
+	virtual void ApplyWindowCommand(const WindowCommand& command) = 0;
+	/* Returns false when there is nothing to render; the thread then sleeps until the next command. */
+	virtual bool RenderFrame() = 0;
+	/* After ApplyWindowCommand() or RenderFrame() threw; should wake the window thread so it calls Stop(). */
+	virtual void OnRenderThreadFailed() {}
+};
+
+struct RenderThreadStats
+{
+	uint64_t Frames = 0;
+	uint64_t Commands = 0;
+	/* Post() to ApplyWindowCommand(), i.e. how long a resize or key waits for the frame boundary. */
+	double MeanCommandLatencyUs = 0.0;
+	double MaxCommandLatencyUs = 0.0;
+	/* Times the thread slept because RenderFrame() had nothing to do. */
+	uint64_t IdleWaits = 0;
+};
+
+/*
+	Runs a RenderThreadClient's frames on a dedicated thread, so a modal window
+	loop or a slow message handler no longer stalls rendering. The window thread
+	only posts commands; they are applied at the next frame boundary.
+*/
+class RenderThread
+{
+public:
+	RenderThread() = default;
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	void Start(RenderThreadClient* client);
+	/*
+		Window thread: called over and over while Post() or Stop() waits on the render thread,
+		which may itself be blocked on the window thread, e.g. sending it a message. Without
+		one they yield or block.
+	*/
+	void SetWaitCallback(std::function<void()> callback) { mWaitCallback = std::move(callback); }
+	/* Window thread. Waits for room if the render thread is a full queue behind. */
+	void Post(const WindowCommand& command);
+	/* Window thread: applies the commands posted so far, waits for the thread to exit, and rethrows what it threw. */
+	void Stop();
+
+	bool IsRunning() const { return mThread.joinable(); }
+	bool Failed() const { return mFailed.load(std::memory_order_acquire); }
+
+	/* Render thread, or the window thread once stopped. */
+	RenderThreadStats Stats() const;
+	void ResetStats();
+
+private:
+	void Main();
+	void Loop();
+	static int64_t NowNs();
+
+	RenderThreadClient* mClient = nullptr;
+	WindowCommandQueue mQueue;
+	std::thread mThread;
+	std::function<void()> mWaitCallback;
+	/* Set as the last thing the thread does, so Stop() only joins a thread that is already done. */
+	std::atomic<bool> mExited{ false };
+	std::atomic<bool> mFailed{ false };
+	std::exception_ptr mFailure;
+
+	uint64_t mFrames = 0;
+	uint64_t mCommands = 0;
+	int64_t mLatencySumNs = 0;
+	int64_t mLatencyMaxNs = 0;
+	uint64_t mIdleWaits = 0;
+};
@@ -0,0 +1,224 @@
+#include "ResizeScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include "NullGpu.h"
+#include "RenderTargetPool.h"
+#include "SystemClock.h"
+
+void ResizeScheduler::Initialize(int64_t ticksPerSecond, double debounceMs)
+{
+	mTicksPerSecond = std::max<int64_t>(ticksPerSecond, 1);
+	mDebounceTicks = (int64_t)(std::max(debounceMs, 0.0) * (double)mTicksPerSecond / 1000.0);
+	mPending = false;
+	mImmediate = false;
+	ResetStats();
+}
+
+void ResizeScheduler::Request(uint32_t width, uint32_t height, int64_t now, bool immediate)
+{
+	if (width == 0 || height == 0)
+		return;
+
+	mRequests++;
+	if (mPending)
+		mCoalesced++;
+	else
+		mFirstRequest = now;
+
+	mPending = true;
+	// An immediate request stays immediate when a debounced one follows it before the next Poll().
+	mImmediate = mImmediate || immediate;
+	mWidth = width;
+	mHeight = height;
+	mLastRequest = now;
+}
+
+bool ResizeScheduler::Poll(int64_t now, uint32_t& width, uint32_t& height)
+{
+	if (!mPending)
+		return false;
+	if (!mImmediate && now - mLastRequest < mDebounceTicks)
+		return false;
+
+	mPending = false;
+	mImmediate = false;
+
+	// A drag that ends where it started needs no new buffers.
+	if (mWidth == mAppliedWidth && mHeight == mAppliedHeight)
+	{
+		mRedundant++;
+		return false;
+	}
+
+	int64_t delay = now - mFirstRequest;
+	mDelaySum += delay;
+	mDelayMax = std::max(mDelayMax, delay);
+	mApplied++;
+
+	MarkApplied(mWidth, mHeight);
+	width = mWidth;
+	height = mHeight;
+	return true;
+}
+
+void ResizeScheduler::MarkApplied(uint32_t width, uint32_t height)
+{
+	mAppliedWidth = width;
+	mAppliedHeight = height;
+}
+
+ResizeSchedulerStats ResizeScheduler::Stats() const
+{
+	ResizeSchedulerStats stats;
+	stats.Requests = mRequests;
+	stats.Applied = mApplied;
+	stats.Coalesced = mCoalesced;
+	stats.Redundant = mRedundant;
+	if (mApplied > 0)
+		stats.MeanDelayMs = (double)mDelaySum * 1000.0 / (double)mTicksPerSecond / (double)mApplied;
+	stats.MaxDelayMs = (double)mDelayMax * 1000.0 / (double)mTicksPerSecond;
+	return stats;
+}
+
+void ResizeScheduler::ResetStats()
+{
+	mRequests = 0;
+	mApplied = 0;
+	mCoalesced = 0;
+	mRedundant = 0;
+	mDelaySum = 0;
+	mDelayMax = 0;
+}
+
+std::vector<ResizeStressResult> ResizeScheduler::MeasureResize(uint32_t frameCount, double gpuLatencyMs)
+{
+	using Clock = std::chrono::steady_clock;
+
+	enum class Strategy { EveryRequest, PerFrame, Debounced };
+	const char* names[] = { "every-request", "per-frame", "debounced" };
+
+	// Bursts of dragging an edge, several WM_SIZE per frame, then a pause; every fourth pause maximizes or restores.
+	constexpr uint32_t BurstFrames = 40;
+	constexpr uint32_t RequestsPerFrame = 4;
+	constexpr uint32_t DepthFormat = 45;
+
+	std::vector<ResizeStressResult> results;
+	for (Strategy strategy : { Strategy::EveryRequest, Strategy::PerFrame, Strategy::Debounced })
+	{
+		// Frames are empty submissions; only the simulated GPU time keeps them in flight.
+		NullGpuQueue queue(gpuLatencyMs);
+		FrameRing<FrameContextBase> ring;
+		ring.Initialize(&queue, 3);
+
+		// Targets are ids; a pool miss stands for a placed resource allocation.
+		RenderTargetPool<uint32_t> pool;
+		pool.Initialize(&queue);
+		ResizeScheduler scheduler;
+		scheduler.Initialize(SystemClock::Frequency(), strategy == Strategy::Debounced ? ResizeScheduler::DefaultDebounceMs : 0.0);
+		scheduler.MarkApplied(1280, 720);
+
+		ResizeStressResult result = {};
+		result.Strategy = names[(uint32_t)strategy];
+
+		RenderTargetKey depthKey = pool.Bucket(1280, 720, DepthFormat);
+		uint32_t depth = 0;
+		uint32_t nextId = 1;
+		uint32_t restoredWidth = 1280;
+		uint32_t restoredHeight = 720;
+		bool maximized = false;
+
+		auto resize = [&](uint32_t width, uint32_t height)
+		{
+			// Like a swap chain resize, waits until the GPU is done with every frame in flight.
+			Clock::time_point stallBegin = Clock::now();
+			ring.WaitIdle();
+			result.StallMs += std::chrono::duration<double, std::milli>(Clock::now() - stallBegin).count();
+			result.Resizes++;
+
+			RenderTargetKey key = pool.Bucket(width, height, DepthFormat);
+			if (strategy == Strategy::EveryRequest)
+			{
+				// The queue is idle, so the old target is simply replaced.
+				depth = nextId++;
+				result.Allocations++;
+			}
+			else if (!(key == depthKey))
+			{
+				pool.Release(depthKey, std::move(depth), queue.LastSignaledValue());
+				if (!pool.Acquire(key, depth))
+				{
+					depth = nextId++;
+					result.Allocations++;
+				}
+				pool.Trim([](uint32_t&) {});
+			}
+			depthKey = key;
+		};
+
+		std::vector<double> samples;
+		samples.reserve(frameCount);
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			Clock::time_point begin = Clock::now();
+
+			uint32_t segment = frame / BurstFrames;
+			uint32_t inSegment = frame % BurstFrames;
+			if (segment % 2 == 0 && !maximized)
+			{
+				for (uint32_t i = 0; i < RequestsPerFrame; i++)
+				{
+					restoredWidth = 1280 + (inSegment * RequestsPerFrame + i) * 3;
+					restoredHeight = 720 + (inSegment * RequestsPerFrame + i);
+					result.Requests++;
+					if (strategy == Strategy::EveryRequest)
+						resize(restoredWidth, restoredHeight);
+					else
+						scheduler.Request(restoredWidth, restoredHeight, SystemClock::Now(), false);
+				}
+			}
+			else if (segment % 4 == 3 && inSegment == 0)
+			{
+				maximized = !maximized;
+				uint32_t width = maximized ? 1920 : restoredWidth;
+				uint32_t height = maximized ? 1080 : restoredHeight;
+				result.Requests++;
+				if (strategy == Strategy::EveryRequest)
+					resize(width, height);
+				else
+					scheduler.Request(width, height, SystemClock::Now(), true);
+			}
+
+			uint32_t width = 0;
+			uint32_t height = 0;
+			if (strategy != Strategy::EveryRequest && scheduler.Poll(SystemClock::Now(), width, height))
+				resize(width, height);
+
+			ring.BeginFrame();
+			ring.EndFrame();
+			samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+		}
+
+		RenderTargetPoolStats poolStats = pool.Stats();
+		result.PoolHits = poolStats.Hits;
+		pool.Clear([](uint32_t&) {});
+
+		if (!samples.empty())
+		{
+			double sum = 0.0;
+			for (double ms : samples)
+				sum += ms;
+			std::sort(samples.begin(), samples.end());
+
+			size_t p99 = (size_t)std::ceil(0.99 * (double)samples.size()) - 1;
+			result.MeanMs = sum / (double)samples.size();
+			result.P99Ms = samples[std::min(p99, samples.size() - 1)];
+			result.MaxMs = samples.back();
+		}
+		results.push_back(result);
+	}
+
+	return results;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct ResizeSchedulerStats
+{
+	uint64_t Requests = 0;
+	uint64_t Applied = 0;
+	/* Requests replaced by a later one before they were applied. */
+	uint64_t Coalesced = 0;
+	/* Due requests dropped because they asked for the size already applied. */
+	uint64_t Redundant = 0;
+	/* Request() of the applied size to the Poll() that returned it. */
+	double MeanDelayMs = 0.0;
+	double MaxDelayMs = 0.0;
+};
+
+struct ResizeStressResult
+{
+	const char* Strategy = "";
+	uint64_t Requests = 0;
+	/* Swap chain resizes, each of which waits for the frames in flight. */
+	uint64_t Resizes = 0;
+	/* Depth targets created, i.e. pool misses. */
+	uint64_t Allocations = 0;
+	uint64_t PoolHits = 0;
+	double StallMs = 0.0;
+	double MeanMs = 0.0;
+	double P99Ms = 0.0;
+	double MaxMs = 0.0;
+};
+
+/*
+	Collects window size changes and decides when the swap chain should follow.
+	The latest request replaces any pending one. Immediate requests (maximize,
+	restore, end of a drag) are due at the next Poll(); the others only once the
+	size has stayed unchanged for the debounce time, so dragging a window edge
+	costs a resize when the drag pauses rather than one per WM_SIZE.
+*/
+class ResizeScheduler
+{
+public:
+	static constexpr double DefaultDebounceMs = 60.0;
+
+	void Initialize(int64_t ticksPerSecond, double debounceMs = DefaultDebounceMs);
+
+	/* Zero sizes, i.e. minimized windows, are ignored. */
+	void Request(uint32_t width, uint32_t height, int64_t now, bool immediate);
+	bool HasPending() const { return mPending; }
+	/* Makes the pending request, if any, due at the next Poll(), e.g. when a drag ends. */
+	void Expedite() { mImmediate = mPending; }
+
+	/* True with the size to apply once the pending request is due; the size then counts as applied. */
+	bool Poll(int64_t now, uint32_t& width, uint32_t& height);
+	/* Records a size applied outside Poll(), e.g. at startup. */
+	void MarkApplied(uint32_t width, uint32_t height);
+
+	ResizeSchedulerStats Stats() const;
+	void ResetStats();
+
+	/*
+		Runs frameCount frames against a NullGpuQueue while a window is dragged in bursts and
+		flipped between two sizes, resizing on every request, once per frame, and debounced
+		with a depth target pool, and reports what each strategy cost.
+	*/
+	static std::vector<ResizeStressResult> MeasureResize(uint32_t frameCount, double gpuLatencyMs);
+
+private:
+	int64_t mTicksPerSecond = 1;
+	int64_t mDebounceTicks = 0;
+
+	bool mPending = false;
+	bool mImmediate = false;
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	/* Time of the first request since the last applied size, and of the latest one. */
+	int64_t mFirstRequest = 0;
+	int64_t mLastRequest = 0;
+
+	uint32_t mAppliedWidth = 0;
+	uint32_t mAppliedHeight = 0;
+
+	uint64_t mRequests = 0;
+	uint64_t mApplied = 0;
+	uint64_t mCoalesced = 0;
+	uint64_t mRedundant = 0;
+	int64_t mDelaySum = 0;
+	int64_t mDelayMax = 0;
+};
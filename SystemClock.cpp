@@ -0,0 +1,36 @@
+#include "SystemClock.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+int64_t SystemClock::Now()
+{
+#ifdef _WIN32
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return now.QuadPart;
+#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+int64_t SystemClock::Frequency()
+{
+#ifdef _WIN32
+	// Fixed at boot, so it is only queried once.
+	static const int64_t frequency = []
+	{
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+		return (int64_t)f.QuadPart;
+	}();
+	return frequency;
+#else
+	return 1000000000;
+#endif
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+	Monotonic tick source shared by GameTimer and the frame pacer:
+	QueryPerformanceCounter on Windows, CLOCK_MONOTONIC nanoseconds elsewhere.
+*/
+class SystemClock
+{
+public:
+	static int64_t Now();
+	static int64_t Frequency();
+};
@@ -0,0 +1,148 @@
+#include "UnitTest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "AdapterSelection.h"
+
+static const char* TestCachePath = "unit_test_adapters.bin";
+/* DXGI_FORMAT_R8G8B8A8_UNORM and DXGI_FORMAT_B8G8R8A8_UNORM. */
+static constexpr uint32_t Rgba8 = 28;
+static constexpr uint32_t Bgra8 = 87;
+
+static AdapterInfo Adapter(uint64_t luid, uint64_t dedicatedMB)
+{
+	AdapterInfo adapter;
+	adapter.Luid = luid;
+	adapter.DriverVersion = 0x001F00000000ABCDull;
+	adapter.VendorId = 0x10DE;
+	adapter.DeviceId = 0x2684;
+	adapter.DedicatedVideoMemory = dedicatedMB * 1024 * 1024;
+	adapter.Probed = true;
+	adapter.Caps.MaxFeatureLevel = 0xc100;
+	adapter.Caps.ResourceBindingTier = 3;
+	return adapter;
+}
+
+static AdapterCaps ProbedCaps()
+{
+	AdapterCaps caps;
+	caps.MaxFeatureLevel = 0xc200;
+	caps.HighestShaderModel = 0x67;
+	caps.ResourceBindingTier = 3;
+	caps.RaytracingTier = 11;
+	caps.MeshShaderTier = 10;
+	caps.MsaaSampleCounts = 0x1F;
+	caps.Msaa4xQualityLevels = 1;
+	return caps;
+}
+
+TEST(AdapterCacheRoundTripsThroughTheFile)
+{
+	AdapterInfo first = Adapter(0x1234, 16384);
+	AdapterInfo second = Adapter(0x5678, 512);
+	second.VendorId = 0x8086;
+
+	AdapterCapsCache cache;
+	cache.Store(first, Rgba8, ProbedCaps());
+	cache.Store(second, Rgba8, AdapterCaps());
+	CHECK(cache.IsDirty());
+	REQUIRE(cache.Save(TestCachePath));
+
+	AdapterCapsCache loaded;
+	loaded.Load(TestCachePath);
+	CHECK(!loaded.IsDirty());
+
+	AdapterCaps expected = ProbedCaps();
+	const AdapterCaps* caps = loaded.Find(first, Rgba8);
+	REQUIRE(caps != nullptr);
+	CHECK(memcmp(caps, &expected, sizeof(AdapterCaps)) == 0);
+	CHECK(loaded.Find(second, Rgba8) != nullptr);
+	// Caps depend on the probed format, so another format misses.
+	CHECK(loaded.Find(first, Bgra8) == nullptr);
+	CHECK(loaded.Stats().Hits == 2);
+	CHECK(loaded.Stats().Misses == 1);
+
+	std::remove(TestCachePath);
+}
+
+TEST(AdapterCacheMissesAfterADriverUpdate)
+{
+	AdapterInfo adapter = Adapter(0x1234, 8192);
+	AdapterCapsCache cache;
+	cache.Store(adapter, Rgba8, ProbedCaps());
+
+	adapter.DriverVersion++;
+	CHECK(cache.Find(adapter, Rgba8) == nullptr);
+	CHECK(cache.Stats().Stale == 1);
+
+	// Storing the new probe replaces the stale entry instead of adding one.
+	cache.Store(adapter, Rgba8, AdapterCaps());
+	REQUIRE(cache.Save(TestCachePath));
+	AdapterCapsCache loaded;
+	loaded.Load(TestCachePath);
+	CHECK(loaded.Find(adapter, Rgba8) != nullptr);
+	adapter.DriverVersion--;
+	CHECK(loaded.Find(adapter, Rgba8) == nullptr);
+
+	std::remove(TestCachePath);
+}
+
+TEST(AdapterCacheIgnoresBadFiles)
+{
+	AdapterCapsCache cache;
+	cache.Load("unit_test_missing.bin");
+	CHECK(cache.Find(Adapter(1, 1), Rgba8) == nullptr);
+
+	AdapterCapsCache written;
+	written.Store(Adapter(1, 1), Rgba8, ProbedCaps());
+	written.Store(Adapter(2, 1), Rgba8, ProbedCaps());
+	REQUIRE(written.Save(TestCachePath));
+
+	// Cut off inside the second entry: the header's count no longer matches the size.
+	std::string bytes;
+	{
+		std::ifstream file(TestCachePath, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	{
+		std::ofstream file(TestCachePath, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), (std::streamsize)bytes.size() - 8);
+	}
+	cache.Load(TestCachePath);
+	CHECK(cache.Find(Adapter(1, 1), Rgba8) == nullptr);
+
+	// A different version, e.g. from before AdapterCaps changed.
+	bytes[4]++;
+	{
+		std::ofstream file(TestCachePath, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), (std::streamsize)bytes.size());
+	}
+	cache.Load(TestCachePath);
+	CHECK(cache.Find(Adapter(1, 1), Rgba8) == nullptr);
+
+	std::remove(TestCachePath);
+}
+
+TEST(AdapterScoringPrefersMemoryThenFeatures)
+{
+	AdapterRequirements requirements;
+	std::vector<AdapterInfo> adapters = { Adapter(1, 2048), Adapter(2, 8192), Adapter(3, 8192) };
+	adapters[2].Caps.RaytracingTier = 10;
+	CHECK(AdapterScoring::Select(adapters, requirements) == 2);
+
+	// Ties keep DXGI's order.
+	adapters[2].Caps.RaytracingTier = 0;
+	CHECK(AdapterScoring::Select(adapters, requirements) == 1);
+
+	adapters[1].Software = true;
+	CHECK(AdapterScoring::Score(adapters[1], requirements) == 0);
+	requirements.RejectSoftware = true;
+	CHECK(AdapterScoring::Score(adapters[1], requirements) == -1);
+
+	requirements.MinFeatureLevel = 0xc200;
+	CHECK(AdapterScoring::Select(adapters, requirements) == AdapterScoring::InvalidAdapter);
+}
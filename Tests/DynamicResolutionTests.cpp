@@ -0,0 +1,129 @@
+#include "UnitTest.h"
+
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+#include "DynamicResolution.h"
+
+/* A trace of full resolution GPU times: frames of each phase's cost, one phase after the other. */
+static std::vector<double> Trace(std::initializer_list<std::pair<uint32_t, double>> phases)
+{
+	std::vector<double> trace;
+	for (const std::pair<uint32_t, double>& phase : phases)
+		trace.insert(trace.end(), phase.first, phase.second);
+	return trace;
+}
+
+static uint32_t OverBudget(const std::vector<DynamicResolutionSample>& samples, size_t first, size_t last, double budgetMs)
+{
+	uint32_t count = 0;
+	for (size_t i = first; i < last; i++)
+		count += samples[i].GpuMs > budgetMs ? 1 : 0;
+	return count;
+}
+
+TEST(DynamicResolutionKeepsFullResolutionWithinBudget)
+{
+	DynamicResolutionSettings settings;
+	std::vector<DynamicResolutionSample> samples = DynamicResolutionController::Replay(settings, Trace({ { 300, 9.0 } }), 3);
+
+	REQUIRE(samples.size() == 300);
+	bool full = true;
+	for (const DynamicResolutionSample& sample : samples)
+		full = full && sample.Scale == 1.0;
+	CHECK(full);
+}
+
+TEST(DynamicResolutionSettlesUnderBudgetForAHeavyScene)
+{
+	DynamicResolutionSettings settings;
+	std::vector<DynamicResolutionSample> samples = DynamicResolutionController::Replay(settings, Trace({ { 300, 32.0 } }), 3);
+
+	// Only the frames rendered before the first measurement arrived, and the one reacting to it, miss.
+	CHECK(OverBudget(samples, 0, samples.size(), settings.BudgetMs) <= 4);
+
+	// Settled: one scale, snapped to Step, inside the headroom.
+	double settled = samples.back().Scale;
+	bool steady = true;
+	for (size_t i = 100; i < samples.size(); i++)
+		steady = steady && samples[i].Scale == settled;
+	CHECK(steady);
+	CHECK(settled / settings.Step == (double)(int)(settled / settings.Step));
+	CHECK(samples.back().GpuMs <= settings.BudgetMs * settings.Headroom);
+	CHECK(samples.back().GpuMs > settings.BudgetMs * 0.75);
+}
+
+TEST(DynamicResolutionFollowsLoadChangesBothWays)
+{
+	DynamicResolutionSettings settings;
+	std::vector<DynamicResolutionSample> samples = DynamicResolutionController::Replay(settings,
+		Trace({ { 120, 10.0 }, { 240, 24.0 }, { 240, 10.0 } }), 3);
+
+	CHECK(samples[119].Scale == 1.0);
+	// The first miss to arrive drops the scale to fit it, so only the frames rendered before then miss.
+	CHECK(OverBudget(samples, 120, 360, settings.BudgetMs) == 3 + 1);
+	CHECK(samples[359].Scale < 0.85);
+	// Climbing back is gradual but gets there.
+	CHECK(samples[362].Scale < 1.0);
+	CHECK(samples.back().Scale == 1.0);
+	CHECK(OverBudget(samples, 360, 600, settings.BudgetMs) == 0);
+}
+
+TEST(DynamicResolutionRidesOutASingleSpike)
+{
+	DynamicResolutionSettings settings;
+	std::vector<DynamicResolutionSample> samples = DynamicResolutionController::Replay(settings,
+		Trace({ { 100, 8.0 }, { 1, 40.0 }, { 200, 8.0 } }), 3);
+
+	CHECK(samples[100].GpuMs == 40.0);
+	CHECK(samples[104].Scale < 1.0);
+	CHECK(samples.back().Scale == 1.0);
+	CHECK(OverBudget(samples, 0, samples.size(), settings.BudgetMs) == 1);
+}
+
+TEST(DynamicResolutionStopsAtMinScale)
+{
+	DynamicResolutionSettings settings;
+	settings.MinScale = 0.5;
+	std::vector<DynamicResolutionSample> samples = DynamicResolutionController::Replay(settings, Trace({ { 100, 200.0 } }), 0);
+
+	CHECK(samples.back().Scale == 0.5);
+	CHECK(samples.back().GpuMs == 50.0);
+}
+
+TEST(DynamicResolutionReplayIsDeterministic)
+{
+	DynamicResolutionSettings settings;
+	std::vector<double> trace;
+	for (uint32_t i = 0; i < 500; i++)
+		trace.push_back(12.0 + 10.0 * (double)((i * 7919) % 13) / 13.0);
+
+	std::vector<DynamicResolutionSample> first = DynamicResolutionController::Replay(settings, trace, 2);
+	std::vector<DynamicResolutionSample> second = DynamicResolutionController::Replay(settings, trace, 2);
+	bool same = true;
+	for (size_t i = 0; i < first.size(); i++)
+		same = same && first[i].Scale == second[i].Scale && first[i].GpuMs == second[i].GpuMs;
+	CHECK(same);
+
+	// Measurements arrive two frames late, so the first two frames render at MaxScale.
+	CHECK(first[0].Scale == 1.0 && first[1].Scale == 1.0);
+}
+
+TEST(DynamicResolutionControllerIgnoresInvalidMeasurements)
+{
+	DynamicResolutionController controller;
+	controller.Initialize(DynamicResolutionSettings());
+
+	CHECK(controller.Update(0.0, 1.0) == 1.0);
+	CHECK(controller.Update(20.0, 0.0) == 1.0);
+	CHECK(controller.Stats().Frames == 0);
+
+	controller.Update(64.0, 1.0);
+	uint32_t width = 0;
+	uint32_t height = 0;
+	controller.ScaledSize(1920, 1080, width, height);
+	CHECK(width == 960 && height == 540);
+	controller.ScaledSize(0, 0, width, height);
+	CHECK(width == 1 && height == 1);
+}
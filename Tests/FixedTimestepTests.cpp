@@ -0,0 +1,103 @@
+#include "UnitTest.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include "FixedTimestep.h"
+
+/* A 10 MHz clock, like QPC on most Windows machines; 60 Hz does not divide it. */
+static constexpr int64_t Qpc = 10000000;
+
+TEST(FixedTimestepAccumulatesWithoutDrift)
+{
+	FixedTimestep timestep(Qpc, 60.0);
+
+	// An hour of 144 Hz frames; 1/144 s is not a whole number of ticks either, so frames alternate like a real clock's.
+	uint64_t steps = 0;
+	int64_t elapsed = 0;
+	for (uint32_t frame = 0; frame < 144 * 3600; frame++)
+	{
+		int64_t frameTicks = Qpc / 144 + (frame % 9 < 4 ? 1 : 0);
+		steps += timestep.Advance(frameTicks);
+		elapsed += frameTicks;
+	}
+
+	// Exactly the whole steps in the elapsed time, and the simulation is less than a step behind it.
+	CHECK(steps == timestep.StepIndex());
+	CHECK(steps == (uint64_t)(elapsed * 60 / Qpc));
+	CHECK(timestep.SimulationTicks() <= elapsed);
+	CHECK(elapsed - timestep.SimulationTicks() < Qpc / 60 + 1);
+	CHECK(timestep.Stats().ClampedFrames == 0);
+}
+
+TEST(FixedTimestepKeepsFractionalRatesExact)
+{
+	FixedTimestep timestep(Qpc, 59.94);
+
+	for (uint32_t frame = 0; frame < 70000; frame++)
+		timestep.Advance(Qpc / 100);
+
+	CHECK(timestep.StepIndex() == 41958);
+	CHECK(timestep.Alpha() == 0.0);
+	CHECK(timestep.SimulationTicks() == 700 * Qpc);
+}
+
+TEST(FixedTimestepCarriesTheFractionIntoAlpha)
+{
+	FixedTimestep timestep(1000, 100.0);
+
+	CHECK(timestep.Advance(15) == 1);
+	CHECK(timestep.Alpha() == 0.5);
+	CHECK(timestep.InterpolatedSeconds() == 0.005);
+	CHECK(timestep.Advance(5) == 1);
+	CHECK(timestep.Alpha() == 0.0);
+
+	// A rate change keeps the simulation time reached so far.
+	timestep.SetRate(50.0);
+	CHECK(timestep.Advance(20) == 1);
+	CHECK(timestep.SimulationTicks() == 40);
+	CHECK(timestep.Advance(-5) == 0);
+}
+
+TEST(FixedTimestepClampsALongFrame)
+{
+	FixedTimestep timestep(Qpc, 60.0, 8);
+
+	timestep.Advance(Qpc / 120);
+	double alpha = timestep.Alpha();
+
+	// Ten seconds behind, e.g. after a breakpoint: eight steps run and the rest is dropped.
+	const int64_t frameTicks = 10 * Qpc;
+	CHECK(timestep.Advance(frameTicks) == 8);
+
+	const FixedTimestepStats& stats = timestep.Stats();
+	CHECK(stats.ClampedFrames == 1);
+	CHECK(stats.MaxStepsInFrame == 8);
+	int64_t expectedDropped = frameTicks - 8 * Qpc / 60;
+	CHECK(stats.DroppedTicks > expectedDropped - Qpc / 60 && stats.DroppedTicks <= expectedDropped);
+	// Only whole steps are dropped, so the fraction owed before the stall carries over.
+	CHECK(timestep.Alpha() >= alpha && timestep.Alpha() < alpha + 0.01);
+
+	CHECK(timestep.Advance(Qpc / 60) == 1);
+	CHECK(timestep.Stats().ClampedFrames == 1);
+}
+
+TEST(FixedTimestepDoesNotOverflowAtTheLimits)
+{
+	const int64_t longest = std::numeric_limits<int64_t>::max();
+
+	// Nanosecond ticks at the lowest and highest rates, with the catch-up limit requested above its maximum.
+	for (double rate : { 0.001, 60.0, 1000000.0 })
+	{
+		FixedTimestep timestep(1000000000, rate, 1u << 20);
+		CHECK(timestep.Advance(longest) == FixedTimestep::MaxStepsPerFrameLimit);
+		CHECK(timestep.Advance(longest) == FixedTimestep::MaxStepsPerFrameLimit);
+		CHECK(timestep.Alpha() >= 0.0 && timestep.Alpha() < 1.0);
+		CHECK(timestep.Stats().ClampedFrames == 2);
+		CHECK(timestep.SimulationTicks() > 0);
+	}
+
+	FixedTimestep timestep(Qpc, 60.0);
+	timestep.SetMaxStepsPerFrame(0);
+	CHECK(timestep.Advance(longest) == 1);
+}
@@ -0,0 +1,116 @@
+#include "UnitTest.h"
+
+#include <cmath>
+#include "FramePacer.h"
+
+/* Nanosecond clock that only moves when the pacer sleeps or spins, or when the test advances it. */
+class TestPacerClock : public PacerClock
+{
+public:
+	int64_t Now() override { return Time; }
+	int64_t Frequency() const override { return 1000000000; }
+	void Sleep(int64_t ticks) override { Time += ticks + SleepOvershoot; Sleeps++; }
+	void Spin() override { Time += 1000; }
+
+	int64_t Time = 0;
+	int64_t SleepOvershoot = 0;
+	uint32_t Sleeps = 0;
+};
+
+static constexpr int64_t Ms = 1000000;
+
+/* Spins advance the clock 1 us at a time, so a wake-up may land up to one spin past its deadline. */
+static bool WokeAt(const TestPacerClock& clock, int64_t deadline)
+{
+	return clock.Time >= deadline && clock.Time < deadline + 1000;
+}
+
+TEST(FramePacerPacesAClockStartingAtZero)
+{
+	TestPacerClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetFps(100.0);
+
+	// The first frame starts at once, and at tick 0 that must not read as "not started" on the next.
+	CHECK(pacer.Wait() == 0);
+	CHECK(pacer.Wait() == 10 * Ms);
+	CHECK(clock.Time == 10 * Ms);
+	CHECK(pacer.Stats().Missed == 0);
+}
+
+TEST(FramePacerDeadlinesDoNotDrift)
+{
+	TestPacerClock clock;
+	clock.Time = 5 * Ms;
+	clock.SleepOvershoot = Ms / 2;
+	FramePacer pacer(clock);
+	pacer.SetTargetFps(60.0);
+
+	const int64_t interval = std::llround(1000000000.0 / 60.0);
+	pacer.Wait();
+	for (int64_t frame = 1; frame <= 100; frame++)
+	{
+		clock.Time += 3 * Ms;
+		pacer.Wait();
+		// Sleeps overshoot by 0.5 ms and the spin window absorbs it.
+		int64_t deadline = 5 * Ms + frame * interval;
+		CHECK(WokeAt(clock, deadline));
+	}
+
+	FramePacerStats stats = pacer.Stats();
+	CHECK(clock.Sleeps == 100);
+	CHECK(stats.Missed == 0);
+	CHECK(stats.MaxErrorUs < 1.0);
+	CHECK(std::fabs(stats.MeanIntervalMs - 1000.0 / 60.0) < 0.001);
+}
+
+TEST(FramePacerRestartsTheScheduleAfterAMiss)
+{
+	TestPacerClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetFps(100.0);
+
+	pacer.Wait();
+	clock.Time += 25 * Ms;
+	CHECK(pacer.Wait() == 0);
+	CHECK(pacer.Stats().Missed == 1);
+
+	// The next deadline follows the late frame, not the missed ones.
+	clock.Time += 2 * Ms;
+	CHECK(pacer.Wait() == 8 * Ms);
+	CHECK(clock.Time == 35 * Ms);
+}
+
+TEST(FramePacerResetStartsTheNextFrameAtOnce)
+{
+	TestPacerClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetFps(100.0);
+
+	pacer.Wait();
+	pacer.Wait();
+	pacer.Reset();
+	CHECK(pacer.Wait() == 0);
+	CHECK(pacer.Stats().Missed == 0);
+	// The interval across the reset is not counted.
+	CHECK(pacer.Stats().MeanIntervalMs == 10.0);
+}
+
+TEST(FramePacerAlignsToEveryDivisorthVblank)
+{
+	TestPacerClock clock;
+	FramePacer pacer(clock);
+	const int64_t period = 16 * Ms;
+	pacer.SetVsync(period, 3 * Ms, 2);
+
+	pacer.Wait();
+	CHECK(WokeAt(clock, 3 * Ms));
+	pacer.Wait();
+	CHECK(WokeAt(clock, 3 * Ms + 2 * period));
+
+	// A phase update between frames snaps the next deadline to the nearest new vblank.
+	pacer.UpdateVsync(period, 4 * Ms);
+	pacer.Wait();
+	CHECK(WokeAt(clock, 4 * Ms + 4 * period));
+	CHECK(pacer.TargetFps() == 1000.0 / 32.0);
+}
@@ -0,0 +1,80 @@
+#include "UnitTest.h"
+
+#include "FrameRing.h"
+#include "ManualFence.h"
+
+TEST(FrameRingDoesNotWaitUntilItWraps)
+{
+	ManualFence fence;
+	FrameRing<FrameContextBase> ring;
+	ring.Initialize(&fence, 3);
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		ring.BeginFrame();
+		ring.EndFrame();
+	}
+
+	CHECK(fence.Waits == 0);
+	CHECK(ring.Stats().Stalls == 0);
+	CHECK(ring.FramesInFlight() == 3);
+	CHECK(ring.CurrentIndex() == 0);
+}
+
+TEST(FrameRingWaitsForTheOldestFrameOnWrap)
+{
+	ManualFence fence;
+	FrameRing<FrameContextBase> ring;
+	ring.Initialize(&fence, 2);
+
+	ring.BeginFrame();
+	ring.EndFrame();
+	ring.BeginFrame();
+	ring.EndFrame();
+
+	// The GPU has not finished frame 1, so reusing its context blocks on exactly its fence value.
+	FrameContextBase& context = ring.BeginFrame();
+	CHECK(fence.Waits == 1);
+	CHECK(fence.CompletedValue() == 1);
+	CHECK(context.FenceValue == 1);
+	ring.EndFrame();
+
+	CHECK(ring.Stats().Stalls == 1);
+	CHECK(ring.Stats().Frames == 3);
+	CHECK(ring.Stats().MaxFramesInFlight == 2);
+}
+
+TEST(FrameRingSkipsTheWaitForRetiredFrames)
+{
+	ManualFence fence;
+	FrameRing<FrameContextBase> ring;
+	ring.Initialize(&fence, 2);
+
+	for (uint32_t i = 0; i < 10; i++)
+	{
+		ring.BeginFrame();
+		ring.EndFrame();
+		fence.Complete(fence.LastSignaledValue());
+	}
+
+	CHECK(fence.Waits == 0);
+	CHECK(ring.Stats().Stalls == 0);
+	CHECK(ring.FramesInFlight() == 0);
+}
+
+TEST(FrameRingWaitIdleRetiresEveryFrame)
+{
+	ManualFence fence;
+	FrameRing<FrameContextBase> ring;
+	ring.Initialize(&fence, 4);
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		ring.BeginFrame();
+		ring.EndFrame();
+	}
+	ring.WaitIdle();
+
+	CHECK(fence.CompletedValue() == 4);
+	CHECK(ring.FramesInFlight() == 0);
+}
@@ -0,0 +1,165 @@
+#include "UnitTest.h"
+
+#include <cstring>
+#include <vector>
+#include "GpuBreadcrumbs.h"
+
+/* The breadcrumb buffer as the GPU left it: tests write the slot values a hang would have stopped at. */
+struct BreadcrumbBuffer
+{
+	std::vector<uint32_t> Values = std::vector<uint32_t>(GpuBreadcrumbs::Capacity * GpuBreadcrumbs::SlotValues, 0);
+
+	void Set(uint32_t slot, uint32_t started, uint32_t finished)
+	{
+		Values[slot * GpuBreadcrumbs::SlotValues + GpuBreadcrumbs::StartedValue] = started;
+		Values[slot * GpuBreadcrumbs::SlotValues + GpuBreadcrumbs::FinishedValue] = finished;
+	}
+};
+
+static bool Named(const char* name, const char* expected)
+{
+	return name && strcmp(name, expected) == 0;
+}
+
+TEST(GpuBreadcrumbsNumbersBeginsAndEndsInOneSequence)
+{
+	GpuBreadcrumbs breadcrumbs;
+	breadcrumbs.BeginSubmission("Frame", 0);
+	CHECK(breadcrumbs.BeginMarker("Outer") == 1);
+	CHECK(breadcrumbs.BeginMarker("Inner") == 2);
+	CHECK(breadcrumbs.EndMarker() == 3);
+	CHECK(breadcrumbs.EndMarker() == 4);
+	CHECK(breadcrumbs.EndMarker() == 0);
+}
+
+TEST(GpuBreadcrumbsLocatesAHangInsideAParentAfterItsChildFinished)
+{
+	GpuBreadcrumbs breadcrumbs;
+	BreadcrumbBuffer buffer;
+	uint32_t slot = breadcrumbs.BeginSubmission("Frame", 7);
+	breadcrumbs.BeginMarker("Lighting");
+	uint32_t started = breadcrumbs.BeginMarker("Shadows");
+	uint32_t finished = breadcrumbs.EndMarker();
+	breadcrumbs.EndMarker();
+	breadcrumbs.Submit(1);
+
+	// Shadows began and ended, then the GPU hung in the rest of Lighting; the finished value is now past the started one.
+	buffer.Set(slot, started, finished);
+	std::vector<BreadcrumbFault> faults = breadcrumbs.Correlate(buffer.Values.data());
+
+	REQUIRE(faults.size() == 1);
+	CHECK(faults[0].Frame == 7);
+	CHECK(faults[0].State == BreadcrumbFault::Progress::InMarker);
+	CHECK(Named(faults[0].LastStarted, "Lighting"));
+	CHECK(Named(faults[0].LastFinished, "Shadows"));
+}
+
+TEST(GpuBreadcrumbsLocatesAHangInsideANestedMarker)
+{
+	GpuBreadcrumbs breadcrumbs;
+	BreadcrumbBuffer buffer;
+	uint32_t slot = breadcrumbs.BeginSubmission("Frame", 0);
+	breadcrumbs.BeginMarker("Lighting");
+	uint32_t started = breadcrumbs.BeginMarker("Shadows");
+	breadcrumbs.EndMarker();
+	breadcrumbs.EndMarker();
+	breadcrumbs.Submit(1);
+
+	buffer.Set(slot, started, 0);
+	std::vector<BreadcrumbFault> faults = breadcrumbs.Correlate(buffer.Values.data());
+
+	REQUIRE(faults.size() == 1);
+	CHECK(faults[0].State == BreadcrumbFault::Progress::InMarker);
+	CHECK(Named(faults[0].LastStarted, "Shadows"));
+	CHECK(faults[0].LastFinished == nullptr);
+}
+
+TEST(GpuBreadcrumbsTellsAHangBetweenMarkers)
+{
+	GpuBreadcrumbs breadcrumbs;
+	BreadcrumbBuffer buffer;
+	uint32_t slot = breadcrumbs.BeginSubmission("Frame", 0);
+	breadcrumbs.BeginMarker("GBuffer");
+	breadcrumbs.BeginMarker("Opaque");
+	breadcrumbs.EndMarker();
+	breadcrumbs.EndMarker();
+	uint32_t started = breadcrumbs.BeginMarker("Post");
+	uint32_t finished = breadcrumbs.EndMarker();
+	breadcrumbs.BeginMarker("UI");
+	breadcrumbs.EndMarker();
+	breadcrumbs.Submit(1);
+
+	buffer.Set(slot, started, finished);
+	std::vector<BreadcrumbFault> faults = breadcrumbs.Correlate(buffer.Values.data());
+
+	REQUIRE(faults.size() == 1);
+	CHECK(faults[0].State == BreadcrumbFault::Progress::BetweenMarkers);
+	CHECK(Named(faults[0].LastStarted, "Post"));
+	CHECK(Named(faults[0].LastFinished, "Post"));
+	CHECK(faults[0].MarkerCount == 4);
+}
+
+TEST(GpuBreadcrumbsReportsOnlyUnfinishedSubmissions)
+{
+	GpuBreadcrumbs breadcrumbs;
+	BreadcrumbBuffer buffer;
+	for (uint64_t frame = 0; frame < 3; frame++)
+	{
+		breadcrumbs.BeginSubmission("Frame", frame);
+		breadcrumbs.BeginMarker("Pass");
+		breadcrumbs.EndMarker();
+		breadcrumbs.Submit(frame + 1);
+	}
+	// A removed device reports UINT64_MAX; the last value seen before it is what counts.
+	breadcrumbs.SetCompletedValue(1);
+	breadcrumbs.SetCompletedValue(UINT64_MAX);
+
+	std::vector<BreadcrumbFault> faults = breadcrumbs.Correlate(buffer.Values.data());
+	REQUIRE(faults.size() == 2);
+	CHECK(faults[0].Frame == 1 && faults[1].Frame == 2);
+	CHECK(faults[0].State == BreadcrumbFault::Progress::NotStarted);
+	CHECK(faults[0].LastStarted == nullptr && faults[0].LastFinished == nullptr);
+	CHECK(breadcrumbs.Overruns() == 0);
+}
+
+TEST(GpuBreadcrumbsClampsGarbageSlotValues)
+{
+	GpuBreadcrumbs breadcrumbs;
+	BreadcrumbBuffer buffer;
+	uint32_t slot = breadcrumbs.BeginSubmission("Frame", 0);
+	breadcrumbs.BeginMarker("Only");
+	breadcrumbs.EndMarker();
+	breadcrumbs.Submit(1);
+
+	buffer.Set(slot, 0xFFFFFFFFu, 0xDEADBEEFu);
+	std::vector<BreadcrumbFault> faults = breadcrumbs.Correlate(buffer.Values.data());
+
+	REQUIRE(faults.size() == 1);
+	CHECK(faults[0].State == BreadcrumbFault::Progress::BetweenMarkers);
+	CHECK(Named(faults[0].LastFinished, "Only"));
+}
+
+TEST(GpuBreadcrumbsStopsNumberingWhenOutOfMarkers)
+{
+	GpuBreadcrumbs breadcrumbs;
+	breadcrumbs.BeginSubmission("Frame", 0);
+	for (uint32_t i = 0; i < GpuBreadcrumbs::MaxMarkers; i++)
+	{
+		breadcrumbs.BeginMarker("Pass");
+		breadcrumbs.EndMarker();
+	}
+
+	// Unrecorded markers write nothing, and still pair up with their ends.
+	CHECK(breadcrumbs.BeginMarker("Outer") == 0);
+	CHECK(breadcrumbs.BeginMarker("Inner") == 0);
+	CHECK(breadcrumbs.EndMarker() == 0);
+	CHECK(breadcrumbs.EndMarker() == 0);
+
+	breadcrumbs.BeginSubmission("Frame", 1);
+	CHECK(breadcrumbs.BeginMarker("Pass") == 1);
+}
+
+TEST(GpuBreadcrumbsOverheadRunLocatesItsHang)
+{
+	CHECK(GpuBreadcrumbs::MeasureOverhead(1000).HangLocated);
+}
@@ -0,0 +1,162 @@
+#include "UnitTest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "InputQueue.h"
+
+static InputEvent Move(int32_t x, int32_t y)
+{
+	InputEvent event;
+	event.Type = InputEventType::MouseMove;
+	event.X = x;
+	event.Y = y;
+	return event;
+}
+
+static InputEvent Key(uint32_t code)
+{
+	InputEvent event;
+	event.Type = InputEventType::Key;
+	event.Code = code;
+	event.X = 1;
+	return event;
+}
+
+TEST(InputQueueCoalescesMovesUntilAnotherEvent)
+{
+	InputQueue queue;
+	InputEvent out[8];
+
+	InputEvent first = Move(1, 2);
+	first.Ticks = 100;
+	queue.Push(first);
+	queue.Push(Move(3, 4));
+	CHECK(queue.HasPending());
+	CHECK(queue.Drain(out, 8) == 0);
+
+	queue.Push(Key(65));
+	REQUIRE(queue.Drain(out, 8) == 2);
+	CHECK(out[0].X == 4 && out[0].Y == 6);
+	CHECK(out[0].Merged == 2);
+	CHECK(out[0].Ticks == 100);
+	CHECK(out[1].Type == InputEventType::Key && out[1].Code == 65);
+
+	InputQueueStats stats = queue.Stats();
+	CHECK(stats.RawEvents == 3);
+	CHECK(stats.Coalesced == 1);
+	CHECK(stats.Drains == 2);
+	CHECK(stats.MaxDepth == 2);
+}
+
+TEST(InputQueueDropsWhenFull)
+{
+	InputQueue queue;
+	for (uint32_t i = 0; i < InputQueue::Capacity + 10; i++)
+		queue.Push(Key(i));
+
+	std::vector<InputEvent> out(InputQueue::Capacity);
+	CHECK(queue.Drain(out.data(), (uint32_t)out.size()) == InputQueue::Capacity);
+	CHECK(out.back().Code == InputQueue::Capacity - 1);
+	CHECK(queue.Stats().Dropped == 10);
+
+	// The ring has room again once drained.
+	queue.Push(Key(1));
+	CHECK(queue.Drain(out.data(), 1) == 1);
+}
+
+TEST(InputQueueResetStatsCountsFromANewBaseline)
+{
+	InputQueue queue;
+	InputEvent out[4];
+	queue.Push(Move(1, 0));
+	queue.Push(Move(1, 0));
+	queue.Flush();
+	queue.Drain(out, 4);
+
+	queue.ResetStats();
+	InputQueueStats stats = queue.Stats();
+	CHECK(stats.RawEvents == 0 && stats.Coalesced == 0 && stats.Dropped == 0);
+	CHECK(stats.Drains == 0 && stats.MaxDepth == 0);
+
+	queue.Push(Key(1));
+	queue.Drain(out, 4);
+	stats = queue.Stats();
+	CHECK(stats.RawEvents == 1);
+	CHECK(stats.Coalesced == 0);
+	CHECK(stats.Events == 1);
+}
+
+TEST(InputQueueHandsEventsAcrossThreads)
+{
+	constexpr uint32_t Keys = 20000;
+	constexpr uint32_t MovesPerKey = 3;
+
+	InputQueue queue;
+	// Test-side back pressure keeps the producer within the ring, so nothing is dropped and every event can be checked.
+	std::atomic<uint64_t> published{ 0 };
+	std::atomic<uint64_t> consumed{ 0 };
+	std::atomic<bool> done{ false };
+
+	std::thread producer([&]
+	{
+		for (uint32_t key = 0; key < Keys; key++)
+		{
+			while (published.load() - consumed.load() > InputQueue::Capacity / 2)
+				std::this_thread::yield();
+
+			for (uint32_t i = 0; i < MovesPerKey; i++)
+				queue.Push(Move(1, -1));
+			queue.Push(Key(key));
+			published += 2;
+		}
+		queue.Flush();
+		done = true;
+	});
+
+	uint32_t nextKey = 0;
+	uint64_t merged = 0;
+	int64_t x = 0;
+	bool reset = false;
+	bool ordered = true;
+	InputEvent out[64];
+	for (;;)
+	{
+		bool finished = done.load();
+		uint32_t count = queue.Drain(out, 64);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			merged += out[i].Merged;
+			if (out[i].Type == InputEventType::MouseMove)
+				x += out[i].X;
+			else if (out[i].Code == nextKey)
+				nextKey++;
+			else
+				ordered = false;
+		}
+		consumed += count;
+
+		// Resetting while the producer is still pushing must not lose or corrupt its counts.
+		if (!reset && nextKey >= Keys / 2)
+		{
+			queue.ResetStats();
+			reset = true;
+		}
+		if (finished && count == 0)
+			break;
+	}
+	producer.join();
+
+	CHECK(ordered);
+	CHECK(nextKey == Keys);
+	CHECK(x == (int64_t)Keys * MovesPerKey);
+	CHECK(merged == (uint64_t)Keys * (MovesPerKey + 1));
+
+	InputQueueStats stats = queue.Stats();
+	CHECK(reset);
+	CHECK(stats.Dropped == 0);
+	// Only what was pushed after the reset, about half of it.
+	CHECK(stats.RawEvents > 0 && stats.RawEvents < (uint64_t)Keys * (MovesPerKey + 1));
+	CHECK(stats.Coalesced <= stats.RawEvents);
+	CHECK(stats.Events <= stats.RawEvents);
+}
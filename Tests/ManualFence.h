@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include "FrameRing.h"
+
+/*
+	FrameSync whose GPU only makes progress when the test says so, through
+	Complete(), or when the CPU blocks on it, which completes up to the value waited for.
+*/
+class ManualFence : public FrameSync
+{
+public:
+	uint64_t Signal() override { return ++mSignaled; }
+	uint64_t CompletedValue() const override { return mCompleted; }
+	uint64_t LastSignaledValue() const override { return mSignaled; }
+
+	void WaitForValue(uint64_t value) override
+	{
+		Waits++;
+		if (value > mCompleted)
+			mCompleted = value;
+	}
+
+	/* Completes every signal up to and including value. */
+	void Complete(uint64_t value)
+	{
+		if (value > mCompleted)
+			mCompleted = value;
+	}
+
+	uint32_t Waits = 0;
+
+private:
+	uint64_t mSignaled = 0;
+	uint64_t mCompleted = 0;
+};
@@ -0,0 +1,73 @@
+#include "UnitTest.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "PackFile.h"
+
+static const char* TestPackPath = "unit_test.dxpk";
+
+static std::vector<PackFile::Source> TestSources()
+{
+	return { { "a", std::vector<uint8_t>(100, 1) }, { "b", std::vector<uint8_t>(5000, 2) }, { "c", std::vector<uint8_t>(1, 3) } };
+}
+
+/* Overwrites sizeof(T) bytes of the pack at offset with value. */
+template <typename T>
+static void Patch(uint64_t offset, const T& value)
+{
+	std::fstream file(TestPackPath, std::ios::binary | std::ios::in | std::ios::out);
+	file.seekp((std::streamoff)offset);
+	file.write((const char*)&value, sizeof(T));
+}
+
+TEST(PackFileRoundTripsAlignedPayloads)
+{
+	REQUIRE(PackFile::Write(TestPackPath, TestSources()));
+
+	PackFile pack;
+	REQUIRE(pack.Open(TestPackPath));
+	CHECK(pack.EntryCount() == 3);
+
+	uint32_t b = pack.Find("b");
+	REQUIRE(b != PackFile::InvalidEntry);
+	CHECK(pack.Entry(b).Size == 5000);
+	CHECK(pack.Entry(b).Offset % PackFile::DefaultAlignment == 0);
+	CHECK(pack.Data(b)[4999] == 2);
+	CHECK(pack.Find("d") == PackFile::InvalidEntry);
+
+	pack.Close();
+	std::remove(TestPackPath);
+}
+
+TEST(PackFileRejectsABadAlignment)
+{
+	for (uint32_t alignment : { 0u, 3000u })
+	{
+		REQUIRE(PackFile::Write(TestPackPath, TestSources()));
+		Patch(offsetof(PackHeader, Alignment), alignment);
+
+		PackFile pack;
+		CHECK(!pack.Open(TestPackPath));
+		CHECK(!pack.IsOpen());
+	}
+	std::remove(TestPackPath);
+}
+
+TEST(PackFileRejectsAMisalignedEntry)
+{
+	REQUIRE(PackFile::Write(TestPackPath, TestSources()));
+
+	PackFile pack;
+	REQUIRE(pack.Open(TestPackPath));
+	PackEntry entry = pack.Entry(1);
+	pack.Close();
+
+	// Still inside the file and past the index, only off the payload alignment.
+	entry.Offset += 8;
+	Patch(sizeof(PackHeader) + sizeof(PackEntry), entry);
+	CHECK(!pack.Open(TestPackPath));
+
+	std::remove(TestPackPath);
+}
@@ -0,0 +1,168 @@
+#include "UnitTest.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "RenderThread.h"
+
+/*
+	A blocking call from the render thread that only the window thread can answer,
+	like SendMessage() to a window, or DXGI waiting on the window from Present().
+*/
+class SentCall
+{
+public:
+	void Send()
+	{
+		uint32_t call = mSent.fetch_add(1) + 1;
+		while (mHandled.load() < call)
+			std::this_thread::yield();
+	}
+
+	void Handle() { mHandled.store(mSent.load()); }
+
+private:
+	std::atomic<uint32_t> mSent{ 0 };
+	std::atomic<uint32_t> mHandled{ 0 };
+};
+
+/* Records what the render thread was asked to do; only touched from that thread until Stop() returns. */
+class TestRenderClient : public RenderThreadClient
+{
+public:
+	void OnRenderThreadStarted() override { StartedOn = std::this_thread::get_id(); }
+
+	void ApplyWindowCommand(const WindowCommand& command) override
+	{
+		if (std::this_thread::get_id() != StartedOn)
+			WrongThread = true;
+		if (command.Type == WindowCommandType::Key && command.Param == ThrowOnKey)
+			throw std::runtime_error("device removed");
+		Commands.push_back(command);
+	}
+
+	bool RenderFrame() override
+	{
+		if (Sends)
+			Sends->Send();
+		Frames++;
+		return Busy;
+	}
+
+	void OnRenderThreadFailed() override { FailureReported = true; }
+
+	bool Busy = true;
+	uint32_t ThrowOnKey = ~0u;
+	SentCall* Sends = nullptr;
+
+	std::thread::id StartedOn;
+	bool WrongThread = false;
+	bool FailureReported = false;
+	std::vector<WindowCommand> Commands;
+	uint64_t Frames = 0;
+};
+
+static WindowCommand KeyCommand(uint32_t key)
+{
+	WindowCommand command;
+	command.Type = WindowCommandType::Key;
+	command.Param = key;
+	return command;
+}
+
+TEST(RenderThreadAppliesCommandsInOrderOnItsThread)
+{
+	TestRenderClient client;
+	RenderThread thread;
+	thread.Start(&client);
+
+	WindowCommand size;
+	size.Type = WindowCommandType::Size;
+	size.Width = 1280;
+	size.Height = 720;
+	thread.Post(size);
+	for (uint32_t key = 0; key < 1000; key++)
+		thread.Post(KeyCommand(key));
+	thread.Stop();
+
+	CHECK(!thread.IsRunning());
+	CHECK(client.StartedOn != std::this_thread::get_id());
+	CHECK(!client.WrongThread);
+	REQUIRE(client.Commands.size() == 1001);
+	CHECK(client.Commands[0].Type == WindowCommandType::Size && client.Commands[0].Width == 1280);
+	bool ordered = true;
+	for (uint32_t key = 0; key < 1000; key++)
+		ordered = ordered && client.Commands[key + 1].Param == key;
+	CHECK(ordered);
+	CHECK(thread.Stats().Commands == 1001);
+	CHECK(thread.Stats().Frames == client.Frames);
+}
+
+TEST(RenderThreadSleepsWhileIdleAndWakesForCommands)
+{
+	TestRenderClient client;
+	client.Busy = false;
+	RenderThread thread;
+	thread.Start(&client);
+
+	for (uint32_t key = 0; key < 10; key++)
+	{
+		thread.Post(KeyCommand(key));
+		std::this_thread::yield();
+	}
+	thread.Stop();
+
+	CHECK(client.Commands.size() == 10);
+	CHECK(thread.Stats().IdleWaits >= 1);
+	CHECK(thread.Stats().Frames == 0);
+}
+
+TEST(RenderThreadStopRethrowsItsFailure)
+{
+	TestRenderClient client;
+	client.ThrowOnKey = 3;
+	RenderThread thread;
+	thread.Start(&client);
+
+	// Posts after the failure must not block on a queue nobody drains any more.
+	for (uint32_t key = 0; key < 2 * WindowCommandQueue::Capacity; key++)
+		thread.Post(KeyCommand(key));
+
+	bool rethrown = false;
+	try { thread.Stop(); }
+	catch (const std::runtime_error&) { rethrown = true; }
+
+	CHECK(rethrown);
+	CHECK(thread.Failed());
+	CHECK(client.FailureReported);
+	CHECK(client.Commands.size() == 3);
+	CHECK(!thread.IsRunning());
+}
+
+TEST(RenderThreadWaitsServeCallsFromTheRenderThread)
+{
+	SentCall sends;
+	TestRenderClient client;
+	client.Sends = &sends;
+	RenderThread thread;
+
+	// Every frame blocks until the window thread answers, so a full queue in Post() and the wait in Stop()
+	// only finish because the callback keeps answering.
+	uint32_t waits = 0;
+	thread.SetWaitCallback([&]
+	{
+		sends.Handle();
+		waits++;
+		std::this_thread::yield();
+	});
+	thread.Start(&client);
+
+	for (uint32_t key = 0; key < 4 * WindowCommandQueue::Capacity; key++)
+		thread.Post(KeyCommand(key));
+	thread.Stop();
+
+	CHECK(client.Commands.size() == 4 * WindowCommandQueue::Capacity);
+	CHECK(client.Frames > 0);
+	CHECK(waits > 0);
+}
@@ -0,0 +1,130 @@
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "TlsfAllocator.h"
+
+static constexpr uint64_t KB = 1024;
+
+TEST(TlsfRoundsAllocationsUpToTheGranularity)
+{
+	TlsfAllocator tlsf;
+	tlsf.Initialize(1024 * KB, 64 * KB);
+
+	TlsfAllocator::Allocation a = tlsf.Allocate(1, 1);
+	TlsfAllocator::Allocation b = tlsf.Allocate(65 * KB, 1);
+
+	REQUIRE(a.IsValid() && b.IsValid());
+	CHECK(a.Offset == 0 && a.Size == 64 * KB);
+	CHECK(b.Offset == 64 * KB && b.Size == 128 * KB);
+	CHECK(tlsf.UsedBytes() == 192 * KB);
+	CHECK(tlsf.AllocationCount() == 2);
+}
+
+TEST(TlsfAlignsAndKeepsThePaddingFree)
+{
+	TlsfAllocator tlsf;
+	tlsf.Initialize(1024 * KB, 64 * KB);
+
+	tlsf.Allocate(64 * KB, 64 * KB);
+	TlsfAllocator::Allocation aligned = tlsf.Allocate(64 * KB, 256 * KB);
+
+	REQUIRE(aligned.IsValid());
+	CHECK(aligned.Offset == 256 * KB);
+	// The 192 KB skipped for alignment, and the rest of the heap after the allocation.
+	CHECK(tlsf.FreeBlockCount() == 2);
+
+	TlsfAllocator::Allocation padding = tlsf.Allocate(192 * KB, 64 * KB);
+	CHECK(padding.Offset == 64 * KB);
+}
+
+TEST(TlsfCoalescesNeighboursOnFree)
+{
+	TlsfAllocator tlsf;
+	tlsf.Initialize(1024 * KB, 64 * KB);
+
+	TlsfAllocator::Allocation a = tlsf.Allocate(256 * KB, 1);
+	TlsfAllocator::Allocation b = tlsf.Allocate(256 * KB, 1);
+	TlsfAllocator::Allocation c = tlsf.Allocate(256 * KB, 1);
+
+	tlsf.Free(b.Handle);
+	CHECK(tlsf.FreeBlockCount() == 2);
+	CHECK(tlsf.LargestFreeBytes() == 256 * KB);
+
+	// Merges with b on its right.
+	tlsf.Free(a.Handle);
+	CHECK(tlsf.FreeBlockCount() == 2);
+	CHECK(tlsf.LargestFreeBytes() == 512 * KB);
+
+	// Merges with a + b on its left and the tail of the heap on its right.
+	tlsf.Free(c.Handle);
+	CHECK(tlsf.FreeBlockCount() == 1);
+	CHECK(tlsf.LargestFreeBytes() == 1024 * KB);
+	CHECK(tlsf.IsEmpty());
+	CHECK(tlsf.UsedBytes() == 0);
+}
+
+TEST(TlsfServesAnExactFitAndThenFails)
+{
+	TlsfAllocator tlsf;
+	tlsf.Initialize(1000 * KB, 1 * KB);
+
+	// 1000 units is not a class boundary, so this is only found by searching the request's own class.
+	TlsfAllocator::Allocation all = tlsf.Allocate(1000 * KB, 1);
+	REQUIRE(all.IsValid());
+	CHECK(all.Offset == 0);
+	CHECK(!tlsf.Allocate(1 * KB, 1).IsValid());
+
+	tlsf.Free(all.Handle);
+	CHECK(tlsf.Allocate(1000 * KB, 1).IsValid());
+}
+
+TEST(TlsfRandomAllocationsNeverOverlap)
+{
+	TlsfAllocator tlsf;
+	tlsf.Initialize(64 * 1024 * KB, 64 * KB);
+
+	std::mt19937 random(1234);
+	std::vector<TlsfAllocator::Allocation> live;
+
+	for (uint32_t i = 0; i < 20000; i++)
+	{
+		if (live.empty() || random() % 3 != 0)
+		{
+			uint64_t size = (random() % 2048 + 1) * KB;
+			uint64_t alignment = 64 * KB << (random() % 4);
+			TlsfAllocator::Allocation allocation = tlsf.Allocate(size, alignment);
+			if (allocation.IsValid())
+			{
+				CHECK(allocation.Offset % alignment == 0);
+				CHECK(allocation.Size >= size);
+				CHECK(allocation.Offset + allocation.Size <= tlsf.Size());
+				live.push_back(allocation);
+			}
+		}
+		else
+		{
+			size_t index = random() % live.size();
+			tlsf.Free(live[index].Handle);
+			live[index] = live.back();
+			live.pop_back();
+		}
+	}
+
+	std::sort(live.begin(), live.end(), [](const TlsfAllocator::Allocation& a, const TlsfAllocator::Allocation& b) { return a.Offset < b.Offset; });
+	uint64_t used = 0;
+	for (size_t i = 0; i < live.size(); i++)
+	{
+		used += live[i].Size;
+		if (i > 0)
+			CHECK(live[i - 1].Offset + live[i - 1].Size <= live[i].Offset);
+	}
+	CHECK(tlsf.UsedBytes() == used);
+	CHECK(tlsf.AllocationCount() == live.size());
+
+	for (const TlsfAllocator::Allocation& allocation : live)
+		tlsf.Free(allocation.Handle);
+	CHECK(tlsf.FreeBlockCount() == 1);
+	CHECK(tlsf.LargestFreeBytes() == tlsf.Size());
+}
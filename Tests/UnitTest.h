@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+	Minimal self-registering test harness for the platform-independent units.
+	TEST(Name) defines a test, CHECK(expression) records a failure and carries on,
+	REQUIRE(expression) records a failure and leaves the current test.
+*/
+
+namespace UnitTests
+{
+	using TestFunction = void(*)();
+
+	struct Registration
+	{
+		Registration(const char* name, TestFunction function);
+	};
+
+	void ReportFailure(const char* file, int line, const char* expression);
+}
+
+#define TEST(name) \
+	static void name(); \
+	static UnitTests::Registration name##Registration(#name, name); \
+	static void name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) UnitTests::ReportFailure(__FILE__, __LINE__, #expression); } while (false)
+
+#define REQUIRE(expression) \
+	do { if (!(expression)) { UnitTests::ReportFailure(__FILE__, __LINE__, #expression); return; } } while (false)
@@ -0,0 +1,60 @@
+#include "UnitTest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	struct RegisteredTest
+	{
+		const char* Name;
+		UnitTests::TestFunction Function;
+	};
+
+	// Function-local so registrations from other translation units never see it uninitialized.
+	std::vector<RegisteredTest>& Registry()
+	{
+		static std::vector<RegisteredTest> tests;
+		return tests;
+	}
+
+	int sFailures = 0;
+}
+
+UnitTests::Registration::Registration(const char* name, TestFunction function)
+{
+	Registry().push_back({ name, function });
+}
+
+void UnitTests::ReportFailure(const char* file, int line, const char* expression)
+{
+	std::printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+	sFailures++;
+}
+
+/* unit_tests [filter]: runs every test whose name contains filter. Returns 1 if any check failed. */
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : "";
+
+	int run = 0;
+	int failed = 0;
+	for (const RegisteredTest& test : Registry())
+	{
+		if (!std::strstr(test.Name, filter))
+			continue;
+
+		int failuresBefore = sFailures;
+		test.Function();
+		run++;
+
+		bool passed = sFailures == failuresBefore;
+		if (!passed)
+			failed++;
+		std::printf("[%s] %s\n", passed ? "  OK  " : " FAIL ", test.Name);
+	}
+
+	std::printf("%d tests, %d failed\n", run, failed);
+	return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include "UnitTest.h"
+
+#include <vector>
+#include "UploadRing.h"
+#include "ManualFence.h"
+
+TEST(UploadRingAlignsAllocations)
+{
+	ManualFence fence;
+	std::vector<uint8_t> memory(4096);
+	UploadRing ring;
+	ring.Initialize(&fence, memory.size(), memory.data());
+
+	UploadAllocation first = ring.Allocate(10, 1);
+	UploadAllocation second = ring.Allocate(16, 256);
+
+	CHECK(first.Offset == 0);
+	CHECK(second.Offset == 256);
+	CHECK(second.CpuAddress == memory.data() + 256);
+	// The padding before the second allocation counts as used until the frame retires.
+	CHECK(ring.Stats().Used == 256 + 16);
+}
+
+TEST(UploadRingWrapsAroundOntoRetiredFrames)
+{
+	ManualFence fence;
+	UploadRing ring;
+	ring.Initialize(&fence, 1024, nullptr);
+
+	CHECK(ring.Allocate(600, 1).Offset == 0);
+	ring.FinishFrame(fence.Signal());
+	CHECK(ring.Allocate(300, 1).Offset == 600);
+	ring.FinishFrame(fence.Signal());
+	fence.Complete(1);
+
+	// 200 bytes do not fit in the 124 left before the end, so the allocation starts over at 0, in frame 1's memory.
+	UploadAllocation wrapped = ring.Allocate(200, 1);
+	CHECK(wrapped.Offset == 0);
+	CHECK(fence.Waits == 0);
+	CHECK(ring.Stats().Stalls == 0);
+	// Frame 2's 300 bytes, the skipped 124 and the new 200.
+	CHECK(ring.Stats().Used == 624);
+}
+
+TEST(UploadRingWaitsForTheGpuWhenFull)
+{
+	ManualFence fence;
+	UploadRing ring;
+	ring.Initialize(&fence, 1024, nullptr);
+
+	ring.Allocate(600, 1);
+	ring.FinishFrame(fence.Signal());
+	ring.Allocate(300, 1);
+	ring.FinishFrame(fence.Signal());
+
+	CHECK(!ring.TryAllocate(200, 1).IsValid());
+	CHECK(fence.Waits == 0);
+
+	UploadAllocation allocation = ring.Allocate(200, 1);
+	CHECK(allocation.Offset == 0);
+	CHECK(fence.Waits == 1);
+	CHECK(fence.CompletedValue() == 1);
+	CHECK(ring.Stats().Stalls == 1);
+}
+
+TEST(UploadRingRetireReclaimsCompletedFrames)
+{
+	ManualFence fence;
+	UploadRing ring;
+	ring.Initialize(&fence, 1024, nullptr);
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		ring.Allocate(100, 1);
+		ring.FinishFrame(fence.Signal());
+	}
+	fence.Complete(2);
+	ring.Retire();
+
+	CHECK(ring.Stats().Used == 100);
+	CHECK(ring.Stats().HighWaterMark == 300);
+	CHECK(ring.Stats().PeakFrameBytes == 100);
+}
+
+TEST(UploadRingFailsAllocationsItCanNeverServe)
+{
+	ManualFence fence;
+	UploadRing ring;
+	ring.Initialize(&fence, 1024, nullptr);
+
+	CHECK(!ring.Allocate(2048, 1).IsValid());
+
+	// The current frame already holds everything, and waiting on the GPU would not free any of it.
+	CHECK(ring.Allocate(1000, 1).IsValid());
+	CHECK(!ring.Allocate(100, 1).IsValid());
+	CHECK(fence.Waits == 0);
+	CHECK(ring.Stats().Failures == 2);
+}
@@ -0,0 +1,272 @@
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+void TlsfAllocator::Initialize(uint64_t size, uint64_t granularity)
+{
+	assert(granularity != 0 && (granularity & (granularity - 1)) == 0 && "Granularity must be a power of two");
+
+	mGranularity = granularity;
+	mUnits = size / granularity;
+	mUsedUnits = 0;
+	mFreeBlocks = 0;
+	mAllocations = 0;
+
+	mBlocks.clear();
+	mUnusedBlocks.clear();
+	mFirstLevelBitmap = 0;
+	for (uint32_t fl = 0; fl < FirstLevelCount; fl++)
+	{
+		mSecondLevelBitmap[fl] = 0;
+		for (uint32_t sl = 0; sl < SecondLevelCount; sl++)
+			mFreeHeads[fl][sl] = InvalidHandle;
+	}
+
+	if (mUnits == 0)
+		return;
+
+	uint32_t block = NewBlock();
+	mBlocks[block].Offset = 0;
+	mBlocks[block].Units = mUnits;
+	InsertFree(block);
+}
+
+TlsfAllocator::Allocation TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	uint64_t units = std::max<uint64_t>((size + mGranularity - 1) / mGranularity, 1);
+	uint64_t alignUnits = std::max<uint64_t>(alignment / mGranularity, 1);
+
+	// Ask for enough room to align the start of whatever block comes back.
+	uint32_t block = FindFree(units + alignUnits - 1);
+	if (block == InvalidHandle)
+		return {};
+
+	RemoveFree(block);
+
+	uint64_t offset = mBlocks[block].Offset;
+	uint64_t padding = ((offset + alignUnits - 1) / alignUnits) * alignUnits - offset;
+	if (padding > 0)
+	{
+		uint32_t aligned = Split(block, padding);
+		InsertFree(block);
+		block = aligned;
+	}
+
+	if (mBlocks[block].Units > units)
+	{
+		uint32_t remainder = Split(block, units);
+		InsertFree(remainder);
+	}
+
+	mUsedUnits += mBlocks[block].Units;
+	mAllocations++;
+
+	Allocation allocation;
+	allocation.Offset = mBlocks[block].Offset * mGranularity;
+	allocation.Size = mBlocks[block].Units * mGranularity;
+	allocation.Handle = block;
+	return allocation;
+}
+
+void TlsfAllocator::Free(uint32_t handle)
+{
+	assert(handle < mBlocks.size() && !mBlocks[handle].Free && "Invalid or already freed allocation");
+
+	mUsedUnits -= mBlocks[handle].Units;
+	mAllocations--;
+
+	uint32_t block = handle;
+
+	uint32_t prev = mBlocks[block].PrevPhysical;
+	if (prev != InvalidHandle && mBlocks[prev].Free)
+	{
+		RemoveFree(prev);
+		block = Merge(prev, block);
+	}
+
+	uint32_t next = mBlocks[block].NextPhysical;
+	if (next != InvalidHandle && mBlocks[next].Free)
+	{
+		RemoveFree(next);
+		block = Merge(block, next);
+	}
+
+	InsertFree(block);
+}
+
+uint64_t TlsfAllocator::LargestFreeBytes() const
+{
+	if (mFirstLevelBitmap == 0)
+		return 0;
+
+	uint32_t fl = 63 - (uint32_t)std::countl_zero(mFirstLevelBitmap);
+	uint32_t sl = 31 - (uint32_t)std::countl_zero(mSecondLevelBitmap[fl]);
+
+	uint64_t largest = 0;
+	for (uint32_t block = mFreeHeads[fl][sl]; block != InvalidHandle; block = mBlocks[block].NextFree)
+		largest = std::max(largest, mBlocks[block].Units);
+	return largest * mGranularity;
+}
+
+void TlsfAllocator::Mapping(uint64_t units, uint32_t& fl, uint32_t& sl)
+{
+	if (units < SecondLevelCount)
+	{
+		// Small sizes get one exact list each.
+		fl = 0;
+		sl = (uint32_t)units;
+		return;
+	}
+
+	uint32_t msb = (uint32_t)std::bit_width(units) - 1;
+	fl = msb - SecondLevelLog2 + 1;
+	sl = (uint32_t)(units >> (msb - SecondLevelLog2)) - SecondLevelCount;
+}
+
+uint64_t TlsfAllocator::RoundUpToClass(uint64_t units)
+{
+	if (units < SecondLevelCount)
+		return units;
+
+	uint32_t msb = (uint32_t)std::bit_width(units) - 1;
+	uint64_t step = 1ull << (msb - SecondLevelLog2);
+	return units + step - 1;
+}
+
+uint32_t TlsfAllocator::NewBlock()
+{
+	if (!mUnusedBlocks.empty())
+	{
+		uint32_t block = mUnusedBlocks.back();
+		mUnusedBlocks.pop_back();
+		mBlocks[block] = {};
+		return block;
+	}
+
+	mBlocks.push_back({});
+	return (uint32_t)mBlocks.size() - 1;
+}
+
+void TlsfAllocator::ReleaseBlock(uint32_t block)
+{
+	mBlocks[block] = {};
+	mUnusedBlocks.push_back(block);
+}
+
+void TlsfAllocator::InsertFree(uint32_t block)
+{
+	uint32_t fl, sl;
+	Mapping(mBlocks[block].Units, fl, sl);
+
+	uint32_t head = mFreeHeads[fl][sl];
+	mBlocks[block].PrevFree = InvalidHandle;
+	mBlocks[block].NextFree = head;
+	mBlocks[block].Free = true;
+	if (head != InvalidHandle)
+		mBlocks[head].PrevFree = block;
+
+	mFreeHeads[fl][sl] = block;
+	mSecondLevelBitmap[fl] |= 1u << sl;
+	mFirstLevelBitmap |= 1ull << fl;
+	mFreeBlocks++;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t block)
+{
+	uint32_t fl, sl;
+	Mapping(mBlocks[block].Units, fl, sl);
+
+	Block& b = mBlocks[block];
+	if (b.PrevFree != InvalidHandle)
+		mBlocks[b.PrevFree].NextFree = b.NextFree;
+	if (b.NextFree != InvalidHandle)
+		mBlocks[b.NextFree].PrevFree = b.PrevFree;
+
+	if (mFreeHeads[fl][sl] == block)
+	{
+		mFreeHeads[fl][sl] = b.NextFree;
+		if (b.NextFree == InvalidHandle)
+		{
+			mSecondLevelBitmap[fl] &= ~(1u << sl);
+			if (mSecondLevelBitmap[fl] == 0)
+				mFirstLevelBitmap &= ~(1ull << fl);
+		}
+	}
+
+	b.PrevFree = InvalidHandle;
+	b.NextFree = InvalidHandle;
+	b.Free = false;
+	mFreeBlocks--;
+}
+
+uint32_t TlsfAllocator::FindFree(uint64_t units) const
+{
+	uint32_t fl, sl;
+	Mapping(RoundUpToClass(units), fl, sl);
+	if (fl >= FirstLevelCount)
+		return FindInClass(units);
+
+	uint32_t slMap = sl < SecondLevelCount ? mSecondLevelBitmap[fl] & (~0u << sl) : 0;
+	if (slMap == 0)
+	{
+		uint64_t flMap = fl + 1 < 64 ? mFirstLevelBitmap & (~0ull << (fl + 1)) : 0;
+		if (flMap == 0)
+			return FindInClass(units);
+
+		fl = (uint32_t)std::countr_zero(flMap);
+		slMap = mSecondLevelBitmap[fl];
+	}
+
+	sl = (uint32_t)std::countr_zero(slMap);
+	return mFreeHeads[fl][sl];
+}
+
+uint32_t TlsfAllocator::FindInClass(uint64_t units) const
+{
+	// Last resort: the request's own class may still hold a block that is big
+	// enough, e.g. a heap sized exactly for one resource.
+	uint32_t fl, sl;
+	Mapping(units, fl, sl);
+	if (fl >= FirstLevelCount)
+		return InvalidHandle;
+
+	for (uint32_t block = mFreeHeads[fl][sl]; block != InvalidHandle; block = mBlocks[block].NextFree)
+	{
+		if (mBlocks[block].Units >= units)
+			return block;
+	}
+	return InvalidHandle;
+}
+
+uint32_t TlsfAllocator::Split(uint32_t block, uint64_t units)
+{
+	// NewBlock() may grow mBlocks, so only hold indices across it.
+	uint32_t rest = NewBlock();
+
+	mBlocks[rest].Offset = mBlocks[block].Offset + units;
+	mBlocks[rest].Units = mBlocks[block].Units - units;
+	mBlocks[rest].PrevPhysical = block;
+	mBlocks[rest].NextPhysical = mBlocks[block].NextPhysical;
+
+	if (mBlocks[rest].NextPhysical != InvalidHandle)
+		mBlocks[mBlocks[rest].NextPhysical].PrevPhysical = rest;
+
+	mBlocks[block].Units = units;
+	mBlocks[block].NextPhysical = rest;
+	return rest;
+}
+
+uint32_t TlsfAllocator::Merge(uint32_t left, uint32_t right)
+{
+	mBlocks[left].Units += mBlocks[right].Units;
+	mBlocks[left].NextPhysical = mBlocks[right].NextPhysical;
+	if (mBlocks[left].NextPhysical != InvalidHandle)
+		mBlocks[mBlocks[left].NextPhysical].PrevPhysical = left;
+
+	ReleaseBlock(right);
+	return left;
+}
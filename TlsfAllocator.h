@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/*
+	Two-level segregated fit allocator over an abstract range of memory.
+	Works in units of Granularity bytes; with 64 KB units a 256 MB heap is only
+	4096 units, so the free lists stay short and every operation is O(1).
+	Only offsets are managed here, the memory itself is owned by the caller.
+*/
+class TlsfAllocator
+{
+public:
+	static constexpr uint32_t InvalidHandle = ~0u;
+
+	struct Allocation
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		/* Pass back to Free(). */
+		uint32_t Handle = InvalidHandle;
+
+		bool IsValid() const { return Handle != InvalidHandle; }
+	};
+
+	void Initialize(uint64_t size, uint64_t granularity);
+
+	/* alignment must be a power of two. Returns an invalid allocation when no block fits. */
+	Allocation Allocate(uint64_t size, uint64_t alignment);
+	void Free(uint32_t handle);
+
+	uint64_t Size() const { return mUnits * mGranularity; }
+	uint64_t UsedBytes() const { return mUsedUnits * mGranularity; }
+	uint64_t LargestFreeBytes() const;
+	uint32_t FreeBlockCount() const { return mFreeBlocks; }
+	uint32_t AllocationCount() const { return mAllocations; }
+	bool IsEmpty() const { return mAllocations == 0; }
+
+private:
+	static constexpr uint32_t SecondLevelLog2 = 4;
+	static constexpr uint32_t SecondLevelCount = 1u << SecondLevelLog2;
+	static constexpr uint32_t FirstLevelCount = 40;
+
+	struct Block
+	{
+		uint64_t Offset = 0;
+		uint64_t Units = 0;
+		uint32_t PrevPhysical = InvalidHandle;
+		uint32_t NextPhysical = InvalidHandle;
+		uint32_t PrevFree = InvalidHandle;
+		uint32_t NextFree = InvalidHandle;
+		bool Free = false;
+	};
+
+	static void Mapping(uint64_t units, uint32_t& fl, uint32_t& sl);
+	static uint64_t RoundUpToClass(uint64_t units);
+
+	uint32_t NewBlock();
+	void ReleaseBlock(uint32_t block);
+	void InsertFree(uint32_t block);
+	void RemoveFree(uint32_t block);
+	uint32_t FindFree(uint64_t units) const;
+	uint32_t FindInClass(uint64_t units) const;
+	uint32_t Split(uint32_t block, uint64_t units);
+	uint32_t Merge(uint32_t left, uint32_t right);
+
+	std::vector<Block> mBlocks;
+	std::vector<uint32_t> mUnusedBlocks;
+
+	uint64_t mFirstLevelBitmap = 0;
+	uint32_t mSecondLevelBitmap[FirstLevelCount] = {};
+	uint32_t mFreeHeads[FirstLevelCount][SecondLevelCount] = {};
+
+	uint64_t mGranularity = 1;
+	uint64_t mUnits = 0;
+	uint64_t mUsedUnits = 0;
+	uint32_t mFreeBlocks = 0;
+	uint32_t mAllocations = 0;
+};
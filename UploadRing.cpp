@@ -0,0 +1,118 @@
+#include "UploadRing.h"
+
+#include <cassert>
+
+void UploadRing::Initialize(FrameSync* sync, uint64_t capacity, void* mappedBase)
+{
+	mSync = sync;
+	mBase = (uint8_t*)mappedBase;
+	mCapacity = capacity;
+	mTail = 0;
+	mUsed = 0;
+	mFrameBytes = 0;
+	mPendingHead = 0;
+	mPendingCount = 0;
+
+	mStats = {};
+	mStats.Capacity = capacity;
+}
+
+UploadAllocation UploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+	return Allocate(size, alignment, true);
+}
+
+UploadAllocation UploadRing::TryAllocate(uint64_t size, uint64_t alignment)
+{
+	return Allocate(size, alignment, false);
+}
+
+UploadAllocation UploadRing::Allocate(uint64_t size, uint64_t alignment, bool wait)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	if (size > mCapacity)
+	{
+		mStats.Failures++;
+		return {};
+	}
+
+	uint64_t offset = (mTail + alignment - 1) & ~(alignment - 1);
+	if (offset + size > mCapacity)
+	{
+		// Does not fit before the end: skip the remainder and start over at 0.
+		offset = 0;
+	}
+	uint64_t needed = (offset >= mTail ? offset - mTail : mCapacity - mTail) + size;
+
+	bool stalled = false;
+	while (mCapacity - mUsed < needed)
+	{
+		if (mPendingCount == 0)
+		{
+			// Everything in use belongs to the current frame.
+			mStats.Failures++;
+			return {};
+		}
+
+		bool completed = mSync->CompletedValue() >= mPending[mPendingHead].FenceValue;
+		if (!completed && !wait)
+			return {};
+		stalled |= !completed;
+		RetireOldest(!completed);
+	}
+
+	if (stalled)
+		mStats.Stalls++;
+
+	mTail = offset + size;
+	if (mTail == mCapacity)
+		mTail = 0;
+
+	mUsed += needed;
+	mFrameBytes += needed;
+
+	mStats.Allocations++;
+	mStats.Used = mUsed;
+	if (mUsed > mStats.HighWaterMark)
+		mStats.HighWaterMark = mUsed;
+
+	UploadAllocation allocation;
+	allocation.Offset = offset;
+	allocation.Size = size;
+	allocation.CpuAddress = mBase ? mBase + offset : nullptr;
+	return allocation;
+}
+
+void UploadRing::FinishFrame(uint64_t fenceValue)
+{
+	if (mPendingCount == MaxPendingFrames)
+		RetireOldest(true);
+
+	if (mFrameBytes > mStats.PeakFrameBytes)
+		mStats.PeakFrameBytes = mFrameBytes;
+
+	mPending[(mPendingHead + mPendingCount) % MaxPendingFrames] = { fenceValue, mFrameBytes };
+	mPendingCount++;
+	mFrameBytes = 0;
+}
+
+void UploadRing::Retire()
+{
+	uint64_t completed = mSync->CompletedValue();
+	while (mPendingCount > 0 && mPending[mPendingHead].FenceValue <= completed)
+		RetireOldest(false);
+}
+
+void UploadRing::RetireOldest(bool wait)
+{
+	const PendingFrame& frame = mPending[mPendingHead];
+	if (wait)
+		mSync->WaitForValue(frame.FenceValue);
+
+	mUsed -= frame.Bytes;
+	mStats.Used = mUsed;
+
+	mPendingHead = (mPendingHead + 1) % MaxPendingFrames;
+	mPendingCount--;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include "FrameRing.h"
+
+struct UploadAllocation
+{
+	static constexpr uint64_t InvalidOffset = ~0ull;
+
+	uint64_t Offset = InvalidOffset;
+	uint64_t Size = 0;
+	/* Null if the ring was initialized without a mapped base. */
+	void* CpuAddress = nullptr;
+
+	bool IsValid() const { return Offset != InvalidOffset; }
+};
+
+struct UploadRingStats
+{
+	uint64_t Capacity = 0;
+	uint64_t Used = 0;
+	/* Highest Used ever observed, padding included. Size the ring from this. */
+	uint64_t HighWaterMark = 0;
+	/* Largest amount allocated by a single frame. */
+	uint64_t PeakFrameBytes = 0;
+	uint64_t Allocations = 0;
+	/* Allocations that had to wait for the GPU to retire a frame. */
+	uint64_t Stalls = 0;
+	/* Allocations that could not be served: larger than the whole ring, or the current frame alone already fills it. */
+	uint64_t Failures = 0;
+};
+
+/*
+	Linear allocator over one persistently mapped buffer, used as a ring.
+	Memory allocated during a frame is reclaimed once the fence value passed
+	to FinishFrame() for that frame has completed. No heap allocations.
+*/
+class UploadRing
+{
+public:
+	static constexpr uint32_t MaxPendingFrames = 16;
+
+	UploadRing() = default;
+	UploadRing(const UploadRing&) = delete;
+	UploadRing& operator=(const UploadRing&) = delete;
+
+	void Initialize(FrameSync* sync, uint64_t capacity, void* mappedBase);
+
+	/* alignment must be a power of two. Waits on the fence if the ring is full. */
+	UploadAllocation Allocate(uint64_t size, uint64_t alignment);
+	/* Like Allocate(), but returns an invalid allocation instead of waiting on the fence. */
+	UploadAllocation TryAllocate(uint64_t size, uint64_t alignment);
+
+	/* Closes the current frame; its memory is reclaimed once fenceValue completes. */
+	void FinishFrame(uint64_t fenceValue);
+
+	/* Reclaims every frame whose fence value has completed. */
+	void Retire();
+
+	const UploadRingStats& Stats() const { return mStats; }
+
+private:
+	struct PendingFrame
+	{
+		uint64_t FenceValue;
+		uint64_t Bytes;
+	};
+
+	UploadAllocation Allocate(uint64_t size, uint64_t alignment, bool wait);
+	void RetireOldest(bool wait);
+
+	FrameSync* mSync = nullptr;
+	uint8_t* mBase = nullptr;
+	uint64_t mCapacity = 0;
+	uint64_t mTail = 0;
+	uint64_t mUsed = 0;
+	uint64_t mFrameBytes = 0;
+
+	PendingFrame mPending[MaxPendingFrames] = {};
+	uint32_t mPendingHead = 0;
+	uint32_t mPendingCount = 0;
+
+	UploadRingStats mStats;
+};
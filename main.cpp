@@ -1,13 +1,140 @@
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "dwmapi.lib")
 
+#include <cwchar>
 #include "DXRenderer.h"
 #include "DXException.h"
 
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow)
 {
+	// -recordbench <draws>: recording time versus number of recording threads.
+	UINT draws = 0;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-recordbench %u", &draws) == 1)
+	{
+		return DXRenderer::RunRecordBenchmark(draws, "record_scaling.csv");
+	}
+
+	// -jobbench <jobs>: job system throughput on fine-grained jobs.
+	UINT jobs = 0;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-jobbench %u", &jobs) == 1)
+	{
+		return DXRenderer::RunJobBenchmark(jobs, "job_throughput.csv");
+	}
+
+	// -graphbench <passes>: render graph compile time and barrier schedule.
+	UINT passes = 0;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-graphbench %u", &passes) == 1)
+	{
+		return DXRenderer::RunGraphBenchmark(passes, "render_graph_compile.csv", "render_graph_schedule.txt");
+	}
+
+	// -streambench <MB> [entryKB]: pack file streaming throughput.
+	UINT streamMB = 0;
+	UINT entryKB = 4;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-streambench %u %u", &streamMB, &entryKB) >= 1)
+	{
+		return DXRenderer::RunStreamBenchmark(streamMB, entryKB, "stream_benchmark.pack", "stream_throughput.csv");
+	}
+
+	// -streampack <path>: streaming throughput of an existing pack file, read from disk.
+	wchar_t streamPack[MAX_PATH] = L"";
+	if (pCmdLine && swscanf_s(pCmdLine, L"-streampack %259ls", streamPack, (unsigned)_countof(streamPack)) == 1)
+	{
+		char packPath[MAX_PATH] = "";
+		WideCharToMultiByte(CP_UTF8, 0, streamPack, -1, packPath, MAX_PATH, nullptr, nullptr);
+		return DXRenderer::RunStreamBenchmark(0, 1, packPath, "stream_throughput.csv");
+	}
+
+	// -psobench <pipelines>: pipeline cache cold versus warm start.
+	UINT pipelines = 0;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-psobench %u", &pipelines) == 1)
+	{
+		return DXRenderer::RunPipelineBenchmark(pipelines, "pipeline_bench_cache.bin", "pipeline_cache.csv");
+	}
+
+	// -zonebench <zones>: CPU profiler zone overhead.
+	UINT zones = 0;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-zonebench %u", &zones) == 1)
+	{
+		return DXRenderer::RunZoneBenchmark(zones, "cpu_zone_overhead.csv");
+	}
+
+	// -pacebench <fps> [frames]: frame pacer wake-up accuracy.
+	double paceFps = 0.0;
+	UINT paceFrames = 600;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-pacebench %lf %u", &paceFps, &paceFrames) >= 1)
+	{
+		return DXRenderer::RunPaceBenchmark(paceFps, paceFrames, "frame_pacing.csv");
+	}
+
+	// -resizebench <frames> [gpuLatencyMs]: resize strategies during a simulated window drag.
+	UINT resizeFrames = 0;
+	double resizeLatencyMs = 2.0;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-resizebench %u %lf", &resizeFrames, &resizeLatencyMs) >= 1)
+	{
+		return DXRenderer::RunResizeBenchmark(resizeFrames, resizeLatencyMs, "resize_stress.csv");
+	}
+
+	// -breadcrumbbench <markers>: CPU cost of a GPU breadcrumb marker.
+	UINT breadcrumbMarkers = 0;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-breadcrumbbench %u", &breadcrumbMarkers) >= 1)
+	{
+		return DXRenderer::RunBreadcrumbBenchmark(breadcrumbMarkers, "breadcrumbs.csv");
+	}
+
+	// -logbench <messages>: cost of a log call on the writing thread.
+	UINT logMessages = 0;
+	if (pCmdLine && swscanf_s(pCmdLine, L"-logbench %u", &logMessages) >= 1)
+	{
+		return DXRenderer::RunLogBenchmark(logMessages, "log_overhead.csv");
+	}
+
+	// -dynresbench <budgetMs> [trace]: replays GPU frame times, one per line, through the dynamic resolution controller.
+	double dynresBudgetMs = 0.0;
+	wchar_t dynresTrace[MAX_PATH] = L"";
+	if (pCmdLine && swscanf_s(pCmdLine, L"-dynresbench %lf %259ls", &dynresBudgetMs, dynresTrace, (unsigned)_countof(dynresTrace)) >= 1)
+	{
+		char tracePath[MAX_PATH] = "";
+		WideCharToMultiByte(CP_UTF8, 0, dynresTrace, -1, tracePath, MAX_PATH, nullptr, nullptr);
+		return DXRenderer::RunDynamicResolutionBenchmark(dynresBudgetMs, tracePath, "dynres.csv");
+	}
+
+	// The options below can be combined.
+	// -latency <frames>: maximum number of presents DXGI may queue.
+	UINT maxFrameLatency = 1;
+	const wchar_t* option = pCmdLine ? wcsstr(pCmdLine, L"-latency") : nullptr;
+	if (option)
+		swscanf_s(option, L"-latency %u", &maxFrameLatency);
+
+	// -fps <rate>: caps the frame rate. -vsyncpace [divisor]: starts frames on every divisor-th vblank.
+	double targetFps = 60.0;
+	UINT vsyncDivisor = 1;
+	FramePacingMode pacing = FramePacingMode::Unlimited;
+	if ((option = pCmdLine ? wcsstr(pCmdLine, L"-fps") : nullptr) && swscanf_s(option, L"-fps %lf", &targetFps) == 1)
+		pacing = FramePacingMode::TargetFps;
+	if ((option = pCmdLine ? wcsstr(pCmdLine, L"-vsyncpace") : nullptr))
+	{
+		swscanf_s(option, L"-vsyncpace %u", &vsyncDivisor);
+		pacing = FramePacingMode::VsyncAligned;
+	}
+
+	// -simrate <hz>: fixed simulation step rate.
+	double simulationRate = 60.0;
+	if ((option = pCmdLine ? wcsstr(pCmdLine, L"-simrate") : nullptr))
+		swscanf_s(option, L"-simrate %lf", &simulationRate);
+
 	int returnValue = 0;
-	DXRenderer renderer(hInstance);
+	DXRenderer renderer(hInstance, 3, maxFrameLatency);
+	renderer.SetFramePacing(pacing, targetFps, vsyncDivisor);
+	renderer.SetSimulationRate(simulationRate);
+	// -dynres <budgetMs>: starts with dynamic resolution on, keeping GPU time under the budget.
+	double dynresMs = 0.0;
+	if ((option = pCmdLine ? wcsstr(pCmdLine, L"-dynres ") : nullptr) && swscanf_s(option, L"-dynres %lf", &dynresMs) == 1)
+		renderer.SetDynamicResolution(true, dynresMs);
+	// -renderthread: keeps rendering while the window is dragged or resized.
+	renderer.EnableRenderThread(pCmdLine && wcsstr(pCmdLine, L"-renderthread"));
 	try
 	{
 		returnValue = renderer.Run();
@@ -17,4 +144,4 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
 		MessageBoxA(nullptr, e.what(), "DirectX Failed", MB_OK | MB_ICONEXCLAMATION);
 	}
 	return returnValue;
-}
\ No newline at end of file
+}